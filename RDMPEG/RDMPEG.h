@@ -10,7 +10,11 @@
 #import <VideoToolbox/VideoToolbox.h>
 #import <MetalKit/MetalKit.h>
 #import <libavformat/avformat.h>
+#import <RDMPEG/RDMPEGAudioCallbackFlags.h>
+#import <RDMPEG/RDMPEGAudioTap.h>
 #import <RDMPEG/RDMPEGDecoder.h>
 #import <RDMPEG/RDMPEGIOStream.h>
 #import <RDMPEG/RDMPEGShaderTypes.h>
+#import <RDMPEG/RDMPEGSPSCQueue.h>
+#import <RDMPEG/RDMPEGTranscoder.h>
 
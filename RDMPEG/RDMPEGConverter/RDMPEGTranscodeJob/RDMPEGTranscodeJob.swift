@@ -0,0 +1,117 @@
+//
+//  RDMPEGTranscodeJob.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Typed description of RDMPEGTranscodeOperation work. Zero values keep source parameters
+// (or encoder defaults for bit rate and GOP size), nil encoder picks default one of the output format.
+@objcMembers
+public class RDMPEGTranscodeJob: NSObject {
+    public let inputPath: String
+    public let outputPath: String
+    // Guessed from output path extension when nil
+    public var formatName: String?
+    public var startTime: TimeInterval = 0
+    // 0 goes to the end of input
+    public var duration: TimeInterval = 0
+    // Input is read through the stream rather than from inputPath, e.g. RDMPEGCachingIOStream over the cache
+    // player has already filled. Stream is opened and closed by the operation, so it must not be shared
+    // with a decoder which is still reading it
+    public var ioStream: RDMPEGIOStream?
+
+    public var videoMode: RDMPEGTranscoderStreamMode = .transcode
+    // -1 picks the best stream
+    public var videoStreamIndex: Int = -1
+    public var videoEncoderName: String?
+    // When only one dimension is set the other one keeps aspect ratio
+    public var width: Int = 0
+    public var height: Int = 0
+    public var videoBitRate: Int = 0
+    public var gopSize: Int = 0
+    // Private encoder options, e.g. ["preset": "veryfast"]. Unknown option fails the job
+    public var videoEncoderOptions: [String: String] = [:]
+
+    public var audioMode: RDMPEGTranscoderStreamMode = .transcode
+    public var audioStreamIndex: Int = -1
+    public var audioEncoderName: String?
+    public var sampleRate: Int = 0
+    public var channelsCount: Int = 0
+    public var audioBitRate: Int = 0
+    public var audioEncoderOptions: [String: String] = [:]
+
+    public init(inputPath: String, outputPath: String) {
+        self.inputPath = inputPath
+        self.outputPath = outputPath
+        super.init()
+    }
+
+    override public var description: String {
+        "RDMPEGTranscodeJob \(inputPath) -> \(outputPath)"
+    }
+}
+
+extension RDMPEGTranscodeJob {
+    // C strings of the description live until body returns, transcoder copies them
+    func withTranscoderJob<Result>(
+        ioContext: UnsafeMutableRawPointer?,
+        readCallback: RDMPEGTranscoderReadCallback?,
+        seekCallback: RDMPEGTranscoderSeekCallback?,
+        _ body: (UnsafePointer<RDMPEGTranscoderJob>) -> Result
+    ) -> Result {
+        var strings = [UnsafeMutablePointer<CChar>]()
+        defer {
+            strings.forEach { free($0) }
+        }
+
+        func cString(_ string: String?) -> UnsafePointer<CChar>? {
+            guard let string, let copy = strdup(string) else {
+                return nil
+            }
+            strings.append(copy)
+            return UnsafePointer(copy)
+        }
+
+        func optionsString(_ options: [String: String]) -> String? {
+            guard options.isEmpty == false else {
+                return nil
+            }
+            return options.sorted { $0.key < $1.key }.map { "\($0.key)=\($0.value)" }.joined(separator: ":")
+        }
+
+        var job = RDMPEGTranscoderJob()
+        job.inputPath = cString(inputPath)
+        job.outputPath = cString(outputPath)
+        job.formatName = cString(formatName)
+        job.startTime = startTime
+        job.duration = duration
+
+        job.video.mode = videoMode
+        job.video.streamIndex = Int32(videoStreamIndex)
+        job.video.encoderName = cString(videoEncoderName)
+        job.video.width = Int32(width)
+        job.video.height = Int32(height)
+        job.video.bitRate = Int64(videoBitRate)
+        job.video.gopSize = Int32(gopSize)
+        job.video.encoderOptions = cString(optionsString(videoEncoderOptions))
+
+        job.audio.mode = audioMode
+        job.audio.streamIndex = Int32(audioStreamIndex)
+        job.audio.encoderName = cString(audioEncoderName)
+        job.audio.sampleRate = Int32(sampleRate)
+        job.audio.channelsCount = Int32(channelsCount)
+        job.audio.bitRate = Int64(audioBitRate)
+        job.audio.encoderOptions = cString(optionsString(audioEncoderOptions))
+
+        if ioStream != nil {
+            job.readCallback = readCallback
+            job.seekCallback = seekCallback
+            job.ioContext = ioContext
+        }
+
+        return withUnsafePointer(to: &job) { body($0) }
+    }
+}
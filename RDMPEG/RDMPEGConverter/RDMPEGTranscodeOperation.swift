@@ -0,0 +1,160 @@
+//
+//  RDMPEGTranscodeOperation.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+import Log4Cocoa
+
+// Transcodes in process with RDMPEGTranscoder: no command line to build and parse, progress comes from
+// timestamps of written packets. Job is captured when operation is created.
+@objcMembers
+public class RDMPEGTranscodeOperation: RDMPEGOperation, @unchecked Sendable {
+
+    // Both are called on the transcoding thread
+    public typealias ProgressBlock = (RDMPEGTranscodeProgress) -> Void
+    public typealias ResultBlock = (Int32) -> Void
+
+    public let job: RDMPEGTranscodeJob
+    // Set before result block is called when job failed
+    public private(set) var errorMessage: String?
+
+    private let progressBlock: ProgressBlock?
+    private let resultBlock: ResultBlock
+    private var transcoder: OpaquePointer?
+
+    public init(job: RDMPEGTranscodeJob, progressBlock: ProgressBlock?, resultBlock: @escaping ResultBlock) {
+        self.job = job
+        self.progressBlock = progressBlock
+        self.resultBlock = resultBlock
+        super.init()
+
+        self.transcoder = job.withTranscoderJob(
+            ioContext: Unmanaged.passUnretained(self).toOpaque(),
+            readCallback: transcodeOperationRead,
+            seekCallback: transcodeOperationSeek
+        ) {
+            rdmpeg_transcoder_create($0)
+        }
+    }
+
+    deinit {
+        rdmpeg_transcoder_destroy(transcoder)
+    }
+
+    override public func main() {
+        guard let transcoder else {
+            resultBlock(-ENOMEM)
+            completeOperation()
+            return
+        }
+
+        let thread = Thread { [self] in
+            log4Info("Transcoding \(job)")
+
+            if let ioStream = job.ioStream, ioStream.open() == false {
+                errorMessage = "Unable to open input stream"
+                log4Error("Transcoding failed: \(errorMessage ?? "")")
+                resultBlock(-EIO)
+                completeOperation()
+                return
+            }
+
+            let status = rdmpeg_transcoder_run(
+                transcoder,
+                transcodeOperationProgress,
+                Unmanaged.passUnretained(self).toOpaque()
+            )
+
+            job.ioStream?.close()
+
+            if status != 0 && status != RDMPEG_TRANSCODER_CANCELLED {
+                errorMessage = String(cString: rdmpeg_transcoder_error_message(transcoder))
+                log4Error("Transcoding failed: \(errorMessage ?? "")")
+            }
+            else {
+                log4Info("Transcoding \(status == 0 ? "finished" : "cancelled")")
+            }
+
+            resultBlock(status)
+            completeOperation()
+        }
+
+        thread.name = "RDMPEGTranscodeOperation"
+        thread.qualityOfService = qualityOfService
+        thread.start()
+    }
+
+    override public func cancel() {
+        super.cancel()
+
+        if let transcoder {
+            rdmpeg_transcoder_cancel(transcoder)
+        }
+    }
+
+    fileprivate func reportProgress(_ progress: RDMPEGTranscoderProgress) {
+        progressBlock?(RDMPEGTranscodeProgress(progress: progress))
+    }
+
+    fileprivate func readInput(_ buffer: UnsafeMutablePointer<UInt8>, length: Int) -> Int32 {
+        guard let ioStream = job.ioStream else {
+            return -1
+        }
+        return Int32(ioStream.readBuffer(buffer, length: length))
+    }
+
+    fileprivate func seekInput(offset: Int64, whence: Int32) -> Int64 {
+        guard let ioStream = job.ioStream else {
+            return -1
+        }
+
+        if whence & AVSEEK_SIZE != 0 {
+            guard let contentLength = ioStream.contentLength?() else {
+                return -1
+            }
+            return Int64(bitPattern: contentLength)
+        }
+
+        return Int64(bitPattern: ioStream.seekOffset(UInt64(bitPattern: offset), whence: Int(whence)))
+    }
+
+    public class func isReturnCodeCancel(_ code: Int32) -> Bool {
+        return code == RDMPEG_TRANSCODER_CANCELLED
+    }
+
+    public class func isReturnCodeSuccess(_ code: Int32) -> Bool {
+        return code == 0
+    }
+}
+
+// Operation outlives its transcoder, so callbacks get it unretained
+
+private func transcodeOperationProgress(progress: UnsafePointer<RDMPEGTranscoderProgress>?,
+                                        context: UnsafeMutableRawPointer?) {
+    guard let progress, let context else {
+        return
+    }
+    let operation = Unmanaged<RDMPEGTranscodeOperation>.fromOpaque(context).takeUnretainedValue()
+    operation.reportProgress(progress.pointee)
+}
+
+private func transcodeOperationRead(context: UnsafeMutableRawPointer?,
+                                    buffer: UnsafeMutablePointer<UInt8>?,
+                                    size: Int32) -> Int32 {
+    guard let context, let buffer else {
+        return -1
+    }
+    let operation = Unmanaged<RDMPEGTranscodeOperation>.fromOpaque(context).takeUnretainedValue()
+    return operation.readInput(buffer, length: Int(size))
+}
+
+private func transcodeOperationSeek(context: UnsafeMutableRawPointer?, offset: Int64, whence: Int32) -> Int64 {
+    guard let context else {
+        return -1
+    }
+    let operation = Unmanaged<RDMPEGTranscodeOperation>.fromOpaque(context).takeUnretainedValue()
+    return operation.seekInput(offset: offset, whence: whence)
+}
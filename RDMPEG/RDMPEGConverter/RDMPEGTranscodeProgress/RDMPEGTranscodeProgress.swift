@@ -0,0 +1,45 @@
+//
+//  RDMPEGTranscodeProgress.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+@objcMembers
+public class RDMPEGTranscodeProgress: NSObject {
+    // Seconds of output written so far, taken from timestamps of muxed packets
+    public let time: TimeInterval
+    // Expected output duration, 0 when unknown
+    public let duration: TimeInterval
+    public let videoFramesCount: Int
+    public let audioFramesCount: Int
+    public let bytesWritten: Int
+    public let elapsedTime: TimeInterval
+
+    // From 0 to 1, 0 when duration is unknown
+    public var fraction: Double {
+        duration > 0 ? min(time / duration, 1) : 0
+    }
+
+    // Seconds of output per second of wall clock
+    public var speed: Double {
+        elapsedTime > 0 ? time / elapsedTime : 0
+    }
+
+    init(progress: RDMPEGTranscoderProgress) {
+        self.time = progress.time
+        self.duration = progress.duration
+        self.videoFramesCount = Int(progress.videoFramesCount)
+        self.audioFramesCount = Int(progress.audioFramesCount)
+        self.bytesWritten = Int(progress.bytesWritten)
+        self.elapsedTime = progress.elapsedTime
+        super.init()
+    }
+
+    override public var description: String {
+        String(format: "RDMPEGTranscodeProgress %.3f/%.3f s, %d video frames, %d bytes, %.2fx",
+               time, duration, videoFramesCount, bytesWritten, speed)
+    }
+}
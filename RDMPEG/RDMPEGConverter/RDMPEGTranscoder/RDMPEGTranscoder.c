@@ -0,0 +1,1607 @@
+//
+//  RDMPEGTranscoder.c
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGTranscoder.h"
+#include "../RDMPEGTranscoderQueue/RDMPEGTranscoderQueue.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libavcodec/avcodec.h>
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+#include <libavformat/avformat.h>
+#include <libavutil/avstring.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/pixdesc.h>
+#include <libavutil/time.h>
+
+_Static_assert(RDMPEG_TRANSCODER_CANCELLED == AVERROR_EXIT, "RDMPEG_TRANSCODER_CANCELLED must match AVERROR_EXIT");
+
+// Queue capacities bound memory between stages: compressed packets are small, decoded frames aren't
+#define RDMPEG_TRANSCODER_PACKET_QUEUE_CAPACITY 64
+#define RDMPEG_TRANSCODER_FRAME_QUEUE_CAPACITY 8
+#define RDMPEG_TRANSCODER_MUX_QUEUE_CAPACITY 64
+#define RDMPEG_TRANSCODER_MAX_STREAMS 2
+// Packet queue of every transcoded stream, their frame queues and mux queue
+#define RDMPEG_TRANSCODER_MAX_QUEUES (RDMPEG_TRANSCODER_MAX_STREAMS * 2 + 1)
+#define RDMPEG_TRANSCODER_IO_BUFFER_SIZE 32768
+// Seconds of output between progress reports
+#define RDMPEG_TRANSCODER_PROGRESS_INTERVAL 0.1
+
+typedef struct RDMPEGTranscoderStream {
+    RDMPEGTranscoder *transcoder;
+    RDMPEGTranscoderStreamMode mode;
+    enum AVMediaType type;
+    AVStream *inputStream;
+    AVStream *outputStream;
+
+    // Job window in input stream time base, packets and frames are shifted by startPts
+    int64_t startPts;
+    int64_t endPts;
+
+    // Time base of packets this stream hands to muxer
+    AVRational packetTimeBase;
+
+    // Transcoding
+    AVCodecContext *decoderContext;
+    AVCodecContext *encoderContext;
+    AVFilterGraph *filterGraph;
+    AVFilterContext *bufferContext;
+    AVFilterContext *buffersinkContext;
+    // Output part of the graph, source part is rebuilt whenever decoded frames change format
+    char filterDescription[256];
+    AVRational filterTimeBase;
+    int filterWidth;
+    int filterHeight;
+    int filterFormat;
+    int filterSampleRate;
+    uint64_t filterChannelLayout;
+    int64_t lastEncoderPts;
+    RDMPEGTranscoderQueue *packets;
+    RDMPEGTranscoderQueue *frames;
+    pthread_t decodeThread;
+    pthread_t encodeThread;
+    bool isDecodeThreadStarted;
+    bool isEncodeThreadStarted;
+
+    // Demuxer side
+    bool isInputFinished;
+
+    // Muxer side
+    int64_t muxedPacketsCount;
+} RDMPEGTranscoderStream;
+
+struct RDMPEGTranscoder {
+    RDMPEGTranscoderJob job;
+    atomic_bool aborted;
+    atomic_bool cancelled;
+    bool hasRun;
+
+    // Guards status, error message and queues, so that cancel from another thread reaches every queue
+    pthread_mutex_t lock;
+    int status;
+    char errorMessage[512];
+    RDMPEGTranscoderQueue *queues[RDMPEG_TRANSCODER_MAX_QUEUES];
+    int queuesCount;
+
+    AVFormatContext *inputContext;
+    AVIOContext *inputIOContext;
+    AVFormatContext *outputContext;
+    RDMPEGTranscoderStream streams[RDMPEG_TRANSCODER_MAX_STREAMS];
+    int streamsCount;
+    RDMPEGTranscoderQueue *muxQueue;
+    pthread_t demuxThread;
+    bool isDemuxThreadStarted;
+
+    int64_t startedAt;
+    RDMPEGTranscoderProgress progress;
+};
+
+static char *transcoder_strdup(const char *string);
+static void transcoder_fail(RDMPEGTranscoder *transcoder, int status, const char *format, ...);
+static void transcoder_abort(RDMPEGTranscoder *transcoder);
+static bool transcoder_is_aborted(RDMPEGTranscoder *transcoder);
+static int transcoder_interrupt_callback(void *context);
+static RDMPEGTranscoderQueue *transcoder_queue_create(RDMPEGTranscoder *transcoder,
+                                                      size_t capacity,
+                                                      int producersCount,
+                                                      RDMPEGTranscoderQueueItemFree itemFree);
+static int transcoder_open_input(RDMPEGTranscoder *transcoder);
+static int transcoder_add_stream(RDMPEGTranscoder *transcoder,
+                                 enum AVMediaType type,
+                                 RDMPEGTranscoderStreamMode mode,
+                                 int streamIndex,
+                                 int relatedStreamIndex);
+static int transcoder_open_output(RDMPEGTranscoder *transcoder);
+static int transcoder_start_threads(RDMPEGTranscoder *transcoder);
+static int transcoder_mux(RDMPEGTranscoder *transcoder,
+                          RDMPEGTranscoderProgressCallback progressCallback,
+                          void *progressContext);
+static void transcoder_report_progress(RDMPEGTranscoder *transcoder,
+                                       RDMPEGTranscoderProgressCallback progressCallback,
+                                       void *progressContext);
+static void transcoder_join_threads(RDMPEGTranscoder *transcoder);
+static void transcoder_close(RDMPEGTranscoder *transcoder);
+static RDMPEGTranscoderStream *transcoder_stream_for_input(RDMPEGTranscoder *transcoder, int index);
+static RDMPEGTranscoderStream *transcoder_stream_for_output(RDMPEGTranscoder *transcoder, int index);
+static int stream_open_decoder(RDMPEGTranscoderStream *stream);
+static int stream_open_encoder(RDMPEGTranscoderStream *stream, const AVCodec *encoder, const char *encoderOptions);
+static void stream_configure_video_encoder(RDMPEGTranscoderStream *stream, const AVCodec *encoder);
+static void stream_configure_audio_encoder(RDMPEGTranscoderStream *stream, const AVCodec *encoder);
+static int stream_configure_filter_graph(RDMPEGTranscoderStream *stream, const AVFrame *frame);
+static bool stream_filter_graph_matches(RDMPEGTranscoderStream *stream, const AVFrame *frame);
+static int stream_filter_frame(RDMPEGTranscoderStream *stream, AVFrame *frame);
+static int stream_drain_filter_graph(RDMPEGTranscoderStream *stream);
+static int stream_receive_frames(RDMPEGTranscoderStream *stream, AVFrame *frame);
+static int stream_receive_packets(RDMPEGTranscoderStream *stream);
+static void *demux_thread(void *context);
+static void *decode_thread(void *context);
+static void *encode_thread(void *context);
+static uint64_t default_channel_layout(int channelsCount);
+static uint64_t encoder_channel_layout(const AVCodec *encoder, uint64_t channelLayout, int channelsCount);
+static int codec_context_channels_count(const AVCodecContext *context);
+static uint64_t codec_context_channel_layout(const AVCodecContext *context);
+static void codec_context_set_channel_layout(AVCodecContext *context, uint64_t channelLayout);
+static uint64_t frame_channel_layout(const AVFrame *frame);
+static void packet_free(void *item);
+static void frame_free(void *item);
+
+// MARK: - Lifecycle
+
+RDMPEGTranscoder *rdmpeg_transcoder_create(const RDMPEGTranscoderJob *job) {
+    RDMPEGTranscoder *transcoder = calloc(1, sizeof(RDMPEGTranscoder));
+    if (transcoder == NULL) {
+        return NULL;
+    }
+
+    transcoder->job = *job;
+    transcoder->job.inputPath = transcoder_strdup(job->inputPath);
+    transcoder->job.outputPath = transcoder_strdup(job->outputPath);
+    transcoder->job.formatName = transcoder_strdup(job->formatName);
+    transcoder->job.video.encoderName = transcoder_strdup(job->video.encoderName);
+    transcoder->job.video.encoderOptions = transcoder_strdup(job->video.encoderOptions);
+    transcoder->job.audio.encoderName = transcoder_strdup(job->audio.encoderName);
+    transcoder->job.audio.encoderOptions = transcoder_strdup(job->audio.encoderOptions);
+
+    atomic_init(&transcoder->aborted, false);
+    atomic_init(&transcoder->cancelled, false);
+    pthread_mutex_init(&transcoder->lock, NULL);
+
+    return transcoder;
+}
+
+void rdmpeg_transcoder_destroy(RDMPEGTranscoder *transcoder) {
+    if (transcoder == NULL) {
+        return;
+    }
+
+    transcoder_close(transcoder);
+
+    free((char *)transcoder->job.inputPath);
+    free((char *)transcoder->job.outputPath);
+    free((char *)transcoder->job.formatName);
+    free((char *)transcoder->job.video.encoderName);
+    free((char *)transcoder->job.video.encoderOptions);
+    free((char *)transcoder->job.audio.encoderName);
+    free((char *)transcoder->job.audio.encoderOptions);
+
+    pthread_mutex_destroy(&transcoder->lock);
+    free(transcoder);
+}
+
+void rdmpeg_transcoder_cancel(RDMPEGTranscoder *transcoder) {
+    atomic_store(&transcoder->cancelled, true);
+    transcoder_abort(transcoder);
+}
+
+const char *rdmpeg_transcoder_error_message(RDMPEGTranscoder *transcoder) {
+    return transcoder->errorMessage;
+}
+
+static char *transcoder_strdup(const char *string) {
+    if (string == NULL) {
+        return NULL;
+    }
+
+    size_t length = strlen(string) + 1;
+    char *copy = malloc(length);
+    if (copy) {
+        memcpy(copy, string, length);
+    }
+
+    return copy;
+}
+
+// MARK: - Run
+
+int rdmpeg_transcoder_run(RDMPEGTranscoder *transcoder,
+                          RDMPEGTranscoderProgressCallback progressCallback,
+                          void *progressContext) {
+    if (transcoder->hasRun) {
+        return AVERROR(EINVAL);
+    }
+
+    transcoder->hasRun = true;
+    transcoder->startedAt = av_gettime_relative();
+
+    int status = transcoder_open_input(transcoder);
+
+    if (status >= 0) {
+        const RDMPEGTranscoderJob *job = &transcoder->job;
+        AVFormatContext *inputContext = transcoder->inputContext;
+
+        status = transcoder_add_stream(transcoder, AVMEDIA_TYPE_VIDEO, job->video.mode, job->video.streamIndex, -1);
+
+        if (status >= 0) {
+            int videoStreamIndex = transcoder->streamsCount > 0 ? transcoder->streams[0].inputStream->index : -1;
+            status = transcoder_add_stream(transcoder,
+                                           AVMEDIA_TYPE_AUDIO,
+                                           job->audio.mode,
+                                           job->audio.streamIndex,
+                                           videoStreamIndex);
+        }
+
+        if (status >= 0 && transcoder->streamsCount == 0) {
+            status = AVERROR_STREAM_NOT_FOUND;
+            transcoder_fail(transcoder, status, "No video or audio stream to transcode in %s", inputContext->url);
+        }
+    }
+
+    if (status >= 0) {
+        status = transcoder_open_output(transcoder);
+    }
+
+    if (status >= 0) {
+        status = transcoder_start_threads(transcoder);
+    }
+
+    if (status >= 0) {
+        status = transcoder_mux(transcoder, progressCallback, progressContext);
+    }
+
+    if (status < 0) {
+        transcoder_abort(transcoder);
+    }
+
+    transcoder_join_threads(transcoder);
+
+    pthread_mutex_lock(&transcoder->lock);
+    if (atomic_load(&transcoder->cancelled)) {
+        transcoder->status = RDMPEG_TRANSCODER_CANCELLED;
+        snprintf(transcoder->errorMessage, sizeof(transcoder->errorMessage), "Cancelled");
+    }
+    else if (transcoder->status == 0 && status < 0) {
+        transcoder->status = status;
+    }
+    status = transcoder->status;
+    pthread_mutex_unlock(&transcoder->lock);
+
+    transcoder_close(transcoder);
+
+    return status;
+}
+
+// MARK: - Failure
+
+// Records the first failure and stops every stage, later failures are most likely consequences of the first one
+static void transcoder_fail(RDMPEGTranscoder *transcoder, int status, const char *format, ...) {
+    pthread_mutex_lock(&transcoder->lock);
+
+    if (transcoder->status == 0 && atomic_load(&transcoder->aborted) == false) {
+        char message[384];
+        va_list arguments;
+        va_start(arguments, format);
+        vsnprintf(message, sizeof(message), format, arguments);
+        va_end(arguments);
+
+        char reason[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(status, reason, sizeof(reason));
+
+        transcoder->status = status;
+        snprintf(transcoder->errorMessage, sizeof(transcoder->errorMessage), "%s: %s", message, reason);
+        av_log(NULL, AV_LOG_ERROR, "RDMPEGTranscoder: %s\n", transcoder->errorMessage);
+    }
+
+    pthread_mutex_unlock(&transcoder->lock);
+
+    transcoder_abort(transcoder);
+}
+
+static void transcoder_abort(RDMPEGTranscoder *transcoder) {
+    pthread_mutex_lock(&transcoder->lock);
+
+    atomic_store(&transcoder->aborted, true);
+
+    for (int i = 0; i < transcoder->queuesCount; i++) {
+        rdmpeg_transcoder_queue_abort(transcoder->queues[i]);
+    }
+
+    pthread_mutex_unlock(&transcoder->lock);
+}
+
+static bool transcoder_is_aborted(RDMPEGTranscoder *transcoder) {
+    return atomic_load_explicit(&transcoder->aborted, memory_order_relaxed);
+}
+
+// Stops blocking demuxer and muxer I/O
+static int transcoder_interrupt_callback(void *context) {
+    return transcoder_is_aborted(context) ? 1 : 0;
+}
+
+static RDMPEGTranscoderQueue *transcoder_queue_create(RDMPEGTranscoder *transcoder,
+                                                      size_t capacity,
+                                                      int producersCount,
+                                                      RDMPEGTranscoderQueueItemFree itemFree) {
+    RDMPEGTranscoderQueue *queue = rdmpeg_transcoder_queue_create(capacity, producersCount, itemFree);
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&transcoder->lock);
+
+    transcoder->queues[transcoder->queuesCount++] = queue;
+
+    // Job may be cancelled before its queues exist
+    if (atomic_load(&transcoder->aborted)) {
+        rdmpeg_transcoder_queue_abort(queue);
+    }
+
+    pthread_mutex_unlock(&transcoder->lock);
+
+    return queue;
+}
+
+// MARK: - Setup
+
+static int transcoder_open_input(RDMPEGTranscoder *transcoder) {
+    const RDMPEGTranscoderJob *job = &transcoder->job;
+    AVFormatContext *inputContext = avformat_alloc_context();
+    if (inputContext == NULL) {
+        transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate input");
+        return AVERROR(ENOMEM);
+    }
+
+    inputContext->interrupt_callback.callback = transcoder_interrupt_callback;
+    inputContext->interrupt_callback.opaque = transcoder;
+
+    if (job->readCallback) {
+        uint8_t *buffer = av_malloc(RDMPEG_TRANSCODER_IO_BUFFER_SIZE);
+        if (buffer) {
+            transcoder->inputIOContext = avio_alloc_context(buffer,
+                                                            RDMPEG_TRANSCODER_IO_BUFFER_SIZE,
+                                                            0,
+                                                            job->ioContext,
+                                                            job->readCallback,
+                                                            NULL,
+                                                            job->seekCallback);
+        }
+
+        if (transcoder->inputIOContext == NULL) {
+            av_free(buffer);
+            avformat_free_context(inputContext);
+            transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate input I/O");
+            return AVERROR(ENOMEM);
+        }
+
+        if (job->seekCallback == NULL) {
+            transcoder->inputIOContext->seekable = 0;
+        }
+
+        inputContext->pb = transcoder->inputIOContext;
+        inputContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+
+    const char *inputPath = job->inputPath ? job->inputPath : "";
+
+    // Input context is freed on failure
+    int status = avformat_open_input(&inputContext, inputPath, NULL, NULL);
+    if (status < 0) {
+        transcoder_fail(transcoder, status, "Unable to open %s", inputPath);
+        return status;
+    }
+
+    transcoder->inputContext = inputContext;
+
+    status = avformat_find_stream_info(inputContext, NULL);
+    if (status < 0) {
+        transcoder_fail(transcoder, status, "Stream info not found in %s", inputPath);
+        return status;
+    }
+
+    int64_t startTime = inputContext->start_time != AV_NOPTS_VALUE ? inputContext->start_time : 0;
+    startTime += (int64_t)(job->startTime * AV_TIME_BASE);
+
+    if (job->startTime > 0.0) {
+        // Lands on the keyframe before start, frames before it are decoded and dropped
+        status = avformat_seek_file(inputContext, -1, INT64_MIN, startTime, startTime, 0);
+        if (status < 0) {
+            transcoder_fail(transcoder, status, "Unable to seek %s to %.3f", inputPath, job->startTime);
+            return status;
+        }
+    }
+
+    double duration = job->duration;
+
+    if (duration <= 0.0 && inputContext->duration != AV_NOPTS_VALUE) {
+        duration = FFMAX((double)inputContext->duration / AV_TIME_BASE - job->startTime, 0.0);
+    }
+
+    transcoder->progress.duration = duration;
+
+    return 0;
+}
+
+static int transcoder_add_stream(RDMPEGTranscoder *transcoder,
+                                 enum AVMediaType type,
+                                 RDMPEGTranscoderStreamMode mode,
+                                 int streamIndex,
+                                 int relatedStreamIndex) {
+    if (mode == RDMPEGTranscoderStreamModeDrop) {
+        return 0;
+    }
+
+    AVFormatContext *inputContext = transcoder->inputContext;
+
+    if (streamIndex >= 0) {
+        if ((unsigned)streamIndex >= inputContext->nb_streams ||
+            inputContext->streams[streamIndex]->codecpar->codec_type != type) {
+            transcoder_fail(transcoder, AVERROR_STREAM_NOT_FOUND, "No %s stream #%d in %s",
+                            av_get_media_type_string(type), streamIndex, inputContext->url);
+            return AVERROR_STREAM_NOT_FOUND;
+        }
+    }
+    else {
+        streamIndex = av_find_best_stream(inputContext, type, -1, relatedStreamIndex, NULL, 0);
+
+        // Cover art isn't a video stream worth transcoding
+        if (streamIndex >= 0 && (inputContext->streams[streamIndex]->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
+            streamIndex = -1;
+        }
+
+        if (streamIndex < 0) {
+            return 0;
+        }
+    }
+
+    RDMPEGTranscoderStream *stream = &transcoder->streams[transcoder->streamsCount++];
+    const RDMPEGTranscoderJob *job = &transcoder->job;
+    AVStream *inputStream = inputContext->streams[streamIndex];
+
+    stream->transcoder = transcoder;
+    stream->mode = mode;
+    stream->type = type;
+    stream->inputStream = inputStream;
+    stream->lastEncoderPts = AV_NOPTS_VALUE;
+
+    int64_t startTime = inputContext->start_time != AV_NOPTS_VALUE ? inputContext->start_time : 0;
+    startTime += (int64_t)(job->startTime * AV_TIME_BASE);
+
+    stream->startPts = av_rescale_q(startTime, AV_TIME_BASE_Q, inputStream->time_base);
+    stream->endPts = INT64_MAX;
+
+    if (job->duration > 0.0) {
+        stream->endPts = stream->startPts + av_rescale_q((int64_t)(job->duration * AV_TIME_BASE),
+                                                         AV_TIME_BASE_Q,
+                                                         inputStream->time_base);
+    }
+
+    return 0;
+}
+
+static int transcoder_open_output(RDMPEGTranscoder *transcoder) {
+    const RDMPEGTranscoderJob *job = &transcoder->job;
+    const char *outputPath = job->outputPath ? job->outputPath : "";
+
+    int status = avformat_alloc_output_context2(&transcoder->outputContext, NULL, job->formatName, outputPath);
+    if (status < 0) {
+        transcoder_fail(transcoder, status, "Unable to create output format for %s", outputPath);
+        return status;
+    }
+
+    AVFormatContext *outputContext = transcoder->outputContext;
+    outputContext->interrupt_callback.callback = transcoder_interrupt_callback;
+    outputContext->interrupt_callback.opaque = transcoder;
+
+    // Streams which aren't part of the job are discarded by demuxer
+    for (unsigned i = 0; i < transcoder->inputContext->nb_streams; i++) {
+        if (transcoder_stream_for_input(transcoder, (int)i) == NULL) {
+            transcoder->inputContext->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    int transcodedStreamsCount = 0;
+
+    for (int i = 0; i < transcoder->streamsCount; i++) {
+        RDMPEGTranscoderStream *stream = &transcoder->streams[i];
+        bool isVideo = stream->type == AVMEDIA_TYPE_VIDEO;
+
+        stream->outputStream = avformat_new_stream(outputContext, NULL);
+        if (stream->outputStream == NULL) {
+            transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to create output stream");
+            return AVERROR(ENOMEM);
+        }
+
+        if (stream->mode == RDMPEGTranscoderStreamModeCopy) {
+            status = avcodec_parameters_copy(stream->outputStream->codecpar, stream->inputStream->codecpar);
+            if (status < 0) {
+                transcoder_fail(transcoder, status, "Unable to copy stream #%d parameters", stream->inputStream->index);
+                return status;
+            }
+
+            // Tag of the input container may mean something else in the output one
+            stream->outputStream->codecpar->codec_tag = 0;
+            stream->outputStream->time_base = stream->inputStream->time_base;
+            stream->outputStream->avg_frame_rate = stream->inputStream->avg_frame_rate;
+            stream->outputStream->sample_aspect_ratio = stream->inputStream->sample_aspect_ratio;
+            stream->packetTimeBase = stream->inputStream->time_base;
+        }
+        else {
+            const char *encoderName = isVideo ? job->video.encoderName : job->audio.encoderName;
+            const char *encoderOptions = isVideo ? job->video.encoderOptions : job->audio.encoderOptions;
+            const AVCodec *encoder = NULL;
+
+            if (encoderName) {
+                encoder = avcodec_find_encoder_by_name(encoderName);
+            }
+            else {
+                enum AVCodecID codecID = av_guess_codec(outputContext->oformat, NULL, outputPath, NULL, stream->type);
+                encoder = codecID != AV_CODEC_ID_NONE ? avcodec_find_encoder(codecID) : NULL;
+            }
+
+            if (encoder == NULL || encoder->type != stream->type) {
+                transcoder_fail(transcoder, AVERROR_ENCODER_NOT_FOUND, "No %s encoder %s for %s",
+                                av_get_media_type_string(stream->type),
+                                encoderName ? encoderName : "(default)",
+                                outputContext->oformat->name);
+                return AVERROR_ENCODER_NOT_FOUND;
+            }
+
+            status = stream_open_decoder(stream);
+            if (status < 0) {
+                return status;
+            }
+
+            status = stream_open_encoder(stream, encoder, encoderOptions);
+            if (status < 0) {
+                return status;
+            }
+
+            stream->packets = transcoder_queue_create(transcoder,
+                                                      RDMPEG_TRANSCODER_PACKET_QUEUE_CAPACITY,
+                                                      1,
+                                                      packet_free);
+            stream->frames = transcoder_queue_create(transcoder,
+                                                     RDMPEG_TRANSCODER_FRAME_QUEUE_CAPACITY,
+                                                     1,
+                                                     frame_free);
+
+            if (stream->packets == NULL || stream->frames == NULL) {
+                transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate queues");
+                return AVERROR(ENOMEM);
+            }
+
+            transcodedStreamsCount++;
+        }
+    }
+
+    // Demuxer (copied streams) and encoders feed muxer
+    transcoder->muxQueue = transcoder_queue_create(transcoder,
+                                                   RDMPEG_TRANSCODER_MUX_QUEUE_CAPACITY,
+                                                   1 + transcodedStreamsCount,
+                                                   packet_free);
+    if (transcoder->muxQueue == NULL) {
+        transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate queues");
+        return AVERROR(ENOMEM);
+    }
+
+    if ((outputContext->oformat->flags & AVFMT_NOFILE) == 0) {
+        status = avio_open2(&outputContext->pb, outputPath, AVIO_FLAG_WRITE, &outputContext->interrupt_callback, NULL);
+        if (status < 0) {
+            transcoder_fail(transcoder, status, "Unable to open %s", outputPath);
+            return status;
+        }
+    }
+
+    status = avformat_write_header(outputContext, NULL);
+    if (status < 0) {
+        transcoder_fail(transcoder, status, "Unable to write %s header", outputPath);
+        return status;
+    }
+
+    return 0;
+}
+
+static int stream_open_decoder(RDMPEGTranscoderStream *stream) {
+    RDMPEGTranscoder *transcoder = stream->transcoder;
+    AVCodecParameters *parameters = stream->inputStream->codecpar;
+
+    const AVCodec *decoder = avcodec_find_decoder(parameters->codec_id);
+    if (decoder == NULL) {
+        transcoder_fail(transcoder, AVERROR_DECODER_NOT_FOUND, "No %s decoder for stream #%d",
+                        avcodec_get_name(parameters->codec_id), stream->inputStream->index);
+        return AVERROR_DECODER_NOT_FOUND;
+    }
+
+    stream->decoderContext = avcodec_alloc_context3(decoder);
+    if (stream->decoderContext == NULL) {
+        transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate decoder");
+        return AVERROR(ENOMEM);
+    }
+
+    int status = avcodec_parameters_to_context(stream->decoderContext, parameters);
+    if (status < 0) {
+        transcoder_fail(transcoder, status, "Unable to configure %s decoder", decoder->name);
+        return status;
+    }
+
+    stream->decoderContext->pkt_timebase = stream->inputStream->time_base;
+    stream->decoderContext->thread_count = 0;
+
+    status = avcodec_open2(stream->decoderContext, decoder, NULL);
+    if (status < 0) {
+        transcoder_fail(transcoder, status, "Unable to open %s decoder", decoder->name);
+        return status;
+    }
+
+    return 0;
+}
+
+static int stream_open_encoder(RDMPEGTranscoderStream *stream, const AVCodec *encoder, const char *encoderOptions) {
+    RDMPEGTranscoder *transcoder = stream->transcoder;
+
+    stream->encoderContext = avcodec_alloc_context3(encoder);
+    if (stream->encoderContext == NULL) {
+        transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate encoder");
+        return AVERROR(ENOMEM);
+    }
+
+    if (stream->type == AVMEDIA_TYPE_VIDEO) {
+        stream_configure_video_encoder(stream, encoder);
+    }
+    else {
+        stream_configure_audio_encoder(stream, encoder);
+    }
+
+    AVCodecContext *encoderContext = stream->encoderContext;
+    encoderContext->thread_count = 0;
+
+    if (transcoder->outputContext->oformat->flags & AVFMT_GLOBALHEADER) {
+        encoderContext->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    AVDictionary *options = NULL;
+    int status = 0;
+
+    if (encoderOptions) {
+        status = av_dict_parse_string(&options, encoderOptions, "=", ":", 0);
+        if (status < 0) {
+            transcoder_fail(transcoder, status, "Unable to parse %s options \"%s\"", encoder->name, encoderOptions);
+            return status;
+        }
+    }
+
+    status = avcodec_open2(encoderContext, encoder, &options);
+
+    // Typo in options shouldn't silently produce something else than was asked for
+    AVDictionaryEntry *unknownOption = av_dict_get(options, "", NULL, AV_DICT_IGNORE_SUFFIX);
+    if (status >= 0 && unknownOption) {
+        status = AVERROR_OPTION_NOT_FOUND;
+        transcoder_fail(transcoder, status, "Unknown %s option %s", encoder->name, unknownOption->key);
+        av_dict_free(&options);
+        return status;
+    }
+
+    av_dict_free(&options);
+
+    if (status < 0) {
+        transcoder_fail(transcoder, status, "Unable to open %s encoder", encoder->name);
+        return status;
+    }
+
+    status = avcodec_parameters_from_context(stream->outputStream->codecpar, encoderContext);
+    if (status < 0) {
+        transcoder_fail(transcoder, status, "Unable to copy %s encoder parameters", encoder->name);
+        return status;
+    }
+
+    stream->outputStream->time_base = encoderContext->time_base;
+    stream->outputStream->avg_frame_rate = encoderContext->framerate;
+    stream->outputStream->sample_aspect_ratio = encoderContext->sample_aspect_ratio;
+    stream->packetTimeBase = encoderContext->time_base;
+
+    return 0;
+}
+
+static void stream_configure_video_encoder(RDMPEGTranscoderStream *stream, const AVCodec *encoder) {
+    const RDMPEGTranscoderVideoSettings *settings = &stream->transcoder->job.video;
+    AVCodecContext *decoderContext = stream->decoderContext;
+    AVCodecContext *encoderContext = stream->encoderContext;
+
+    int width = settings->width;
+    int height = settings->height;
+
+    if (width <= 0 && height <= 0) {
+        width = decoderContext->width;
+        height = decoderContext->height;
+    }
+    else if (width <= 0) {
+        width = (int)av_rescale(decoderContext->width, height, FFMAX(decoderContext->height, 1));
+    }
+    else if (height <= 0) {
+        height = (int)av_rescale(decoderContext->height, width, FFMAX(decoderContext->width, 1));
+    }
+
+    // Most encoders want even dimensions for subsampled chroma
+    width = FFMAX(width & ~1, 2);
+    height = FFMAX(height & ~1, 2);
+
+    enum AVPixelFormat pixelFormat = decoderContext->pix_fmt;
+
+    if (encoder->pix_fmts) {
+        pixelFormat = avcodec_find_best_pix_fmt_of_list(encoder->pix_fmts, decoderContext->pix_fmt, 0, NULL);
+    }
+
+    if (pixelFormat == AV_PIX_FMT_NONE) {
+        pixelFormat = AV_PIX_FMT_YUV420P;
+    }
+
+    AVRational sampleAspectRatio = av_guess_sample_aspect_ratio(stream->transcoder->inputContext,
+                                                                 stream->inputStream,
+                                                                 NULL);
+
+    // Scaling to a different shape keeps display aspect ratio
+    if (sampleAspectRatio.num > 0 && decoderContext->width > 0 && decoderContext->height > 0) {
+        av_reduce(&sampleAspectRatio.num, &sampleAspectRatio.den,
+                  (int64_t)sampleAspectRatio.num * decoderContext->width * height,
+                  (int64_t)sampleAspectRatio.den * decoderContext->height * width,
+                  INT_MAX);
+    }
+
+    AVRational frameRate = av_guess_frame_rate(stream->transcoder->inputContext, stream->inputStream, NULL);
+    AVRational timeBase = stream->inputStream->time_base;
+
+    // Many encoders can't store time base this fine (MPEG-4 part 2 is limited to 16 bit), frame duration is enough
+    if (timeBase.den > UINT16_MAX && frameRate.num > 0 && frameRate.den > 0) {
+        timeBase = av_inv_q(frameRate);
+    }
+
+    encoderContext->width = width;
+    encoderContext->height = height;
+    encoderContext->pix_fmt = pixelFormat;
+    encoderContext->sample_aspect_ratio = sampleAspectRatio;
+    encoderContext->time_base = timeBase;
+    encoderContext->framerate = frameRate;
+    encoderContext->color_range = decoderContext->color_range;
+    encoderContext->color_primaries = decoderContext->color_primaries;
+    encoderContext->color_trc = decoderContext->color_trc;
+    encoderContext->colorspace = decoderContext->colorspace;
+    encoderContext->chroma_sample_location = decoderContext->chroma_sample_location;
+
+    if (settings->bitRate > 0) {
+        encoderContext->bit_rate = settings->bitRate;
+    }
+
+    if (settings->gopSize > 0) {
+        encoderContext->gop_size = settings->gopSize;
+    }
+
+    // Scale passes frames through untouched when neither size nor format changes
+    snprintf(stream->filterDescription, sizeof(stream->filterDescription),
+             "scale=%d:%d,format=%s", width, height, av_get_pix_fmt_name(pixelFormat));
+
+    stream->filterTimeBase = stream->inputStream->time_base;
+}
+
+static void stream_configure_audio_encoder(RDMPEGTranscoderStream *stream, const AVCodec *encoder) {
+    const RDMPEGTranscoderAudioSettings *settings = &stream->transcoder->job.audio;
+    AVCodecContext *decoderContext = stream->decoderContext;
+    AVCodecContext *encoderContext = stream->encoderContext;
+
+    int sampleRate = settings->sampleRate > 0 ? settings->sampleRate : decoderContext->sample_rate;
+
+    if (encoder->supported_samplerates) {
+        int nearestSampleRate = encoder->supported_samplerates[0];
+
+        for (const int *rate = encoder->supported_samplerates; *rate != 0; rate++) {
+            if (abs(*rate - sampleRate) < abs(nearestSampleRate - sampleRate)) {
+                nearestSampleRate = *rate;
+            }
+        }
+
+        sampleRate = nearestSampleRate;
+    }
+
+    int decoderChannelsCount = codec_context_channels_count(decoderContext);
+    int channelsCount = settings->channelsCount > 0 ? settings->channelsCount : decoderChannelsCount;
+    uint64_t channelLayout = default_channel_layout(channelsCount);
+
+    if (channelsCount == decoderChannelsCount && codec_context_channel_layout(decoderContext) != 0) {
+        channelLayout = codec_context_channel_layout(decoderContext);
+    }
+
+    channelLayout = encoder_channel_layout(encoder, channelLayout, channelsCount);
+
+    enum AVSampleFormat sampleFormat = decoderContext->sample_fmt;
+
+    if (encoder->sample_fmts) {
+        sampleFormat = encoder->sample_fmts[0];
+
+        for (const enum AVSampleFormat *format = encoder->sample_fmts; *format != AV_SAMPLE_FMT_NONE; format++) {
+            if (*format == decoderContext->sample_fmt) {
+                sampleFormat = *format;
+                break;
+            }
+        }
+    }
+
+    encoderContext->sample_rate = sampleRate;
+    codec_context_set_channel_layout(encoderContext, channelLayout);
+    encoderContext->sample_fmt = sampleFormat;
+    encoderContext->time_base = (AVRational){1, sampleRate};
+
+    if (settings->bitRate > 0) {
+        encoderContext->bit_rate = settings->bitRate;
+    }
+
+    snprintf(stream->filterDescription, sizeof(stream->filterDescription),
+             "aresample=%d,aformat=sample_fmts=%s:channel_layouts=0x%" PRIx64,
+             sampleRate, av_get_sample_fmt_name(sampleFormat), channelLayout);
+
+    stream->filterTimeBase = encoderContext->time_base;
+}
+
+static int transcoder_start_threads(RDMPEGTranscoder *transcoder) {
+    for (int i = 0; i < transcoder->streamsCount; i++) {
+        RDMPEGTranscoderStream *stream = &transcoder->streams[i];
+
+        if (stream->mode != RDMPEGTranscoderStreamModeTranscode) {
+            continue;
+        }
+
+        int status = pthread_create(&stream->encodeThread, NULL, encode_thread, stream);
+        if (status != 0) {
+            transcoder_fail(transcoder, AVERROR(status), "Unable to start encoder thread");
+            return AVERROR(status);
+        }
+
+        stream->isEncodeThreadStarted = true;
+
+        status = pthread_create(&stream->decodeThread, NULL, decode_thread, stream);
+        if (status != 0) {
+            transcoder_fail(transcoder, AVERROR(status), "Unable to start decoder thread");
+            return AVERROR(status);
+        }
+
+        stream->isDecodeThreadStarted = true;
+    }
+
+    int status = pthread_create(&transcoder->demuxThread, NULL, demux_thread, transcoder);
+    if (status != 0) {
+        transcoder_fail(transcoder, AVERROR(status), "Unable to start demuxer thread");
+        return AVERROR(status);
+    }
+
+    transcoder->isDemuxThreadStarted = true;
+
+    return 0;
+}
+
+static void transcoder_join_threads(RDMPEGTranscoder *transcoder) {
+    if (transcoder->isDemuxThreadStarted) {
+        pthread_join(transcoder->demuxThread, NULL);
+        transcoder->isDemuxThreadStarted = false;
+    }
+
+    for (int i = 0; i < transcoder->streamsCount; i++) {
+        RDMPEGTranscoderStream *stream = &transcoder->streams[i];
+
+        if (stream->isDecodeThreadStarted) {
+            pthread_join(stream->decodeThread, NULL);
+            stream->isDecodeThreadStarted = false;
+        }
+
+        if (stream->isEncodeThreadStarted) {
+            pthread_join(stream->encodeThread, NULL);
+            stream->isEncodeThreadStarted = false;
+        }
+    }
+}
+
+static void transcoder_close(RDMPEGTranscoder *transcoder) {
+    for (int i = 0; i < transcoder->streamsCount; i++) {
+        RDMPEGTranscoderStream *stream = &transcoder->streams[i];
+
+        avfilter_graph_free(&stream->filterGraph);
+        avcodec_free_context(&stream->decoderContext);
+        avcodec_free_context(&stream->encoderContext);
+    }
+
+    transcoder->streamsCount = 0;
+
+    pthread_mutex_lock(&transcoder->lock);
+
+    for (int i = 0; i < transcoder->queuesCount; i++) {
+        rdmpeg_transcoder_queue_destroy(transcoder->queues[i]);
+    }
+
+    transcoder->queuesCount = 0;
+    transcoder->muxQueue = NULL;
+
+    pthread_mutex_unlock(&transcoder->lock);
+
+    if (transcoder->outputContext) {
+        if ((transcoder->outputContext->oformat->flags & AVFMT_NOFILE) == 0) {
+            avio_closep(&transcoder->outputContext->pb);
+        }
+
+        avformat_free_context(transcoder->outputContext);
+        transcoder->outputContext = NULL;
+    }
+
+    avformat_close_input(&transcoder->inputContext);
+
+    // Custom I/O isn't freed by format context
+    if (transcoder->inputIOContext) {
+        av_freep(&transcoder->inputIOContext->buffer);
+        avio_context_free(&transcoder->inputIOContext);
+    }
+}
+
+static RDMPEGTranscoderStream *transcoder_stream_for_input(RDMPEGTranscoder *transcoder, int index) {
+    for (int i = 0; i < transcoder->streamsCount; i++) {
+        if (transcoder->streams[i].inputStream->index == index) {
+            return &transcoder->streams[i];
+        }
+    }
+
+    return NULL;
+}
+
+static RDMPEGTranscoderStream *transcoder_stream_for_output(RDMPEGTranscoder *transcoder, int index) {
+    for (int i = 0; i < transcoder->streamsCount; i++) {
+        if (transcoder->streams[i].outputStream->index == index) {
+            return &transcoder->streams[i];
+        }
+    }
+
+    return NULL;
+}
+
+// MARK: - Demuxer
+
+static void *demux_thread(void *context) {
+    RDMPEGTranscoder *transcoder = context;
+    AVPacket *packet = NULL;
+    int activeStreamsCount = transcoder->streamsCount;
+
+    while (activeStreamsCount > 0 && transcoder_is_aborted(transcoder) == false) {
+        if (packet == NULL) {
+            packet = av_packet_alloc();
+
+            if (packet == NULL) {
+                transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate packet");
+                break;
+            }
+        }
+
+        int status = av_read_frame(transcoder->inputContext, packet);
+        if (status == AVERROR_EOF) {
+            break;
+        }
+
+        if (status < 0) {
+            transcoder_fail(transcoder, status, "Unable to read %s", transcoder->inputContext->url);
+            break;
+        }
+
+        RDMPEGTranscoderStream *stream = transcoder_stream_for_input(transcoder, packet->stream_index);
+
+        if (stream == NULL || stream->isInputFinished) {
+            av_packet_unref(packet);
+            continue;
+        }
+
+        // Decode order timestamps only grow, so nothing presented before the end follows this packet
+        int64_t timestamp = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+
+        if (timestamp != AV_NOPTS_VALUE && timestamp >= stream->endPts) {
+            stream->isInputFinished = true;
+            activeStreamsCount--;
+            av_packet_unref(packet);
+            continue;
+        }
+
+        bool isPushed = false;
+
+        if (stream->mode == RDMPEGTranscoderStreamModeCopy) {
+            if (packet->pts != AV_NOPTS_VALUE) {
+                packet->pts -= stream->startPts;
+            }
+
+            if (packet->dts != AV_NOPTS_VALUE) {
+                packet->dts -= stream->startPts;
+            }
+
+            packet->stream_index = stream->outputStream->index;
+            packet->pos = -1;
+
+            isPushed = rdmpeg_transcoder_queue_push(transcoder->muxQueue, packet);
+        }
+        else {
+            isPushed = rdmpeg_transcoder_queue_push(stream->packets, packet);
+        }
+
+        // Queue owns the packet now, even if it was aborted
+        packet = NULL;
+
+        if (isPushed == false) {
+            break;
+        }
+    }
+
+    av_packet_free(&packet);
+
+    for (int i = 0; i < transcoder->streamsCount; i++) {
+        if (transcoder->streams[i].packets) {
+            rdmpeg_transcoder_queue_finish(transcoder->streams[i].packets);
+        }
+    }
+
+    rdmpeg_transcoder_queue_finish(transcoder->muxQueue);
+
+    return NULL;
+}
+
+// MARK: - Decoder
+
+static void *decode_thread(void *context) {
+    RDMPEGTranscoderStream *stream = context;
+    RDMPEGTranscoder *transcoder = stream->transcoder;
+    AVFrame *frame = av_frame_alloc();
+    AVPacket *packet = NULL;
+    int status = 0;
+
+    if (frame == NULL) {
+        transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate frame");
+        status = AVERROR(ENOMEM);
+    }
+
+    while (status >= 0 && (packet = rdmpeg_transcoder_queue_pop(stream->packets))) {
+        status = avcodec_send_packet(stream->decoderContext, packet);
+        av_packet_free(&packet);
+
+        // Damaged packet costs a few frames, not the whole job
+        if (status == AVERROR_INVALIDDATA) {
+            av_log(stream->decoderContext, AV_LOG_WARNING, "RDMPEGTranscoder: skipping damaged packet\n");
+            status = 0;
+        }
+        else if (status < 0) {
+            transcoder_fail(transcoder, status, "Unable to decode stream #%d", stream->inputStream->index);
+            break;
+        }
+
+        status = stream_receive_frames(stream, frame);
+    }
+
+    if (status >= 0 && transcoder_is_aborted(transcoder) == false) {
+        avcodec_send_packet(stream->decoderContext, NULL);
+        status = stream_receive_frames(stream, frame);
+    }
+
+    if (status >= 0 && transcoder_is_aborted(transcoder) == false && stream->filterGraph) {
+        status = av_buffersrc_add_frame_flags(stream->bufferContext, NULL, 0);
+
+        if (status >= 0) {
+            status = stream_drain_filter_graph(stream);
+        }
+        else {
+            transcoder_fail(transcoder, status, "Unable to flush stream #%d filters", stream->inputStream->index);
+        }
+    }
+
+    av_frame_free(&frame);
+
+    rdmpeg_transcoder_queue_finish(stream->frames);
+
+    return NULL;
+}
+
+static int stream_receive_frames(RDMPEGTranscoderStream *stream, AVFrame *frame) {
+    while (true) {
+        int status = avcodec_receive_frame(stream->decoderContext, frame);
+
+        if (status == AVERROR(EAGAIN) || status == AVERROR_EOF) {
+            return 0;
+        }
+
+        if (status == AVERROR_INVALIDDATA) {
+            continue;
+        }
+
+        if (status < 0) {
+            transcoder_fail(stream->transcoder, status, "Unable to decode stream #%d", stream->inputStream->index);
+            return status;
+        }
+
+        int64_t pts = frame->best_effort_timestamp;
+
+        // Frames between the keyframe job seeked to and job start, and the ones decoded past the end
+        if (pts != AV_NOPTS_VALUE && (pts < stream->startPts || pts >= stream->endPts)) {
+            av_frame_unref(frame);
+            continue;
+        }
+
+        frame->pts = pts != AV_NOPTS_VALUE ? pts - stream->startPts : AV_NOPTS_VALUE;
+
+        status = stream_filter_frame(stream, frame);
+        if (status < 0) {
+            return status;
+        }
+    }
+}
+
+// MARK: - Filters
+
+static int stream_filter_frame(RDMPEGTranscoderStream *stream, AVFrame *frame) {
+    RDMPEGTranscoder *transcoder = stream->transcoder;
+    int status = 0;
+
+    if (stream->filterGraph && stream_filter_graph_matches(stream, frame) == false) {
+        // Frames buffered by the old graph go out before the new graph is built
+        status = av_buffersrc_add_frame_flags(stream->bufferContext, NULL, 0);
+
+        if (status >= 0) {
+            status = stream_drain_filter_graph(stream);
+        }
+
+        if (status < 0) {
+            av_frame_unref(frame);
+            return status;
+        }
+
+        avfilter_graph_free(&stream->filterGraph);
+    }
+
+    if (stream->filterGraph == NULL) {
+        status = stream_configure_filter_graph(stream, frame);
+
+        if (status < 0) {
+            av_frame_unref(frame);
+            return status;
+        }
+    }
+
+    // Buffer source takes frame's references, frame is left blank for the next decoded one
+    status = av_buffersrc_add_frame_flags(stream->bufferContext, frame, 0);
+    if (status < 0) {
+        av_frame_unref(frame);
+        transcoder_fail(transcoder, status, "Unable to filter stream #%d", stream->inputStream->index);
+        return status;
+    }
+
+    return stream_drain_filter_graph(stream);
+}
+
+static int stream_drain_filter_graph(RDMPEGTranscoderStream *stream) {
+    RDMPEGTranscoder *transcoder = stream->transcoder;
+
+    while (true) {
+        AVFrame *filteredFrame = av_frame_alloc();
+        if (filteredFrame == NULL) {
+            transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate frame");
+            return AVERROR(ENOMEM);
+        }
+
+        int status = av_buffersink_get_frame(stream->buffersinkContext, filteredFrame);
+
+        if (status == AVERROR(EAGAIN) || status == AVERROR_EOF) {
+            av_frame_free(&filteredFrame);
+            return 0;
+        }
+
+        if (status < 0) {
+            av_frame_free(&filteredFrame);
+            transcoder_fail(transcoder, status, "Unable to filter stream #%d", stream->inputStream->index);
+            return status;
+        }
+
+        if (rdmpeg_transcoder_queue_push(stream->frames, filteredFrame) == false) {
+            return AVERROR_EXIT;
+        }
+    }
+}
+
+static bool stream_filter_graph_matches(RDMPEGTranscoderStream *stream, const AVFrame *frame) {
+    if (stream->type == AVMEDIA_TYPE_VIDEO) {
+        return stream->filterWidth == frame->width &&
+               stream->filterHeight == frame->height &&
+               stream->filterFormat == frame->format;
+    }
+
+    return stream->filterSampleRate == frame->sample_rate &&
+           stream->filterFormat == frame->format &&
+           stream->filterChannelLayout == frame_channel_layout(frame);
+}
+
+static int stream_configure_filter_graph(RDMPEGTranscoderStream *stream, const AVFrame *frame) {
+    RDMPEGTranscoder *transcoder = stream->transcoder;
+    bool isVideo = stream->type == AVMEDIA_TYPE_VIDEO;
+    AVRational timeBase = stream->inputStream->time_base;
+    char args[512];
+
+    if (isVideo) {
+        AVRational sampleAspectRatio = frame->sample_aspect_ratio;
+
+        snprintf(args, sizeof(args),
+                 "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
+                 frame->width, frame->height, frame->format, timeBase.num, timeBase.den,
+                 sampleAspectRatio.num, FFMAX(sampleAspectRatio.den, 1));
+    }
+    else {
+        snprintf(args, sizeof(args),
+                 "time_base=%d/%d:sample_rate=%d:sample_fmt=%s:channel_layout=0x%" PRIx64,
+                 timeBase.num, timeBase.den, frame->sample_rate,
+                 av_get_sample_fmt_name(frame->format), frame_channel_layout(frame));
+    }
+
+    stream->filterGraph = avfilter_graph_alloc();
+    if (stream->filterGraph == NULL) {
+        transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate filter graph");
+        return AVERROR(ENOMEM);
+    }
+
+    // Threads are already busy with other stages
+    stream->filterGraph->nb_threads = 1;
+
+    int status = avfilter_graph_create_filter(&stream->bufferContext,
+                                              avfilter_get_by_name(isVideo ? "buffer" : "abuffer"),
+                                              "in", args, NULL, stream->filterGraph);
+
+    if (status >= 0) {
+        status = avfilter_graph_create_filter(&stream->buffersinkContext,
+                                              avfilter_get_by_name(isVideo ? "buffersink" : "abuffersink"),
+                                              "out", NULL, NULL, stream->filterGraph);
+    }
+
+    AVFilterInOut *inputs = NULL;
+    AVFilterInOut *outputs = NULL;
+
+    if (status >= 0) {
+        inputs = avfilter_inout_alloc();
+        outputs = avfilter_inout_alloc();
+
+        if (inputs == NULL || outputs == NULL) {
+            status = AVERROR(ENOMEM);
+        }
+    }
+
+    if (status >= 0) {
+        outputs->name = av_strdup("in");
+        outputs->filter_ctx = stream->bufferContext;
+        outputs->pad_idx = 0;
+        outputs->next = NULL;
+
+        inputs->name = av_strdup("out");
+        inputs->filter_ctx = stream->buffersinkContext;
+        inputs->pad_idx = 0;
+        inputs->next = NULL;
+
+        status = avfilter_graph_parse_ptr(stream->filterGraph, stream->filterDescription, &inputs, &outputs, NULL);
+    }
+
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+
+    if (status >= 0) {
+        status = avfilter_graph_config(stream->filterGraph, NULL);
+    }
+
+    if (status < 0) {
+        avfilter_graph_free(&stream->filterGraph);
+        transcoder_fail(transcoder, status, "Unable to configure stream #%d filters \"%s\"",
+                        stream->inputStream->index, stream->filterDescription);
+        return status;
+    }
+
+    AVCodecContext *encoderContext = stream->encoderContext;
+
+    // Encoders with fixed frame size get exactly that many samples, the last frame may be shorter
+    if (isVideo == false &&
+        encoderContext->frame_size > 0 &&
+        (encoderContext->codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE) == 0) {
+        av_buffersink_set_frame_size(stream->buffersinkContext, (unsigned)encoderContext->frame_size);
+    }
+
+    stream->filterWidth = frame->width;
+    stream->filterHeight = frame->height;
+    stream->filterFormat = frame->format;
+    stream->filterSampleRate = frame->sample_rate;
+    stream->filterChannelLayout = isVideo ? 0 : frame_channel_layout(frame);
+
+    return 0;
+}
+
+// MARK: - Channel layouts
+
+// FFmpeg 5.1 moved channel layouts to AVChannelLayout and 7.0 removed channel masks, system FFmpeg of current
+// Linux distributions has only the former. Transcoder keeps working with masks, helpers below translate them.
+
+#ifdef AV_CHANNEL_LAYOUT_MASK
+// Layouts in other than native order have no mask, default layout of their channels count stands in for them
+static uint64_t channel_layout_mask(const AVChannelLayout *layout) {
+    if (layout->order == AV_CHANNEL_ORDER_NATIVE) {
+        return layout->u.mask;
+    }
+
+    return default_channel_layout(layout->nb_channels);
+}
+#endif
+
+static uint64_t default_channel_layout(int channelsCount) {
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    AVChannelLayout layout;
+    av_channel_layout_default(&layout, channelsCount);
+    return layout.order == AV_CHANNEL_ORDER_NATIVE ? layout.u.mask : 0;
+#else
+    return (uint64_t)av_get_default_channel_layout(channelsCount);
+#endif
+}
+
+// Layout the encoder supports: the same one, otherwise the first one with as many channels, otherwise its first one
+static uint64_t encoder_channel_layout(const AVCodec *encoder, uint64_t channelLayout, int channelsCount) {
+    uint64_t supportedChannelLayout = 0;
+    uint64_t firstChannelLayout = 0;
+
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    if (encoder->ch_layouts == NULL) {
+        return channelLayout;
+    }
+
+    for (const AVChannelLayout *encoderLayout = encoder->ch_layouts;
+         encoderLayout->nb_channels != 0;
+         encoderLayout++) {
+        uint64_t layout = channel_layout_mask(encoderLayout);
+#else
+    if (encoder->channel_layouts == NULL) {
+        return channelLayout;
+    }
+
+    for (const uint64_t *encoderLayout = encoder->channel_layouts; *encoderLayout != 0; encoderLayout++) {
+        uint64_t layout = *encoderLayout;
+#endif
+        if (firstChannelLayout == 0) {
+            firstChannelLayout = layout;
+        }
+
+        if (layout == channelLayout) {
+            return layout;
+        }
+
+        if (supportedChannelLayout == 0 && av_popcount64(layout) == channelsCount) {
+            supportedChannelLayout = layout;
+        }
+    }
+
+    return supportedChannelLayout != 0 ? supportedChannelLayout : firstChannelLayout;
+}
+
+static int codec_context_channels_count(const AVCodecContext *context) {
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    return context->ch_layout.nb_channels;
+#else
+    return context->channels;
+#endif
+}
+
+// 0 if the layout is unknown
+static uint64_t codec_context_channel_layout(const AVCodecContext *context) {
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    return context->ch_layout.order == AV_CHANNEL_ORDER_NATIVE ? context->ch_layout.u.mask : 0;
+#else
+    return context->channel_layout;
+#endif
+}
+
+static void codec_context_set_channel_layout(AVCodecContext *context, uint64_t channelLayout) {
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    av_channel_layout_uninit(&context->ch_layout);
+    av_channel_layout_from_mask(&context->ch_layout, channelLayout);
+#else
+    context->channel_layout = channelLayout;
+    context->channels = av_get_channel_layout_nb_channels(channelLayout);
+#endif
+}
+
+static uint64_t frame_channel_layout(const AVFrame *frame) {
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    return channel_layout_mask(&frame->ch_layout);
+#else
+    if (frame->channel_layout != 0) {
+        return frame->channel_layout;
+    }
+
+    return (uint64_t)av_get_default_channel_layout(frame->channels);
+#endif
+}
+
+// MARK: - Encoder
+
+static void *encode_thread(void *context) {
+    RDMPEGTranscoderStream *stream = context;
+    RDMPEGTranscoder *transcoder = stream->transcoder;
+    AVCodecContext *encoderContext = stream->encoderContext;
+    AVFrame *frame = NULL;
+    int status = 0;
+
+    while ((frame = rdmpeg_transcoder_queue_pop(stream->frames))) {
+        if (frame->pts != AV_NOPTS_VALUE) {
+            frame->pts = av_rescale_q(frame->pts, stream->filterTimeBase, encoderContext->time_base);
+
+            // Coarser encoder time base may round neighbour frames of variable frame rate video to the same pts
+            if (stream->lastEncoderPts != AV_NOPTS_VALUE && frame->pts <= stream->lastEncoderPts) {
+                frame->pts = stream->lastEncoderPts + 1;
+            }
+
+            stream->lastEncoderPts = frame->pts;
+        }
+
+        // Let encoder choose frame types rather than follow the source
+        frame->pict_type = AV_PICTURE_TYPE_NONE;
+
+        status = avcodec_send_frame(encoderContext, frame);
+        av_frame_free(&frame);
+
+        if (status < 0) {
+            transcoder_fail(transcoder, status, "Unable to encode stream #%d", stream->inputStream->index);
+            break;
+        }
+
+        status = stream_receive_packets(stream);
+        if (status < 0) {
+            break;
+        }
+    }
+
+    if (status >= 0 && transcoder_is_aborted(transcoder) == false) {
+        avcodec_send_frame(encoderContext, NULL);
+        stream_receive_packets(stream);
+    }
+
+    rdmpeg_transcoder_queue_finish(transcoder->muxQueue);
+
+    return NULL;
+}
+
+static int stream_receive_packets(RDMPEGTranscoderStream *stream) {
+    RDMPEGTranscoder *transcoder = stream->transcoder;
+
+    while (true) {
+        AVPacket *packet = av_packet_alloc();
+        if (packet == NULL) {
+            transcoder_fail(transcoder, AVERROR(ENOMEM), "Unable to allocate packet");
+            return AVERROR(ENOMEM);
+        }
+
+        int status = avcodec_receive_packet(stream->encoderContext, packet);
+
+        if (status == AVERROR(EAGAIN) || status == AVERROR_EOF) {
+            av_packet_free(&packet);
+            return 0;
+        }
+
+        if (status < 0) {
+            av_packet_free(&packet);
+            transcoder_fail(transcoder, status, "Unable to encode stream #%d", stream->inputStream->index);
+            return status;
+        }
+
+        packet->stream_index = stream->outputStream->index;
+
+        if (rdmpeg_transcoder_queue_push(transcoder->muxQueue, packet) == false) {
+            return AVERROR_EXIT;
+        }
+    }
+}
+
+// MARK: - Muxer
+
+static int transcoder_mux(RDMPEGTranscoder *transcoder,
+                          RDMPEGTranscoderProgressCallback progressCallback,
+                          void *progressContext) {
+    AVFormatContext *outputContext = transcoder->outputContext;
+    RDMPEGTranscoderProgress *progress = &transcoder->progress;
+    double reportedTime = -RDMPEG_TRANSCODER_PROGRESS_INTERVAL;
+    AVPacket *packet = NULL;
+
+    while ((packet = rdmpeg_transcoder_queue_pop(transcoder->muxQueue))) {
+        RDMPEGTranscoderStream *stream = transcoder_stream_for_output(transcoder, packet->stream_index);
+        AVStream *outputStream = stream->outputStream;
+
+        av_packet_rescale_ts(packet, stream->packetTimeBase, outputStream->time_base);
+
+        int64_t timestamp = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+
+        if (timestamp != AV_NOPTS_VALUE) {
+            progress->time = FFMAX(progress->time, timestamp * av_q2d(outputStream->time_base));
+        }
+
+        stream->muxedPacketsCount++;
+
+        // Muxer takes packet's references
+        int status = av_interleaved_write_frame(outputContext, packet);
+        av_packet_free(&packet);
+
+        if (status < 0) {
+            transcoder_fail(transcoder, status, "Unable to write %s", outputContext->url);
+            return status;
+        }
+
+        if (progressCallback && progress->time - reportedTime >= RDMPEG_TRANSCODER_PROGRESS_INTERVAL) {
+            reportedTime = progress->time;
+            transcoder_report_progress(transcoder, progressCallback, progressContext);
+        }
+    }
+
+    // Queue ends early only when some stage failed or job was cancelled
+    if (transcoder_is_aborted(transcoder)) {
+        return AVERROR_EXIT;
+    }
+
+    int status = av_write_trailer(outputContext);
+    if (status < 0) {
+        transcoder_fail(transcoder, status, "Unable to finish %s", outputContext->url);
+        return status;
+    }
+
+    if (outputContext->pb) {
+        avio_flush(outputContext->pb);
+    }
+
+    if (progressCallback) {
+        transcoder_report_progress(transcoder, progressCallback, progressContext);
+    }
+
+    return 0;
+}
+
+static void transcoder_report_progress(RDMPEGTranscoder *transcoder,
+                                       RDMPEGTranscoderProgressCallback progressCallback,
+                                       void *progressContext) {
+    AVFormatContext *outputContext = transcoder->outputContext;
+    RDMPEGTranscoderProgress *progress = &transcoder->progress;
+
+    for (int i = 0; i < transcoder->streamsCount; i++) {
+        if (transcoder->streams[i].type == AVMEDIA_TYPE_VIDEO) {
+            progress->videoFramesCount = transcoder->streams[i].muxedPacketsCount;
+        }
+        else {
+            progress->audioFramesCount = transcoder->streams[i].muxedPacketsCount;
+        }
+    }
+
+    progress->bytesWritten = outputContext->pb ? avio_tell(outputContext->pb) : 0;
+    progress->elapsedTime = (double)(av_gettime_relative() - transcoder->startedAt) / AV_TIME_BASE;
+
+    progressCallback(progress, progressContext);
+}
+
+// MARK: - Queue items
+
+static void packet_free(void *item) {
+    AVPacket *packet = item;
+    av_packet_free(&packet);
+}
+
+static void frame_free(void *item) {
+    AVFrame *frame = item;
+    av_frame_free(&frame);
+}
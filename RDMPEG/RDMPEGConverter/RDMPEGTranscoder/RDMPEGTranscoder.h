@@ -0,0 +1,118 @@
+//
+//  RDMPEGTranscoder.h
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGTranscoder_h
+#define RDMPEGTranscoder_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// In-process transcoder on libav*, plain C so it builds and is tested on Linux too.
+//
+// Job takes the best (or chosen) video and audio stream of the input, each is either transcoded, copied as is
+// or dropped. Stages run on their own threads: demuxer, decoder + filter and encoder of every transcoded stream,
+// and muxer on the thread which runs the job. Stages hand refcounted packets and frames to each other through
+// bounded queues, so frame data is never copied between them and memory stays bounded.
+// Progress is reported from pts of muxed packets.
+
+// Same as AVERROR_EXIT
+#define RDMPEG_TRANSCODER_CANCELLED (-0x54495845)
+
+// Swift imports the enum as a closed enum, the way it does NS_ENUM
+#if defined(__has_attribute) && __has_attribute(enum_extensibility)
+#define RDMPEG_TRANSCODER_CLOSED_ENUM __attribute__((enum_extensibility(closed)))
+#else
+#define RDMPEG_TRANSCODER_CLOSED_ENUM
+#endif
+
+typedef struct RDMPEGTranscoder RDMPEGTranscoder;
+
+typedef enum RDMPEG_TRANSCODER_CLOSED_ENUM RDMPEGTranscoderStreamMode {
+    RDMPEGTranscoderStreamModeTranscode = 0,
+    RDMPEGTranscoderStreamModeCopy,
+    RDMPEGTranscoderStreamModeDrop,
+} RDMPEGTranscoderStreamMode;
+
+// Zero fields keep source parameters (or encoder defaults for bit rate and GOP size)
+typedef struct RDMPEGTranscoderVideoSettings {
+    RDMPEGTranscoderStreamMode mode;
+    // Stream index in the input, -1 picks the best one. Missing stream isn't an error unless index was given
+    int streamIndex;
+    // NULL picks default encoder of the output format
+    const char *encoderName;
+    // When only one dimension is set the other one keeps aspect ratio
+    int width;
+    int height;
+    int64_t bitRate;
+    int gopSize;
+    // Private encoder options, "key=value:key=value" (e.g. "preset=veryfast:crf=23")
+    const char *encoderOptions;
+} RDMPEGTranscoderVideoSettings;
+
+typedef struct RDMPEGTranscoderAudioSettings {
+    RDMPEGTranscoderStreamMode mode;
+    int streamIndex;
+    const char *encoderName;
+    int sampleRate;
+    int channelsCount;
+    int64_t bitRate;
+    const char *encoderOptions;
+} RDMPEGTranscoderAudioSettings;
+
+typedef int (*RDMPEGTranscoderReadCallback)(void *context, uint8_t *buffer, int size);
+typedef int64_t (*RDMPEGTranscoderSeekCallback)(void *context, int64_t offset, int whence);
+
+typedef struct RDMPEGTranscoderJob {
+    // Used for probing and logging when input is read through callbacks
+    const char *inputPath;
+    const char *outputPath;
+    // NULL guesses output format from outputPath extension
+    const char *formatName;
+    // Seconds, output starts at startTime and lasts duration (0 goes to the end of input)
+    double startTime;
+    double duration;
+    RDMPEGTranscoderVideoSettings video;
+    RDMPEGTranscoderAudioSettings audio;
+    // Optional custom input (AVIOContext read and seek semantics), e.g. RDMPEGIOStream sharing player's cache.
+    // Callbacks are called from demuxer thread
+    RDMPEGTranscoderReadCallback readCallback;
+    RDMPEGTranscoderSeekCallback seekCallback;
+    void *ioContext;
+} RDMPEGTranscoderJob;
+
+typedef struct RDMPEGTranscoderProgress {
+    // Seconds of output muxed so far, from packet pts
+    double time;
+    // Expected output duration, 0 when unknown
+    double duration;
+    int64_t videoFramesCount;
+    int64_t audioFramesCount;
+    int64_t bytesWritten;
+    // Wall clock seconds since the job started
+    double elapsedTime;
+} RDMPEGTranscoderProgress;
+
+// Called from the thread which runs the job
+typedef void (*RDMPEGTranscoderProgressCallback)(const RDMPEGTranscoderProgress *progress, void *context);
+
+// Job (including its strings) is copied. Returns NULL when out of memory
+RDMPEGTranscoder *rdmpeg_transcoder_create(const RDMPEGTranscoderJob *job);
+void rdmpeg_transcoder_destroy(RDMPEGTranscoder *transcoder);
+
+// Runs the job to the end on the calling thread, may be called once. Returns 0, RDMPEG_TRANSCODER_CANCELLED
+// or another negative AVERROR code. Incomplete output file is left as is on failure
+int rdmpeg_transcoder_run(RDMPEGTranscoder *transcoder,
+                          RDMPEGTranscoderProgressCallback progressCallback,
+                          void *progressContext);
+
+// May be called from any thread at any time, running job stops as soon as its stages notice
+void rdmpeg_transcoder_cancel(RDMPEGTranscoder *transcoder);
+
+// Human readable description of the failure, empty when job didn't fail
+const char *rdmpeg_transcoder_error_message(RDMPEGTranscoder *transcoder);
+
+#endif /* RDMPEGTranscoder_h */
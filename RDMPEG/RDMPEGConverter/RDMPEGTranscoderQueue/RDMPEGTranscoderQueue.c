@@ -0,0 +1,136 @@
+//
+//  RDMPEGTranscoderQueue.c
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGTranscoderQueue.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+struct RDMPEGTranscoderQueue {
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+    RDMPEGTranscoderQueueItemFree itemFree;
+    void **items;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    int producersCount;
+    bool aborted;
+};
+
+// MARK: - Lifecycle
+
+RDMPEGTranscoderQueue *rdmpeg_transcoder_queue_create(size_t capacity,
+                                                      int producersCount,
+                                                      RDMPEGTranscoderQueueItemFree itemFree) {
+    RDMPEGTranscoderQueue *queue = calloc(1, sizeof(RDMPEGTranscoderQueue));
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    queue->items = calloc(capacity > 0 ? capacity : 1, sizeof(void *));
+    if (queue->items == NULL) {
+        free(queue);
+        return NULL;
+    }
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->notEmpty, NULL);
+    pthread_cond_init(&queue->notFull, NULL);
+    queue->itemFree = itemFree;
+    queue->capacity = capacity > 0 ? capacity : 1;
+    queue->producersCount = producersCount;
+
+    return queue;
+}
+
+void rdmpeg_transcoder_queue_destroy(RDMPEGTranscoderQueue *queue) {
+    if (queue == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < queue->count; i++) {
+        queue->itemFree(queue->items[(queue->head + i) % queue->capacity]);
+    }
+
+    pthread_cond_destroy(&queue->notFull);
+    pthread_cond_destroy(&queue->notEmpty);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->items);
+    free(queue);
+}
+
+// MARK: - Producer
+
+bool rdmpeg_transcoder_queue_push(RDMPEGTranscoderQueue *queue, void *item) {
+    pthread_mutex_lock(&queue->lock);
+
+    while (queue->count == queue->capacity && queue->aborted == false) {
+        pthread_cond_wait(&queue->notFull, &queue->lock);
+    }
+
+    if (queue->aborted) {
+        pthread_mutex_unlock(&queue->lock);
+        queue->itemFree(item);
+        return false;
+    }
+
+    queue->items[(queue->head + queue->count) % queue->capacity] = item;
+    queue->count++;
+
+    pthread_cond_signal(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->lock);
+
+    return true;
+}
+
+void rdmpeg_transcoder_queue_finish(RDMPEGTranscoderQueue *queue) {
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->producersCount > 0) {
+        queue->producersCount--;
+    }
+
+    if (queue->producersCount == 0) {
+        pthread_cond_broadcast(&queue->notEmpty);
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+}
+
+// MARK: - Consumer
+
+void *rdmpeg_transcoder_queue_pop(RDMPEGTranscoderQueue *queue) {
+    pthread_mutex_lock(&queue->lock);
+
+    while (queue->count == 0 && queue->producersCount > 0 && queue->aborted == false) {
+        pthread_cond_wait(&queue->notEmpty, &queue->lock);
+    }
+
+    void *item = NULL;
+
+    if (queue->count > 0 && queue->aborted == false) {
+        item = queue->items[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        pthread_cond_signal(&queue->notFull);
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+
+    return item;
+}
+
+void rdmpeg_transcoder_queue_abort(RDMPEGTranscoderQueue *queue) {
+    pthread_mutex_lock(&queue->lock);
+
+    queue->aborted = true;
+    pthread_cond_broadcast(&queue->notEmpty);
+    pthread_cond_broadcast(&queue->notFull);
+
+    pthread_mutex_unlock(&queue->lock);
+}
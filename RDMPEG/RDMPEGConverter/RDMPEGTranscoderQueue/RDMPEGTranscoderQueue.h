@@ -0,0 +1,40 @@
+//
+//  RDMPEGTranscoderQueue.h
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGTranscoderQueue_h
+#define RDMPEGTranscoderQueue_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bounded blocking FIFO handing items (AVPacket / AVFrame pointers) between RDMPEGTranscoder stages.
+// Queue takes ownership of pushed items and gives it away on pop, so stages pass refcounted buffers along
+// without copying them. Full queue blocks producers, which keeps fast stages from running ahead of slow ones.
+// Any number of producers and consumers, queue ends when every producer finished or it's aborted.
+
+typedef struct RDMPEGTranscoderQueue RDMPEGTranscoderQueue;
+
+typedef void (*RDMPEGTranscoderQueueItemFree)(void *item);
+
+// Items left in the queue when it's destroyed are released with itemFree. Returns NULL when out of memory
+RDMPEGTranscoderQueue *rdmpeg_transcoder_queue_create(size_t capacity,
+                                                      int producersCount,
+                                                      RDMPEGTranscoderQueueItemFree itemFree);
+void rdmpeg_transcoder_queue_destroy(RDMPEGTranscoderQueue *queue);
+
+// Blocks while queue is full. Returns false (item is released) if queue was aborted
+bool rdmpeg_transcoder_queue_push(RDMPEGTranscoderQueue *queue, void *item);
+// Called once by each producer when it has nothing more to push
+void rdmpeg_transcoder_queue_finish(RDMPEGTranscoderQueue *queue);
+
+// Blocks while queue is empty. Returns NULL when all producers finished and queue is drained, or queue was aborted
+void *rdmpeg_transcoder_queue_pop(RDMPEGTranscoderQueue *queue);
+
+// Wakes up all blocked producers and consumers, further pushes and pops fail. May be called from any thread
+void rdmpeg_transcoder_queue_abort(RDMPEGTranscoderQueue *queue);
+
+#endif /* RDMPEGTranscoderQueue_h */
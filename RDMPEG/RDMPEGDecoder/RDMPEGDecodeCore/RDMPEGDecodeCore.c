@@ -0,0 +1,512 @@
+//
+//  RDMPEGDecodeCore.c
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGDecodeCore.h"
+#include <string.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
+#if defined(__APPLE__)
+#include <Accelerate/Accelerate.h>
+#endif
+
+static int64_t stream_timestamp(const AVStream *stream, double timeBase, double position);
+static int deinterlacer_link(AVFilterGraph *graph, AVFilterContext *bufferContext, AVFilterContext *buffersinkContext);
+static SwrContext *resampler_alloc(uint64_t outputLayout,
+                                   enum AVSampleFormat outputSampleFormat,
+                                   int outputSampleRate,
+                                   uint64_t inputLayout,
+                                   enum AVSampleFormat inputSampleFormat,
+                                   int inputSampleRate);
+static uint64_t layout_channel(uint64_t channelLayout, int channelIndex);
+
+// MARK: - Streams
+
+void rdmpeg_decode_core_stream_fps_timebase(const AVStream *stream,
+                                            double defaultTimeBase,
+                                            double *fps,
+                                            double *timeBase) {
+    double streamFPS;
+    double streamTimeBase;
+
+    if (stream->time_base.den && stream->time_base.num) {
+        streamTimeBase = av_q2d(stream->time_base);
+    }
+    else {
+        av_log(NULL, AV_LOG_WARNING, "Default timebase used: %f\n", defaultTimeBase);
+        streamTimeBase = defaultTimeBase;
+    }
+
+    if (stream->avg_frame_rate.den && stream->avg_frame_rate.num) {
+        streamFPS = av_q2d(stream->avg_frame_rate);
+    }
+    else if (stream->r_frame_rate.den && stream->r_frame_rate.num) {
+        streamFPS = av_q2d(stream->r_frame_rate);
+    }
+    else {
+        streamFPS = 1.0 / streamTimeBase;
+        av_log(NULL, AV_LOG_WARNING, "Default fps used: %f\n", streamFPS);
+    }
+
+    if (fps) {
+        *fps = streamFPS;
+    }
+    if (timeBase) {
+        *timeBase = streamTimeBase;
+    }
+}
+
+double rdmpeg_decode_core_frame_position(const AVStream *stream, double timeBase, const AVFrame *frame) {
+    double offset = stream->start_time != AV_NOPTS_VALUE ? stream->start_time * timeBase : 0.0;
+
+    return frame->best_effort_timestamp * timeBase - offset;
+}
+
+int rdmpeg_decode_core_seek(AVFormatContext *formatContext, int streamIndex, double timeBase, double position) {
+    int64_t ts = stream_timestamp(formatContext->streams[streamIndex], timeBase, position);
+
+    return avformat_seek_file(formatContext, streamIndex, ts, ts, ts, AVSEEK_FLAG_FRAME);
+}
+
+int rdmpeg_decode_core_seek_keyframe(AVFormatContext *formatContext,
+                                     int streamIndex,
+                                     double timeBase,
+                                     double position) {
+    int64_t ts = stream_timestamp(formatContext->streams[streamIndex], timeBase, position);
+
+    return avformat_seek_file(formatContext, streamIndex, INT64_MIN, ts, ts, 0);
+}
+
+static int64_t stream_timestamp(const AVStream *stream, double timeBase, double position) {
+    int64_t ts = (int64_t)(position / timeBase);
+
+    if (stream->start_time != AV_NOPTS_VALUE) {
+        ts += stream->start_time;
+    }
+
+    return ts;
+}
+
+// MARK: - Video
+
+int rdmpeg_decode_core_is_keyframe(const AVFrame *frame) {
+#ifdef AV_FRAME_FLAG_KEY
+    int isKeyframe = (frame->flags & AV_FRAME_FLAG_KEY) != 0;
+#else
+    int isKeyframe = frame->key_frame != 0;
+#endif
+
+    return isKeyframe || frame->pict_type == AV_PICTURE_TYPE_I;
+}
+
+int rdmpeg_decode_core_is_yuv_format(enum AVPixelFormat pixelFormat) {
+    return pixelFormat == AV_PIX_FMT_YUV420P || pixelFormat == AV_PIX_FMT_YUVJ420P;
+}
+
+size_t rdmpeg_decode_core_plane_size(int linesize, int width, int height) {
+    return (size_t)FFMIN(linesize, width) * (size_t)height;
+}
+
+void rdmpeg_decode_core_copy_plane(uint8_t *destination, const uint8_t *source, int linesize, int width, int height) {
+    width = FFMIN(linesize, width);
+
+    for (int i = 0; i < height; ++i) {
+        memcpy(destination, source, (size_t)width);
+        destination += width;
+        source += linesize;
+    }
+}
+
+AVFilterGraph *rdmpeg_decode_core_deinterlacer_create(const AVCodecContext *codecContext) {
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    if (graph == NULL) {
+        return NULL;
+    }
+
+    char args[512];
+    snprintf(args, sizeof(args),
+             "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
+             codecContext->width,
+             codecContext->height,
+             codecContext->pix_fmt,
+             codecContext->time_base.num,
+             codecContext->time_base.den,
+             codecContext->sample_aspect_ratio.num,
+             codecContext->sample_aspect_ratio.den);
+
+    AVFilterContext *bufferContext = NULL;
+    AVFilterContext *buffersinkContext = NULL;
+
+    int status = avfilter_graph_create_filter(&bufferContext, avfilter_get_by_name("buffer"), "in", args, NULL, graph);
+    if (status < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Create in filter error: %s\n", av_err2str(status));
+        avfilter_graph_free(&graph);
+        return NULL;
+    }
+
+    status = avfilter_graph_create_filter(&buffersinkContext, avfilter_get_by_name("buffersink"), "out", NULL, NULL,
+                                          graph);
+    if (status < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Create out filter error: %s\n", av_err2str(status));
+        avfilter_graph_free(&graph);
+        return NULL;
+    }
+
+    if ((status = deinterlacer_link(graph, bufferContext, buffersinkContext)) < 0 ||
+        (status = avfilter_graph_config(graph, NULL)) < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Configure deinterlacer error: %s\n", av_err2str(status));
+        avfilter_graph_free(&graph);
+        return NULL;
+    }
+
+    return graph;
+}
+
+static int deinterlacer_link(AVFilterGraph *graph, AVFilterContext *bufferContext, AVFilterContext *buffersinkContext) {
+    AVFilterInOut *inputs = avfilter_inout_alloc();
+    AVFilterInOut *outputs = avfilter_inout_alloc();
+
+    if (inputs == NULL || outputs == NULL) {
+        avfilter_inout_free(&inputs);
+        avfilter_inout_free(&outputs);
+        return AVERROR(ENOMEM);
+    }
+
+    outputs->name = av_strdup("in");
+    outputs->filter_ctx = bufferContext;
+    outputs->pad_idx = 0;
+    outputs->next = NULL;
+
+    inputs->name = av_strdup("out");
+    inputs->filter_ctx = buffersinkContext;
+    inputs->pad_idx = 0;
+    inputs->next = NULL;
+
+    int status = avfilter_graph_parse_ptr(graph, "yadif=0:-1:0", &inputs, &outputs, NULL);
+
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+
+    return status;
+}
+
+AVFrame *rdmpeg_decode_core_bgra_frame_create(const AVCodecContext *codecContext) {
+    AVFrame *frame = av_frame_alloc();
+    if (frame == NULL) {
+        return NULL;
+    }
+
+    frame->width = codecContext->width;
+    frame->height = codecContext->height;
+    frame->format = AV_PIX_FMT_BGRA;
+
+    int status = av_image_alloc(frame->data, frame->linesize, frame->width, frame->height, AV_PIX_FMT_BGRA, 1);
+    if (status < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Allocate image error: %s\n", av_err2str(status));
+        av_frame_free(&frame);
+        return NULL;
+    }
+
+    return frame;
+}
+
+void rdmpeg_decode_core_bgra_frame_free(AVFrame **frame) {
+    if (*frame) {
+        av_freep(&(*frame)->data[0]);
+        av_frame_free(frame);
+    }
+}
+
+struct SwsContext *rdmpeg_decode_core_bgra_scaler(struct SwsContext *swsContext,
+                                                  const AVCodecContext *codecContext,
+                                                  const AVFrame *bgraFrame) {
+    return sws_getCachedContext(swsContext,
+                                codecContext->width,
+                                codecContext->height,
+                                codecContext->pix_fmt,
+                                bgraFrame->width,
+                                bgraFrame->height,
+                                bgraFrame->format,
+                                SWS_FAST_BILINEAR,
+                                NULL, NULL, NULL);
+}
+
+// MARK: - Audio
+
+// FFmpeg 5.1 moved channel layouts to AVChannelLayout and 7.0 removed channel masks, decode core keeps working
+// with masks of native order layouts on either
+
+int rdmpeg_decode_core_channels_count(const AVCodecContext *codecContext) {
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    return codecContext->ch_layout.nb_channels;
+#else
+    return codecContext->channels;
+#endif
+}
+
+uint64_t rdmpeg_decode_core_default_channel_layout(int channelsCount) {
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    AVChannelLayout layout;
+    av_channel_layout_default(&layout, channelsCount);
+    return layout.order == AV_CHANNEL_ORDER_NATIVE ? layout.u.mask : 0;
+#else
+    return (uint64_t)av_get_default_channel_layout(channelsCount);
+#endif
+}
+
+uint64_t rdmpeg_decode_core_channel_layout(const AVCodecContext *codecContext) {
+    int channelsCount = rdmpeg_decode_core_channels_count(codecContext);
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    uint64_t channelLayout = codecContext->ch_layout.order == AV_CHANNEL_ORDER_NATIVE ?
+        codecContext->ch_layout.u.mask :
+        0;
+#else
+    uint64_t channelLayout = codecContext->channel_layout;
+#endif
+
+    if (channelLayout == 0 || av_popcount64(channelLayout) != channelsCount) {
+        channelLayout = rdmpeg_decode_core_default_channel_layout(channelsCount);
+    }
+
+    return channelLayout;
+}
+
+int rdmpeg_decode_core_resampler_set_profile(SwrContext *swrContext, const RDMPEGResamplerProfile *profile) {
+    int status;
+
+    if ((status = av_opt_set_int(swrContext, "filter_size", profile->filterSize, 0)) < 0 ||
+        (status = av_opt_set_int(swrContext, "phase_shift", profile->phaseShift, 0)) < 0 ||
+        (status = av_opt_set_int(swrContext, "linear_interp", profile->linearInterpolation, 0)) < 0 ||
+        (status = av_opt_set_double(swrContext, "cutoff", profile->cutoff, 0)) < 0) {
+        return status;
+    }
+
+    return 0;
+}
+
+SwrContext *rdmpeg_decode_core_resampler_create(const AVCodecContext *codecContext,
+                                                int outputSampleRate,
+                                                int outputChannels,
+                                                enum AVSampleFormat outputSampleFormat,
+                                                RDMPEGDownmixLevels downmixLevels,
+                                                const RDMPEGResamplerProfile *profile) {
+    uint64_t inputLayout = rdmpeg_decode_core_channel_layout(codecContext);
+    uint64_t outputLayout = rdmpeg_decode_core_default_channel_layout(outputChannels);
+
+    SwrContext *swrContext = resampler_alloc(outputLayout,
+                                             outputSampleFormat,
+                                             outputSampleRate,
+                                             inputLayout,
+                                             codecContext->sample_fmt,
+                                             codecContext->sample_rate);
+    if (swrContext == NULL) {
+        return NULL;
+    }
+
+    if (rdmpeg_decode_core_resampler_set_profile(swrContext, profile) < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Unable to set audio resampler %s profile\n", profile->name);
+    }
+
+    const int inputChannels = av_popcount64(inputLayout);
+    double downmixMatrix[2 * RDMPEG_DOWNMIX_MAX_CHANNELS];
+
+    if (rdmpeg_downmix_matrix(inputLayout, outputLayout, downmixLevels, downmixMatrix, inputChannels)) {
+        int status = swr_set_matrix(swrContext, downmixMatrix, inputChannels);
+        if (status < 0) {
+            av_log(NULL, AV_LOG_ERROR, "Set audio downmix matrix error: %s\n", av_err2str(status));
+        }
+
+        av_log(NULL, AV_LOG_DEBUG, "Audio downmix 0x%llx -> 0x%llx\n",
+               (unsigned long long)inputLayout, (unsigned long long)outputLayout);
+    }
+
+    if (swr_init(swrContext) < 0) {
+        swr_free(&swrContext);
+        return NULL;
+    }
+
+    return swrContext;
+}
+
+int rdmpeg_decode_core_resample(SwrContext *swrContext,
+                                const AVCodecContext *codecContext,
+                                const AVFrame *frame,
+                                int outputSampleRate,
+                                int outputChannels,
+                                uint8_t **buffer,
+                                int *bufferSize) {
+    // Room for upsampling and upmixing, with the same margin again for samples resampler holds back
+    const int ratio = FFMAX(1, outputSampleRate / codecContext->sample_rate) *
+                      FFMAX(1, outputChannels / rdmpeg_decode_core_channels_count(codecContext)) * 2;
+
+    const int requiredSize = av_samples_get_buffer_size(NULL,
+                                                        outputChannels,
+                                                        frame->nb_samples * ratio,
+                                                        AV_SAMPLE_FMT_S16,
+                                                        1);
+    if (requiredSize < 0) {
+        return requiredSize;
+    }
+
+    if (*buffer == NULL || *bufferSize < requiredSize) {
+        uint8_t *grownBuffer = realloc(*buffer, (size_t)requiredSize);
+        if (grownBuffer == NULL) {
+            return AVERROR(ENOMEM);
+        }
+
+        *buffer = grownBuffer;
+        *bufferSize = requiredSize;
+    }
+
+    uint8_t *output[2] = {*buffer, NULL};
+
+    return swr_convert(swrContext,
+                       output,
+                       frame->nb_samples * ratio,
+                       (const uint8_t **)frame->data,
+                       frame->nb_samples);
+}
+
+SwrContext *rdmpeg_decode_core_float_converter_create(const AVCodecContext *codecContext) {
+    uint64_t channelLayout = rdmpeg_decode_core_channel_layout(codecContext);
+
+    SwrContext *swrContext = resampler_alloc(channelLayout,
+                                             AV_SAMPLE_FMT_FLT,
+                                             codecContext->sample_rate,
+                                             channelLayout,
+                                             codecContext->sample_fmt,
+                                             codecContext->sample_rate);
+    if (swrContext == NULL) {
+        return NULL;
+    }
+
+    if (swr_init(swrContext) < 0) {
+        swr_free(&swrContext);
+        return NULL;
+    }
+
+    return swrContext;
+}
+
+int rdmpeg_decode_core_convert_to_float(SwrContext *swrContext,
+                                        const AVCodecContext *codecContext,
+                                        const AVFrame *frame,
+                                        uint8_t **buffer,
+                                        int *bufferSize) {
+    // Sampling rate and layout stay the same, so converter holds no samples back
+    const int requiredSize = av_samples_get_buffer_size(NULL,
+                                                        rdmpeg_decode_core_channels_count(codecContext),
+                                                        frame->nb_samples,
+                                                        AV_SAMPLE_FMT_FLT,
+                                                        1);
+    if (requiredSize < 0) {
+        return requiredSize;
+    }
+
+    if (*buffer == NULL || *bufferSize < requiredSize) {
+        uint8_t *grownBuffer = realloc(*buffer, (size_t)requiredSize);
+        if (grownBuffer == NULL) {
+            return AVERROR(ENOMEM);
+        }
+
+        *buffer = grownBuffer;
+        *bufferSize = requiredSize;
+    }
+
+    uint8_t *output[2] = {*buffer, NULL};
+
+    return swr_convert(swrContext,
+                       output,
+                       frame->nb_samples,
+                       (const uint8_t **)frame->data,
+                       frame->nb_samples);
+}
+
+double rdmpeg_decode_core_loudness_channel_weight(uint64_t channelLayout, int channelIndex) {
+    switch (layout_channel(channelLayout, channelIndex)) {
+        case AV_CH_LOW_FREQUENCY:
+        case AV_CH_LOW_FREQUENCY_2:
+            return 0.0;
+
+        case AV_CH_SIDE_LEFT:
+        case AV_CH_SIDE_RIGHT:
+        case AV_CH_BACK_LEFT:
+        case AV_CH_BACK_RIGHT:
+            return 1.41;
+
+        default:
+            return 1.0;
+    }
+}
+
+void rdmpeg_decode_core_samples_to_float(const int16_t *samples, float *output, size_t count) {
+    const float scale = 1.0f / (float)INT16_MAX;
+
+#if defined(__APPLE__)
+    vDSP_vflt16(samples, 1, output, 1, count);
+    vDSP_vsmul(output, 1, &scale, output, 1, count);
+#else
+    for (size_t i = 0; i < count; i++) {
+        output[i] = (float)samples[i] * scale;
+    }
+#endif
+}
+
+static SwrContext *resampler_alloc(uint64_t outputLayout,
+                                   enum AVSampleFormat outputSampleFormat,
+                                   int outputSampleRate,
+                                   uint64_t inputLayout,
+                                   enum AVSampleFormat inputSampleFormat,
+                                   int inputSampleRate) {
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    // Layouts of native order made from masks own no memory, nothing to uninit
+    AVChannelLayout outputChannelLayout;
+    AVChannelLayout inputChannelLayout;
+    SwrContext *swrContext = NULL;
+
+    if (av_channel_layout_from_mask(&outputChannelLayout, outputLayout) < 0 ||
+        av_channel_layout_from_mask(&inputChannelLayout, inputLayout) < 0) {
+        return NULL;
+    }
+
+    if (swr_alloc_set_opts2(&swrContext,
+                            &outputChannelLayout,
+                            outputSampleFormat,
+                            outputSampleRate,
+                            &inputChannelLayout,
+                            inputSampleFormat,
+                            inputSampleRate,
+                            0,
+                            NULL) < 0) {
+        return NULL;
+    }
+
+    return swrContext;
+#else
+    return swr_alloc_set_opts(NULL,
+                              (int64_t)outputLayout,
+                              outputSampleFormat,
+                              outputSampleRate,
+                              (int64_t)inputLayout,
+                              inputSampleFormat,
+                              inputSampleRate,
+                              0,
+                              NULL);
+#endif
+}
+
+// Channel at the index of the layout, channels go in the order of their bits
+static uint64_t layout_channel(uint64_t channelLayout, int channelIndex) {
+    for (int bit = 0; bit < 64; bit++) {
+        uint64_t channel = 1ULL << bit;
+
+        if ((channelLayout & channel) != 0 && channelIndex-- == 0) {
+            return channel;
+        }
+    }
+
+    return 0;
+}
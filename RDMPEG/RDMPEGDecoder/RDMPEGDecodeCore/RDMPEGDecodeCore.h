@@ -0,0 +1,116 @@
+//
+//  RDMPEGDecodeCore.h
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGDecodeCore_h
+#define RDMPEGDecodeCore_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <libavcodec/avcodec.h>
+#include <libavfilter/avfilter.h>
+#include <libavformat/avformat.h>
+#include <libswresample/swresample.h>
+#include <libswscale/swscale.h>
+#include "RDMPEGDownmix.h"
+#include "RDMPEGResamplerProfile.h"
+
+// Seeks and frame conversions of RDMPEGDecoder in plain C, so the headless benchmark runs exactly the code the
+// player does rather than a copy of it. Errors are logged with av_log, which RDMPEGLogBridge forwards to Log4Cocoa.
+
+// MARK: - Streams
+
+// Stream time base, default one when stream has none, and frame rate, falling back to 1 / time base
+void rdmpeg_decode_core_stream_fps_timebase(const AVStream *stream,
+                                            double defaultTimeBase,
+                                            double *fps,
+                                            double *timeBase);
+
+// Position in seconds from the stream start of frame's best effort timestamp
+double rdmpeg_decode_core_frame_position(const AVStream *stream, double timeBase, const AVFrame *frame);
+
+// Seeks to the frame at the position, returns avformat_seek_file status
+int rdmpeg_decode_core_seek(AVFormatContext *formatContext, int streamIndex, double timeBase, double position);
+
+// Seeks to the keyframe at or before the position, returns avformat_seek_file status
+int rdmpeg_decode_core_seek_keyframe(AVFormatContext *formatContext, int streamIndex, double timeBase, double position);
+
+// MARK: - Video
+
+// Keyframe or intra frame, which decodes without the preceding ones. Leading frames of open GOP come out of decoder
+// before the keyframe they were sent after and aren't flagged.
+int rdmpeg_decode_core_is_keyframe(const AVFrame *frame);
+
+// Frames of these formats are handed over as YUV planes, others are scaled to BGRA
+int rdmpeg_decode_core_is_yuv_format(enum AVPixelFormat pixelFormat);
+
+// Bytes rdmpeg_decode_core_copy_plane writes
+size_t rdmpeg_decode_core_plane_size(int linesize, int width, int height);
+
+// Copies plane rows without the padding
+void rdmpeg_decode_core_copy_plane(uint8_t *destination, const uint8_t *source, int linesize, int width, int height);
+
+// yadif graph for the decoded frames. Frames are added to graph->filters[0] and taken from graph->filters[1].
+AVFilterGraph *rdmpeg_decode_core_deinterlacer_create(const AVCodecContext *codecContext);
+
+// BGRA frame of the decoded size with its image allocated, freed with rdmpeg_decode_core_bgra_frame_free
+AVFrame *rdmpeg_decode_core_bgra_frame_create(const AVCodecContext *codecContext);
+void rdmpeg_decode_core_bgra_frame_free(AVFrame **frame);
+
+// Scaler from decoded frames to the BGRA frame, reuses the context when it fits
+struct SwsContext *rdmpeg_decode_core_bgra_scaler(struct SwsContext *swsContext,
+                                                  const AVCodecContext *codecContext,
+                                                  const AVFrame *bgraFrame);
+
+// MARK: - Audio
+
+// Channels count of the stream
+int rdmpeg_decode_core_channels_count(const AVCodecContext *codecContext);
+
+// Default layout for the channels count, 0 if there is none
+uint64_t rdmpeg_decode_core_default_channel_layout(int channelsCount);
+
+// Layout stream declares, or the default one for its channels count when it's unknown or inconsistent
+uint64_t rdmpeg_decode_core_channel_layout(const AVCodecContext *codecContext);
+
+// Sets profile options, should be called before swr_init
+int rdmpeg_decode_core_resampler_set_profile(SwrContext *swrContext, const RDMPEGResamplerProfile *profile);
+
+// Initialized resampler to interleaved output format with downmix matrix for the real input layout, NULL on error.
+// Decoder outputs S16, rdmpeg_decode_core_resample expects it.
+SwrContext *rdmpeg_decode_core_resampler_create(const AVCodecContext *codecContext,
+                                                int outputSampleRate,
+                                                int outputChannels,
+                                                enum AVSampleFormat outputSampleFormat,
+                                                RDMPEGDownmixLevels downmixLevels,
+                                                const RDMPEGResamplerProfile *profile);
+
+// Resamples frame into buffer, which is grown with realloc when needed. Returns samples count or AVERROR code.
+int rdmpeg_decode_core_resample(SwrContext *swrContext,
+                                const AVCodecContext *codecContext,
+                                const AVFrame *frame,
+                                int outputSampleRate,
+                                int outputChannels,
+                                uint8_t **buffer,
+                                int *bufferSize);
+
+// Converter of decoded frames to interleaved floats of the same layout and sampling rate, NULL on error
+SwrContext *rdmpeg_decode_core_float_converter_create(const AVCodecContext *codecContext);
+
+// Converts frame into buffer, which is grown with realloc when needed. Returns samples count or AVERROR code.
+int rdmpeg_decode_core_convert_to_float(SwrContext *swrContext,
+                                        const AVCodecContext *codecContext,
+                                        const AVFrame *frame,
+                                        uint8_t **buffer,
+                                        int *bufferSize);
+
+// ITU-R BS.1770 weight of the channel at the index of the layout: 1.41 for surround channels, 0 for LFE, 1 otherwise
+double rdmpeg_decode_core_loudness_channel_weight(uint64_t channelLayout, int channelIndex);
+
+// S16 samples to floats in [-1, 1]
+void rdmpeg_decode_core_samples_to_float(const int16_t *samples, float *output, size_t count);
+
+#endif /* RDMPEGDecodeCore_h */
@@ -0,0 +1,95 @@
+//
+//  RDMPEGDecodeStatistics.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Time spent in each stage of decoding pipeline and frame counters for a single stream type
+@objcMembers
+public class RDMPEGDecodeStreamStatistics: NSObject {
+    public let demuxTime: TimeInterval
+    public let decodeTime: TimeInterval
+    public let deinterlaceTime: TimeInterval
+    public let convertTime: TimeInterval
+    public let copyTime: TimeInterval
+    public let packetsDemuxed: UInt64
+    public let framesDecoded: UInt64
+    public let framesDropped: UInt64
+    public let framesConverted: UInt64
+    public let bytesCopied: UInt64
+
+    public var totalTime: TimeInterval {
+        demuxTime + decodeTime + deinterlaceTime + convertTime + copyTime
+    }
+
+    public init(
+        demuxTime: TimeInterval,
+        decodeTime: TimeInterval,
+        deinterlaceTime: TimeInterval,
+        convertTime: TimeInterval,
+        copyTime: TimeInterval,
+        packetsDemuxed: UInt64,
+        framesDecoded: UInt64,
+        framesDropped: UInt64,
+        framesConverted: UInt64,
+        bytesCopied: UInt64
+    ) {
+        self.demuxTime = demuxTime
+        self.decodeTime = decodeTime
+        self.deinterlaceTime = deinterlaceTime
+        self.convertTime = convertTime
+        self.copyTime = copyTime
+        self.packetsDemuxed = packetsDemuxed
+        self.framesDecoded = framesDecoded
+        self.framesDropped = framesDropped
+        self.framesConverted = framesConverted
+        self.bytesCopied = bytesCopied
+        super.init()
+    }
+
+    override public var description: String {
+        return String(
+            format: "demux: %.3fs, decode: %.3fs, deinterlace: %.3fs, convert: %.3fs, copy: %.3fs, " +
+            "packets: %llu, decoded: %llu, dropped: %llu, converted: %llu, copied: %llu bytes",
+            demuxTime,
+            decodeTime,
+            deinterlaceTime,
+            convertTime,
+            copyTime,
+            packetsDemuxed,
+            framesDecoded,
+            framesDropped,
+            framesConverted,
+            bytesCopied
+        )
+    }
+}
+
+@objcMembers
+public class RDMPEGDecodeStatistics: NSObject {
+    public let video: RDMPEGDecodeStreamStatistics
+    public let audio: RDMPEGDecodeStreamStatistics
+    public let subtitle: RDMPEGDecodeStreamStatistics
+
+    public var totalTime: TimeInterval {
+        video.totalTime + audio.totalTime + subtitle.totalTime
+    }
+
+    public init(
+        video: RDMPEGDecodeStreamStatistics,
+        audio: RDMPEGDecodeStreamStatistics,
+        subtitle: RDMPEGDecodeStreamStatistics
+    ) {
+        self.video = video
+        self.audio = audio
+        self.subtitle = subtitle
+        super.init()
+    }
+
+    override public var description: String {
+        return "video: {\(video)}, audio: {\(audio)}, subtitle: {\(subtitle)}"
+    }
+}
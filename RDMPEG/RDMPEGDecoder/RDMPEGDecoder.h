@@ -9,8 +9,11 @@
 #import <Foundation/Foundation.h>
 
 @class RDMPEGFrame;
+@class RDMPEGVideoFrame;
 @protocol RDMPEGIOStream;
 @class RDMPEGStream;
+@class RDMPEGIOStatistics;
+@class RDMPEGDecodeStatistics;
 
 
 
@@ -35,7 +38,32 @@ typedef NS_ENUM(NSUInteger, RDMPEGVideoFrameFormat) {
     RDMPEGVideoFrameFormatYUV,
 };
 
+// Video frames decoder doesn't even decode, ordered from the mildest
+typedef NS_ENUM(NSUInteger, RDMPEGDecoderFrameSkip) {
+    RDMPEGDecoderFrameSkipNone,
+    RDMPEGDecoderFrameSkipNonReference,
+    RDMPEGDecoderFrameSkipBidirectional,
+    RDMPEGDecoderFrameSkipNonKey,
+};
+
+// How channels missing in output (e.g. 5.1 played on stereo output) are mixed into the output ones
+typedef NS_ENUM(NSUInteger, RDMPEGDecoderDownmix) {
+    // ITU-R BS.775, centre and surrounds at -3 dB, LFE dropped
+    RDMPEGDecoderDownmixITU,
+    // Centre at full level and surrounds at -6 dB, LFE dropped
+    RDMPEGDecoderDownmixDialogueBoost,
+};
+
+// Resampler filter length and precision, higher quality costs more CPU (see resampler pass of RDMPEGBenchmark)
+typedef NS_ENUM(NSUInteger, RDMPEGDecoderResamplerQuality) {
+    RDMPEGDecoderResamplerQualityFast,
+    RDMPEGDecoderResamplerQualityBalanced,
+    RDMPEGDecoderResamplerQualityHigh,
+};
+
 typedef BOOL (^RDMPEGDecoderInterruptCallback)(void);
+// Interleaved floats of every source channel at source sampling rate
+typedef void (^RDMPEGDecoderSourceAudioHandler)(const float *samples, NSUInteger framesCount);
 
 
 
@@ -59,6 +87,32 @@ typedef BOOL (^RDMPEGDecoderInterruptCallback)(void);
 @property (nonatomic, readonly, getter=isAudioStreamExist) BOOL audioStreamExist;
 @property (nonatomic, readonly, getter=isSubtitleStreamExist) BOOL subtitleStreamExist;
 @property (nonatomic, assign, getter=isDeinterlacingEnabled) BOOL deinterlacingEnabled;
+// Audio is time stretched (pitch preserved) to the rate, frames keep media time positions and durations.
+// Non-reference video frames are skipped at high rates
+@property (nonatomic, assign) double playbackRate;
+// Applied on top of the skip required by playback rate
+@property (nonatomic, assign) RDMPEGDecoderFrameSkip frameSkip;
+// Video frames ending before the position are dropped without conversion, -infinity (default) disables dropping
+@property (nonatomic, assign) NSTimeInterval videoDropPosition;
+// Packets of all video streams are discarded by demuxer (not even read where container allows), audio and subtitles
+// keep decoding. Decoding of video resumes from the next keyframe, moveAtKeyframeBeforePosition: resumes it at once
+@property (nonatomic, assign, getter=isVideoDiscarded) BOOL videoDiscarded;
+// Changing them rebuilds resampler of the active audio stream
+@property (nonatomic, assign) RDMPEGDecoderDownmix downmix;
+// Balanced by default
+@property (nonatomic, assign) RDMPEGDecoderResamplerQuality resamplerQuality;
+// Format the active audio stream decodes to, before it's resampled and downmixed to output format
+@property (nonatomic, readonly) double sourceAudioSamplingRate;
+@property (nonatomic, readonly) NSUInteger sourceAudioChannels;
+// ITU-R BS.1770 loudness weights of source channels, surround ones count more and LFE doesn't count
+@property (nonatomic, readonly) NSArray<NSNumber *> *sourceAudioLoudnessWeights;
+// Called on decoding thread with every audio frame as it's decoded, before time stretching and resampling
+@property (nonatomic, copy, nullable) RDMPEGDecoderSourceAudioHandler sourceAudioHandler;
+@property (nonatomic, readonly) RDMPEGIOStatistics *ioStatistics;
+// Cumulative time spent in stream reads, cheap to poll around every decode step
+@property (nonatomic, readonly) NSTimeInterval ioReadTime;
+@property (nonatomic, assign, getter=isDecodeStatisticsEnabled) BOOL decodeStatisticsEnabled;
+@property (nonatomic, readonly) RDMPEGDecodeStatistics *decodeStatistics;
 
 - (instancetype)initWithPath:(NSString *)path
                     ioStream:(nullable id<RDMPEGIOStream>)ioStream
@@ -76,7 +130,24 @@ typedef BOOL (^RDMPEGDecoderInterruptCallback)(void);
 - (void)close;
 
 - (void)moveAtPosition:(NSTimeInterval)position;
+// Decoding continues from the keyframe at or before the position, so frames preceding the position are decoded too
+- (void)moveAtKeyframeBeforePosition:(NSTimeInterval)position NS_SWIFT_NAME(moveToKeyframe(before:));
+// Skew is how much faster than host clock audio device consumes samples. Resampler stretches (positive skew) or
+// shrinks the next duration (output time) of audio by it, at most by 0.5%. Zero skew stops compensation.
+// Audio decoded in output format already bypasses resampler and isn't compensated
+- (void)compensateAudioClockSkew:(double)skew
+                    overDuration:(NSTimeInterval)duration NS_SWIFT_NAME(compensateAudioClockSkew(_:overDuration:));
+// Takes over resampler of the decoder which played preceding item when both produce audio of the same format,
+// so samples it still holds and its filter state carry over the boundary. Should be called before decoding
+- (BOOL)continueAudioOfDecoder:(RDMPEGDecoder *)decoder NS_SWIFT_NAME(continueAudio(of:));
 - (nullable NSArray<RDMPEGFrame *> *)decodeFrames;
+// Trick play: hops through container index to the keyframe at or after (forward) or at or before (backward)
+// the position and decodes only it, audio and non-key packets aren't even read into decoder. Frame is scaled down
+// by the factor. Returns nil when there is no keyframe in that direction, normal decoding resumes after moveAtPosition:
+- (nullable RDMPEGVideoFrame *)decodeKeyframeFromPosition:(NSTimeInterval)position
+                                                  forward:(BOOL)forward
+                                              scaleFactor:(NSUInteger)scaleFactor
+    NS_SWIFT_NAME(decodeKeyframe(from:forward:scaleFactor:));
 
 - (BOOL)activateAudioStreamAtIndex:(nullable NSNumber *)audioStreamIndex
                       samplingRate:(double)samplingRate
@@ -86,6 +157,12 @@ typedef BOOL (^RDMPEGDecoderInterruptCallback)(void);
 - (BOOL)activateSubtitleStreamAtIndex:(nullable NSNumber *)subtitleStreamIndex;
 - (void)deactivateSubtitleStream;
 
+// Statistics are updated from decoding thread, snapshot, reset and trace methods may be called from any thread
+- (void)resetDecodeStatistics;
+- (void)resetIOStatistics;
+- (BOOL)startIOTraceAtPath:(NSString *)path;
+- (void)stopIOTrace;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -8,16 +8,21 @@
 
 #import "RDMPEGDecoder.h"
 #import "RDMPEGIOStream.h"
-#import <Accelerate/Accelerate.h>
+#import "RDMPEGLogBridge.h"
+#import "RDMPEGDownmix.h"
+#import "RDMPEGResamplerProfile.h"
+#import "RDMPEGDecodeCore.h"
 #import <libavformat/avformat.h>
 #import <libswscale/swscale.h>
 #import <libswresample/swresample.h>
 #import <libavutil/pixdesc.h>
-#import <libavutil/imgutils.h>
+#import <libavutil/opt.h>
 #import <libavfilter/avfilter.h>
 #import <libavfilter/buffersink.h>
 #import <libavfilter/buffersrc.h>
 #import <Log4Cocoa/Log4Cocoa.h>
+#import <os/lock.h>
+#import <stdatomic.h>
 
 #import <RDMPEG/RDMPEG-Swift.h>
 
@@ -25,14 +30,81 @@ NS_ASSUME_NONNULL_BEGIN
 
 NSString * const RDMPEGDecoderErrorDomain = @"RDMPEGDecoderErrorDomain";
 
+#define RDMPEG_IO_LATENCY_BUCKETS 24
+
+_Static_assert(RDMPEG_DOWNMIX_CHANNEL_FRONT_CENTER == AV_CH_FRONT_CENTER &&
+               RDMPEG_DOWNMIX_CHANNEL_SIDE_LEFT == AV_CH_SIDE_LEFT &&
+               RDMPEG_DOWNMIX_CHANNEL_LOW_FREQUENCY_2 == AV_CH_LOW_FREQUENCY_2,
+               "Downmix channels should match FFmpeg channel masks");
+
+// atempo filter accepts tempo down to 0.5, slower rates are chained
+static const double RDMPEGDecoderMinimumTempo = 0.5;
+static const double RDMPEGDecoderSkipNonReferenceFramesRate = 2.0;
+// Resampler stretches or shrinks audio by at most that ratio
+static const double RDMPEGDecoderMaximumAudioClockSkewCompensation = 0.005;
+// Keyframe search gives up after that many packets, e.g. when index is missing and seek landed far from the keyframe
+static const NSUInteger RDMPEGDecoderKeyframeSearchPacketsLimit = 8192;
+
+typedef struct RDMPEGIOCounters {
+    _Atomic uint64_t readBytes;
+    _Atomic uint64_t readCalls;
+    _Atomic uint64_t readErrors;
+    _Atomic uint64_t readTime;
+    _Atomic uint64_t seekCalls;
+    _Atomic uint64_t seekDistance;
+    _Atomic uint64_t sizeQueries;
+    _Atomic uint64_t readFrameCalls;
+    _Atomic uint64_t readFrameTime;
+    _Atomic uint64_t readLatency[RDMPEG_IO_LATENCY_BUCKETS];
+    int64_t position; // Accessed only from IO callbacks on decoding thread
+    os_unfair_lock traceLock; // Serializes trace writes with start and stop
+    _Atomic(FILE *) traceFile; // Checked without the lock, so IO callbacks don't take it while tracing is off
+    uint64_t traceStartTime;
+} RDMPEGIOCounters;
+
+typedef NS_ENUM(NSUInteger, RDMPEGDecodeStream) {
+    RDMPEGDecodeStreamVideo,
+    RDMPEGDecodeStreamAudio,
+    RDMPEGDecodeStreamSubtitle,
+    RDMPEGDecodeStreamCount
+};
+
+typedef NS_ENUM(NSUInteger, RDMPEGDecodeStage) {
+    RDMPEGDecodeStageDemux,
+    RDMPEGDecodeStageDecode,
+    RDMPEGDecodeStageDeinterlace,
+    RDMPEGDecodeStageConvert,
+    RDMPEGDecodeStageCopy,
+    RDMPEGDecodeStageCount
+};
+
+typedef struct RDMPEGDecodeCounters {
+    atomic_bool enabled;
+    _Atomic uint64_t stageTime[RDMPEGDecodeStreamCount][RDMPEGDecodeStageCount];
+    _Atomic uint64_t packetsDemuxed[RDMPEGDecodeStreamCount];
+    _Atomic uint64_t framesDecoded[RDMPEGDecodeStreamCount];
+    _Atomic uint64_t framesDropped[RDMPEGDecodeStreamCount];
+    _Atomic uint64_t framesConverted[RDMPEGDecodeStreamCount];
+    _Atomic uint64_t bytesCopied[RDMPEGDecodeStreamCount];
+} RDMPEGDecodeCounters;
+
 
 
-static void ffmpeg_log(void *context, int level, const char *format, va_list args);
 static int interrupt_callback(void *ctx);
 static int iostream_readbuffer(void *ctx, uint8_t *buf, int buf_size);
 static int64_t iostream_seekoffset(void *ctx, int64_t offset, int whence);
-static void av_stream_FPS_timebase(AVStream *st, double defaultTimeBase, double * _Nullable pFPS, double * _Nullable pTimeBase);
 static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
+static uint64_t io_counters_now(void);
+static void io_counters_reset(RDMPEGIOCounters *counters);
+static void io_counters_record_read(RDMPEGIOCounters *counters, int result, uint64_t duration);
+static void io_counters_record_seek(RDMPEGIOCounters *counters, int64_t offset, int whence, int64_t result, uint64_t duration);
+static void io_counters_record_read_frame(RDMPEGIOCounters *counters, int result, uint64_t duration);
+static void io_counters_trace(RDMPEGIOCounters *counters, const char *event, int64_t offset, int whence, int64_t result, uint64_t duration);
+static uint64_t decode_counters_begin(RDMPEGDecodeCounters *counters);
+static void decode_counters_end(RDMPEGDecodeCounters *counters, RDMPEGDecodeStream stream, RDMPEGDecodeStage stage, uint64_t startTime);
+static void decode_counters_add_time(RDMPEGDecodeCounters *counters, RDMPEGDecodeStream stream, RDMPEGDecodeStage stage, uint64_t duration);
+static void decode_counters_add(RDMPEGDecodeCounters *counters, _Atomic uint64_t *counter, uint64_t value);
+static void decode_counters_reset(RDMPEGDecodeCounters *counters);
 
 
 
@@ -43,16 +115,26 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     AVFrame *_filteredVideoFrame;
     AVFrame *_bgraVideoFrame;
     AVFrame *_audioFrame;
+    AVFrame *_stretchedAudioFrame;
     double _videoTimeBase;
     double _audioTimeBase;
     double _subtitleTimeBase;
     double _fps;
     SwrContext *_swrContext;
-    void *_swrBuffer;
-    NSUInteger _swrBufferSize;
+    uint8_t *_swrBuffer;
+    int _swrBufferSize;
+    SwrContext *_sourceAudioSwrContext;
+    uint8_t *_sourceAudioBuffer;
+    int _sourceAudioBufferSize;
     struct SwsContext *_swsContext;
+    struct SwsContext *_keyframeSwsContext;
     NSNumber *_subtitleASSEvents;
     AVFilterGraph *_filterGraph;
+    AVFilterGraph *_audioFilterGraph;
+    NSTimeInterval _stretchedAudioPosition;
+    BOOL _stretchedAudioStarted;
+    RDMPEGIOCounters _ioCounters;
+    RDMPEGDecodeCounters _decodeCounters;
 }
 
 @property (nonatomic, strong) NSString *path;
@@ -71,6 +153,7 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
 @property (nonatomic, assign) double audioSamplingRate;
 @property (nonatomic, assign) NSUInteger audioOutputChannels;
 @property (nonatomic, assign, getter=isEndReached) BOOL endReached;
+@property (nonatomic, readonly) RDMPEGIOCounters *ioCounters;
 
 @end
 
@@ -81,7 +164,7 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
 #pragma mark - Overridden Class Methods
 
 + (void)initialize {
-    av_log_set_callback(ffmpeg_log);
+    [RDMPEGLogBridge install];
     avformat_network_init();
 }
 
@@ -108,6 +191,10 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
         self.audioStreams = [NSMutableArray array];
         self.subtitleStreams = [NSMutableArray array];
         self.artworkStreams = [NSMutableArray array];
+        
+        _playbackRate = 1.0;
+        _resamplerQuality = RDMPEGDecoderResamplerQualityBalanced;
+        _videoDropPosition = -INFINITY;
     }
     return self;
 }
@@ -123,6 +210,7 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
 
 - (void)dealloc {
     [self close];
+    [self stopIOTrace];
 }
 
 #pragma mark - Public Accessors
@@ -179,6 +267,132 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     return @([self.subtitleStreams indexOfObject:self.activeSubtitleStream]);
 }
 
+- (RDMPEGIOStatistics *)ioStatistics {
+    NSMutableArray<NSNumber *> *readLatencyHistogram = [NSMutableArray arrayWithCapacity:RDMPEG_IO_LATENCY_BUCKETS];
+    for (int bucket = 0; bucket < RDMPEG_IO_LATENCY_BUCKETS; bucket++) {
+        [readLatencyHistogram addObject:@(atomic_load_explicit(&_ioCounters.readLatency[bucket], memory_order_relaxed))];
+    }
+    
+    return [[RDMPEGIOStatistics alloc] initWithReadBytes:atomic_load_explicit(&_ioCounters.readBytes, memory_order_relaxed)
+                                               readCalls:atomic_load_explicit(&_ioCounters.readCalls, memory_order_relaxed)
+                                              readErrors:atomic_load_explicit(&_ioCounters.readErrors, memory_order_relaxed)
+                                               seekCalls:atomic_load_explicit(&_ioCounters.seekCalls, memory_order_relaxed)
+                                            seekDistance:atomic_load_explicit(&_ioCounters.seekDistance, memory_order_relaxed)
+                                             sizeQueries:atomic_load_explicit(&_ioCounters.sizeQueries, memory_order_relaxed)
+                                                readTime:atomic_load_explicit(&_ioCounters.readTime, memory_order_relaxed) / (double)NSEC_PER_SEC
+                                          readFrameCalls:atomic_load_explicit(&_ioCounters.readFrameCalls, memory_order_relaxed)
+                                    readFrameBlockedTime:atomic_load_explicit(&_ioCounters.readFrameTime, memory_order_relaxed) / (double)NSEC_PER_SEC
+                                    readLatencyHistogram:readLatencyHistogram];
+}
+
+- (NSTimeInterval)ioReadTime {
+    return atomic_load_explicit(&_ioCounters.readTime, memory_order_relaxed) / (double)NSEC_PER_SEC;
+}
+
+- (void)setPlaybackRate:(double)playbackRate {
+    if (_playbackRate == playbackRate) {
+        return;
+    }
+    
+    _playbackRate = playbackRate;
+    
+    // Graph is configured for particular tempo, it's recreated on demand
+    [self unloadAudioFilterGraph];
+    [self updateVideoSkipFrame];
+}
+
+- (void)setFrameSkip:(RDMPEGDecoderFrameSkip)frameSkip {
+    if (_frameSkip == frameSkip) {
+        return;
+    }
+    
+    log4Info(@"Video frame skip changed: %lu -> %lu", (unsigned long)_frameSkip, (unsigned long)frameSkip);
+    
+    _frameSkip = frameSkip;
+    
+    [self updateVideoSkipFrame];
+}
+
+- (void)setVideoDiscarded:(BOOL)videoDiscarded {
+    if (_videoDiscarded == videoDiscarded) {
+        return;
+    }
+    
+    log4Info(@"Video discarding changed: %d -> %d", _videoDiscarded, videoDiscarded);
+    
+    _videoDiscarded = videoDiscarded;
+    
+    [self updateVideoDiscard];
+    
+    if (videoDiscarded == NO && self.activeVideoStream.codecContext) {
+        // Frames decoder still references were dropped with the packets
+        avcodec_flush_buffers(self.activeVideoStream.codecContext);
+        [self unloadFilterGraph];
+    }
+}
+
+- (void)setDownmix:(RDMPEGDecoderDownmix)downmix {
+    if (_downmix == downmix) {
+        return;
+    }
+    
+    log4Info(@"Audio downmix changed: %lu -> %lu", (unsigned long)_downmix, (unsigned long)downmix);
+    
+    _downmix = downmix;
+    
+    [self reloadResampler];
+}
+
+- (void)setResamplerQuality:(RDMPEGDecoderResamplerQuality)resamplerQuality {
+    if (_resamplerQuality == resamplerQuality) {
+        return;
+    }
+    
+    log4Info(@"Audio resampler quality changed: %lu -> %lu", (unsigned long)_resamplerQuality, (unsigned long)resamplerQuality);
+    
+    _resamplerQuality = resamplerQuality;
+    
+    [self reloadResampler];
+}
+
+- (double)sourceAudioSamplingRate {
+    return self.activeAudioStream.codecContext ? self.activeAudioStream.codecContext->sample_rate : 0.0;
+}
+
+- (NSUInteger)sourceAudioChannels {
+    return self.activeAudioStream.codecContext ? (NSUInteger)self.activeAudioStream.codecContext->channels : 0;
+}
+
+- (NSArray<NSNumber *> *)sourceAudioLoudnessWeights {
+    AVCodecContext *codecContext = self.activeAudioStream.codecContext;
+    if (codecContext == NULL) {
+        return @[];
+    }
+    
+    uint64_t channelLayout = rdmpeg_decode_core_channel_layout(codecContext);
+    NSMutableArray<NSNumber *> *weights = [NSMutableArray arrayWithCapacity:(NSUInteger)codecContext->channels];
+    
+    for (int channelIndex = 0; channelIndex < codecContext->channels; channelIndex++) {
+        [weights addObject:@(rdmpeg_decode_core_loudness_channel_weight(channelLayout, channelIndex))];
+    }
+    
+    return weights;
+}
+
+- (BOOL)isDecodeStatisticsEnabled {
+    return atomic_load_explicit(&_decodeCounters.enabled, memory_order_relaxed);
+}
+
+- (void)setDecodeStatisticsEnabled:(BOOL)decodeStatisticsEnabled {
+    atomic_store_explicit(&_decodeCounters.enabled, decodeStatisticsEnabled, memory_order_relaxed);
+}
+
+- (RDMPEGDecodeStatistics *)decodeStatistics {
+    return [[RDMPEGDecodeStatistics alloc] initWithVideo:[self decodeStatisticsForStream:RDMPEGDecodeStreamVideo]
+                                                   audio:[self decodeStatisticsForStream:RDMPEGDecodeStreamAudio]
+                                                subtitle:[self decodeStatisticsForStream:RDMPEGDecodeStreamSubtitle]];
+}
+
 #pragma mark - Public Methods
 
 - (nullable NSError *)openInput {
@@ -204,6 +418,8 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     }
     
     if (self.ioStream) {
+        _ioCounters.position = 0;
+        
         if ([self.ioStream open] == NO) {
             avformat_free_context(formatCtx);
             return [self errorWithCode:RDMPEGDecoderErrorCodeOpenFile];
@@ -356,37 +572,78 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     self.endReached = NO;
     
     if (self.activeVideoStream) {
-        int64_t ts = (int64_t)(position / _videoTimeBase);
-        
-        if (self.activeVideoStream.stream->start_time != AV_NOPTS_VALUE) {
-            ts += self.activeVideoStream.stream->start_time;
-        }
-        
-        avformat_seek_file(_formatCtx, (int)self.activeVideoStream.streamIndex, ts, ts, ts, AVSEEK_FLAG_FRAME);
+        rdmpeg_decode_core_seek(_formatCtx, (int)self.activeVideoStream.streamIndex, _videoTimeBase, position);
     }
     else if (self.activeAudioStream) {
-        int64_t ts = (int64_t)(position / _audioTimeBase);
-        
-        if (self.activeAudioStream.stream->start_time != AV_NOPTS_VALUE) {
-            ts += self.activeAudioStream.stream->start_time;
-        }
-        
-        avformat_seek_file(_formatCtx, (int)self.activeAudioStream.streamIndex, ts, ts, ts, AVSEEK_FLAG_FRAME);
+        rdmpeg_decode_core_seek(_formatCtx, (int)self.activeAudioStream.streamIndex, _audioTimeBase, position);
     }
     else if (self.activeSubtitleStream) {
         int64_t ts = 0.0;
         avformat_seek_file(_formatCtx, (int)self.activeSubtitleStream.streamIndex, ts, ts, ts, AVSEEK_FLAG_FRAME);
     }
     
-    if (self.activeVideoStream.codecContext) {
-        avcodec_flush_buffers(self.activeVideoStream.codecContext);
+    [self flushCodecs];
+}
+
+- (void)moveAtKeyframeBeforePosition:(NSTimeInterval)position {
+    if (self.activeVideoStream == nil) {
+        [self moveAtPosition:position];
+        return;
     }
-    if (self.activeAudioStream.codecContext) {
-        avcodec_flush_buffers(self.activeAudioStream.codecContext);
+    
+    self.endReached = NO;
+    
+    int seekStatus = rdmpeg_decode_core_seek_keyframe(_formatCtx, (int)self.activeVideoStream.streamIndex, _videoTimeBase, position);
+    
+    if (seekStatus < 0) {
+        log4Error(@"Seek to keyframe before %f error: %s", position, av_err2str(seekStatus));
     }
-    if (self.activeSubtitleStream.codecContext) {
-        avcodec_flush_buffers(self.activeSubtitleStream.codecContext);
+    
+    [self flushCodecs];
+}
+
+- (void)compensateAudioClockSkew:(double)skew overDuration:(NSTimeInterval)duration {
+    // Audio already in output format bypasses resampler. Setting one up mid-stream just for compensation would
+    // move output onto the resampled path, and its delay and filter would be heard every time compensation starts
+    if (self.activeAudioStream == nil || _swrContext == NULL) {
+        return;
+    }
+    
+    // Resampler output is the device sample rate, atempo is applied before it
+    int compensationDistance = (int)lround(MAX(duration, 0.0) * self.audioSamplingRate);
+    skew = MAX(-RDMPEGDecoderMaximumAudioClockSkewCompensation, MIN(skew, RDMPEGDecoderMaximumAudioClockSkewCompensation));
+    int sampleDelta = (int)lround(skew * compensationDistance);
+    
+    int compensationStatus = swr_set_compensation(_swrContext, sampleDelta, sampleDelta != 0 ? compensationDistance : 0);
+    if (compensationStatus < 0) {
+        log4Error(@"Set audio compensation error: %s", av_err2str(compensationStatus));
+    }
+}
+
+- (BOOL)continueAudioOfDecoder:(RDMPEGDecoder *)decoder {
+    if (self.activeAudioStream == nil || decoder.activeAudioStream == nil) {
+        return NO;
+    }
+    
+    AVCodecContext *codecContext = self.activeAudioStream.codecContext;
+    AVCodecContext *previousCodecContext = decoder.activeAudioStream.codecContext;
+    
+    if (codecContext->sample_fmt != previousCodecContext->sample_fmt ||
+        codecContext->sample_rate != previousCodecContext->sample_rate ||
+        rdmpeg_decode_core_channel_layout(codecContext) != rdmpeg_decode_core_channel_layout(previousCodecContext) ||
+        self.downmix != decoder.downmix ||
+        self.resamplerQuality != decoder.resamplerQuality ||
+        self.audioSamplingRate != decoder.audioSamplingRate ||
+        self.audioOutputChannels != decoder.audioOutputChannels) {
+        return NO;
     }
+    
+    // Resamplers are swapped rather than moved, so both decoders stay able to decode
+    SwrContext *swrContext = _swrContext;
+    _swrContext = decoder->_swrContext;
+    decoder->_swrContext = swrContext;
+    
+    return YES;
 }
 
 - (nullable NSArray<RDMPEGFrame *> *)decodeFrames {
@@ -396,30 +653,46 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     while (isFinished == NO) {
         AVPacket packet;
         
+        uint64_t readFrameStartTime = io_counters_now();
         int readFrameStatus = av_read_frame(_formatCtx, &packet);
+        uint64_t readFrameDuration = io_counters_now() - readFrameStartTime;
+        io_counters_record_read_frame(&_ioCounters, readFrameStatus, readFrameDuration);
+        
         if (readFrameStatus < 0) {
             log4Error(@"Read frame error: %s (%@)", av_err2str(readFrameStatus), self.path.lastPathComponent);
             self.endReached = YES;
             break;
         }
         
-        if (self.activeVideoStream && packet.stream_index == self.activeVideoStream.streamIndex) {
+        if (self.activeVideoStream && self.isVideoDiscarded == NO && packet.stream_index == self.activeVideoStream.streamIndex) {
+            decode_counters_add_time(&_decodeCounters, RDMPEGDecodeStreamVideo, RDMPEGDecodeStageDemux, readFrameDuration);
+            decode_counters_add(&_decodeCounters, &_decodeCounters.packetsDemuxed[RDMPEGDecodeStreamVideo], 1);
+            
+            uint64_t sendVideoPacketStartTime = decode_counters_begin(&_decodeCounters);
             int sendVideoPacketStatus = avcodec_send_packet(self.activeVideoStream.codecContext, &packet);
+            decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamVideo, RDMPEGDecodeStageDecode, sendVideoPacketStartTime);
+            
             if (sendVideoPacketStatus >= 0) {
                 while (YES) {
-                    if ([self receiveFrameWithCodecContext:self.activeVideoStream.codecContext frame:_videoFrame] == NO) {
+                    if ([self receiveFrameWithCodecContext:self.activeVideoStream.codecContext frame:_videoFrame stream:RDMPEGDecodeStreamVideo] == NO) {
                         break;
                     }
                     
                     if (self.isDeinterlacingEnabled && _videoFrame->interlaced_frame && [self setupFilterGraphIfNeeded]) {
+                        uint64_t addFrameToBufferStartTime = decode_counters_begin(&_decodeCounters);
                         int addFrameToBufferStatus = av_buffersrc_add_frame_flags(_filterGraph->filters[0], _videoFrame, AV_BUFFERSRC_FLAG_KEEP_REF);
+                        decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamVideo, RDMPEGDecodeStageDeinterlace, addFrameToBufferStartTime);
+                        
                         if (addFrameToBufferStatus < 0) {
                             log4Assert(NO, @"Add frame to buffer error: %s", av_err2str(addFrameToBufferStatus));
                             break;
                         }
                         
                         while (YES) {
+                            uint64_t buffersinkGetFrameStartTime = decode_counters_begin(&_decodeCounters);
                             int buffersinkGetFrameStatus = av_buffersink_get_frame(_filterGraph->filters[1], _filteredVideoFrame);
+                            decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamVideo, RDMPEGDecodeStageDeinterlace, buffersinkGetFrameStartTime);
+                            
                             if (buffersinkGetFrameStatus == AVERROR(EAGAIN) || buffersinkGetFrameStatus == AVERROR(AVERROR_EOF)) {
                                 break;
                             }
@@ -434,6 +707,9 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
                                 [frames addObject:videoFrame];
                                 isFinished = YES;
                             }
+                            else {
+                                decode_counters_add(&_decodeCounters, &_decodeCounters.framesDropped[RDMPEGDecodeStreamVideo], 1);
+                            }
                             
                             av_frame_unref(_filteredVideoFrame);
                         }
@@ -444,6 +720,9 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
                             [frames addObject:videoFrame];
                             isFinished = YES;
                         }
+                        else {
+                            decode_counters_add(&_decodeCounters, &_decodeCounters.framesDropped[RDMPEGDecodeStreamVideo], 1);
+                        }
                     }
                 }
             }
@@ -452,19 +731,78 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
             }
         }
         else if (self.activeAudioStream && packet.stream_index == self.activeAudioStream.streamIndex) {
+            decode_counters_add_time(&_decodeCounters, RDMPEGDecodeStreamAudio, RDMPEGDecodeStageDemux, readFrameDuration);
+            decode_counters_add(&_decodeCounters, &_decodeCounters.packetsDemuxed[RDMPEGDecodeStreamAudio], 1);
+            
+            uint64_t sendAudioPacketStartTime = decode_counters_begin(&_decodeCounters);
             int sendAudioPacketStatus = avcodec_send_packet(self.activeAudioStream.codecContext, &packet);
+            decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamAudio, RDMPEGDecodeStageDecode, sendAudioPacketStartTime);
+            
             if (sendAudioPacketStatus >= 0) {
                 while (YES) {
-                    if ([self receiveFrameWithCodecContext:self.activeAudioStream.codecContext frame:_audioFrame] == NO) {
+                    if ([self receiveFrameWithCodecContext:self.activeAudioStream.codecContext frame:_audioFrame stream:RDMPEGDecodeStreamAudio] == NO) {
                         break;
                     }
                     
-                    RDMPEGAudioFrame *audioFrame = [self handleAudioFrame];
-                    if (audioFrame) {
-                        [frames addObject:audioFrame];
+                    if (self.sourceAudioHandler) {
+                        [self handleSourceAudioFrame:_audioFrame];
+                    }
+                    
+                    if (self.playbackRate != 1.0 && [self setupAudioFilterGraphIfNeeded]) {
+                        if (_stretchedAudioStarted == NO) {
+                            _stretchedAudioPosition = [self positionOfAudioFrame:_audioFrame];
+                            _stretchedAudioStarted = YES;
+                        }
                         
-                        if (self.activeVideoStream == nil) {
-                            isFinished = YES;
+                        uint64_t addFrameToBufferStartTime = decode_counters_begin(&_decodeCounters);
+                        int addFrameToBufferStatus = av_buffersrc_add_frame_flags(_audioFilterGraph->filters[0], _audioFrame, AV_BUFFERSRC_FLAG_KEEP_REF);
+                        decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamAudio, RDMPEGDecodeStageConvert, addFrameToBufferStartTime);
+                        
+                        if (addFrameToBufferStatus < 0) {
+                            log4Assert(NO, @"Add audio frame to buffer error: %s", av_err2str(addFrameToBufferStatus));
+                            break;
+                        }
+                        
+                        while (YES) {
+                            uint64_t buffersinkGetFrameStartTime = decode_counters_begin(&_decodeCounters);
+                            int buffersinkGetFrameStatus = av_buffersink_get_frame(_audioFilterGraph->filters[1], _stretchedAudioFrame);
+                            decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamAudio, RDMPEGDecodeStageConvert, buffersinkGetFrameStartTime);
+                            
+                            if (buffersinkGetFrameStatus == AVERROR(EAGAIN) || buffersinkGetFrameStatus == AVERROR_EOF) {
+                                break;
+                            }
+                            
+                            if (buffersinkGetFrameStatus < 0) {
+                                log4Assert(NO, @"Get audio frame from buffer error: %s", av_err2str(buffersinkGetFrameStatus));
+                                break;
+                            }
+                            
+                            RDMPEGAudioFrame *audioFrame = [self handleAudioFrame:_stretchedAudioFrame];
+                            if (audioFrame) {
+                                [frames addObject:audioFrame];
+                                
+                                if (self.activeVideoStream == nil || self.isVideoDiscarded) {
+                                    isFinished = YES;
+                                }
+                            }
+                            else {
+                                decode_counters_add(&_decodeCounters, &_decodeCounters.framesDropped[RDMPEGDecodeStreamAudio], 1);
+                            }
+                            
+                            av_frame_unref(_stretchedAudioFrame);
+                        }
+                    }
+                    else {
+                        RDMPEGAudioFrame *audioFrame = [self handleAudioFrame:_audioFrame];
+                        if (audioFrame) {
+                            [frames addObject:audioFrame];
+                            
+                            if (self.activeVideoStream == nil || self.isVideoDiscarded) {
+                                isFinished = YES;
+                            }
+                        }
+                        else {
+                            decode_counters_add(&_decodeCounters, &_decodeCounters.framesDropped[RDMPEGDecodeStreamAudio], 1);
                         }
                     }
                 }
@@ -482,11 +820,16 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
             }
         }
         else if (self.activeSubtitleStream && packet.stream_index == self.activeSubtitleStream.streamIndex) {
+            decode_counters_add_time(&_decodeCounters, RDMPEGDecodeStreamSubtitle, RDMPEGDecodeStageDemux, readFrameDuration);
+            decode_counters_add(&_decodeCounters, &_decodeCounters.packetsDemuxed[RDMPEGDecodeStreamSubtitle], 1);
+            
             int remainingPacketSize = packet.size;
             while (remainingPacketSize > 0) {
                 AVSubtitle subtitle;
                 int gotsubtitle = 0;
+                uint64_t decodeSubtitleStartTime = decode_counters_begin(&_decodeCounters);
                 int len = avcodec_decode_subtitle2(self.activeSubtitleStream.codecContext, &subtitle, &gotsubtitle, &packet);
+                decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamSubtitle, RDMPEGDecodeStageDecode, decodeSubtitleStartTime);
                 
                 if (len < 0) {
                     log4Error(@"Decode subtitle error, skip packet: %s", av_err2str(len));
@@ -494,11 +837,16 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
                 }
                 
                 if (gotsubtitle) {
+                    decode_counters_add(&_decodeCounters, &_decodeCounters.framesDecoded[RDMPEGDecodeStreamSubtitle], 1);
+                    
                     RDMPEGSubtitleFrame *subtitleFrame = [self handleSubtitle:&subtitle];
-                    if (subtitleFrame) {
+                    if (subtitleFrame == nil) {
+                        decode_counters_add(&_decodeCounters, &_decodeCounters.framesDropped[RDMPEGDecodeStreamSubtitle], 1);
+                    }
+                    else {
                         [frames addObject:subtitleFrame];
                         
-                        if (self.activeVideoStream == nil && self.activeAudioStream == nil) {
+                        if ((self.activeVideoStream == nil || self.isVideoDiscarded) && self.activeAudioStream == nil) {
                             isFinished = YES;
                         }
                     }
@@ -519,6 +867,96 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     return frames;
 }
 
+- (nullable RDMPEGVideoFrame *)decodeKeyframeFromPosition:(NSTimeInterval)position
+                                                  forward:(BOOL)forward
+                                              scaleFactor:(NSUInteger)scaleFactor {
+    if (self.activeVideoStream == nil) {
+        return nil;
+    }
+    
+    self.endReached = NO;
+    
+    AVStream *stream = self.activeVideoStream.stream;
+    AVCodecContext *codecContext = self.activeVideoStream.codecContext;
+    int streamIndex = (int)self.activeVideoStream.streamIndex;
+    
+    int64_t ts = (int64_t)(position / _videoTimeBase);
+    
+    if (stream->start_time != AV_NOPTS_VALUE) {
+        ts += stream->start_time;
+    }
+    
+    // Seek bounds make demuxer pick keyframe from the index in the requested direction only
+    int seekStatus = forward ?
+        avformat_seek_file(_formatCtx, streamIndex, ts, ts, INT64_MAX, 0) :
+        avformat_seek_file(_formatCtx, streamIndex, INT64_MIN, ts, ts, 0);
+    
+    if (seekStatus < 0) {
+        log4Debug(@"There is no keyframe %@ %f: %s", forward ? @"after" : @"before", position, av_err2str(seekStatus));
+        return nil;
+    }
+    
+    avcodec_flush_buffers(codecContext);
+    codecContext->skip_frame = AVDISCARD_NONKEY;
+    
+    RDMPEGVideoFrame *videoFrame = nil;
+    
+    for (NSUInteger packetsCount = 0; packetsCount < RDMPEGDecoderKeyframeSearchPacketsLimit && videoFrame == nil; ++packetsCount) {
+        AVPacket packet;
+        
+        uint64_t readFrameStartTime = io_counters_now();
+        int readFrameStatus = av_read_frame(_formatCtx, &packet);
+        uint64_t readFrameDuration = io_counters_now() - readFrameStartTime;
+        io_counters_record_read_frame(&_ioCounters, readFrameStatus, readFrameDuration);
+        
+        if (readFrameStatus < 0) {
+            self.endReached = YES;
+            break;
+        }
+        
+        // Demuxers without index may land before the timestamp, keyframes which are passed already aren't decoded
+        BOOL isKeyframePacket = (packet.stream_index == streamIndex && (packet.flags & AV_PKT_FLAG_KEY));
+        BOOL isPassedPacket = (forward && packet.pts != AV_NOPTS_VALUE && packet.pts < ts);
+        
+        if (isKeyframePacket == NO || isPassedPacket) {
+            av_packet_unref(&packet);
+            continue;
+        }
+        
+        decode_counters_add_time(&_decodeCounters, RDMPEGDecodeStreamVideo, RDMPEGDecodeStageDemux, readFrameDuration);
+        decode_counters_add(&_decodeCounters, &_decodeCounters.packetsDemuxed[RDMPEGDecodeStreamVideo], 1);
+        
+        uint64_t sendVideoPacketStartTime = decode_counters_begin(&_decodeCounters);
+        int sendVideoPacketStatus = avcodec_send_packet(codecContext, &packet);
+        
+        // Decoder with reordering delay or frame threads holds the frame back until it's drained
+        if (sendVideoPacketStatus >= 0) {
+            sendVideoPacketStatus = avcodec_send_packet(codecContext, NULL);
+        }
+        decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamVideo, RDMPEGDecodeStageDecode, sendVideoPacketStartTime);
+        
+        av_packet_unref(&packet);
+        
+        if (sendVideoPacketStatus < 0) {
+            log4Error(@"Send keyframe packet to decoder error: %s", av_err2str(sendVideoPacketStatus));
+            avcodec_flush_buffers(codecContext);
+            continue;
+        }
+        
+        if ([self receiveFrameWithCodecContext:codecContext frame:_videoFrame stream:RDMPEGDecodeStreamVideo]) {
+            videoFrame = [self handleKeyframe:_videoFrame scaleFactor:scaleFactor];
+            av_frame_unref(_videoFrame);
+        }
+        
+        // Drained decoder accepts packets again only after flush
+        avcodec_flush_buffers(codecContext);
+    }
+    
+    [self updateVideoSkipFrame];
+    
+    return videoFrame;
+}
+
 - (BOOL)activateAudioStreamAtIndex:(nullable NSNumber *)audioStreamIndex
                       samplingRate:(double)samplingRate
                     outputChannels:(NSUInteger)outputChannels {
@@ -557,6 +995,66 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     [self activateSubtitleStreamAtIndex:nil];
 }
 
+- (void)resetDecodeStatistics {
+    decode_counters_reset(&_decodeCounters);
+}
+
+- (void)resetIOStatistics {
+    io_counters_reset(&_ioCounters);
+}
+
+- (BOOL)startIOTraceAtPath:(NSString *)path {
+    FILE *traceFile = fopen(path.fileSystemRepresentation, "w");
+    if (traceFile == NULL) {
+        log4Error(@"Unable to open IO trace file: %s (%@)", strerror(errno), path);
+        return NO;
+    }
+    
+    fputs("time_us,event,offset,whence,result,duration_us\n", traceFile);
+    
+    os_unfair_lock_lock(&_ioCounters.traceLock);
+    _ioCounters.traceStartTime = io_counters_now();
+    FILE *previousTraceFile = atomic_exchange_explicit(&_ioCounters.traceFile, traceFile, memory_order_relaxed);
+    os_unfair_lock_unlock(&_ioCounters.traceLock);
+    
+    if (previousTraceFile) {
+        fclose(previousTraceFile);
+    }
+    
+    return YES;
+}
+
+- (void)stopIOTrace {
+    os_unfair_lock_lock(&_ioCounters.traceLock);
+    FILE *traceFile = atomic_exchange_explicit(&_ioCounters.traceFile, NULL, memory_order_relaxed);
+    os_unfair_lock_unlock(&_ioCounters.traceLock);
+    
+    if (traceFile) {
+        fclose(traceFile);
+    }
+}
+
+#pragma mark - Private Accessors
+
+- (RDMPEGIOCounters *)ioCounters {
+    return &_ioCounters;
+}
+
+- (RDMPEGDecodeStreamStatistics *)decodeStatisticsForStream:(RDMPEGDecodeStream)stream {
+    _Atomic uint64_t *stageTime = _decodeCounters.stageTime[stream];
+    
+    return [[RDMPEGDecodeStreamStatistics alloc] initWithDemuxTime:atomic_load_explicit(&stageTime[RDMPEGDecodeStageDemux], memory_order_relaxed) / (double)NSEC_PER_SEC
+                                                        decodeTime:atomic_load_explicit(&stageTime[RDMPEGDecodeStageDecode], memory_order_relaxed) / (double)NSEC_PER_SEC
+                                                   deinterlaceTime:atomic_load_explicit(&stageTime[RDMPEGDecodeStageDeinterlace], memory_order_relaxed) / (double)NSEC_PER_SEC
+                                                       convertTime:atomic_load_explicit(&stageTime[RDMPEGDecodeStageConvert], memory_order_relaxed) / (double)NSEC_PER_SEC
+                                                          copyTime:atomic_load_explicit(&stageTime[RDMPEGDecodeStageCopy], memory_order_relaxed) / (double)NSEC_PER_SEC
+                                                    packetsDemuxed:atomic_load_explicit(&_decodeCounters.packetsDemuxed[stream], memory_order_relaxed)
+                                                     framesDecoded:atomic_load_explicit(&_decodeCounters.framesDecoded[stream], memory_order_relaxed)
+                                                     framesDropped:atomic_load_explicit(&_decodeCounters.framesDropped[stream], memory_order_relaxed)
+                                                   framesConverted:atomic_load_explicit(&_decodeCounters.framesConverted[stream], memory_order_relaxed)
+                                                       bytesCopied:atomic_load_explicit(&_decodeCounters.bytesCopied[stream], memory_order_relaxed)];
+}
+
 #pragma mark - Private Methods
 
 #pragma mark Open
@@ -619,8 +1117,11 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     
     self.activeVideoStream = videoStream;
     
+    [self updateVideoSkipFrame];
+    [self updateVideoDiscard];
+    
     if (preferredVideoFrameFormat == RDMPEGVideoFrameFormatYUV &&
-        (self.activeVideoStream.codecContext->pix_fmt == AV_PIX_FMT_YUV420P || self.activeVideoStream.codecContext->pix_fmt == AV_PIX_FMT_YUVJ420P)) {
+        rdmpeg_decode_core_is_yuv_format(self.activeVideoStream.codecContext->pix_fmt)) {
         self.actualVideoFrameFormat = RDMPEGVideoFrameFormatYUV;
     }
     else {
@@ -631,7 +1132,7 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
         *actualVideoFrameFormat = self.actualVideoFrameFormat;
     }
     
-    av_stream_FPS_timebase(videoStream.stream, 0.04, &_fps, &_videoTimeBase);
+    rdmpeg_decode_core_stream_fps_timebase(videoStream.stream, 0.04, &_fps, &_videoTimeBase);
     
     log4Info(@"Video codec size: %lu:%lu fps: %.3f tb: %f", (unsigned long)self.frameWidth, (unsigned long)self.frameHeight, _fps, _videoTimeBase);
     log4Info(@"Video start time %f disposition: %d", self.activeVideoStream.stream->start_time * _videoTimeBase, self.activeVideoStream.stream->disposition);
@@ -660,27 +1161,12 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     SwrContext *swrContext = NULL;
     
     if (audioCodecSupported == NO) {
-        swrContext = swr_alloc_set_opts(NULL,
-                                        av_get_default_channel_layout((int)outputChannels),
-                                        AV_SAMPLE_FMT_S16,
-                                        (int)samplingRate,
-                                        av_get_default_channel_layout(audioStream.codecContext->channels),
-                                        audioStream.codecContext->sample_fmt,
-                                        audioStream.codecContext->sample_rate,
-                                        0,
-                                        NULL);
+        swrContext = [self allocateResamplerForAudioStream:audioStream samplingRate:samplingRate outputChannels:outputChannels];
         
         if (swrContext == NULL) {
             [audioStream closeCodec];
             return [self errorWithCode:RDMPEGDecoderErrorCodeSampler];
         }
-        
-        if (swr_init(swrContext)) {
-            swr_free(&swrContext);
-            [audioStream closeCodec];
-            
-            return [self errorWithCode:RDMPEGDecoderErrorCodeSampler];
-        }
     }
     
     _audioFrame = av_frame_alloc();
@@ -697,7 +1183,7 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     self.audioSamplingRate = samplingRate;
     self.audioOutputChannels = outputChannels;
     
-    av_stream_FPS_timebase(self.activeAudioStream.stream, 0.025, NULL, &_audioTimeBase);
+    rdmpeg_decode_core_stream_fps_timebase(self.activeAudioStream.stream, 0.025, NULL, &_audioTimeBase);
     
     log4Info(@"Audio codec smr: %.d fmt: %d chn: %d tb: %f %@", self.activeAudioStream.codecContext->sample_rate, self.activeAudioStream.codecContext->sample_fmt, self.activeAudioStream.codecContext->channels, _audioTimeBase, _swrContext ? @"resample" : @"");
     
@@ -741,11 +1227,53 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
         }
     }
     
-    av_stream_FPS_timebase(self.activeSubtitleStream.stream, 0.01, NULL, &_subtitleTimeBase);
+    rdmpeg_decode_core_stream_fps_timebase(self.activeSubtitleStream.stream, 0.01, NULL, &_subtitleTimeBase);
     
     return nil;
 }
 
+// Resampler options can't be changed once it's initialized, so it's replaced and samples it holds are dropped
+- (void)reloadResampler {
+    if (_swrContext == NULL) {
+        return;
+    }
+    
+    SwrContext *swrContext = [self allocateResamplerForAudioStream:self.activeAudioStream
+                                                      samplingRate:self.audioSamplingRate
+                                                    outputChannels:self.audioOutputChannels];
+    if (swrContext == NULL) {
+        log4Error(@"Unable to reload audio resampler");
+        return;
+    }
+    
+    swr_free(&_swrContext);
+    _swrContext = swrContext;
+}
+
+- (nullable SwrContext *)allocateResamplerForAudioStream:(RDMPEGStream *)audioStream
+                                            samplingRate:(double)samplingRate
+                                          outputChannels:(NSUInteger)outputChannels {
+    RDMPEGDownmixLevels downmixLevels = RDMPEGDownmixLevelsITU;
+    switch (self.downmix) {
+        case RDMPEGDecoderDownmixITU: { downmixLevels = RDMPEGDownmixLevelsITU; break; }
+        case RDMPEGDecoderDownmixDialogueBoost: { downmixLevels = RDMPEGDownmixLevelsDialogueBoost; break; }
+    }
+    
+    const RDMPEGResamplerProfile *profile = &RDMPEGResamplerProfileBalanced;
+    switch (self.resamplerQuality) {
+        case RDMPEGDecoderResamplerQualityFast: { profile = &RDMPEGResamplerProfileFast; break; }
+        case RDMPEGDecoderResamplerQualityBalanced: { profile = &RDMPEGResamplerProfileBalanced; break; }
+        case RDMPEGDecoderResamplerQualityHigh: { profile = &RDMPEGResamplerProfileHigh; break; }
+    }
+    
+    return rdmpeg_decode_core_resampler_create(audioStream.codecContext,
+                                               (int)samplingRate,
+                                               (int)outputChannels,
+                                               AV_SAMPLE_FMT_S16,
+                                               downmixLevels,
+                                               profile);
+}
+
 - (void)closeVideoStream {
     [self unloadFilterGraph];
     
@@ -762,6 +1290,8 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
 }
 
 - (void)closeAudioStream {
+    [self unloadAudioFilterGraph];
+    
     [self.activeAudioStream closeCodec];
     
     self.activeAudioStream = nil;
@@ -779,6 +1309,16 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
         _swrContext = NULL;
     }
     
+    if (_sourceAudioBuffer) {
+        free(_sourceAudioBuffer);
+        _sourceAudioBuffer = NULL;
+        _sourceAudioBufferSize = 0;
+    }
+    
+    if (_sourceAudioSwrContext) {
+        swr_free(&_sourceAudioSwrContext);
+    }
+    
     if (_audioFrame) {
         av_freep(_audioFrame);
     }
@@ -791,8 +1331,41 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
 
 #pragma mark Decoding
 
-- (BOOL)receiveFrameWithCodecContext:(AVCodecContext *)codecContext frame:(AVFrame *)frame {
+- (void)flushCodecs {
+    if (self.activeVideoStream.codecContext) {
+        avcodec_flush_buffers(self.activeVideoStream.codecContext);
+    }
+    if (self.activeAudioStream.codecContext) {
+        avcodec_flush_buffers(self.activeAudioStream.codecContext);
+    }
+    if (self.activeSubtitleStream.codecContext) {
+        avcodec_flush_buffers(self.activeSubtitleStream.codecContext);
+    }
+    
+    [self unloadAudioFilterGraph];
+    [self flushResampler];
+}
+
+// Samples resampler delays and compensation in progress belong to the position decoding moved away from.
+// Reinitializing keeps its options, so the same context resamples audio decoded from the new position.
+- (void)flushResampler {
+    if (_swrContext == NULL) {
+        return;
+    }
+    
+    swr_close(_swrContext);
+    
+    int initStatus = swr_init(_swrContext);
+    if (initStatus < 0) {
+        log4Error(@"Audio resampler flush error: %s", av_err2str(initStatus));
+        [self reloadResampler];
+    }
+}
+
+- (BOOL)receiveFrameWithCodecContext:(AVCodecContext *)codecContext frame:(AVFrame *)frame stream:(RDMPEGDecodeStream)stream {
+    uint64_t receiveFrameStartTime = decode_counters_begin(&_decodeCounters);
     int receiveFrameStatus = avcodec_receive_frame(codecContext, frame);
+    decode_counters_end(&_decodeCounters, stream, RDMPEGDecodeStageDecode, receiveFrameStartTime);
     
     if (receiveFrameStatus == AVERROR(EAGAIN) || receiveFrameStatus == AVERROR_EOF) {
         return NO;
@@ -803,6 +1376,8 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
         return NO;
     }
     
+    decode_counters_add(&_decodeCounters, &_decodeCounters.framesDecoded[stream], 1);
+    
     return YES;
 }
 
@@ -818,46 +1393,93 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
         return NO;
     }
     
-    const AVFilter *buffer = avfilter_get_by_name("buffer");
-    const AVFilter *buffersink = avfilter_get_by_name("buffersink");
-    
-    _filterGraph = avfilter_graph_alloc();
+    _filterGraph = rdmpeg_decode_core_deinterlacer_create(self.activeVideoStream.codecContext);
     if (_filterGraph == NULL) {
+        log4Assert(NO, @"Unable to create deinterlacer");
         return NO;
     }
     
+    _filteredVideoFrame = av_frame_alloc();
+    if (_filteredVideoFrame == NULL) {
+        log4Assert(NO, @"Unable to create filter frame");
+        avfilter_graph_free(&_filterGraph);
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (void)unloadFilterGraph {
+    avfilter_graph_free(&_filterGraph);
+    
+    if (_filteredVideoFrame) {
+        av_freep(_filteredVideoFrame);
+    }
+}
+
+- (BOOL)setupAudioFilterGraphIfNeeded {
+    if (_audioFilterGraph) {
+        return YES;
+    }
+    
+    AVCodecContext *codecContext = self.activeAudioStream.codecContext;
+    if (codecContext == NULL) {
+        log4Assert(NO, @"Active audio stream with correct codec context should exist");
+        return NO;
+    }
+    
+    const AVFilter *abuffer = avfilter_get_by_name("abuffer");
+    const AVFilter *abuffersink = avfilter_get_by_name("abuffersink");
+    
+    _audioFilterGraph = avfilter_graph_alloc();
+    if (_audioFilterGraph == NULL) {
+        return NO;
+    }
+    
+    uint64_t channelLayout = rdmpeg_decode_core_channel_layout(codecContext);
+    
     char args[512];
     snprintf(args, sizeof(args),
-             "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
-             self.activeVideoStream.codecContext->width,
-             self.activeVideoStream.codecContext->height,
-             self.activeVideoStream.codecContext->pix_fmt,
-             self.activeVideoStream.codecContext->time_base.num,
-             self.activeVideoStream.codecContext->time_base.den,
-             self.activeVideoStream.codecContext->sample_aspect_ratio.num,
-             self.activeVideoStream.codecContext->sample_aspect_ratio.den);
-    
-    AVFilterContext *bufferContext = NULL;
-    AVFilterContext *buffersinkContext = NULL;
-    
-    int createInFilterStatus = avfilter_graph_create_filter(&bufferContext, buffer, "in", args, NULL, _filterGraph);
+             "time_base=1/%d:sample_rate=%d:sample_fmt=%s:channel_layout=0x%" PRIx64,
+             codecContext->sample_rate,
+             codecContext->sample_rate,
+             av_get_sample_fmt_name(codecContext->sample_fmt),
+             channelLayout);
+    
+    AVFilterContext *abufferContext = NULL;
+    AVFilterContext *abuffersinkContext = NULL;
+    
+    int createInFilterStatus = avfilter_graph_create_filter(&abufferContext, abuffer, "in", args, NULL, _audioFilterGraph);
     if (createInFilterStatus < 0) {
-        log4Assert(NO, @"Create in filter error: %s", av_err2str(createInFilterStatus));
-        avfilter_graph_free(&_filterGraph);
+        log4Assert(NO, @"Create audio in filter error: %s", av_err2str(createInFilterStatus));
+        avfilter_graph_free(&_audioFilterGraph);
         return NO;
     }
     
-    int createOutFilterStatus = avfilter_graph_create_filter(&buffersinkContext, buffersink, "out", NULL, NULL, _filterGraph);
+    int createOutFilterStatus = avfilter_graph_create_filter(&abuffersinkContext, abuffersink, "out", NULL, NULL, _audioFilterGraph);
     if (createOutFilterStatus < 0) {
-        log4Assert(NO, @"Create out filter error: %s", av_err2str(createOutFilterStatus));
-        avfilter_graph_free(&_filterGraph);
+        log4Assert(NO, @"Create audio out filter error: %s", av_err2str(createOutFilterStatus));
+        avfilter_graph_free(&_audioFilterGraph);
         return NO;
     }
     
-    AVFilterInOut *inputs  = avfilter_inout_alloc();
+    // atempo works with packed samples only, output is converted back to decoder format expected by resampler
+    const enum AVSampleFormat sampleFormats[] = { codecContext->sample_fmt, AV_SAMPLE_FMT_NONE };
+    const int64_t channelLayouts[] = { (int64_t)channelLayout, -1 };
+    const int sampleRates[] = { codecContext->sample_rate, -1 };
+    
+    if (av_opt_set_int_list(abuffersinkContext, "sample_fmts", sampleFormats, AV_SAMPLE_FMT_NONE, AV_OPT_SEARCH_CHILDREN) < 0 ||
+        av_opt_set_int_list(abuffersinkContext, "channel_layouts", channelLayouts, -1, AV_OPT_SEARCH_CHILDREN) < 0 ||
+        av_opt_set_int_list(abuffersinkContext, "sample_rates", sampleRates, -1, AV_OPT_SEARCH_CHILDREN) < 0) {
+        log4Assert(NO, @"Unable to setup audio out filter format");
+        avfilter_graph_free(&_audioFilterGraph);
+        return NO;
+    }
+    
+    AVFilterInOut *inputs = avfilter_inout_alloc();
     if (inputs == NULL) {
         log4Assert(NO, @"Unable to create inputs");
-        avfilter_graph_free(&_filterGraph);
+        avfilter_graph_free(&_audioFilterGraph);
         return NO;
     }
     
@@ -865,53 +1487,95 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     if (outputs == NULL) {
         log4Assert(NO, @"Unable to create outputs");
         avfilter_inout_free(&inputs);
-        avfilter_graph_free(&_filterGraph);
+        avfilter_graph_free(&_audioFilterGraph);
         return NO;
     }
     
     outputs->name = av_strdup("in");
-    outputs->filter_ctx = bufferContext;
+    outputs->filter_ctx = abufferContext;
     outputs->pad_idx = 0;
     outputs->next = NULL;
     
     inputs->name = av_strdup("out");
-    inputs->filter_ctx = buffersinkContext;
+    inputs->filter_ctx = abuffersinkContext;
     inputs->pad_idx = 0;
     inputs->next = NULL;
     
-    int parseGraphStatus = avfilter_graph_parse_ptr(_filterGraph, "yadif=0:-1:0", &inputs, &outputs, NULL);
+    char filters[128];
+    if (self.playbackRate < RDMPEGDecoderMinimumTempo) {
+        snprintf(filters, sizeof(filters), "atempo=%f,atempo=%f", RDMPEGDecoderMinimumTempo, self.playbackRate / RDMPEGDecoderMinimumTempo);
+    }
+    else {
+        snprintf(filters, sizeof(filters), "atempo=%f", self.playbackRate);
+    }
+    
+    int parseGraphStatus = avfilter_graph_parse_ptr(_audioFilterGraph, filters, &inputs, &outputs, NULL);
     
     avfilter_inout_free(&inputs);
     avfilter_inout_free(&outputs);
     
     if (parseGraphStatus < 0) {
-        log4Assert(NO, @"Parse graph error: %s", av_err2str(parseGraphStatus));
-        avfilter_graph_free(&_filterGraph);
+        log4Assert(NO, @"Parse audio graph error: %s", av_err2str(parseGraphStatus));
+        avfilter_graph_free(&_audioFilterGraph);
         return NO;
     }
     
-    int configureGraphStatus = avfilter_graph_config(_filterGraph, NULL);
+    int configureGraphStatus = avfilter_graph_config(_audioFilterGraph, NULL);
     if (configureGraphStatus < 0) {
-        log4Assert(NO, @"Configure graph error: %s", av_err2str(configureGraphStatus));
-        avfilter_graph_free(&_filterGraph);
+        log4Assert(NO, @"Configure audio graph error: %s", av_err2str(configureGraphStatus));
+        avfilter_graph_free(&_audioFilterGraph);
         return NO;
     }
     
-    _filteredVideoFrame = av_frame_alloc();
-    if (_filteredVideoFrame == NULL) {
-        log4Assert(NO, @"Unable to create filter frame");
-        avfilter_graph_free(&_filterGraph);
+    _stretchedAudioFrame = av_frame_alloc();
+    if (_stretchedAudioFrame == NULL) {
+        log4Assert(NO, @"Unable to create audio filter frame");
+        avfilter_graph_free(&_audioFilterGraph);
         return NO;
     }
     
+    _stretchedAudioStarted = NO;
+    
+    log4Info(@"Audio time stretch: %s", filters);
+    
     return YES;
 }
 
-- (void)unloadFilterGraph {
-    avfilter_graph_free(&_filterGraph);
+- (void)unloadAudioFilterGraph {
+    // Samples buffered by atempo are dropped, it's only unloaded on seek or rate change anyway
+    avfilter_graph_free(&_audioFilterGraph);
     
-    if (_filteredVideoFrame) {
-        av_freep(_filteredVideoFrame);
+    if (_stretchedAudioFrame) {
+        av_frame_free(&_stretchedAudioFrame);
+    }
+    
+    _stretchedAudioStarted = NO;
+}
+
+- (void)updateVideoSkipFrame {
+    if (self.activeVideoStream.codecContext == NULL) {
+        return;
+    }
+    
+    RDMPEGDecoderFrameSkip frameSkip = self.frameSkip;
+    
+    // Decoder has to produce frames faster than realtime by the rate, dropping B-frames keeps it up
+    if (self.playbackRate >= RDMPEGDecoderSkipNonReferenceFramesRate) {
+        frameSkip = MAX(frameSkip, RDMPEGDecoderFrameSkipNonReference);
+    }
+    
+    switch (frameSkip) {
+        case RDMPEGDecoderFrameSkipNone: { self.activeVideoStream.codecContext->skip_frame = AVDISCARD_DEFAULT; break; }
+        case RDMPEGDecoderFrameSkipNonReference: { self.activeVideoStream.codecContext->skip_frame = AVDISCARD_NONREF; break; }
+        case RDMPEGDecoderFrameSkipBidirectional: { self.activeVideoStream.codecContext->skip_frame = AVDISCARD_BIDIR; break; }
+        case RDMPEGDecoderFrameSkipNonKey: { self.activeVideoStream.codecContext->skip_frame = AVDISCARD_NONKEY; break; }
+    }
+}
+
+- (void)updateVideoDiscard {
+    // Inactive video streams too, so audio-only decoding doesn't read them even if video stream isn't loaded
+    for (RDMPEGStream *videoStream in self.videoStreams) {
+        videoStream.stream->discard = self.isVideoDiscarded ? AVDISCARD_ALL : AVDISCARD_DEFAULT;
     }
 }
 
@@ -927,13 +1591,7 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
         return nil;
     }
     
-    NSTimeInterval frameOffset = 0.0;
-    
-    if (self.activeVideoStream.stream->start_time != AV_NOPTS_VALUE) {
-        frameOffset = self.activeVideoStream.stream->start_time * _videoTimeBase;
-    }
-    
-    NSTimeInterval framePosition = avFrame->best_effort_timestamp * _videoTimeBase - frameOffset;
+    NSTimeInterval framePosition = rdmpeg_decode_core_frame_position(self.activeVideoStream.stream, _videoTimeBase, avFrame);
     
     NSTimeInterval frameDuration = 0.0;
     if (avFrame->pkt_duration) {
@@ -946,12 +1604,20 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
         frameDuration = 1.0 / _fps;
     }
     
+    if (framePosition + frameDuration < self.videoDropPosition) {
+        // Playback already passed the frame, it would be dropped anyway
+        return nil;
+    }
+    
     RDMPEGVideoFrame *videoFrame;
     
     if (self.actualVideoFrameFormat == RDMPEGVideoFrameFormatYUV) {
+        uint64_t copyStartTime = decode_counters_begin(&_decodeCounters);
         NSData *luma = copy_frame_data(avFrame->data[0], avFrame->linesize[0], self.activeVideoStream.codecContext->width, self.activeVideoStream.codecContext->height);
         NSData *chromaB = copy_frame_data(avFrame->data[1], avFrame->linesize[1], self.activeVideoStream.codecContext->width / 2, self.activeVideoStream.codecContext->height / 2);
         NSData *chromaR = copy_frame_data(avFrame->data[2], avFrame->linesize[2], self.activeVideoStream.codecContext->width / 2, self.activeVideoStream.codecContext->height / 2);
+        decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamVideo, RDMPEGDecodeStageCopy, copyStartTime);
+        decode_counters_add(&_decodeCounters, &_decodeCounters.bytesCopied[RDMPEGDecodeStreamVideo], luma.length + chromaB.length + chromaR.length);
         
         videoFrame = [[RDMPEGVideoFrameYUV alloc] initWithPosition:framePosition
                                                           duration:frameDuration
@@ -967,6 +1633,7 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
             return nil;
         }
         
+        uint64_t convertStartTime = decode_counters_begin(&_decodeCounters);
         sws_scale(_swsContext,
                   (const uint8_t **)avFrame->data,
                   avFrame->linesize,
@@ -974,9 +1641,14 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
                   self.activeVideoStream.codecContext->height,
                   _bgraVideoFrame->data,
                   _bgraVideoFrame->linesize);
+        decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamVideo, RDMPEGDecodeStageConvert, convertStartTime);
+        decode_counters_add(&_decodeCounters, &_decodeCounters.framesConverted[RDMPEGDecodeStreamVideo], 1);
         
+        uint64_t copyStartTime = decode_counters_begin(&_decodeCounters);
         NSUInteger linesize = _bgraVideoFrame->linesize[0];
         NSData *bgra = [NSData dataWithBytes:_bgraVideoFrame->data[0] length:(linesize * self.activeVideoStream.codecContext->height)];
+        decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamVideo, RDMPEGDecodeStageCopy, copyStartTime);
+        decode_counters_add(&_decodeCounters, &_decodeCounters.bytesCopied[RDMPEGDecodeStreamVideo], bgra.length);
         
         videoFrame = [[RDMPEGVideoFrameBGRA alloc] initWithPosition:framePosition
                                                            duration:frameDuration
@@ -986,51 +1658,165 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
                                                            linesize:linesize];
     }
     
+    videoFrame.isKeyframe = rdmpeg_decode_core_is_keyframe(avFrame) != 0;
+    
     return videoFrame;
 }
 
-- (nullable RDMPEGAudioFrame *)handleAudioFrame {
-    if (_audioFrame == NULL) {
-        log4Assert(NO, @"Audio frame doesn't exist");
+- (nullable RDMPEGVideoFrame *)handleKeyframe:(AVFrame *)avFrame scaleFactor:(NSUInteger)scaleFactor {
+    if (avFrame->data[0] == NULL) {
         return nil;
     }
     
-    if (_audioFrame->data[0] == NULL) {
+    NSTimeInterval framePosition = rdmpeg_decode_core_frame_position(self.activeVideoStream.stream, _videoTimeBase, avFrame);
+    
+    // Chroma planes are half the size, so dimensions are kept even
+    scaleFactor = MAX(scaleFactor, 1);
+    int width = MAX(2, (avFrame->width / (int)scaleFactor) & ~1);
+    int height = MAX(2, (avFrame->height / (int)scaleFactor) & ~1);
+    enum AVPixelFormat format = (self.actualVideoFrameFormat == RDMPEGVideoFrameFormatYUV) ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_BGRA;
+    
+    _keyframeSwsContext = sws_getCachedContext(_keyframeSwsContext,
+                                               avFrame->width,
+                                               avFrame->height,
+                                               avFrame->format,
+                                               width,
+                                               height,
+                                               format,
+                                               SWS_FAST_BILINEAR,
+                                               NULL, NULL, NULL);
+    
+    if (_keyframeSwsContext == NULL) {
+        log4Assert(NO, @"Failed to setup keyframe scaler");
         return nil;
     }
     
-    NSInteger samplesCount;
-    void *audioData;
+    AVFrame *scaledFrame = av_frame_alloc();
     
-    if (_swrContext) {
-        const NSUInteger ratio = MAX(1, self.audioSamplingRate / self.activeAudioStream.codecContext->sample_rate) *
-                                 MAX(1, self.audioOutputChannels / self.activeAudioStream.codecContext->channels) * 2;
+    if (scaledFrame == NULL) {
+        return nil;
+    }
+    
+    scaledFrame->width = width;
+    scaledFrame->height = height;
+    scaledFrame->format = format;
+    
+    int bufferStatus = av_frame_get_buffer(scaledFrame, 0);
+    
+    if (bufferStatus < 0) {
+        log4Error(@"Allocate keyframe buffer error: %s", av_err2str(bufferStatus));
+        av_frame_free(&scaledFrame);
+        return nil;
+    }
+    
+    uint64_t convertStartTime = decode_counters_begin(&_decodeCounters);
+    sws_scale(_keyframeSwsContext,
+              (const uint8_t **)avFrame->data,
+              avFrame->linesize,
+              0,
+              avFrame->height,
+              scaledFrame->data,
+              scaledFrame->linesize);
+    decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamVideo, RDMPEGDecodeStageConvert, convertStartTime);
+    decode_counters_add(&_decodeCounters, &_decodeCounters.framesConverted[RDMPEGDecodeStreamVideo], 1);
+    
+    RDMPEGVideoFrame *videoFrame;
+    
+    if (format == AV_PIX_FMT_YUV420P) {
+        NSData *luma = copy_frame_data(scaledFrame->data[0], scaledFrame->linesize[0], width, height);
+        NSData *chromaB = copy_frame_data(scaledFrame->data[1], scaledFrame->linesize[1], width / 2, height / 2);
+        NSData *chromaR = copy_frame_data(scaledFrame->data[2], scaledFrame->linesize[2], width / 2, height / 2);
         
-        const int bufSize = av_samples_get_buffer_size(NULL,
-                                                       (int)self.audioOutputChannels,
-                                                       (int)(_audioFrame->nb_samples * ratio),
-                                                       AV_SAMPLE_FMT_S16,
-                                                       1);
+        videoFrame = [[RDMPEGVideoFrameYUV alloc] initWithPosition:framePosition
+                                                          duration:1.0 / _fps
+                                                             width:width
+                                                            height:height
+                                                              luma:luma
+                                                           chromaB:chromaB
+                                                           chromaR:chromaR];
+    }
+    else {
+        NSData *bgra = copy_frame_data(scaledFrame->data[0], scaledFrame->linesize[0], width * 4, height);
         
-        if (_swrBuffer == NULL || _swrBufferSize < bufSize) {
-            _swrBufferSize = bufSize;
-            _swrBuffer = realloc(_swrBuffer, _swrBufferSize);
+        videoFrame = [[RDMPEGVideoFrameBGRA alloc] initWithPosition:framePosition
+                                                           duration:1.0 / _fps
+                                                              width:width
+                                                             height:height
+                                                               bgra:bgra
+                                                           linesize:width * 4];
+    }
+    
+    av_frame_free(&scaledFrame);
+    
+    videoFrame.isKeyframe = YES;
+    
+    return videoFrame;
+}
+
+// Frames which are already interleaved floats are handed over as they are, others are converted keeping the format
+- (void)handleSourceAudioFrame:(AVFrame *)avFrame {
+    if (avFrame->data[0] == NULL || avFrame->nb_samples <= 0) {
+        return;
+    }
+    
+    AVCodecContext *codecContext = self.activeAudioStream.codecContext;
+    
+    if (codecContext->sample_fmt == AV_SAMPLE_FMT_FLT) {
+        self.sourceAudioHandler((const float *)avFrame->data[0], (NSUInteger)avFrame->nb_samples);
+        return;
+    }
+    
+    if (_sourceAudioSwrContext == NULL) {
+        _sourceAudioSwrContext = rdmpeg_decode_core_float_converter_create(codecContext);
+        if (_sourceAudioSwrContext == NULL) {
+            log4Error(@"Unable to setup source audio converter");
+            return;
         }
-        
-        Byte *outbuf[2] = {_swrBuffer, 0};
-        
-        samplesCount = swr_convert(_swrContext,
-                                   outbuf,
-                                   (int)(_audioFrame->nb_samples * ratio),
-                                   (const uint8_t **)_audioFrame->data,
-                                   _audioFrame->nb_samples);
+    }
+    
+    int samplesCount = rdmpeg_decode_core_convert_to_float(_sourceAudioSwrContext,
+                                                           codecContext,
+                                                           avFrame,
+                                                           &_sourceAudioBuffer,
+                                                           &_sourceAudioBufferSize);
+    if (samplesCount < 0) {
+        log4Error(@"Source audio conversion error: %s", av_err2str(samplesCount));
+        return;
+    }
+    
+    self.sourceAudioHandler((const float *)_sourceAudioBuffer, (NSUInteger)samplesCount);
+}
+
+- (nullable RDMPEGAudioFrame *)handleAudioFrame:(AVFrame *)avFrame {
+    if (avFrame == NULL) {
+        log4Assert(NO, @"Audio frame doesn't exist");
+        return nil;
+    }
+    
+    if (avFrame->data[0] == NULL) {
+        return nil;
+    }
+    
+    NSInteger samplesCount;
+    const int16_t *audioData;
+    
+    uint64_t convertStartTime = decode_counters_begin(&_decodeCounters);
+    
+    if (_swrContext) {
+        samplesCount = rdmpeg_decode_core_resample(_swrContext,
+                                                   self.activeAudioStream.codecContext,
+                                                   avFrame,
+                                                   (int)self.audioSamplingRate,
+                                                   (int)self.audioOutputChannels,
+                                                   &_swrBuffer,
+                                                   &_swrBufferSize);
         
         if (samplesCount < 0) {
-            log4Assert(NO, @"Failed to resample audio");
+            log4Assert(NO, @"Failed to resample audio: %s", av_err2str((int)samplesCount));
             return nil;
         }
         
-        audioData = _swrBuffer;
+        audioData = (const int16_t *)_swrBuffer;
     }
     else {
         if (self.activeAudioStream.codecContext->sample_fmt != AV_SAMPLE_FMT_S16) {
@@ -1038,34 +1824,40 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
             return nil;
         }
         
-        audioData = _audioFrame->data[0];
-        samplesCount = _audioFrame->nb_samples;
+        audioData = (const int16_t *)avFrame->data[0];
+        samplesCount = avFrame->nb_samples;
     }
     
     const NSUInteger elementsCount = samplesCount * self.audioOutputChannels;
     NSMutableData *samples = [NSMutableData dataWithLength:(elementsCount * sizeof(float))];
     
-    float scale = 1.0 / (float)INT16_MAX;
-    vDSP_vflt16((SInt16 *)audioData, 1, samples.mutableBytes, 1, elementsCount);
-    vDSP_vsmul(samples.mutableBytes, 1, &scale, samples.mutableBytes, 1, elementsCount);
+    rdmpeg_decode_core_samples_to_float(audioData, samples.mutableBytes, elementsCount);
     
-    NSTimeInterval frameOffset = 0.0;
-    
-    if (self.activeAudioStream.stream->start_time != AV_NOPTS_VALUE) {
-        frameOffset = self.activeAudioStream.stream->start_time * _audioTimeBase;
-    }
-    
-    NSTimeInterval framePosition = _audioFrame->best_effort_timestamp * _audioTimeBase - frameOffset;
+    decode_counters_end(&_decodeCounters, RDMPEGDecodeStreamAudio, RDMPEGDecodeStageConvert, convertStartTime);
+    decode_counters_add(&_decodeCounters, &_decodeCounters.framesConverted[RDMPEGDecodeStreamAudio], 1);
+    decode_counters_add(&_decodeCounters, &_decodeCounters.bytesCopied[RDMPEGDecodeStreamAudio], samples.length);
     
+    NSTimeInterval framePosition = 0.0;
     NSTimeInterval frameDuration = 0.0;
-    if (_audioFrame->pkt_duration) {
-        frameDuration = _audioFrame->pkt_duration * _audioTimeBase;
+    
+    if (avFrame == _stretchedAudioFrame) {
+        // Stretched frame plays shorter (or longer) than media time it covers, frames are positioned back to back
+        frameDuration = avFrame->nb_samples * self.playbackRate / avFrame->sample_rate;
+        framePosition = _stretchedAudioPosition;
+        _stretchedAudioPosition += frameDuration;
     }
     else {
-        // sometimes ffmpeg can't determine the duration of audio frame
-        // especially of wma/wmv format
-        // so in this case must compute duration
-        frameDuration = samples.length / (sizeof(float) * self.audioOutputChannels * self.audioSamplingRate);
+        framePosition = [self positionOfAudioFrame:avFrame];
+        
+        if (avFrame->pkt_duration) {
+            frameDuration = avFrame->pkt_duration * _audioTimeBase;
+        }
+        else {
+            // sometimes ffmpeg can't determine the duration of audio frame
+            // especially of wma/wmv format
+            // so in this case must compute duration
+            frameDuration = samples.length / (sizeof(float) * self.audioOutputChannels * self.audioSamplingRate);
+        }
     }
     
     RDMPEGAudioFrame *audioFrame = [[RDMPEGAudioFrame alloc] initWithPosition:framePosition
@@ -1074,6 +1866,10 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
     return audioFrame;
 }
 
+- (NSTimeInterval)positionOfAudioFrame:(AVFrame *)avFrame {
+    return rdmpeg_decode_core_frame_position(self.activeAudioStream.stream, _audioTimeBase, avFrame);
+}
+
 - (nullable RDMPEGSubtitleFrame *)handleSubtitle:(AVSubtitle *)pSubtitle {
     NSMutableString *mutableSubtitle = [NSMutableString string];
     
@@ -1122,40 +1918,13 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
 - (BOOL)setupVideoScaler {
     [self closeVideoScaler];
     
-    _bgraVideoFrame = av_frame_alloc();
+    _bgraVideoFrame = rdmpeg_decode_core_bgra_frame_create(self.activeVideoStream.codecContext);
     
     if (_bgraVideoFrame == NULL) {
         return NO;
     }
     
-    _bgraVideoFrame->width = self.activeVideoStream.codecContext->width;
-    _bgraVideoFrame->height = self.activeVideoStream.codecContext->height;
-    _bgraVideoFrame->format = AV_PIX_FMT_BGRA;
-    
-    int imageStatusCode = av_image_alloc(_bgraVideoFrame->data,
-                                         _bgraVideoFrame->linesize,
-                                         _bgraVideoFrame->width,
-                                         _bgraVideoFrame->height,
-                                         _bgraVideoFrame->format,
-                                         1);
-    
-    if (imageStatusCode < 0) {
-        log4Error(@"Allocate image error: %s", av_err2str(imageStatusCode));
-        
-        av_freep(_bgraVideoFrame);
-        
-        return NO;
-    }
-    
-    _swsContext = sws_getCachedContext(_swsContext,
-                                       self.activeVideoStream.codecContext->width,
-                                       self.activeVideoStream.codecContext->height,
-                                       self.activeVideoStream.codecContext->pix_fmt,
-                                       _bgraVideoFrame->width,
-                                       _bgraVideoFrame->height,
-                                       _bgraVideoFrame->format,
-                                       SWS_FAST_BILINEAR,
-                                       NULL, NULL, NULL);
+    _swsContext = rdmpeg_decode_core_bgra_scaler(_swsContext, self.activeVideoStream.codecContext, _bgraVideoFrame);
     
     return (_swsContext != NULL);
 }
@@ -1166,10 +1935,12 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
         _swsContext = NULL;
     }
     
-    if (_bgraVideoFrame) {
-        av_freep(_bgraVideoFrame->data);
-        av_freep(_bgraVideoFrame);
+    if (_keyframeSwsContext) {
+        sws_freeContext(_keyframeSwsContext);
+        _keyframeSwsContext = NULL;
     }
+    
+    rdmpeg_decode_core_bgra_frame_free(&_bgraVideoFrame);
 }
 
 #pragma mark Errors
@@ -1202,23 +1973,6 @@ static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height);
 
 
 
-static void ffmpeg_log(void *context, int level, const char *format, va_list args) {
-    @autoreleasepool {
-        if (level == AV_LOG_PANIC ||
-            level == AV_LOG_FATAL ||
-            level == AV_LOG_ERROR) {
-            log4CError(@"%@", [[NSString alloc] initWithFormat:[NSString stringWithUTF8String:format] arguments:args]);
-        }
-        else if (level == AV_LOG_WARNING) {
-            log4CWarn(@"%@", [[NSString alloc] initWithFormat:[NSString stringWithUTF8String:format] arguments:args]);
-        }
-        else if (level == AV_LOG_INFO ||
-                 level == AV_LOG_VERBOSE) {
-            log4CDebug(@"%@", [[NSString alloc] initWithFormat:[NSString stringWithUTF8String:format] arguments:args]);
-        }
-    }
-}
-
 static int interrupt_callback(void *ctx) {
     if (ctx == NULL) {
         return 0;
@@ -1241,7 +1995,10 @@ static int iostream_readbuffer(void *ctx, uint8_t *buf, int buf_size) {
     RDMPEGDecoder *decoder = (__bridge RDMPEGDecoder *)ctx;
     
     if (decoder.ioStream) {
-        return (int)[decoder.ioStream readBuffer:buf length:buf_size];
+        uint64_t startTime = io_counters_now();
+        int result = (int)[decoder.ioStream readBuffer:buf length:buf_size];
+        io_counters_record_read(decoder.ioCounters, result, io_counters_now() - startTime);
+        return result;
     }
     else {
         log4CError(@"Method 'iostream_readbuffer' should be called only if stream exist");
@@ -1258,14 +2015,20 @@ static int64_t iostream_seekoffset(void *ctx, int64_t offset, int whence) {
     RDMPEGDecoder *decoder = (__bridge RDMPEGDecoder *)ctx;
     
     if (decoder.ioStream) {
+        uint64_t startTime = io_counters_now();
+        int64_t result = -1;
+        
         if (whence == AVSEEK_SIZE) {
-            if ([decoder.ioStream respondsToSelector:@selector(contentLength)] == NO) {
-                return -1;
+            if ([decoder.ioStream respondsToSelector:@selector(contentLength)]) {
+                result = decoder.ioStream.contentLength;
             }
-            return decoder.ioStream.contentLength;
+        }
+        else {
+            result = [decoder.ioStream seekOffset:offset whence:whence];
         }
         
-        return [decoder.ioStream seekOffset:offset whence:whence];
+        io_counters_record_seek(decoder.ioCounters, offset, whence, result, io_counters_now() - startTime);
+        return result;
     }
     else {
         log4CError(@"Method 'iostream_seekoffset' should be called only if stream exist");
@@ -1274,50 +2037,144 @@ static int64_t iostream_seekoffset(void *ctx, int64_t offset, int whence) {
     }
 }
 
-static void av_stream_FPS_timebase(AVStream *st, double defaultTimeBase, double * _Nullable pFPS, double * _Nullable pTimeBase) {
-    double fps;
-    double timebase;
+static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height) {
+    NSMutableData *frameData = [NSMutableData dataWithLength:rdmpeg_decode_core_plane_size(linesize, width, height)];
+    rdmpeg_decode_core_copy_plane(frameData.mutableBytes, src, linesize, width, height);
     
-    if (st->time_base.den && st->time_base.num) {
-        timebase = av_q2d(st->time_base);
+    return frameData;
+}
+
+static uint64_t io_counters_now(void) {
+    return clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+}
+
+static void io_counters_reset(RDMPEGIOCounters *counters) {
+    atomic_store_explicit(&counters->readBytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->readCalls, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->readErrors, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->readTime, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->seekCalls, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->seekDistance, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->sizeQueries, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->readFrameCalls, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->readFrameTime, 0, memory_order_relaxed);
+    
+    for (int bucket = 0; bucket < RDMPEG_IO_LATENCY_BUCKETS; bucket++) {
+        atomic_store_explicit(&counters->readLatency[bucket], 0, memory_order_relaxed);
     }
-    else {
-        log4CWarn(@"Default timebase used: %f", defaultTimeBase);
-        NSCParameterAssert(NO);
-        timebase = defaultTimeBase;
+}
+
+static void io_counters_record_read(RDMPEGIOCounters *counters, int result, uint64_t duration) {
+    atomic_fetch_add_explicit(&counters->readCalls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->readTime, duration, memory_order_relaxed);
+    
+    if (result > 0) {
+        atomic_fetch_add_explicit(&counters->readBytes, result, memory_order_relaxed);
+        counters->position += result;
+    }
+    else if (result < 0) {
+        atomic_fetch_add_explicit(&counters->readErrors, 1, memory_order_relaxed);
     }
     
-    if (st->avg_frame_rate.den && st->avg_frame_rate.num) {
-        fps = av_q2d(st->avg_frame_rate);
+    // Bucket is floor(log2(microseconds)), so bucket N holds reads faster than 2^(N+1) microseconds
+    uint64_t microseconds = duration / NSEC_PER_USEC;
+    int bucket = microseconds > 0 ? 63 - __builtin_clzll(microseconds) : 0;
+    bucket = MIN(bucket, RDMPEG_IO_LATENCY_BUCKETS - 1);
+    atomic_fetch_add_explicit(&counters->readLatency[bucket], 1, memory_order_relaxed);
+    
+    io_counters_trace(counters, "read", counters->position, 0, result, duration);
+}
+
+static void io_counters_record_seek(RDMPEGIOCounters *counters, int64_t offset, int whence, int64_t result, uint64_t duration) {
+    if (whence == AVSEEK_SIZE) {
+        atomic_fetch_add_explicit(&counters->sizeQueries, 1, memory_order_relaxed);
+        io_counters_trace(counters, "size", offset, whence, result, duration);
+        return;
     }
-    else if (st->r_frame_rate.den && st->r_frame_rate.num) {
-        fps = av_q2d(st->r_frame_rate);
+    
+    atomic_fetch_add_explicit(&counters->seekCalls, 1, memory_order_relaxed);
+    
+    if (result >= 0) {
+        uint64_t distance = (uint64_t)llabs(result - counters->position);
+        atomic_fetch_add_explicit(&counters->seekDistance, distance, memory_order_relaxed);
+        counters->position = result;
     }
-    else {
-        fps = 1.0 / timebase;
-        log4CWarn(@"Default fps used: %f", fps);
+    
+    io_counters_trace(counters, "seek", offset, whence, result, duration);
+}
+
+static void io_counters_record_read_frame(RDMPEGIOCounters *counters, int result, uint64_t duration) {
+    atomic_fetch_add_explicit(&counters->readFrameCalls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->readFrameTime, duration, memory_order_relaxed);
+    
+    io_counters_trace(counters, "read_frame", 0, 0, result, duration);
+}
+
+static void io_counters_trace(RDMPEGIOCounters *counters, const char *event, int64_t offset, int whence, int64_t result, uint64_t duration) {
+    if (atomic_load_explicit(&counters->traceFile, memory_order_relaxed) == NULL) {
+        return;
     }
     
-    if (pFPS) {
-        *pFPS = fps;
+    os_unfair_lock_lock(&counters->traceLock);
+    
+    // Trace could stop before the lock was taken
+    FILE *traceFile = atomic_load_explicit(&counters->traceFile, memory_order_relaxed);
+    if (traceFile) {
+        uint64_t now = io_counters_now();
+        fprintf(traceFile,
+                "%llu,%s,%lld,%d,%lld,%llu\n",
+                (now - counters->traceStartTime) / NSEC_PER_USEC,
+                event,
+                offset,
+                whence,
+                result,
+                duration / NSEC_PER_USEC);
     }
-    if (pTimeBase) {
-        *pTimeBase = timebase;
+    
+    os_unfair_lock_unlock(&counters->traceLock);
+}
+
+static uint64_t decode_counters_begin(RDMPEGDecodeCounters *counters) {
+    // Zero start time means statistics were disabled, so the matching end call is a no-op
+    if (atomic_load_explicit(&counters->enabled, memory_order_relaxed) == false) {
+        return 0;
     }
+    
+    return io_counters_now();
 }
 
-static NSData *copy_frame_data(UInt8 *src, int linesize, int width, int height) {
-    width = MIN(linesize, width);
+static void decode_counters_end(RDMPEGDecodeCounters *counters, RDMPEGDecodeStream stream, RDMPEGDecodeStage stage, uint64_t startTime) {
+    if (startTime == 0) {
+        return;
+    }
     
-    NSMutableData *frameData = [NSMutableData dataWithLength:(width * height)];
-    Byte *dst = frameData.mutableBytes;
-    for (NSUInteger i = 0; i < height; ++i) {
-        memcpy(dst, src, width);
-        dst += width;
-        src += linesize;
+    atomic_fetch_add_explicit(&counters->stageTime[stream][stage], io_counters_now() - startTime, memory_order_relaxed);
+}
+
+static void decode_counters_add_time(RDMPEGDecodeCounters *counters, RDMPEGDecodeStream stream, RDMPEGDecodeStage stage, uint64_t duration) {
+    decode_counters_add(counters, &counters->stageTime[stream][stage], duration);
+}
+
+static void decode_counters_add(RDMPEGDecodeCounters *counters, _Atomic uint64_t *counter, uint64_t value) {
+    if (atomic_load_explicit(&counters->enabled, memory_order_relaxed) == false) {
+        return;
     }
     
-    return frameData;
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+static void decode_counters_reset(RDMPEGDecodeCounters *counters) {
+    for (int stream = 0; stream < RDMPEGDecodeStreamCount; stream++) {
+        for (int stage = 0; stage < RDMPEGDecodeStageCount; stage++) {
+            atomic_store_explicit(&counters->stageTime[stream][stage], 0, memory_order_relaxed);
+        }
+        
+        atomic_store_explicit(&counters->packetsDemuxed[stream], 0, memory_order_relaxed);
+        atomic_store_explicit(&counters->framesDecoded[stream], 0, memory_order_relaxed);
+        atomic_store_explicit(&counters->framesDropped[stream], 0, memory_order_relaxed);
+        atomic_store_explicit(&counters->framesConverted[stream], 0, memory_order_relaxed);
+        atomic_store_explicit(&counters->bytesCopied[stream], 0, memory_order_relaxed);
+    }
 }
 
 NS_ASSUME_NONNULL_END
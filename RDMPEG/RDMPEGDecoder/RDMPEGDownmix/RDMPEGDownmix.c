@@ -0,0 +1,168 @@
+//
+//  RDMPEGDownmix.c
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGDownmix.h"
+#include <math.h>
+#include <string.h>
+
+#define RDMPEG_DOWNMIX_SQRT1_2 0.70710678118654752440
+
+const RDMPEGDownmixLevels RDMPEGDownmixLevelsITU = {
+    .center = RDMPEG_DOWNMIX_SQRT1_2,
+    .surround = RDMPEG_DOWNMIX_SQRT1_2,
+    .lowFrequency = 0.0,
+};
+
+const RDMPEGDownmixLevels RDMPEGDownmixLevelsDialogueBoost = {
+    .center = 1.0,
+    .surround = 0.5,
+    .lowFrequency = 0.0,
+};
+
+static int downmix_channels_count(uint64_t layout);
+static void downmix_stereo_gains(uint64_t channel, RDMPEGDownmixLevels levels, double *left, double *right);
+
+// MARK: - Matrix
+
+bool rdmpeg_downmix_matrix(uint64_t inputLayout,
+                           uint64_t outputLayout,
+                           RDMPEGDownmixLevels levels,
+                           double *matrix,
+                           int stride) {
+    if (outputLayout != RDMPEG_DOWNMIX_LAYOUT_STEREO && outputLayout != RDMPEG_DOWNMIX_LAYOUT_MONO) {
+        return false;
+    }
+
+    if ((inputLayout & ~outputLayout) == 0) {
+        return false;
+    }
+
+    int inputsCount = downmix_channels_count(inputLayout);
+    int outputsCount = downmix_channels_count(outputLayout);
+
+    if (stride < inputsCount) {
+        return false;
+    }
+
+    memset(matrix, 0, sizeof(double) * (size_t)outputsCount * (size_t)stride);
+
+    int input = 0;
+
+    for (int bit = 0; bit < RDMPEG_DOWNMIX_MAX_CHANNELS; bit++) {
+        uint64_t channel = 1ULL << bit;
+
+        if ((inputLayout & channel) == 0) {
+            continue;
+        }
+
+        double left = 0.0;
+        double right = 0.0;
+        downmix_stereo_gains(channel, levels, &left, &right);
+
+        if (outputLayout == RDMPEG_DOWNMIX_LAYOUT_STEREO) {
+            matrix[input] = left;
+            matrix[stride + input] = right;
+        }
+        else {
+            matrix[input] = (left + right) / 2.0;
+        }
+
+        input++;
+    }
+
+    // The loudest possible output is all inputs at full scale in phase
+    double maximumSum = 0.0;
+
+    for (int output = 0; output < outputsCount; output++) {
+        double sum = 0.0;
+
+        for (input = 0; input < inputsCount; input++) {
+            sum += fabs(matrix[output * stride + input]);
+        }
+
+        maximumSum = fmax(maximumSum, sum);
+    }
+
+    if (maximumSum > 1.0) {
+        for (int output = 0; output < outputsCount; output++) {
+            for (input = 0; input < inputsCount; input++) {
+                matrix[output * stride + input] /= maximumSum;
+            }
+        }
+    }
+
+    return true;
+}
+
+static int downmix_channels_count(uint64_t layout) {
+    int count = 0;
+
+    for (; layout != 0; layout &= layout - 1) {
+        count++;
+    }
+
+    return count;
+}
+
+// Channel's gain in the left and right output. Channels nobody knows where to put are dropped
+static void downmix_stereo_gains(uint64_t channel, RDMPEGDownmixLevels levels, double *left, double *right) {
+    switch (channel) {
+        case RDMPEG_DOWNMIX_CHANNEL_FRONT_LEFT:
+        case RDMPEG_DOWNMIX_CHANNEL_FRONT_LEFT_OF_CENTER:
+        case RDMPEG_DOWNMIX_CHANNEL_STEREO_LEFT:
+        case RDMPEG_DOWNMIX_CHANNEL_WIDE_LEFT: {
+            *left = 1.0;
+            break;
+        }
+        case RDMPEG_DOWNMIX_CHANNEL_FRONT_RIGHT:
+        case RDMPEG_DOWNMIX_CHANNEL_FRONT_RIGHT_OF_CENTER:
+        case RDMPEG_DOWNMIX_CHANNEL_STEREO_RIGHT:
+        case RDMPEG_DOWNMIX_CHANNEL_WIDE_RIGHT: {
+            *right = 1.0;
+            break;
+        }
+        case RDMPEG_DOWNMIX_CHANNEL_FRONT_CENTER: {
+            *left = levels.center;
+            *right = levels.center;
+            break;
+        }
+        case RDMPEG_DOWNMIX_CHANNEL_LOW_FREQUENCY:
+        case RDMPEG_DOWNMIX_CHANNEL_LOW_FREQUENCY_2: {
+            *left = levels.lowFrequency;
+            *right = levels.lowFrequency;
+            break;
+        }
+        case RDMPEG_DOWNMIX_CHANNEL_BACK_LEFT:
+        case RDMPEG_DOWNMIX_CHANNEL_SIDE_LEFT:
+        case RDMPEG_DOWNMIX_CHANNEL_SURROUND_DIRECT_LEFT:
+        case RDMPEG_DOWNMIX_CHANNEL_TOP_FRONT_LEFT:
+        case RDMPEG_DOWNMIX_CHANNEL_TOP_BACK_LEFT: {
+            *left = levels.surround;
+            break;
+        }
+        case RDMPEG_DOWNMIX_CHANNEL_BACK_RIGHT:
+        case RDMPEG_DOWNMIX_CHANNEL_SIDE_RIGHT:
+        case RDMPEG_DOWNMIX_CHANNEL_SURROUND_DIRECT_RIGHT:
+        case RDMPEG_DOWNMIX_CHANNEL_TOP_FRONT_RIGHT:
+        case RDMPEG_DOWNMIX_CHANNEL_TOP_BACK_RIGHT: {
+            *right = levels.surround;
+            break;
+        }
+        case RDMPEG_DOWNMIX_CHANNEL_BACK_CENTER:
+        case RDMPEG_DOWNMIX_CHANNEL_TOP_CENTER:
+        case RDMPEG_DOWNMIX_CHANNEL_TOP_FRONT_CENTER:
+        case RDMPEG_DOWNMIX_CHANNEL_TOP_BACK_CENTER: {
+            // Surround split between both sides
+            *left = levels.surround * RDMPEG_DOWNMIX_SQRT1_2;
+            *right = levels.surround * RDMPEG_DOWNMIX_SQRT1_2;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+//
+//  RDMPEGDownmix.h
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGDownmix_h
+#define RDMPEGDownmix_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Downmix matrix of multichannel audio to stereo or mono output, plain C so it builds and is tested on Linux too.
+//
+// Layouts are FFmpeg channel masks (AV_CH_*), matrix is in swr_set_matrix format: weight of input channel i
+// in output channel o is matrix[o * stride + i], channels are ordered as bits of their layouts. Resampler
+// applies it with its SIMD rematrix code.
+
+#define RDMPEG_DOWNMIX_MAX_CHANNELS 64
+
+// Same values as AV_CH_*, RDMPEGDecoder checks they match
+#define RDMPEG_DOWNMIX_CHANNEL_FRONT_LEFT 0x1ULL
+#define RDMPEG_DOWNMIX_CHANNEL_FRONT_RIGHT 0x2ULL
+#define RDMPEG_DOWNMIX_CHANNEL_FRONT_CENTER 0x4ULL
+#define RDMPEG_DOWNMIX_CHANNEL_LOW_FREQUENCY 0x8ULL
+#define RDMPEG_DOWNMIX_CHANNEL_BACK_LEFT 0x10ULL
+#define RDMPEG_DOWNMIX_CHANNEL_BACK_RIGHT 0x20ULL
+#define RDMPEG_DOWNMIX_CHANNEL_FRONT_LEFT_OF_CENTER 0x40ULL
+#define RDMPEG_DOWNMIX_CHANNEL_FRONT_RIGHT_OF_CENTER 0x80ULL
+#define RDMPEG_DOWNMIX_CHANNEL_BACK_CENTER 0x100ULL
+#define RDMPEG_DOWNMIX_CHANNEL_SIDE_LEFT 0x200ULL
+#define RDMPEG_DOWNMIX_CHANNEL_SIDE_RIGHT 0x400ULL
+#define RDMPEG_DOWNMIX_CHANNEL_TOP_CENTER 0x800ULL
+#define RDMPEG_DOWNMIX_CHANNEL_TOP_FRONT_LEFT 0x1000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_TOP_FRONT_CENTER 0x2000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_TOP_FRONT_RIGHT 0x4000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_TOP_BACK_LEFT 0x8000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_TOP_BACK_CENTER 0x10000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_TOP_BACK_RIGHT 0x20000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_STEREO_LEFT 0x20000000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_STEREO_RIGHT 0x40000000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_WIDE_LEFT 0x80000000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_WIDE_RIGHT 0x100000000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_SURROUND_DIRECT_LEFT 0x200000000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_SURROUND_DIRECT_RIGHT 0x400000000ULL
+#define RDMPEG_DOWNMIX_CHANNEL_LOW_FREQUENCY_2 0x800000000ULL
+
+#define RDMPEG_DOWNMIX_LAYOUT_MONO RDMPEG_DOWNMIX_CHANNEL_FRONT_CENTER
+#define RDMPEG_DOWNMIX_LAYOUT_STEREO (RDMPEG_DOWNMIX_CHANNEL_FRONT_LEFT | RDMPEG_DOWNMIX_CHANNEL_FRONT_RIGHT)
+
+// Gains of channels relative to front left and right ones, before the matrix is normalized
+typedef struct RDMPEGDownmixLevels {
+    double center;
+    double surround;
+    double lowFrequency;
+} RDMPEGDownmixLevels;
+
+// ITU-R BS.775: centre and surrounds at -3 dB, LFE dropped
+extern const RDMPEGDownmixLevels RDMPEGDownmixLevelsITU;
+// Centre at full level and surrounds at -6 dB, so dialogue stands out of effects and music
+extern const RDMPEGDownmixLevels RDMPEGDownmixLevelsDialogueBoost;
+
+// Fills outputs count * stride matrix, rows are scaled down so no output channel can clip. Returns false when
+// output isn't stereo or mono, or has all input channels, resampler's own matrix is fine then
+bool rdmpeg_downmix_matrix(uint64_t inputLayout,
+                           uint64_t outputLayout,
+                           RDMPEGDownmixLevels levels,
+                           double *matrix,
+                           int stride);
+
+#endif /* RDMPEGDownmix_h */
@@ -24,6 +24,11 @@ public class RDMPEGFrame: NSObject {
     public var position: TimeInterval
     public var duration: TimeInterval
 
+    // Size of payload frame keeps in memory, used for buffer accounting
+    public var byteSize: Int {
+        0
+    }
+
     public init(type: RDMPEGFrameType, position: TimeInterval, duration: TimeInterval) {
         self.type = type
         self.position = position
@@ -36,6 +41,10 @@ public class RDMPEGFrame: NSObject {
 public class RDMPEGAudioFrame: RDMPEGFrame {
     public var samples: Data
 
+    override public var byteSize: Int {
+        samples.count
+    }
+
     public init(position: TimeInterval, duration: TimeInterval, samples: Data) {
         self.samples = samples
         super.init(type: .audio, position: position, duration: duration)
@@ -46,6 +55,8 @@ public class RDMPEGAudioFrame: RDMPEGFrame {
 public class RDMPEGVideoFrame: RDMPEGFrame {
     public var width: UInt
     public var height: UInt
+    // Frame decodes without the preceding ones, unlike leading frames of open GOP which come out before it
+    public var isKeyframe = false
 
     public init(position: TimeInterval, duration: TimeInterval, width: UInt, height: UInt) {
         self.width = width
@@ -59,6 +70,10 @@ public class RDMPEGVideoFrameBGRA: RDMPEGVideoFrame {
     public var linesize: UInt
     public var bgra: Data
 
+    override public var byteSize: Int {
+        bgra.count
+    }
+
     public init(position: TimeInterval, duration: TimeInterval, width: UInt, height: UInt, bgra: Data, linesize: UInt) {
         self.bgra = bgra
         self.linesize = linesize
@@ -96,6 +111,10 @@ public class RDMPEGVideoFrameYUV: RDMPEGVideoFrame {
     public var chromaB: Data
     public var chromaR: Data
 
+    override public var byteSize: Int {
+        luma.count + chromaB.count + chromaR.count
+    }
+
     public init(
         position: TimeInterval,
         duration: TimeInterval,
@@ -116,6 +135,10 @@ public class RDMPEGVideoFrameYUV: RDMPEGVideoFrame {
 public class RDMPEGArtworkFrame: RDMPEGFrame {
     public var picture: Data
 
+    override public var byteSize: Int {
+        picture.count
+    }
+
     public init(picture: Data) {
         self.picture = picture
         super.init(type: .artwork, position: 0, duration: 0)
@@ -137,6 +160,10 @@ public class RDMPEGArtworkFrame: RDMPEGFrame {
 public class RDMPEGSubtitleFrame: RDMPEGFrame {
     public var text: String
 
+    override public var byteSize: Int {
+        text.utf8.count
+    }
+
     public init(position: TimeInterval, duration: TimeInterval, text: String) {
         self.text = text
         super.init(type: .subtitle, position: position, duration: duration)
@@ -0,0 +1,247 @@
+//
+//  RDMPEGCachingIOStream.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+import Log4Cocoa
+
+// Wraps remote stream and serves reads from RDMPEGIOCache whenever possible.
+// Upstream stream is only seeked and read when requested block is missing in cache.
+@objcMembers
+public class RDMPEGCachingIOStream: NSObject, RDMPEGIOStream {
+    public let contentKey: String
+    public private(set) var bytesReadFromCache: UInt64 = 0
+    public private(set) var bytesReadFromUpstream: UInt64 = 0
+
+    private let upstream: RDMPEGIOStream
+    private let cache: RDMPEGIOCache
+    private var position: UInt64 = 0
+    private var upstreamPosition: UInt64?
+    private var isOpened = false
+    // Block the last read ended in, demuxer reads are much smaller than a block
+    private var currentBlock: (index: Int, data: Data)?
+
+    public init(stream: RDMPEGIOStream, cache: RDMPEGIOCache, contentKey: String) {
+        self.upstream = stream
+        self.cache = cache
+        self.contentKey = contentKey
+        super.init()
+    }
+
+    deinit {
+        close()
+    }
+
+    public func open() -> Bool {
+        guard !isOpened else {
+            log4AssertionFailure("Already opened")
+            return true
+        }
+
+        guard upstream.open() else {
+            return false
+        }
+
+        isOpened = true
+        position = 0
+        upstreamPosition = 0
+        cache.beginAccess(forKey: contentKey)
+
+        if let upstreamContentLength = upstream.contentLength?(), upstreamContentLength != UInt64.max {
+            cache.setContentLength(upstreamContentLength, forKey: contentKey)
+        }
+
+        return true
+    }
+
+    public func close() {
+        guard isOpened else { return }
+
+        isOpened = false
+        currentBlock = nil
+        cache.endAccess(forKey: contentKey)
+        upstream.close()
+    }
+
+    public func readBuffer(_ buffer: UnsafeMutablePointer<UInt8>, length: Int) -> Int {
+        var bytesRead = 0
+
+        while bytesRead < length {
+            let blockIndex = Int(position / UInt64(RDMPEGIOCache.blockSize))
+            let blockOffset = Int(position % UInt64(RDMPEGIOCache.blockSize))
+
+            let block: Data
+            switch loadBlock(at: blockIndex) {
+            case .success(let loadedBlock):
+                block = loadedBlock
+            case .failure(let status):
+                return bytesRead > 0 ? bytesRead : status.status
+            }
+
+            guard blockOffset < block.count else {
+                break
+            }
+
+            let bytesToCopy = min(block.count - blockOffset, length - bytesRead)
+            block.copyBytes(to: buffer.advanced(by: bytesRead), from: blockOffset..<(blockOffset + bytesToCopy))
+
+            bytesRead += bytesToCopy
+            position += UInt64(bytesToCopy)
+
+            if block.count < RDMPEGIOCache.blockSize {
+                break
+            }
+        }
+
+        return bytesRead
+    }
+
+    public func writeBuffer(_ buffer: UnsafeMutablePointer<UInt8>, length: Int) -> Int {
+        log4AssertionFailure("Writing isn't supported by caching stream")
+        return -1
+    }
+
+    public func seekOffset(_ offset: UInt64, whence: Int) -> UInt64 {
+        let signedOffset = Int64(bitPattern: offset)
+        let newPosition: Int64
+
+        switch Int32(whence) & ~AVSEEK_FORCE {
+        case SEEK_SET:
+            newPosition = signedOffset
+        case SEEK_CUR:
+            newPosition = Int64(position) + signedOffset
+        case SEEK_END:
+            let length = contentLength()
+            guard length != UInt64.max else {
+                // Unknown length, so upstream is the only one able to resolve position
+                let upstreamResult = upstream.seekOffset(offset, whence: whence)
+                if Int64(bitPattern: upstreamResult) >= 0 {
+                    position = upstreamResult
+                    upstreamPosition = upstreamResult
+                }
+                return upstreamResult
+            }
+            newPosition = Int64(length) + signedOffset
+        default:
+            log4AssertionFailure("Unsupported whence: \(whence)")
+            return UInt64.max
+        }
+
+        guard newPosition >= 0 else {
+            return UInt64.max
+        }
+
+        position = UInt64(newPosition)
+        return position
+    }
+
+    public func contentLength() -> UInt64 {
+        if let cachedContentLength = cache.contentLength(forKey: contentKey) {
+            return cachedContentLength.uint64Value
+        }
+
+        guard let upstreamContentLength = upstream.contentLength?(), upstreamContentLength != UInt64.max else {
+            return UInt64.max
+        }
+
+        cache.setContentLength(upstreamContentLength, forKey: contentKey)
+        return upstreamContentLength
+    }
+
+    // MARK: - Private
+
+    private func loadBlock(at blockIndex: Int) -> Result<Data, UpstreamStatus> {
+        if let currentBlock, currentBlock.index == blockIndex {
+            return .success(currentBlock.data)
+        }
+
+        let result = fetchBlock(at: blockIndex)
+
+        // Short block interrupted by upstream error is fetched again next time
+        if case .success(let block) = result,
+           block.count == RDMPEGIOCache.blockSize || cache.containsBlock(at: blockIndex, forKey: contentKey) {
+            currentBlock = (blockIndex, block)
+        }
+
+        return result
+    }
+
+    private func fetchBlock(at blockIndex: Int) -> Result<Data, UpstreamStatus> {
+        if let cachedBlock = cache.readBlock(at: blockIndex, forKey: contentKey) {
+            bytesReadFromCache += UInt64(cachedBlock.count)
+            return .success(cachedBlock)
+        }
+
+        let blockStart = UInt64(blockIndex * RDMPEGIOCache.blockSize)
+
+        if let knownContentLength = cache.contentLength(forKey: contentKey)?.uint64Value,
+           blockStart >= knownContentLength {
+            return .failure(UpstreamStatus(0))
+        }
+
+        if upstreamPosition != blockStart {
+            let seekResult = upstream.seekOffset(blockStart, whence: Int(SEEK_SET))
+            guard seekResult == blockStart else {
+                upstreamPosition = nil
+                return .failure(UpstreamStatus(-1))
+            }
+            upstreamPosition = blockStart
+        }
+
+        var block = Data(count: RDMPEGIOCache.blockSize)
+        var blockLength = 0
+        var lastReadStatus = 0
+
+        block.withUnsafeMutableBytes { blockBytes in
+            guard let baseAddress = blockBytes.bindMemory(to: UInt8.self).baseAddress else { return }
+
+            while blockLength < RDMPEGIOCache.blockSize {
+                lastReadStatus = upstream.readBuffer(
+                    baseAddress.advanced(by: blockLength),
+                    length: RDMPEGIOCache.blockSize - blockLength
+                )
+                if lastReadStatus <= 0 {
+                    break
+                }
+                blockLength += lastReadStatus
+            }
+        }
+
+        upstreamPosition = blockStart + UInt64(blockLength)
+        bytesReadFromUpstream += UInt64(blockLength)
+
+        guard blockLength > 0 else {
+            return .failure(UpstreamStatus(lastReadStatus))
+        }
+
+        block.count = blockLength
+
+        if blockLength == RDMPEGIOCache.blockSize {
+            cache.writeBlock(block, at: blockIndex, forKey: contentKey)
+        }
+        else if lastReadStatus == 0 {
+            // Short block followed by end of stream is the last one
+            cache.setContentLength(blockStart + UInt64(blockLength), forKey: contentKey)
+            cache.writeBlock(block, at: blockIndex, forKey: contentKey)
+        }
+
+        return .success(block)
+    }
+}
+
+private struct UpstreamStatus: Error {
+    let status: Int
+
+    init(_ status: Int) {
+        self.status = status
+    }
+}
+
+extension RDMPEGCachingIOStream {
+    override public class func l4Logger() -> L4Logger {
+        return L4Logger(forName: "rd.mediaplayer.RDMPEGCachingIOStream")
+    }
+}
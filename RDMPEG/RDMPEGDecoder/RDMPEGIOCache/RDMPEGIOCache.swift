@@ -0,0 +1,696 @@
+//
+//  RDMPEGIOCache.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+import Log4Cocoa
+import zlib
+
+// Sparse on-disk cache of remote media content. Every content key owns a data file, where fetched
+// blocks are written at their original offsets. Block maps and checksums of all keys live in a single
+// index file, which is the only file read when the cache is first used. Changes of the index are appended
+// to a journal next to it, which is folded back into the index once it outgrows it.
+@objcMembers
+public class RDMPEGIOCache: NSObject {
+    public static let blockSize: Int = 128 * 1024
+
+    fileprivate static let indexVersion = 2
+
+    private static let dataFileExtension = "rdcache"
+    private static let indexFileName = "index.rdindex"
+    private static let journalFileName = "index.rdjournal"
+    // Per-key index files of the first index version
+    private static let legacyIndexFileExtension = "rdindex"
+    private static let journalFlushInterval: TimeInterval = 5
+    private static let journalCompactionMinimumSize: UInt64 = 1024 * 1024
+    // Access dates only order eviction, reads don't need to journal them more often
+    private static let accessDateResolution: TimeInterval = 60
+
+    public let directoryURL: URL
+    public let capacity: UInt64
+
+    public var totalSize: UInt64 {
+        lock.withLock {
+            loadIndexIfNeeded()
+            return cachedSize
+        }
+    }
+
+    private let lock = NSLock()
+    private var index = Index()
+    private var isIndexLoaded = false
+    private var cachedSize: UInt64 = 0
+    private var entries: [String: Entry] = [:]
+
+    private var journalHandle: FileHandle?
+    private var journalSize: UInt64 = 0
+    private var snapshotSize: UInt64 = 0
+    private var pendingChanges: [Change] = []
+    // Data files to synchronize before their pending changes are journaled
+    private var unsyncedFileNames = Set<String>()
+    private var isJournalFlushScheduled = false
+
+    public init(directoryURL: URL, capacity: UInt64) {
+        self.directoryURL = directoryURL
+        self.capacity = capacity
+        super.init()
+    }
+
+    public func beginAccess(forKey key: String) {
+        lock.withLock {
+            let entry = openEntry(forKey: key)
+            entry.accessCount += 1
+            touch(itemNamed: entry.fileName)
+        }
+    }
+
+    public func endAccess(forKey key: String) {
+        lock.withLock {
+            guard let entry = entries[RDMPEGIOCache.fileName(forKey: key)] else {
+                log4AssertionFailure("Unbalanced cache access for key: \(key)")
+                return
+            }
+
+            entry.accessCount -= 1
+            flushJournal()
+
+            if entry.accessCount == 0 {
+                try? entry.dataHandle?.close()
+                entries[entry.fileName] = nil
+            }
+        }
+    }
+
+    public func contentLength(forKey key: String) -> NSNumber? {
+        lock.withLock {
+            return item(forKey: key)?.contentLength.map { NSNumber(value: $0) }
+        }
+    }
+
+    public func setContentLength(_ contentLength: UInt64, forKey key: String) {
+        lock.withLock {
+            let fileName = prepareItem(forKey: key)
+
+            if let knownContentLength = index.items[fileName]?.contentLength {
+                guard knownContentLength != contentLength else { return }
+
+                log4Info("Content length changed for key '\(key)', dropping cached blocks")
+                reset(itemNamed: fileName, key: key)
+            }
+
+            apply(Change(kind: .contentLength, fileName: fileName, contentLength: contentLength))
+        }
+    }
+
+    public func containsBlock(at blockIndex: Int, forKey key: String) -> Bool {
+        lock.withLock {
+            return item(forKey: key)?.blocks[blockIndex] != nil
+        }
+    }
+
+    // Blocks are verified against their checksums here, once per load from disk
+    public func readBlock(at blockIndex: Int, forKey key: String) -> Data? {
+        lock.withLock {
+            guard let block = item(forKey: key)?.blocks[blockIndex] else {
+                return nil
+            }
+
+            let fileName = RDMPEGIOCache.fileName(forKey: key)
+            let data: Data
+
+            do {
+                data = try withDataHandle(named: fileName) { dataHandle in
+                    try dataHandle.seek(toOffset: UInt64(blockIndex * RDMPEGIOCache.blockSize))
+                    return try dataHandle.read(upToCount: Int(block.length)) ?? Data()
+                }
+            }
+            catch {
+                log4Error("Unable to read cached block \(blockIndex) of '\(key)': \(error)")
+                return nil
+            }
+
+            guard data.count == block.length, RDMPEGIOCache.checksum(of: data) == block.checksum else {
+                log4Error("Cached block \(blockIndex) of '\(key)' is corrupted, dropping it")
+                removeBlock(at: blockIndex, fromItemNamed: fileName)
+                return nil
+            }
+
+            touch(itemNamed: fileName)
+            return data
+        }
+    }
+
+    @discardableResult
+    public func writeBlock(_ data: Data, at blockIndex: Int, forKey key: String) -> Bool {
+        guard !data.isEmpty, data.count <= RDMPEGIOCache.blockSize else {
+            log4AssertionFailure("Invalid block size: \(data.count)")
+            return false
+        }
+
+        // Checksum is calculated outside of the lock, other streams keep using the cache meanwhile
+        let checksum = RDMPEGIOCache.checksum(of: data)
+
+        return lock.withLock {
+            let fileName = prepareItem(forKey: key)
+
+            if index.items[fileName]?.blocks[blockIndex] != nil {
+                return true
+            }
+
+            guard makeRoom(for: UInt64(data.count), keeping: fileName) else {
+                return false
+            }
+
+            do {
+                try withDataHandle(named: fileName) { dataHandle in
+                    try dataHandle.seek(toOffset: UInt64(blockIndex * RDMPEGIOCache.blockSize))
+                    try dataHandle.write(contentsOf: data)
+
+                    // Data file opened just for this write is closed before the journal is flushed
+                    if entries[fileName] == nil {
+                        try dataHandle.synchronize()
+                    }
+                }
+            }
+            catch {
+                log4Error("Unable to write cached block \(blockIndex) of '\(key)': \(error)")
+                return false
+            }
+
+            if entries[fileName] != nil {
+                unsyncedFileNames.insert(fileName)
+            }
+
+            let block = Block(length: UInt32(data.count), checksum: checksum)
+            apply(Change(kind: .block, fileName: fileName, blockIndex: blockIndex, block: block))
+            touch(itemNamed: fileName)
+
+            return true
+        }
+    }
+
+    public func removeData(forKey key: String) {
+        lock.withLock {
+            loadIndexIfNeeded()
+
+            let fileName = RDMPEGIOCache.fileName(forKey: key)
+
+            if entries[fileName] != nil {
+                reset(itemNamed: fileName, key: key)
+            }
+            else {
+                removeItem(named: fileName)
+            }
+
+            flushJournal()
+        }
+    }
+
+    public func removeAllData() {
+        lock.withLock {
+            loadIndexIfNeeded()
+
+            for (fileName, item) in index.items {
+                if entries[fileName] != nil {
+                    reset(itemNamed: fileName, key: item.key)
+                }
+                else {
+                    removeItem(named: fileName)
+                }
+            }
+
+            flushJournal()
+        }
+    }
+
+    // MARK: - Entries
+
+    // Entries hold data files open between beginAccess and endAccess only
+    private func openEntry(forKey key: String) -> Entry {
+        let fileName = RDMPEGIOCache.fileName(forKey: key)
+
+        if let entry = entries[fileName] {
+            return entry
+        }
+
+        loadIndexIfNeeded()
+
+        if let item = index.items[fileName], !isValid(item, named: fileName, key: key) {
+            removeItem(named: fileName)
+        }
+
+        prepareItem(forKey: key)
+
+        let entry = Entry(fileName: fileName)
+        entries[fileName] = entry
+
+        return entry
+    }
+
+    private func isValid(_ item: Item, named fileName: String, key: String) -> Bool {
+        guard item.key == key else {
+            log4Info("Discarding cached content of '\(item.key)', its file name is taken by '\(key)'")
+            return false
+        }
+
+        let dataURL = fileURL(named: fileName)
+        let dataFileSize = (try? FileManager.default.attributesOfItem(atPath: dataURL.path)[.size] as? UInt64) ?? 0
+        let requiredDataFileSize = item.blocks
+            .map { UInt64($0.key * RDMPEGIOCache.blockSize) + UInt64($0.value.length) }
+            .max() ?? 0
+
+        guard dataFileSize >= requiredDataFileSize else {
+            log4Error("Cache data file of '\(key)' is truncated, discarding it")
+            return false
+        }
+
+        return true
+    }
+
+    private func item(forKey key: String) -> Item? {
+        loadIndexIfNeeded()
+
+        guard let item = index.items[RDMPEGIOCache.fileName(forKey: key)], item.key == key else {
+            return nil
+        }
+
+        return item
+    }
+
+    // Creates item of the key unless it exists, item of a colliding key is replaced
+    @discardableResult
+    private func prepareItem(forKey key: String) -> String {
+        loadIndexIfNeeded()
+
+        let fileName = RDMPEGIOCache.fileName(forKey: key)
+
+        if index.items[fileName]?.key != key {
+            reset(itemNamed: fileName, key: key)
+        }
+
+        return fileName
+    }
+
+    // Outside of an access data file is opened for a single call
+    private func withDataHandle<Result>(
+        named fileName: String,
+        _ body: (FileHandle) throws -> Result
+    ) throws -> Result {
+        if let entry = entries[fileName] {
+            let dataHandle = try entry.dataHandle ?? openDataFile(named: fileName)
+            entry.dataHandle = dataHandle
+
+            return try body(dataHandle)
+        }
+
+        let dataHandle = try openDataFile(named: fileName)
+        defer { try? dataHandle.close() }
+
+        return try body(dataHandle)
+    }
+
+    private func openDataFile(named fileName: String) throws -> FileHandle {
+        let dataURL = fileURL(named: fileName)
+
+        try FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true)
+
+        if !FileManager.default.fileExists(atPath: dataURL.path) {
+            FileManager.default.createFile(atPath: dataURL.path, contents: nil)
+        }
+
+        return try FileHandle(forUpdating: dataURL)
+    }
+
+    private func touch(itemNamed fileName: String) {
+        guard let item = index.items[fileName],
+              -item.lastAccessDate.timeIntervalSinceNow >= RDMPEGIOCache.accessDateResolution else {
+            return
+        }
+
+        apply(Change(kind: .access, fileName: fileName, date: Date()))
+    }
+
+    private func removeBlock(at blockIndex: Int, fromItemNamed fileName: String) {
+        guard index.items[fileName]?.blocks[blockIndex] != nil else { return }
+        apply(Change(kind: .blockRemoval, fileName: fileName, blockIndex: blockIndex))
+    }
+
+    // Leaves an empty item of the key, data file of an open entry is truncated in place
+    private func reset(itemNamed fileName: String, key: String) {
+        if let entry = entries[fileName] {
+            try? entry.dataHandle?.truncate(atOffset: 0)
+        }
+        else {
+            try? FileManager.default.removeItem(at: fileURL(named: fileName))
+        }
+
+        apply(Change(kind: .item, fileName: fileName, key: key, date: Date()))
+    }
+
+    // MARK: - Index
+
+    private func apply(_ change: Change) {
+        let previousSize = index.items[change.fileName]?.cachedSize ?? 0
+
+        index.apply(change)
+
+        cachedSize += index.items[change.fileName]?.cachedSize ?? 0
+        cachedSize -= previousSize
+
+        pendingChanges.append(change)
+        scheduleJournalFlush()
+    }
+
+    private func loadIndexIfNeeded() {
+        guard !isIndexLoaded else { return }
+        isIndexLoaded = true
+
+        var isIndexCompatible = true
+
+        if let indexData = try? Data(contentsOf: directoryURL.appendingPathComponent(RDMPEGIOCache.indexFileName)) {
+            if let loadedIndex = try? PropertyListDecoder().decode(Index.self, from: indexData),
+               loadedIndex.version == RDMPEGIOCache.indexVersion,
+               loadedIndex.blockSize == RDMPEGIOCache.blockSize {
+                index = loadedIndex
+                snapshotSize = UInt64(indexData.count)
+            }
+            else {
+                log4Info("Discarding incompatible cache index")
+                isIndexCompatible = false
+            }
+        }
+
+        let journalData = (try? Data(contentsOf: journalURL)) ?? Data()
+
+        if isIndexCompatible {
+            applyJournal(journalData)
+        }
+
+        cachedSize = index.items.values.reduce(0) { $0 + $1.cachedSize }
+
+        // Journal of the previous run is folded into the index, a torn tail left by a crash is dropped with it
+        if !journalData.isEmpty {
+            do {
+                try writeSnapshot()
+            }
+            catch {
+                log4Error("Unable to write cache index: \(error)")
+            }
+        }
+
+        // Data files missing from the index (left by a crash or an older index format) can't be used
+        let fileURLs = (try? FileManager.default.contentsOfDirectory(
+            at: directoryURL,
+            includingPropertiesForKeys: nil
+        )) ?? []
+
+        for fileURL in fileURLs where fileURL.lastPathComponent != RDMPEGIOCache.indexFileName {
+            let fileName = fileURL.deletingPathExtension().lastPathComponent
+
+            switch fileURL.pathExtension {
+            case RDMPEGIOCache.dataFileExtension where index.items[fileName] == nil,
+                 RDMPEGIOCache.legacyIndexFileExtension:
+                try? FileManager.default.removeItem(at: fileURL)
+            default:
+                break
+            }
+        }
+    }
+
+    // Journal is a sequence of chunks, each one is a little-endian 32-bit length and a property list of changes
+    private func applyJournal(_ journalData: Data) {
+        let decoder = PropertyListDecoder()
+        var offset = journalData.startIndex
+
+        while offset + 4 <= journalData.endIndex {
+            let chunkLength = journalData[offset..<(offset + 4)].reversed().reduce(0) { $0 << 8 | Int($1) }
+            let chunkRange = (offset + 4)..<(offset + 4 + chunkLength)
+
+            guard chunkRange.upperBound <= journalData.endIndex,
+                  let changes = try? decoder.decode([Change].self, from: journalData.subdata(in: chunkRange)) else {
+                log4Info("Discarding incomplete cache journal chunk")
+                break
+            }
+
+            for change in changes {
+                index.apply(change)
+            }
+
+            offset = chunkRange.upperBound
+        }
+    }
+
+    private func scheduleJournalFlush() {
+        guard !isJournalFlushScheduled else { return }
+        isJournalFlushScheduled = true
+
+        let deadline = DispatchTime.now() + RDMPEGIOCache.journalFlushInterval
+
+        DispatchQueue.global(qos: .utility).asyncAfter(deadline: deadline) { [weak self] in
+            guard let self = self else { return }
+
+            self.lock.withLock {
+                self.isJournalFlushScheduled = false
+                self.flushJournal()
+            }
+        }
+    }
+
+    private func flushJournal() {
+        guard !pendingChanges.isEmpty else { return }
+
+        do {
+            // Block data is written before its changes, so the journal never references missing bytes
+            for fileName in unsyncedFileNames {
+                try entries[fileName]?.dataHandle?.synchronize()
+            }
+            unsyncedFileNames.removeAll()
+
+            let changesData = try RDMPEGIOCache.makeEncoder().encode(pendingChanges)
+            var chunk = withUnsafeBytes(of: UInt32(changesData.count).littleEndian) { Data($0) }
+            chunk.append(changesData)
+
+            let journalHandle = try openJournal()
+            try journalHandle.seekToEnd()
+            try journalHandle.write(contentsOf: chunk)
+
+            journalSize += UInt64(chunk.count)
+            pendingChanges.removeAll()
+
+            if journalSize > max(RDMPEGIOCache.journalCompactionMinimumSize, snapshotSize) {
+                try writeSnapshot()
+            }
+        }
+        catch {
+            log4Error("Unable to write cache journal: \(error)")
+        }
+    }
+
+    // Writes the whole index and empties the journal, whose changes it already contains
+    private func writeSnapshot() throws {
+        let indexData = try RDMPEGIOCache.makeEncoder().encode(index)
+
+        try indexData.write(to: directoryURL.appendingPathComponent(RDMPEGIOCache.indexFileName), options: .atomic)
+        snapshotSize = UInt64(indexData.count)
+
+        try openJournal().truncate(atOffset: 0)
+        journalSize = 0
+    }
+
+    private func openJournal() throws -> FileHandle {
+        if let journalHandle = journalHandle {
+            return journalHandle
+        }
+
+        try FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true)
+
+        if !FileManager.default.fileExists(atPath: journalURL.path) {
+            FileManager.default.createFile(atPath: journalURL.path, contents: nil)
+        }
+
+        let journalHandle = try FileHandle(forWritingTo: journalURL)
+        self.journalHandle = journalHandle
+
+        return journalHandle
+    }
+
+    private var journalURL: URL {
+        return directoryURL.appendingPathComponent(RDMPEGIOCache.journalFileName)
+    }
+
+    // MARK: - Eviction
+
+    private func makeRoom(for size: UInt64, keeping keptFileName: String) -> Bool {
+        if size > capacity {
+            return false
+        }
+
+        if cachedSize + size <= capacity {
+            return true
+        }
+
+        let evictionCandidates = index.items
+            .filter { $0.key != keptFileName && entries[$0.key] == nil }
+            .sorted { $0.value.lastAccessDate < $1.value.lastAccessDate }
+
+        for (fileName, item) in evictionCandidates {
+            log4Debug("Evicting cached content: \(fileName) (\(item.cachedSize) bytes)")
+            removeItem(named: fileName)
+
+            if cachedSize + size <= capacity {
+                return true
+            }
+        }
+
+        return false
+    }
+
+    private func removeItem(named fileName: String) {
+        try? FileManager.default.removeItem(at: fileURL(named: fileName))
+
+        if index.items[fileName] != nil {
+            apply(Change(kind: .removal, fileName: fileName))
+        }
+    }
+
+    // MARK: - Helpers
+
+    private func fileURL(named fileName: String) -> URL {
+        return directoryURL.appendingPathComponent(fileName).appendingPathExtension(RDMPEGIOCache.dataFileExtension)
+    }
+
+    private static func fileName(forKey key: String) -> String {
+        var hash: UInt64 = 0xcbf29ce484222325
+        for byte in key.utf8 {
+            hash = (hash ^ UInt64(byte)) &* 0x100000001b3
+        }
+        return String(format: "%016llx", hash)
+    }
+
+    private static func checksum(of data: Data) -> UInt32 {
+        return data.withUnsafeBytes { bytes in
+            let buffer = bytes.bindMemory(to: Bytef.self)
+            return UInt32(crc32(0, buffer.baseAddress, uInt(buffer.count)))
+        }
+    }
+
+    private static func makeEncoder() -> PropertyListEncoder {
+        let encoder = PropertyListEncoder()
+        encoder.outputFormat = .binary
+        return encoder
+    }
+}
+
+private struct Block: Codable {
+    var length: UInt32
+    var checksum: UInt32
+}
+
+private struct Item: Codable {
+    private enum CodingKeys: String, CodingKey {
+        case key
+        case contentLength
+        case lastAccessDate
+        case blocks
+    }
+
+    var key: String
+    var contentLength: UInt64?
+    var lastAccessDate: Date
+    private(set) var blocks: [Int: Block] = [:]
+    // Sum of block lengths, kept along with blocks
+    private(set) var cachedSize: UInt64 = 0
+
+    init(key: String, lastAccessDate: Date) {
+        self.key = key
+        self.lastAccessDate = lastAccessDate
+    }
+
+    init(from decoder: Decoder) throws {
+        let container = try decoder.container(keyedBy: CodingKeys.self)
+        key = try container.decode(String.self, forKey: .key)
+        contentLength = try container.decodeIfPresent(UInt64.self, forKey: .contentLength)
+        lastAccessDate = try container.decode(Date.self, forKey: .lastAccessDate)
+        blocks = try container.decode([Int: Block].self, forKey: .blocks)
+        cachedSize = blocks.values.reduce(0) { $0 + UInt64($1.length) }
+    }
+
+    mutating func setBlock(_ block: Block, at blockIndex: Int) {
+        removeBlock(at: blockIndex)
+        blocks[blockIndex] = block
+        cachedSize += UInt64(block.length)
+    }
+
+    mutating func removeBlock(at blockIndex: Int) {
+        guard let block = blocks.removeValue(forKey: blockIndex) else { return }
+        cachedSize -= UInt64(block.length)
+    }
+}
+
+private struct Index: Codable {
+    var version: Int = RDMPEGIOCache.indexVersion
+    var blockSize: Int = RDMPEGIOCache.blockSize
+    // Keyed by data file name
+    var items: [String: Item] = [:]
+
+    mutating func apply(_ change: Change) {
+        switch change.kind {
+        case .item:
+            guard let key = change.key else { return }
+            items[change.fileName] = Item(key: key, lastAccessDate: change.date ?? Date())
+        case .removal:
+            items[change.fileName] = nil
+        case .block:
+            guard let blockIndex = change.blockIndex, let block = change.block else { return }
+            items[change.fileName]?.setBlock(block, at: blockIndex)
+        case .blockRemoval:
+            guard let blockIndex = change.blockIndex else { return }
+            items[change.fileName]?.removeBlock(at: blockIndex)
+        case .contentLength:
+            items[change.fileName]?.contentLength = change.contentLength
+        case .access:
+            guard let date = change.date else { return }
+            items[change.fileName]?.lastAccessDate = date
+        }
+    }
+}
+
+// Journal record of a single index change. Replaying changes which the index already contains leaves it as is.
+private struct Change: Codable {
+    enum Kind: Int, Codable {
+        // Item is created, or reset to no blocks and unknown content length
+        case item
+        case removal
+        case block
+        case blockRemoval
+        case contentLength
+        case access
+    }
+
+    var kind: Kind
+    var fileName: String
+    var key: String?
+    var blockIndex: Int?
+    var block: Block?
+    var contentLength: UInt64?
+    var date: Date?
+}
+
+private class Entry {
+    let fileName: String
+    var dataHandle: FileHandle?
+    var accessCount: Int = 0
+
+    init(fileName: String) {
+        self.fileName = fileName
+    }
+}
+
+extension RDMPEGIOCache {
+    override public class func l4Logger() -> L4Logger {
+        return L4Logger(forName: "rd.mediaplayer.RDMPEGIOCache")
+    }
+}
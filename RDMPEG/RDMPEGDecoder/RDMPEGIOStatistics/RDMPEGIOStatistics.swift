@@ -0,0 +1,76 @@
+//
+//  RDMPEGIOStatistics.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Immutable snapshot of decoder IO counters. Values are cumulative since decoder opening (or last reset).
+@objcMembers
+public class RDMPEGIOStatistics: NSObject {
+    public let readBytes: UInt64
+    public let readCalls: UInt64
+    public let readErrors: UInt64
+    public let seekCalls: UInt64
+    public let seekDistance: UInt64
+    public let sizeQueries: UInt64
+    public let readTime: TimeInterval
+    public let readFrameCalls: UInt64
+    public let readFrameBlockedTime: TimeInterval
+    // Bucket N counts reads that took less than 2^(N+1) microseconds, the last bucket counts everything slower
+    public let readLatencyHistogram: [NSNumber]
+
+    public var averageReadSize: Double {
+        readCalls > 0 ? Double(readBytes) / Double(readCalls) : 0
+    }
+
+    public var averageReadTime: TimeInterval {
+        readCalls > 0 ? readTime / Double(readCalls) : 0
+    }
+
+    public init(
+        readBytes: UInt64,
+        readCalls: UInt64,
+        readErrors: UInt64,
+        seekCalls: UInt64,
+        seekDistance: UInt64,
+        sizeQueries: UInt64,
+        readTime: TimeInterval,
+        readFrameCalls: UInt64,
+        readFrameBlockedTime: TimeInterval,
+        readLatencyHistogram: [NSNumber]
+    ) {
+        self.readBytes = readBytes
+        self.readCalls = readCalls
+        self.readErrors = readErrors
+        self.seekCalls = seekCalls
+        self.seekDistance = seekDistance
+        self.sizeQueries = sizeQueries
+        self.readTime = readTime
+        self.readFrameCalls = readFrameCalls
+        self.readFrameBlockedTime = readFrameBlockedTime
+        self.readLatencyHistogram = readLatencyHistogram
+        super.init()
+    }
+
+    public static func readLatencyUpperBound(forBucket bucket: Int) -> TimeInterval {
+        return Double(UInt64(1) << UInt64(bucket + 1)) / 1_000_000
+    }
+
+    override public var description: String {
+        return String(
+            format: "read: %llu bytes in %llu calls (%.3fs), seeks: %llu (%llu bytes), size queries: %llu, " +
+                "av_read_frame: %llu calls (%.3fs blocked)",
+            readBytes,
+            readCalls,
+            readTime,
+            seekCalls,
+            seekDistance,
+            sizeQueries,
+            readFrameCalls,
+            readFrameBlockedTime
+        )
+    }
+}
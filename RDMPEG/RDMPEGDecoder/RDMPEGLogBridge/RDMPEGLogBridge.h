@@ -0,0 +1,24 @@
+//
+//  RDMPEGLogBridge.h
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Forwards libav log lines to Log4Cocoa.
+// Lines below effective logger level are dropped before formatting,
+// accepted lines are formatted on calling thread into fixed size buffer and handed to background logger thread.
+@interface RDMPEGLogBridge : NSObject
+
++ (void)install;
+
+// Maximum number of lines per second coming from the same call site, 0 disables rate limiting
+@property (class, nonatomic, assign) NSUInteger rateLimit;
+
+@end
+
+NS_ASSUME_NONNULL_END
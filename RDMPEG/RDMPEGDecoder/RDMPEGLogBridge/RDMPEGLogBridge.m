@@ -0,0 +1,285 @@
+//
+//  RDMPEGLogBridge.m
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#import "RDMPEGLogBridge.h"
+#import <libavutil/log.h>
+#import <Log4Cocoa/Log4Cocoa.h>
+#import <stdatomic.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+#define RDMPEG_LOG_QUEUE_CAPACITY 256 // Should be power of two
+#define RDMPEG_LOG_LINE_LENGTH 1024
+#define RDMPEG_LOG_RATE_LIMIT_SLOTS 64
+#define RDMPEG_LOG_DEFAULT_RATE_LIMIT 50
+#define RDMPEG_LOG_LEVEL_REFRESH_INTERVAL NSEC_PER_SEC
+
+typedef struct RDMPEGLogSlot {
+    _Atomic size_t sequence;
+    int level;
+    uint32_t suppressed;
+    char line[RDMPEG_LOG_LINE_LENGTH];
+} RDMPEGLogSlot;
+
+typedef struct RDMPEGLogRateLimitEntry {
+    _Atomic(const char *) format;
+    _Atomic uint64_t windowStart;
+    _Atomic uint32_t count;
+} RDMPEGLogRateLimitEntry;
+
+// Bounded MPSC queue (Vyukov), producers are libav threads and the only consumer is logger thread
+static RDMPEGLogSlot log_queue[RDMPEG_LOG_QUEUE_CAPACITY];
+static _Atomic size_t log_queue_enqueue_position;
+static size_t log_queue_dequeue_position;
+static _Atomic uint64_t log_queue_dropped;
+static atomic_bool log_consumer_sleeping;
+static dispatch_semaphore_t log_semaphore;
+
+static atomic_int log_max_level = AV_LOG_ERROR;
+static _Atomic uint32_t log_rate_limit = RDMPEG_LOG_DEFAULT_RATE_LIMIT;
+static RDMPEGLogRateLimitEntry log_rate_limit_entries[RDMPEG_LOG_RATE_LIMIT_SLOTS];
+
+static void log_bridge_callback(void * _Nullable context, int level, const char *format, va_list args);
+static BOOL log_rate_limit_allow(const char *format, uint64_t now, uint32_t *suppressed);
+static BOOL log_queue_push(int level, const char *line, uint32_t suppressed);
+static RDMPEGLogSlot * _Nullable log_queue_peek(void);
+static void log_queue_pop(RDMPEGLogSlot *slot);
+
+
+
+@implementation RDMPEGLogBridge
+
+#pragma mark - Overridden Class Methods
+
+// libav lines keep going to the logger log4C macros used to write them to, so existing log configurations still apply
++ (L4Logger *)l4Logger {
+    return [L4FunctionLogger instance];
+}
+
+#pragma mark - Public Class Methods
+
++ (void)install {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        for (size_t i = 0; i < RDMPEG_LOG_QUEUE_CAPACITY; i++) {
+            atomic_init(&log_queue[i].sequence, i);
+        }
+        
+        log_semaphore = dispatch_semaphore_create(0);
+        
+        [self updateMaxLevel];
+        
+        NSThread *loggerThread = [[NSThread alloc] initWithBlock:^{
+            [self drainQueue];
+        }];
+        loggerThread.name = @"RDMPEGLogBridge";
+        loggerThread.qualityOfService = NSQualityOfServiceUtility;
+        [loggerThread start];
+        
+        av_log_set_callback(log_bridge_callback);
+    });
+}
+
++ (NSUInteger)rateLimit {
+    return atomic_load_explicit(&log_rate_limit, memory_order_relaxed);
+}
+
++ (void)setRateLimit:(NSUInteger)rateLimit {
+    atomic_store_explicit(&log_rate_limit, (uint32_t)MIN(rateLimit, UINT32_MAX), memory_order_relaxed);
+}
+
+#pragma mark - Private Class Methods
+
++ (void)updateMaxLevel {
+    L4Logger *logger = [self l4Logger];
+    
+    int maxLevel = AV_LOG_QUIET;
+    if ([logger isDebugEnabled]) {
+        maxLevel = AV_LOG_VERBOSE;
+    }
+    else if ([logger isWarnEnabled]) {
+        maxLevel = AV_LOG_WARNING;
+    }
+    else if ([logger isErrorEnabled]) {
+        maxLevel = AV_LOG_ERROR;
+    }
+    
+    atomic_store_explicit(&log_max_level, maxLevel, memory_order_relaxed);
+}
+
++ (void)drainQueue {
+    uint64_t lastLevelUpdateTime = clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+    
+    while (YES) {
+        @autoreleasepool {
+            RDMPEGLogSlot *slot = NULL;
+            while ((slot = log_queue_peek())) {
+                [self logLine:slot->line level:slot->level suppressed:slot->suppressed];
+                log_queue_pop(slot);
+            }
+            
+            uint64_t dropped = atomic_exchange_explicit(&log_queue_dropped, 0, memory_order_relaxed);
+            if (dropped > 0) {
+                log4Warn(@"%llu lines dropped since log queue was full", dropped);
+            }
+            
+            // Logger levels may be changed at runtime, so threshold is re-evaluated periodically
+            uint64_t now = clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+            if (now - lastLevelUpdateTime >= RDMPEG_LOG_LEVEL_REFRESH_INTERVAL) {
+                [self updateMaxLevel];
+                lastLevelUpdateTime = now;
+            }
+            
+            atomic_store(&log_consumer_sleeping, true);
+            atomic_thread_fence(memory_order_seq_cst);
+            
+            if (log_queue_peek() == NULL) {
+                dispatch_semaphore_wait(log_semaphore, dispatch_time(DISPATCH_TIME_NOW, RDMPEG_LOG_LEVEL_REFRESH_INTERVAL));
+            }
+            
+            atomic_store(&log_consumer_sleeping, false);
+        }
+    }
+}
+
++ (void)logLine:(const char *)line level:(int)level suppressed:(uint32_t)suppressed {
+    NSString *message = [[NSString alloc] initWithUTF8String:line];
+    if (message == nil) {
+        message = [[NSString alloc] initWithCString:line encoding:NSISOLatin1StringEncoding];
+    }
+    
+    if (suppressed > 0) {
+        message = [message stringByAppendingFormat:@" (%u similar lines suppressed)", suppressed];
+    }
+    
+    if (level <= AV_LOG_ERROR) {
+        log4Error(@"%@", message);
+    }
+    else if (level <= AV_LOG_WARNING) {
+        log4Warn(@"%@", message);
+    }
+    else {
+        log4Debug(@"%@", message);
+    }
+}
+
+@end
+
+
+
+static void log_bridge_callback(void * _Nullable context, int level, const char *format, va_list args) {
+    if (level > atomic_load_explicit(&log_max_level, memory_order_relaxed)) {
+        return;
+    }
+    
+    uint32_t suppressed = 0;
+    if (log_rate_limit_allow(format, clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW), &suppressed) == NO) {
+        return;
+    }
+    
+    static _Thread_local int printPrefix = 1;
+    char line[RDMPEG_LOG_LINE_LENGTH];
+    
+    if (av_log_format_line2(context, level, format, args, line, sizeof(line), &printPrefix) < 0) {
+        return;
+    }
+    
+    size_t lineLength = strlen(line);
+    while (lineLength > 0 && (line[lineLength - 1] == '\n' || line[lineLength - 1] == '\r')) {
+        line[--lineLength] = '\0';
+    }
+    
+    if (lineLength == 0) {
+        return;
+    }
+    
+    if (log_queue_push(level, line, suppressed) == NO) {
+        atomic_fetch_add_explicit(&log_queue_dropped, 1, memory_order_relaxed);
+        return;
+    }
+    
+    atomic_thread_fence(memory_order_seq_cst);
+    
+    if (atomic_exchange(&log_consumer_sleeping, false)) {
+        dispatch_semaphore_signal(log_semaphore);
+    }
+}
+
+static BOOL log_rate_limit_allow(const char *format, uint64_t now, uint32_t *suppressed) {
+    uint32_t rateLimit = atomic_load_explicit(&log_rate_limit, memory_order_relaxed);
+    if (rateLimit == 0) {
+        return YES;
+    }
+    
+    // Format string address identifies call site, Fibonacci hashing spreads pointers over table
+    uintptr_t slotIndex = ((uint64_t)(uintptr_t)format * 0x9E3779B97F4A7C15ull) >> (64 - 6);
+    RDMPEGLogRateLimitEntry *entry = &log_rate_limit_entries[slotIndex % RDMPEG_LOG_RATE_LIMIT_SLOTS];
+    
+    // Entries are updated without lock, so counts are approximate under contention, which is fine for rate limiting
+    const char *entryFormat = atomic_load_explicit(&entry->format, memory_order_relaxed);
+    uint64_t windowStart = atomic_load_explicit(&entry->windowStart, memory_order_relaxed);
+    
+    if (entryFormat != format || now - windowStart >= NSEC_PER_SEC) {
+        uint32_t previousCount = atomic_exchange_explicit(&entry->count, 0, memory_order_relaxed);
+        if (entryFormat == format && previousCount > rateLimit) {
+            *suppressed = previousCount - rateLimit;
+        }
+        
+        atomic_store_explicit(&entry->format, format, memory_order_relaxed);
+        atomic_store_explicit(&entry->windowStart, now, memory_order_relaxed);
+    }
+    
+    return atomic_fetch_add_explicit(&entry->count, 1, memory_order_relaxed) < rateLimit;
+}
+
+static BOOL log_queue_push(int level, const char *line, uint32_t suppressed) {
+    size_t position = atomic_load_explicit(&log_queue_enqueue_position, memory_order_relaxed);
+    
+    while (YES) {
+        RDMPEGLogSlot *slot = &log_queue[position & (RDMPEG_LOG_QUEUE_CAPACITY - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&log_queue_enqueue_position,
+                                                      &position,
+                                                      position + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                slot->level = level;
+                slot->suppressed = suppressed;
+                strlcpy(slot->line, line, sizeof(slot->line));
+                atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+                return YES;
+            }
+        }
+        else if (difference < 0) {
+            return NO;
+        }
+        else {
+            position = atomic_load_explicit(&log_queue_enqueue_position, memory_order_relaxed);
+        }
+    }
+}
+
+static RDMPEGLogSlot * _Nullable log_queue_peek(void) {
+    RDMPEGLogSlot *slot = &log_queue[log_queue_dequeue_position & (RDMPEG_LOG_QUEUE_CAPACITY - 1)];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    
+    if (sequence != log_queue_dequeue_position + 1) {
+        return NULL;
+    }
+    
+    return slot;
+}
+
+static void log_queue_pop(RDMPEGLogSlot *slot) {
+    atomic_store_explicit(&slot->sequence, log_queue_dequeue_position + RDMPEG_LOG_QUEUE_CAPACITY, memory_order_release);
+    log_queue_dequeue_position++;
+}
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,53 @@
+//
+//  RDMPEGLoudness.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Normalisation leaves that much headroom below 0 dBTP, lossy encoding of the output may add inter-sample peaks
+private let RDMPEGLoudnessTruePeakLimit: Double = -1.0
+
+// EBU R128 measurement of a file's decoded audio, every source channel weighted by its position
+@objcMembers
+public class RDMPEGLoudness: NSObject {
+    // Mobile playback target, EBU R128 broadcast target is -23 LUFS
+    public static let defaultTargetLoudness: Double = -16.0
+
+    // Gated integrated loudness in LUFS, -infinity for silence
+    public let integratedLoudness: Double
+    // Maximum of 4x oversampled signal in dBTP, -infinity for silence
+    public let truePeak: Double
+
+    public init(integratedLoudness: Double, truePeak: Double) {
+        self.integratedLoudness = integratedLoudness
+        self.truePeak = truePeak
+        super.init()
+    }
+
+    // Gain in dB which brings integrated loudness to the target, reduced if the true peak would exceed -1 dBTP.
+    // Silence gets no gain
+    public func normalizationGain(forTargetLoudness targetLoudness: Double) -> Double {
+        guard integratedLoudness.isFinite else {
+            return 0
+        }
+
+        var gain = targetLoudness - integratedLoudness
+
+        if truePeak.isFinite {
+            gain = min(gain, RDMPEGLoudnessTruePeakLimit - truePeak)
+        }
+
+        return gain
+    }
+
+    public var normalizationGain: Double {
+        normalizationGain(forTargetLoudness: RDMPEGLoudness.defaultTargetLoudness)
+    }
+
+    override public var description: String {
+        String(format: "%.1f LUFS, %.1f dBTP", integratedLoudness, truePeak)
+    }
+}
@@ -0,0 +1,284 @@
+//
+//  RDMPEGLoudnessAnalyzer.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+import Log4Cocoa
+
+// Output format audio stream is opened with. Decoded audio is measured before it's resampled and downmixed to it,
+// so surround channels keep their BS.1770 weights and samples aren't quantized to 16 bits
+private let RDMPEGLoudnessAnalyzerSamplingRate: Double = 48000
+private let RDMPEGLoudnessAnalyzerOutputChannelsCount = 2
+private let RDMPEGLoudnessAnalyzerCacheVersion = 1
+
+// Scans files for EBU R128 loudness and caches results, so normalisation gain of a file is known before it plays.
+//
+// Every file is decoded audio only in a separate operation (demuxer discards video packets), files are analyzed
+// in parallel. Cache is a property list keyed by file path, entry is valid while file size and modification date
+// stay the same. Measured entries are written once per analyzeFiles batch rather than per file.
+@objcMembers
+public class RDMPEGLoudnessAnalyzer: NSObject {
+    private static let analysisOperationName = "Loudness Analysis Operation"
+
+    public let cacheURL: URL
+
+    private let analysisQueue: OperationQueue
+    private let lock = NSLock()
+    private var cache: [String: CacheEntry] = [:]
+    private var cacheLoaded = false
+    private var cacheChanged = false
+
+    public init(cacheURL: URL) {
+        self.cacheURL = cacheURL
+        self.analysisQueue = OperationQueue()
+        super.init()
+
+        self.analysisQueue.name = "RDMPEGLoudnessAnalyzer Analysis Queue"
+        self.analysisQueue.maxConcurrentOperationCount = ProcessInfo.processInfo.activeProcessorCount
+        self.analysisQueue.qualityOfService = .utility
+    }
+
+    deinit {
+        analysisQueue.cancelAllOperations()
+    }
+
+    public func cachedLoudness(forFilePath filePath: String) -> RDMPEGLoudness? {
+        let fileSignature = FileSignature(filePath: filePath)
+
+        return lock.withLock {
+            loadCacheIfNeeded()
+
+            guard let entry = cache[filePath], let fileSignature = fileSignature,
+                  entry.signature == fileSignature else {
+                return nil
+            }
+
+            return RDMPEGLoudness(integratedLoudness: entry.integratedLoudness, truePeak: entry.truePeak)
+        }
+    }
+
+    // Files without valid cache entry are analyzed, completion is called on main queue with loudness of all files
+    // which are cached or were measured successfully
+    public func analyzeFiles(atPaths filePaths: [String], completion: @escaping ([String: RDMPEGLoudness]) -> Void) {
+        let resultsLock = NSLock()
+        var results: [String: RDMPEGLoudness] = [:]
+
+        let completionOperation = BlockOperation { [weak self] in
+            self?.saveCacheIfChanged()
+
+            let results = resultsLock.withLock { results }
+
+            DispatchQueue.main.async {
+                completion(results)
+            }
+        }
+
+        for filePath in Set(filePaths) {
+            if let loudness = cachedLoudness(forFilePath: filePath) {
+                resultsLock.withLock {
+                    results[filePath] = loudness
+                }
+                continue
+            }
+
+            let analysisOperation = BlockOperation()
+            analysisOperation.name = RDMPEGLoudnessAnalyzer.analysisOperationName
+
+            analysisOperation.addExecutionBlock { [weak self, weak analysisOperation] in
+                guard let self = self, let analysisOperation = analysisOperation else { return }
+
+                guard let loudness = RDMPEGLoudnessAnalyzer.measureLoudness(
+                    ofFileAtPath: filePath,
+                    operation: analysisOperation
+                ) else {
+                    return
+                }
+
+                self.storeLoudness(loudness, forFilePath: filePath)
+
+                resultsLock.withLock {
+                    results[filePath] = loudness
+                }
+            }
+
+            completionOperation.addDependency(analysisOperation)
+            analysisQueue.addOperation(analysisOperation)
+        }
+
+        analysisQueue.addOperation(completionOperation)
+    }
+
+    // Analyses in progress are abandoned, completions are still called with what was measured so far
+    public func cancelAllAnalyses() {
+        // Completion operations aren't cancelled, they save the cache and report once their analyses stop
+        for operation in analysisQueue.operations where operation.name == RDMPEGLoudnessAnalyzer.analysisOperationName {
+            operation.cancel()
+        }
+    }
+
+    public func removeAllCachedLoudness() {
+        lock.withLock {
+            cache.removeAll()
+            cacheLoaded = true
+            cacheChanged = false
+            saveCache()
+        }
+    }
+
+    // MARK: - Private
+
+    private static func measureLoudness(ofFileAtPath filePath: String, operation: Operation) -> RDMPEGLoudness? {
+        let decoder = RDMPEGDecoder(path: filePath, ioStream: nil, subtitleEncoding: nil) { [weak operation] in
+            operation?.isCancelled ?? true
+        }
+
+        defer {
+            decoder.close()
+        }
+
+        if let openError = decoder.openInput() ?? decoder.loadAudioStream(
+            withSamplingRate: RDMPEGLoudnessAnalyzerSamplingRate,
+            outputChannels: UInt(RDMPEGLoudnessAnalyzerOutputChannelsCount)
+        ) {
+            log4Error("Unable to open \(filePath) for loudness analysis: \(openError)")
+            return nil
+        }
+
+        decoder.isVideoDiscarded = true
+
+        let meter = RDMPEGLoudnessMeter(
+            samplingRate: decoder.sourceAudioSamplingRate,
+            channelWeights: decoder.sourceAudioLoudnessWeights.map { $0.doubleValue }
+        )
+        let analysisStartTime = ProcessInfo.processInfo.systemUptime
+        var decodingFailed = false
+
+        decoder.sourceAudioHandler = { samples, framesCount in
+            meter.process(UnsafeBufferPointer(start: samples, count: Int(framesCount) * meter.channelsCount))
+        }
+
+        while !decoder.isEndReached && !decodingFailed && !operation.isCancelled {
+            autoreleasepool {
+                // Frames in output format aren't needed, source audio handler measures decoded audio
+                if decoder.decodeFrames() == nil {
+                    decodingFailed = true
+                }
+            }
+        }
+
+        if operation.isCancelled {
+            return nil
+        }
+
+        let loudness = meter.loudness
+
+        log4Info(String(
+            format: "Loudness of %@: %@ in %.2f s",
+            (filePath as NSString).lastPathComponent,
+            loudness.description,
+            ProcessInfo.processInfo.systemUptime - analysisStartTime
+        ))
+
+        return loudness
+    }
+
+    private func storeLoudness(_ loudness: RDMPEGLoudness, forFilePath filePath: String) {
+        guard let fileSignature = FileSignature(filePath: filePath) else {
+            return
+        }
+
+        lock.withLock {
+            loadCacheIfNeeded()
+
+            cache[filePath] = CacheEntry(
+                signature: fileSignature,
+                integratedLoudness: loudness.integratedLoudness,
+                truePeak: loudness.truePeak
+            )
+
+            cacheChanged = true
+        }
+    }
+
+    private func saveCacheIfChanged() {
+        lock.withLock {
+            guard cacheChanged else {
+                return
+            }
+
+            cacheChanged = false
+            saveCache()
+        }
+    }
+
+    // Lock should be held
+    private func loadCacheIfNeeded() {
+        guard !cacheLoaded else {
+            return
+        }
+
+        cacheLoaded = true
+
+        guard let cacheData = try? Data(contentsOf: cacheURL),
+              let storedCache = try? PropertyListDecoder().decode(Cache.self, from: cacheData),
+              storedCache.version == RDMPEGLoudnessAnalyzerCacheVersion else {
+            return
+        }
+
+        cache = storedCache.entries
+    }
+
+    // Lock should be held
+    private func saveCache() {
+        do {
+            try FileManager.default.createDirectory(
+                at: cacheURL.deletingLastPathComponent(),
+                withIntermediateDirectories: true
+            )
+
+            let encoder = PropertyListEncoder()
+            encoder.outputFormat = .binary
+            let cacheData = try encoder.encode(Cache(version: RDMPEGLoudnessAnalyzerCacheVersion, entries: cache))
+            try cacheData.write(to: cacheURL, options: .atomic)
+        }
+        catch {
+            log4Error("Unable to save loudness cache: \(error)")
+        }
+    }
+}
+
+private struct FileSignature: Codable, Equatable {
+    let size: UInt64
+    let modificationDate: Date
+
+    init?(filePath: String) {
+        guard let attributes = try? FileManager.default.attributesOfItem(atPath: filePath),
+              let size = attributes[.size] as? UInt64,
+              let modificationDate = attributes[.modificationDate] as? Date else {
+            return nil
+        }
+
+        self.size = size
+        self.modificationDate = modificationDate
+    }
+}
+
+private struct CacheEntry: Codable {
+    let signature: FileSignature
+    let integratedLoudness: Double
+    let truePeak: Double
+}
+
+private struct Cache: Codable {
+    let version: Int
+    let entries: [String: CacheEntry]
+}
+
+extension RDMPEGLoudnessAnalyzer {
+    override public class func l4Logger() -> L4Logger {
+        return L4Logger(forName: "rd.mediaplayer.RDMPEGLoudnessAnalyzer")
+    }
+}
@@ -0,0 +1,269 @@
+//
+//  RDMPEGLoudnessMeter.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+import Accelerate
+
+// Gating blocks are 400 ms long and overlap by 75%, so they are assembled from 100 ms steps
+private let RDMPEGLoudnessMeterStepDuration: Double = 0.1
+private let RDMPEGLoudnessMeterStepsPerBlock = 4
+private let RDMPEGLoudnessMeterAbsoluteGate: Double = -70.0
+private let RDMPEGLoudnessMeterRelativeGate: Double = -10.0
+// Interpolation filter of true peak, 48 taps split into 4 phases as in ITU-R BS.1770-4 Annex 2
+private let RDMPEGLoudnessMeterPhaseTapsCount = 12
+private let RDMPEGLoudnessMeterInterpolationPhases: [[Float]] = [
+    [
+        0.0017089843750, 0.0109863281250, -0.0196533203125, 0.0332031250000, -0.0594482421875, 0.1373291015625,
+        0.9721679687500, -0.1022949218750, 0.0476074218750, -0.0266113281250, 0.0148925781250, -0.0083007812500,
+    ],
+    [
+        -0.0291748046875, 0.0292968750000, -0.0517578125000, 0.0891113281250, -0.1665039062500, 0.4650878906250,
+        0.7797851562500, -0.2003173828125, 0.1015625000000, -0.0582275390625, 0.0330810546875, -0.0189208984375,
+    ],
+    [
+        -0.0189208984375, 0.0330810546875, -0.0582275390625, 0.1015625000000, -0.2003173828125, 0.7797851562500,
+        0.4650878906250, -0.1665039062500, 0.0891113281250, -0.0517578125000, 0.0292968750000, -0.0291748046875,
+    ],
+    [
+        -0.0083007812500, 0.0148925781250, -0.0266113281250, 0.0476074218750, -0.1022949218750, 0.9721679687500,
+        0.1373291015625, -0.0594482421875, 0.0332031250000, -0.0196533203125, 0.0109863281250, 0.0017089843750,
+    ],
+]
+
+// ITU-R BS.1770-4 (EBU R128) integrated loudness and true peak meter of interleaved float samples.
+//
+// K-weighting (high shelf followed by high pass) runs as two-section vDSP biquad directly on interleaved samples
+// of every channel. Only mean square of every 100 ms step is kept, 8 bytes per step. True peak phases of 4x
+// upsampled signal are vDSP convolutions of deinterleaved channel. Mean squares of channels are summed with
+// BS.1770 weights of their positions (RDMPEGDecoder.sourceAudioLoudnessWeights).
+final class RDMPEGLoudnessMeter {
+    let samplingRate: Double
+    let channelsCount: Int
+    let channelWeights: [Double]
+
+    private let biquadSetup: vDSP_biquad_Setup?
+    private var biquadDelays: [[Float]]
+    // Samples preceding the chunk being processed, interpolation filter needs them
+    private var channelHistories: [[Float]]
+    private var filteredSamples: [Float] = []
+    private var channelSamples: [Float] = []
+    private var interpolatedSamples: [Float] = []
+    private let stepFramesCount: Int
+    private var stepFramesLeft: Int
+    private var stepSquaresSum: Double = 0
+    private var stepPowers: [Double] = []
+    private var peak: Float = 0
+
+    init(samplingRate: Double, channelWeights: [Double]) {
+        self.samplingRate = samplingRate
+        self.channelsCount = channelWeights.count
+        self.channelWeights = channelWeights
+        self.biquadSetup = vDSP_biquad_CreateSetup(
+            RDMPEGLoudnessMeter.kWeightingCoefficients(samplingRate: samplingRate),
+            2
+        )
+        self.biquadDelays = Array(repeating: [Float](repeating: 0, count: 2 * 2 + 2), count: channelsCount)
+        self.channelHistories = Array(
+            repeating: [Float](repeating: 0, count: RDMPEGLoudnessMeterPhaseTapsCount - 1),
+            count: channelsCount
+        )
+        self.stepFramesCount = max(1, Int(samplingRate * RDMPEGLoudnessMeterStepDuration))
+        self.stepFramesLeft = self.stepFramesCount
+    }
+
+    // Equally weighted channels, e.g. mono or stereo
+    convenience init(samplingRate: Double, channelsCount: Int) {
+        self.init(samplingRate: samplingRate, channelWeights: Array(repeating: 1, count: channelsCount))
+    }
+
+    deinit {
+        if let biquadSetup = biquadSetup {
+            vDSP_biquad_DestroySetup(biquadSetup)
+        }
+    }
+
+    var loudness: RDMPEGLoudness {
+        RDMPEGLoudness(
+            integratedLoudness: integratedLoudness,
+            truePeak: peak > 0 ? 20 * log10(Double(peak)) : -.infinity
+        )
+    }
+
+    func process(_ samples: UnsafeBufferPointer<Float>) {
+        guard let baseAddress = samples.baseAddress, channelsCount > 0 else {
+            return
+        }
+
+        var framesLeft = samples.count / channelsCount
+        var chunkAddress = baseAddress
+
+        while framesLeft > 0 {
+            let chunkFramesCount = min(framesLeft, stepFramesLeft)
+
+            processChunk(chunkAddress, framesCount: chunkFramesCount)
+
+            framesLeft -= chunkFramesCount
+            chunkAddress = chunkAddress.advanced(by: chunkFramesCount * channelsCount)
+            stepFramesLeft -= chunkFramesCount
+
+            if stepFramesLeft == 0 {
+                stepPowers.append(stepSquaresSum / Double(stepFramesCount))
+                stepSquaresSum = 0
+                stepFramesLeft = stepFramesCount
+            }
+        }
+    }
+
+    // MARK: - Private
+
+    private var integratedLoudness: Double {
+        guard stepPowers.count >= RDMPEGLoudnessMeterStepsPerBlock else {
+            return -.infinity
+        }
+
+        var blockPowers: [Double] = []
+        blockPowers.reserveCapacity(stepPowers.count - RDMPEGLoudnessMeterStepsPerBlock + 1)
+
+        var blockStepsSum = stepPowers[0..<RDMPEGLoudnessMeterStepsPerBlock].reduce(0, +)
+        blockPowers.append(blockStepsSum / Double(RDMPEGLoudnessMeterStepsPerBlock))
+
+        for stepIndex in RDMPEGLoudnessMeterStepsPerBlock..<stepPowers.count {
+            blockStepsSum += stepPowers[stepIndex] - stepPowers[stepIndex - RDMPEGLoudnessMeterStepsPerBlock]
+            blockPowers.append(max(0, blockStepsSum) / Double(RDMPEGLoudnessMeterStepsPerBlock))
+        }
+
+        let absoluteGatedPowers = blockPowers.filter {
+            RDMPEGLoudnessMeter.loudness(ofPower: $0) > RDMPEGLoudnessMeterAbsoluteGate
+        }
+
+        guard !absoluteGatedPowers.isEmpty else {
+            return -.infinity
+        }
+
+        let relativeGate = RDMPEGLoudnessMeter.loudness(
+            ofPower: absoluteGatedPowers.reduce(0, +) / Double(absoluteGatedPowers.count)
+        ) + RDMPEGLoudnessMeterRelativeGate
+
+        let gatedPowers = absoluteGatedPowers.filter { RDMPEGLoudnessMeter.loudness(ofPower: $0) > relativeGate }
+
+        guard !gatedPowers.isEmpty else {
+            return -.infinity
+        }
+
+        return RDMPEGLoudnessMeter.loudness(ofPower: gatedPowers.reduce(0, +) / Double(gatedPowers.count))
+    }
+
+    private func processChunk(_ samples: UnsafePointer<Float>, framesCount: Int) {
+        let historyCount = RDMPEGLoudnessMeterPhaseTapsCount - 1
+
+        if filteredSamples.count < framesCount {
+            filteredSamples = [Float](repeating: 0, count: framesCount)
+            interpolatedSamples = [Float](repeating: 0, count: framesCount)
+            channelSamples = [Float](repeating: 0, count: historyCount + framesCount)
+        }
+
+        var zero: Float = 0
+
+        for channel in 0..<channelsCount {
+            let channelAddress = samples.advanced(by: channel)
+
+            if let biquadSetup = biquadSetup {
+                vDSP_biquad(
+                    biquadSetup,
+                    &biquadDelays[channel],
+                    channelAddress,
+                    vDSP_Stride(channelsCount),
+                    &filteredSamples,
+                    1,
+                    vDSP_Length(framesCount)
+                )
+            }
+
+            var squaresSum: Float = 0
+            vDSP_svesq(filteredSamples, 1, &squaresSum, vDSP_Length(framesCount))
+            stepSquaresSum += channelWeights[channel] * Double(squaresSum)
+
+            // History is followed by deinterleaved chunk, so every phase is a single convolution
+            channelSamples.withUnsafeMutableBufferPointer { channelBuffer in
+                guard let channelBufferAddress = channelBuffer.baseAddress else { return }
+
+                channelHistories[channel].withUnsafeBufferPointer {
+                    channelBufferAddress.initialize(from: $0.baseAddress!, count: historyCount)
+                }
+
+                vDSP_vsadd(
+                    channelAddress,
+                    vDSP_Stride(channelsCount),
+                    &zero,
+                    channelBufferAddress.advanced(by: historyCount),
+                    1,
+                    vDSP_Length(framesCount)
+                )
+
+                for phase in RDMPEGLoudnessMeterInterpolationPhases {
+                    phase.withUnsafeBufferPointer { phaseBuffer in
+                        // Negative filter stride makes vDSP_conv convolution rather than correlation
+                        vDSP_conv(
+                            channelBufferAddress,
+                            1,
+                            phaseBuffer.baseAddress!.advanced(by: historyCount),
+                            -1,
+                            &interpolatedSamples,
+                            1,
+                            vDSP_Length(framesCount),
+                            vDSP_Length(RDMPEGLoudnessMeterPhaseTapsCount)
+                        )
+                    }
+
+                    var phasePeak: Float = 0
+                    vDSP_maxmgv(interpolatedSamples, 1, &phasePeak, vDSP_Length(framesCount))
+                    peak = max(peak, phasePeak)
+                }
+
+                let nextHistoryAddress = channelBufferAddress.advanced(by: framesCount)
+                channelHistories[channel].withUnsafeMutableBufferPointer {
+                    $0.baseAddress!.initialize(from: nextHistoryAddress, count: historyCount)
+                }
+            }
+        }
+    }
+
+    private static func loudness(ofPower power: Double) -> Double {
+        power > 0 ? -0.691 + 10 * log10(power) : -.infinity
+    }
+
+    // Biquad sections b0, b1, b2, a1, a2 for the sampling rate, BS.1770 specifies them for 48 kHz only
+    private static func kWeightingCoefficients(samplingRate: Double) -> [Double] {
+        // High shelf modelling acoustic effect of the head
+        let shelfFrequency = 1681.974450955533
+        let shelfGain = 3.999843853973347
+        let shelfQ = 0.7071752369554196
+        let shelfK = tan(Double.pi * shelfFrequency / samplingRate)
+        let shelfVh = pow(10, shelfGain / 20)
+        let shelfVb = pow(shelfVh, 0.4996667741545416)
+        let shelfA0 = 1 + shelfK / shelfQ + shelfK * shelfK
+
+        // RLB high pass
+        let highPassFrequency = 38.13547087602444
+        let highPassQ = 0.5003270373238773
+        let highPassK = tan(Double.pi * highPassFrequency / samplingRate)
+        let highPassA0 = 1 + highPassK / highPassQ + highPassK * highPassK
+
+        return [
+            (shelfVh + shelfVb * shelfK / shelfQ + shelfK * shelfK) / shelfA0,
+            2 * (shelfK * shelfK - shelfVh) / shelfA0,
+            (shelfVh - shelfVb * shelfK / shelfQ + shelfK * shelfK) / shelfA0,
+            2 * (shelfK * shelfK - 1) / shelfA0,
+            (1 - shelfK / shelfQ + shelfK * shelfK) / shelfA0,
+            1,
+            -2,
+            1,
+            2 * (highPassK * highPassK - 1) / highPassA0,
+            (1 - highPassK / highPassQ + highPassK * highPassK) / highPassA0,
+        ]
+    }
+}
@@ -0,0 +1,32 @@
+//
+//  RDMPEGResamplerProfile.c
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGResamplerProfile.h"
+
+const RDMPEGResamplerProfile RDMPEGResamplerProfileFast = {
+    .name = "fast",
+    .filterSize = 8,
+    .phaseShift = 6,
+    .linearInterpolation = 1,
+    .cutoff = 0.9,
+};
+
+const RDMPEGResamplerProfile RDMPEGResamplerProfileBalanced = {
+    .name = "balanced",
+    .filterSize = 32,
+    .phaseShift = 10,
+    .linearInterpolation = 1,
+    .cutoff = 0.97,
+};
+
+const RDMPEGResamplerProfile RDMPEGResamplerProfileHigh = {
+    .name = "high",
+    .filterSize = 64,
+    .phaseShift = 12,
+    .linearInterpolation = 1,
+    .cutoff = 0.98,
+};
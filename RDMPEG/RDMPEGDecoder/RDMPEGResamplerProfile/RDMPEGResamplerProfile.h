@@ -0,0 +1,33 @@
+//
+//  RDMPEGResamplerProfile.h
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGResamplerProfile_h
+#define RDMPEGResamplerProfile_h
+
+// libswresample options of resampler quality profiles, shared by RDMPEGDecoder and the benchmark which measures
+// their CPU cost and quality. Plain C without FFmpeg dependency, options are set by name (av_opt_set_*).
+
+typedef struct RDMPEGResamplerProfile {
+    const char *name;
+    // Taps per output sample ("filter_size")
+    int filterSize;
+    // 2^phaseShift filter phases between input samples ("phase_shift")
+    int phaseShift;
+    // Interpolate between neighbour phases rather than pick the nearest one ("linear_interp")
+    int linearInterpolation;
+    // Passband edge relative to Nyquist frequency of the lower rate ("cutoff")
+    double cutoff;
+} RDMPEGResamplerProfile;
+
+// Short filter with coarse phases, for low-end devices
+extern const RDMPEGResamplerProfile RDMPEGResamplerProfileFast;
+// Close to libswresample defaults
+extern const RDMPEGResamplerProfile RDMPEGResamplerProfileBalanced;
+// Long filter with fine phases and wider passband
+extern const RDMPEGResamplerProfile RDMPEGResamplerProfileHigh;
+
+#endif /* RDMPEGResamplerProfile_h */
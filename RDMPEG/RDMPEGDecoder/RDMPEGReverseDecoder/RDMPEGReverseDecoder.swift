@@ -0,0 +1,218 @@
+//
+//  RDMPEGReverseDecoder.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+import Log4Cocoa
+
+// Half of the budget holds frames being handed out, another half the prefetched ones
+private let RDMPEGReverseDecoderDefaultByteBudget = 128 * 1024 * 1024
+// First keyframe search steps back by that much, every retry which lands on the same keyframe doubles the step
+private let RDMPEGReverseDecoderKeyframeSearchStep: TimeInterval = 0.001
+
+// Plays video backwards frame by frame.
+//
+// Frames come in segments: GOP is decoded forward from its keyframe and handed out in reverse order, while segment
+// preceding it is decoded on worker queue. GOP which doesn't fit the half of the budget is split, frames closest
+// to its end are kept and the rest is decoded again from the same keyframe once the kept ones are handed out,
+// so memory stays bounded at the cost of decoding long GOPs more than once.
+@objcMembers
+public class RDMPEGReverseDecoder: NSObject {
+    public let byteBudget: Int
+
+    private let decoder: RDMPEGDecoder
+    private let workerQueue: OperationQueue
+    private let condition = NSCondition()
+    // Ascending, handed out from the end
+    private var frames: [RDMPEGVideoFrame] = []
+    private var prefetchedSegment: Segment?
+    private var isPrefetching = false
+    private var generation = 0
+
+    private var segmentByteBudget: Int {
+        byteBudget / 2
+    }
+
+    // Decoder should have video stream loaded and isn't used by anyone else from now on.
+    // Audio and subtitles aren't played backwards, so their streams are deactivated
+    public init(decoder: RDMPEGDecoder, byteBudget: Int) {
+        self.decoder = decoder
+        self.byteBudget = byteBudget
+        self.workerQueue = OperationQueue()
+        super.init()
+
+        self.workerQueue.name = "RDMPEGReverseDecoder Worker Queue"
+        self.workerQueue.maxConcurrentOperationCount = 1
+        self.workerQueue.qualityOfService = .userInitiated
+
+        decoder.deactivateAudioStream()
+        decoder.deactivateSubtitleStream()
+    }
+
+    public convenience init(decoder: RDMPEGDecoder) {
+        self.init(decoder: decoder, byteBudget: RDMPEGReverseDecoderDefaultByteBudget)
+    }
+
+    deinit {
+        workerQueue.cancelAllOperations()
+    }
+
+    // The next previousFrame() returns the last frame before the position
+    public func move(to position: TimeInterval) {
+        condition.withLock {
+            generation += 1
+            frames.removeAll()
+            prefetchedSegment = nil
+
+            startPrefetching(Request(
+                endPosition: position,
+                keyframeSearchPosition: position - RDMPEGReverseDecoderKeyframeSearchStep
+            ))
+        }
+    }
+
+    // Blocks while preceding segment is being decoded, returns nil once the beginning is reached
+    public func previousFrame() -> RDMPEGVideoFrame? {
+        condition.withLock {
+            while true {
+                if let frame = frames.popLast() {
+                    return frame
+                }
+
+                while isPrefetching {
+                    condition.wait()
+                }
+
+                guard let segment = prefetchedSegment else {
+                    return nil
+                }
+
+                prefetchedSegment = nil
+                frames = segment.frames
+
+                if let nextRequest = segment.nextRequest {
+                    startPrefetching(nextRequest)
+                }
+            }
+        }
+    }
+
+    // MARK: - Private
+
+    // Condition lock should be held
+    private func startPrefetching(_ request: Request) {
+        isPrefetching = true
+
+        let requestGeneration = generation
+
+        workerQueue.addOperation { [weak self] in
+            guard let self = self else { return }
+
+            let segment = self.decodeSegment(request)
+
+            self.condition.withLock {
+                // Position was moved meanwhile
+                guard self.generation == requestGeneration else { return }
+
+                self.prefetchedSegment = segment
+                self.isPrefetching = false
+                self.condition.broadcast()
+            }
+        }
+    }
+
+    private func decodeSegment(_ request: Request) -> Segment {
+        log4Assert(OperationQueue.current == workerQueue, "Method '\(#function)' called from wrong queue")
+
+        var keyframeSearchPosition = request.keyframeSearchPosition
+        var keyframeSearchStep = RDMPEGReverseDecoderKeyframeSearchStep
+
+        while true {
+            decoder.moveToKeyframe(before: max(0, keyframeSearchPosition))
+
+            var segmentFrames: [RDMPEGVideoFrame] = []
+            var segmentByteSize = 0
+            var keyframePosition: TimeInterval?
+            var isSplit = false
+
+            decoding: while !decoder.isEndReached {
+                guard let decodedFrames = decoder.decodeFrames() else {
+                    break
+                }
+
+                for case let videoFrame as RDMPEGVideoFrame in decodedFrames {
+                    if keyframePosition == nil {
+                        // Leading frames of open GOP reference the preceding one, so they come out broken before
+                        // the keyframe and belong to the previous segment
+                        guard videoFrame.isKeyframe else {
+                            continue
+                        }
+
+                        keyframePosition = videoFrame.position
+                    }
+
+                    if videoFrame.position >= request.endPosition {
+                        break decoding
+                    }
+
+                    segmentFrames.append(videoFrame)
+                    segmentByteSize += videoFrame.byteSize
+
+                    while segmentByteSize > segmentByteBudget && segmentFrames.count > 1 {
+                        segmentByteSize -= segmentFrames.removeFirst().byteSize
+                        isSplit = true
+                    }
+                }
+            }
+
+            guard let keyframePosition = keyframePosition, let firstFrame = segmentFrames.first else {
+                // Timestamp rounding landed on the keyframe which starts the next segment, or there is no video
+                if keyframeSearchPosition <= 0 {
+                    return Segment(frames: [], nextRequest: nil)
+                }
+
+                keyframeSearchPosition -= keyframeSearchStep
+                keyframeSearchStep *= 2
+                continue
+            }
+
+            if isSplit {
+                return Segment(
+                    frames: segmentFrames,
+                    nextRequest: Request(
+                        endPosition: firstFrame.position,
+                        keyframeSearchPosition: keyframeSearchPosition
+                    )
+                )
+            }
+
+            return Segment(
+                frames: segmentFrames,
+                nextRequest: Request(
+                    endPosition: keyframePosition,
+                    keyframeSearchPosition: keyframePosition - RDMPEGReverseDecoderKeyframeSearchStep
+                )
+            )
+        }
+    }
+}
+
+// Frames before the end position, decoded from the keyframe found at or before the search position
+private struct Request {
+    let endPosition: TimeInterval
+    let keyframeSearchPosition: TimeInterval
+}
+
+private struct Segment {
+    let frames: [RDMPEGVideoFrame]
+    let nextRequest: Request?
+}
+
+extension RDMPEGReverseDecoder {
+    override public class func l4Logger() -> L4Logger {
+        return L4Logger(forName: "rd.mediaplayer.RDMPEGReverseDecoder")
+    }
+}
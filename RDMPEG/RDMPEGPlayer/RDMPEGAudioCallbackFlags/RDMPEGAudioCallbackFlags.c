@@ -0,0 +1,48 @@
+//
+//  RDMPEGAudioCallbackFlags.c
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGAudioCallbackFlags.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+struct RDMPEGAudioCallbackFlags {
+    _Atomic bool values[RDMPEGAudioCallbackFlagsCount];
+};
+
+RDMPEGAudioCallbackFlags *rdmpeg_audio_callback_flags_create(void) {
+    RDMPEGAudioCallbackFlags *flags = malloc(sizeof(RDMPEGAudioCallbackFlags));
+    if (flags == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < RDMPEGAudioCallbackFlagsCount; i++) {
+        atomic_init(&flags->values[i], false);
+    }
+
+    return flags;
+}
+
+void rdmpeg_audio_callback_flags_destroy(RDMPEGAudioCallbackFlags *flags) {
+    free(flags);
+}
+
+bool rdmpeg_audio_callback_flags_get(RDMPEGAudioCallbackFlags *flags, RDMPEGAudioCallbackFlag flag) {
+    return atomic_load(&flags->values[flag]);
+}
+
+void rdmpeg_audio_callback_flags_set(RDMPEGAudioCallbackFlags *flags, RDMPEGAudioCallbackFlag flag, bool value) {
+    atomic_store(&flags->values[flag], value);
+}
+
+bool rdmpeg_audio_callback_flags_take(RDMPEGAudioCallbackFlags *flags, RDMPEGAudioCallbackFlag flag) {
+    // Plain load first, so the render thread doesn't write the cache line when there is nothing to take
+    if (!atomic_load(&flags->values[flag])) {
+        return false;
+    }
+
+    return atomic_exchange(&flags->values[flag], false);
+}
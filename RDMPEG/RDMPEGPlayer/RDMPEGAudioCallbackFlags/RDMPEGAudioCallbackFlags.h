@@ -0,0 +1,37 @@
+//
+//  RDMPEGAudioCallbackFlags.h
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGAudioCallbackFlags_h
+#define RDMPEGAudioCallbackFlags_h
+
+#include <stdbool.h>
+
+// Player state audio render callback shares with other threads, kept in C11 atomics so the render thread
+// never takes a lock (and never waits for a lower priority thread holding one).
+// All functions may be called from any thread.
+
+typedef enum RDMPEGAudioCallbackFlag {
+    // Audio-only mode, video isn't decoded and presented until resync finishes
+    RDMPEGAudioCallbackFlagVideoSuspended = 0,
+    // Startup measurement waits for the first audio rendered
+    RDMPEGAudioCallbackFlagAwaitingFirstAudio,
+    RDMPEGAudioCallbackFlagsCount
+} RDMPEGAudioCallbackFlag;
+
+typedef struct RDMPEGAudioCallbackFlags RDMPEGAudioCallbackFlags;
+
+// All flags are cleared, returns NULL when out of memory
+RDMPEGAudioCallbackFlags *rdmpeg_audio_callback_flags_create(void);
+void rdmpeg_audio_callback_flags_destroy(RDMPEGAudioCallbackFlags *flags);
+
+bool rdmpeg_audio_callback_flags_get(RDMPEGAudioCallbackFlags *flags, RDMPEGAudioCallbackFlag flag);
+void rdmpeg_audio_callback_flags_set(RDMPEGAudioCallbackFlags *flags, RDMPEGAudioCallbackFlag flag, bool value);
+
+// Clears the flag, returns whether it was set. Only one of concurrent callers gets true
+bool rdmpeg_audio_callback_flags_take(RDMPEGAudioCallbackFlags *flags, RDMPEGAudioCallbackFlag flag);
+
+#endif /* RDMPEGAudioCallbackFlags_h */
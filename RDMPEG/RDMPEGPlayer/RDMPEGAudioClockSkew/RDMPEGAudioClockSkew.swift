@@ -0,0 +1,141 @@
+//
+//  RDMPEGAudioClockSkew.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Skew is measured and compensation changes at most once per that much host time
+private let RDMPEGAudioClockSkewWindow: TimeInterval = 4.0
+// Gap between audio callbacks longer than that (pause, interruption) is cut out of host time
+private let RDMPEGAudioClockSkewGapThreshold: TimeInterval = 0.5
+// Same limit decoder resampler compensation has
+private let RDMPEGAudioClockSkewMaximumCompensation: Double = 0.005
+
+// Measures audio device clock against host clock and decides how much decoder resampler stretches audio.
+//
+// Audio callback reports how many frames device asks for and host time of the callback. Device time (frames
+// consumed over sampling rate) is regressed against host time since measurement started, so callback jitter
+// averages out rather than being divided by window length. Device doesn't run while playback is paused,
+// so such gaps are cut out of host time and measurement goes on. Positive skew means device consumes samples
+// faster than host clock runs. Decoder stretches upcoming audio by the skew, so audio advances at host rate
+// and playback clock following audio doesn't keep slewing after the device.
+// Compensation is handed out once per measurement window and spans two windows, so it doesn't lapse when
+// the next measurement comes late. Audio already buffered was stretched by previously applied skew, so
+// the difference accumulated in it is paid back within the next window as well.
+//
+// Callbacks are reported from audio thread, compensation is taken on decoding queue.
+final class RDMPEGAudioClockSkew {
+    private let lock = NSLock()
+
+    private var samplingRate: Double = 0
+    private var firstHostTime: TimeInterval = 0
+    private var lastHostTime: TimeInterval = 0
+    private var lastCallbackDuration: TimeInterval = 0
+    private var windowStartHostTime: TimeInterval = 0
+    private var deviceTime: TimeInterval = 0
+    // Least squares sums of device time (y) over host time (x), both relative to the first callback
+    private var pointsCount: Double = 0
+    private var sumX: Double = 0
+    private var sumY: Double = 0
+    private var sumXY: Double = 0
+    private var sumXX: Double = 0
+    private var measuredSkew: Double?
+    private var measurementsCount = 0
+    private var appliedMeasurementsCount = 0
+    private var appliedSkew: Double = 0
+
+    // Duration of output audio compensation is spread over
+    var compensationDuration: TimeInterval {
+        RDMPEGAudioClockSkewWindow * 2
+    }
+
+    var skew: Double? {
+        lock.withLock { measuredSkew }
+    }
+
+    func recordCallback(framesCount: Int, samplingRate: Double, hostTime: TimeInterval) {
+        guard framesCount > 0, samplingRate > 0 else {
+            return
+        }
+
+        lock.withLock {
+            if samplingRate != self.samplingRate {
+                // Another device, skew of the previous one says nothing about it
+                self.samplingRate = samplingRate
+                measuredSkew = nil
+                restartMeasurement(hostTime: hostTime)
+            }
+            else if hostTime - lastHostTime > RDMPEGAudioClockSkewGapThreshold {
+                // Device resumes where it stopped, as if the previous callback was followed right away
+                let gap = hostTime - lastHostTime - lastCallbackDuration
+                firstHostTime += gap
+                windowStartHostTime += gap
+            }
+
+            lastHostTime = hostTime
+            lastCallbackDuration = Double(framesCount) / samplingRate
+
+            let x = hostTime - firstHostTime
+            let y = deviceTime
+            pointsCount += 1
+            sumX += x
+            sumY += y
+            sumXY += x * y
+            sumXX += x * x
+            deviceTime += lastCallbackDuration
+
+            guard hostTime - windowStartHostTime >= RDMPEGAudioClockSkewWindow else {
+                return
+            }
+
+            let denominator = pointsCount * sumXX - sumX * sumX
+            guard pointsCount > 2, denominator > 0 else {
+                return
+            }
+
+            let slope = (pointsCount * sumXY - sumX * sumY) / denominator
+            measuredSkew = clampedCompensation(slope - 1)
+            measurementsCount += 1
+            windowStartHostTime = hostTime
+        }
+    }
+
+    // Skew decoder should stretch the next compensation duration of audio by, nil until the next measurement.
+    // Buffered duration is real time of decoded audio which isn't heard yet.
+    func takeCompensation(bufferedDuration: TimeInterval) -> Double? {
+        lock.withLock {
+            guard let skew = measuredSkew, measurementsCount != appliedMeasurementsCount else {
+                return nil
+            }
+
+            appliedMeasurementsCount = measurementsCount
+
+            let catchUp = (skew - appliedSkew) * max(bufferedDuration, 0) / RDMPEGAudioClockSkewWindow
+            appliedSkew = skew
+
+            return clampedCompensation(skew + catchUp)
+        }
+    }
+
+    // MARK: - Private
+
+    private func restartMeasurement(hostTime: TimeInterval) {
+        firstHostTime = hostTime
+        lastHostTime = hostTime
+        lastCallbackDuration = 0
+        windowStartHostTime = hostTime
+        deviceTime = 0
+        pointsCount = 0
+        sumX = 0
+        sumY = 0
+        sumXY = 0
+        sumXX = 0
+    }
+
+    private func clampedCompensation(_ skew: Double) -> Double {
+        min(max(skew, -RDMPEGAudioClockSkewMaximumCompensation), RDMPEGAudioClockSkewMaximumCompensation)
+    }
+}
@@ -24,6 +24,8 @@ class RDMPEGAudioRenderer: NSObject {
     private(set) var isPlaying: Bool = false
     private(set) var samplingRate: Double
     private(set) var outputChannelsCount: Int = 0
+    // Time between render callback and rendered samples being heard
+    private(set) var outputLatency: TimeInterval = 0
 
     private var audioUnit: AudioUnit?
     private var outputCallback: OutputCallback?
@@ -31,12 +33,26 @@ class RDMPEGAudioRenderer: NSObject {
     private var outputFormat: AudioStreamBasicDescription = AudioStreamBasicDescription()
     private var bytesPerSample: Int = 0
     private var audioUnitStarted: Bool = false
+    private let audioTap: OpaquePointer?
+
+    // Rendered audio is measured for visualisers while enabled, see RDMPEGAudioTap.h
+    var isAudioTapEnabled: Bool {
+        get {
+            guard let audioTap = audioTap else { return false }
+            return rdmpeg_audio_tap_is_enabled(audioTap)
+        }
+        set {
+            guard let audioTap = audioTap else { return }
+            rdmpeg_audio_tap_set_enabled(audioTap, newValue)
+        }
+    }
 
     override public init() {
         self.samplingRate = AVAudioSession.sharedInstance().sampleRate
         self.outputData = UnsafeMutablePointer<Float>.allocate(
                 capacity: RDMPEGAudioRenderer.maxFrameSize * RDMPEGAudioRenderer.maxChannelsCount
             )
+        self.audioTap = rdmpeg_audio_tap_create()
         super.init()
 
         self.outputData?.initialize(
@@ -50,6 +66,10 @@ class RDMPEGAudioRenderer: NSObject {
         _ = stopAudioUnit()
         outputData?.deallocate()
         outputData = nil
+
+        if let audioTap = audioTap {
+            rdmpeg_audio_tap_destroy(audioTap)
+        }
     }
 
     func play(withOutputCallback outputCallback: @escaping OutputCallback) -> Bool {
@@ -87,6 +107,19 @@ class RDMPEGAudioRenderer: NSObject {
         return false
     }
 
+    // Should be called from one thread at a time, returns nil if no block was measured since the previous call
+    func readAudioTap() -> RDMPEGAudioSpectrum? {
+        guard let audioTap = audioTap else { return nil }
+
+        var snapshot = RDMPEGAudioTapSnapshot()
+
+        guard rdmpeg_audio_tap_read(audioTap, &snapshot) else {
+            return nil
+        }
+
+        return RDMPEGAudioSpectrum(snapshot: snapshot)
+    }
+
     // swiftlint:disable:next function_body_length
     private func startAudioUnit() -> Bool {
         do {
@@ -98,6 +131,9 @@ class RDMPEGAudioRenderer: NSObject {
             return false
         }
 
+        // Rendered buffer starts playing once the previous one is played out
+        outputLatency = AVAudioSession.sharedInstance().outputLatency + AVAudioSession.sharedInstance().ioBufferDuration
+
         var description = AudioComponentDescription(
             componentType: kAudioUnitType_Output,
             componentSubType: kAudioUnitSubType_RemoteIO,
@@ -230,6 +266,10 @@ class RDMPEGAudioRenderer: NSObject {
 
         outputCallback(outputData, numFrames, UInt32(outputChannelsCount))
 
+        if let audioTap = audioTap {
+            rdmpeg_audio_tap_write(audioTap, outputData, numFrames, UInt32(outputChannelsCount), samplingRate)
+        }
+
         // Put the rendered data into the output buffer
         if bytesPerSample == 4 { // then we've already got floats
             var zero: Float = 0.0
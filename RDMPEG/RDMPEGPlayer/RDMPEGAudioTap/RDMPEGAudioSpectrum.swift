@@ -0,0 +1,51 @@
+//
+//  RDMPEGAudioSpectrum.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Levels and spectrum of the latest block of rendered audio, values are linear with full scale being 1
+@objcMembers
+public class RDMPEGAudioSpectrum: NSObject {
+    // Number of blocks measured since audio renderer was created, gaps mean some blocks weren't read
+    public let sequence: UInt64
+    public let samplingRate: Double
+    // Per output channel
+    public let rmsLevels: [Float]
+    public let peakLevels: [Float]
+    // Amplitude of the channels mix at index * binWidth Hz, from 0 up to Nyquist frequency
+    public let magnitudes: [Float]
+
+    public var binWidth: Double {
+        samplingRate / Double(RDMPEG_AUDIO_TAP_BLOCK_SIZE)
+    }
+
+    public var blockDuration: TimeInterval {
+        Double(RDMPEG_AUDIO_TAP_BLOCK_SIZE) / samplingRate
+    }
+
+    init(snapshot: RDMPEGAudioTapSnapshot) {
+        let channelsCount = Int(snapshot.channelsCount)
+
+        self.sequence = snapshot.sequence
+        self.samplingRate = snapshot.samplingRate
+        self.rmsLevels = withUnsafeBytes(of: snapshot.rms) {
+            Array($0.bindMemory(to: Float.self).prefix(channelsCount))
+        }
+        self.peakLevels = withUnsafeBytes(of: snapshot.peak) {
+            Array($0.bindMemory(to: Float.self).prefix(channelsCount))
+        }
+        self.magnitudes = withUnsafeBytes(of: snapshot.magnitudes) {
+            Array($0.bindMemory(to: Float.self))
+        }
+        super.init()
+    }
+
+    override public var description: String {
+        let levels = zip(rmsLevels, peakLevels).map { String(format: "%.3f/%.3f", $0, $1) }
+        return "RDMPEGAudioSpectrum #\(sequence) RMS/peak: \(levels.joined(separator: ", "))"
+    }
+}
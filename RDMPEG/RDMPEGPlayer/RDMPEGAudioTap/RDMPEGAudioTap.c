@@ -0,0 +1,239 @@
+//
+//  RDMPEGAudioTap.c
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGAudioTap.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Triple buffer: writer fills back slot and swaps it with the middle one, reader swaps its front slot with
+// the middle one if it's fresh. Each side owns its slot exclusively, so slots are never accessed concurrently.
+#define RDMPEG_AUDIO_TAP_SLOTS_COUNT 3
+#define RDMPEG_AUDIO_TAP_SLOT_INDEX_MASK 0x3u
+#define RDMPEG_AUDIO_TAP_SLOT_FRESH 0x4u
+
+struct RDMPEGAudioTap {
+    _Atomic bool enabled;
+    _Atomic uint32_t middleSlot;
+    RDMPEGAudioTapSnapshot slots[RDMPEG_AUDIO_TAP_SLOTS_COUNT];
+
+    // Tables
+    float window[RDMPEG_AUDIO_TAP_BLOCK_SIZE];
+    float windowSum;
+    float cosines[RDMPEG_AUDIO_TAP_BLOCK_SIZE / 2];
+    float sines[RDMPEG_AUDIO_TAP_BLOCK_SIZE / 2];
+    uint32_t bitReversed[RDMPEG_AUDIO_TAP_BLOCK_SIZE];
+
+    // Writer side
+    bool writerEnabled;
+    uint32_t backSlot;
+    uint64_t sequence;
+    uint32_t channelsCount;
+    double samplingRate;
+    uint32_t blockFramesCount;
+    double squaresSums[RDMPEG_AUDIO_TAP_MAX_CHANNELS];
+    float peaks[RDMPEG_AUDIO_TAP_MAX_CHANNELS];
+    float mix[RDMPEG_AUDIO_TAP_BLOCK_SIZE];
+    float real[RDMPEG_AUDIO_TAP_BLOCK_SIZE];
+    float imaginary[RDMPEG_AUDIO_TAP_BLOCK_SIZE];
+
+    // Reader side
+    uint32_t frontSlot;
+};
+
+static void audio_tap_reset_block(RDMPEGAudioTap *tap);
+static void audio_tap_publish_block(RDMPEGAudioTap *tap);
+static void audio_tap_transform(RDMPEGAudioTap *tap, float *magnitudes);
+
+// MARK: - Lifecycle
+
+RDMPEGAudioTap *rdmpeg_audio_tap_create(void) {
+    RDMPEGAudioTap *tap = calloc(1, sizeof(RDMPEGAudioTap));
+    if (tap == NULL) {
+        return NULL;
+    }
+
+    atomic_init(&tap->enabled, false);
+    atomic_init(&tap->middleSlot, 1);
+    tap->backSlot = 0;
+    tap->frontSlot = 2;
+
+    uint32_t bitsCount = 0;
+    while ((1u << bitsCount) < RDMPEG_AUDIO_TAP_BLOCK_SIZE) {
+        bitsCount++;
+    }
+
+    for (uint32_t i = 0; i < RDMPEG_AUDIO_TAP_BLOCK_SIZE; i++) {
+        tap->window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / RDMPEG_AUDIO_TAP_BLOCK_SIZE));
+        tap->windowSum += tap->window[i];
+
+        uint32_t reversed = 0;
+        for (uint32_t bit = 0; bit < bitsCount; bit++) {
+            reversed |= ((i >> bit) & 1u) << (bitsCount - 1 - bit);
+        }
+        tap->bitReversed[i] = reversed;
+    }
+
+    for (uint32_t i = 0; i < RDMPEG_AUDIO_TAP_BLOCK_SIZE / 2; i++) {
+        tap->cosines[i] = (float)cos(2.0 * M_PI * i / RDMPEG_AUDIO_TAP_BLOCK_SIZE);
+        tap->sines[i] = (float)sin(2.0 * M_PI * i / RDMPEG_AUDIO_TAP_BLOCK_SIZE);
+    }
+
+    return tap;
+}
+
+void rdmpeg_audio_tap_destroy(RDMPEGAudioTap *tap) {
+    free(tap);
+}
+
+void rdmpeg_audio_tap_set_enabled(RDMPEGAudioTap *tap, bool enabled) {
+    atomic_store_explicit(&tap->enabled, enabled, memory_order_relaxed);
+}
+
+bool rdmpeg_audio_tap_is_enabled(RDMPEGAudioTap *tap) {
+    return atomic_load_explicit(&tap->enabled, memory_order_relaxed);
+}
+
+// MARK: - Writer
+
+void rdmpeg_audio_tap_write(RDMPEGAudioTap *tap,
+                            const float *samples,
+                            uint32_t framesCount,
+                            uint32_t channelsCount,
+                            double samplingRate) {
+    if (atomic_load_explicit(&tap->enabled, memory_order_relaxed) == false) {
+        tap->writerEnabled = false;
+        return;
+    }
+
+    if (channelsCount == 0 || channelsCount > RDMPEG_AUDIO_TAP_MAX_CHANNELS) {
+        return;
+    }
+
+    if (tap->writerEnabled == false || tap->channelsCount != channelsCount || tap->samplingRate != samplingRate) {
+        tap->writerEnabled = true;
+        tap->channelsCount = channelsCount;
+        tap->samplingRate = samplingRate;
+        audio_tap_reset_block(tap);
+    }
+
+    float mixScale = 1.0f / channelsCount;
+
+    for (uint32_t frame = 0; frame < framesCount; frame++) {
+        const float *frameSamples = samples + (size_t)frame * channelsCount;
+        float mixedSample = 0.0f;
+
+        for (uint32_t channel = 0; channel < channelsCount; channel++) {
+            float sample = frameSamples[channel];
+            tap->squaresSums[channel] += sample * sample;
+            tap->peaks[channel] = fmaxf(tap->peaks[channel], fabsf(sample));
+            mixedSample += sample;
+        }
+
+        tap->mix[tap->blockFramesCount++] = mixedSample * mixScale;
+
+        if (tap->blockFramesCount == RDMPEG_AUDIO_TAP_BLOCK_SIZE) {
+            audio_tap_publish_block(tap);
+            audio_tap_reset_block(tap);
+        }
+    }
+}
+
+static void audio_tap_reset_block(RDMPEGAudioTap *tap) {
+    tap->blockFramesCount = 0;
+    memset(tap->squaresSums, 0, sizeof(tap->squaresSums));
+    memset(tap->peaks, 0, sizeof(tap->peaks));
+}
+
+static void audio_tap_publish_block(RDMPEGAudioTap *tap) {
+    RDMPEGAudioTapSnapshot *snapshot = &tap->slots[tap->backSlot];
+
+    tap->sequence++;
+
+    snapshot->sequence = tap->sequence;
+    snapshot->samplingRate = tap->samplingRate;
+    snapshot->channelsCount = tap->channelsCount;
+
+    for (uint32_t channel = 0; channel < RDMPEG_AUDIO_TAP_MAX_CHANNELS; channel++) {
+        if (channel < tap->channelsCount) {
+            snapshot->rms[channel] = (float)sqrt(tap->squaresSums[channel] / RDMPEG_AUDIO_TAP_BLOCK_SIZE);
+            snapshot->peak[channel] = tap->peaks[channel];
+        }
+        else {
+            snapshot->rms[channel] = 0.0f;
+            snapshot->peak[channel] = 0.0f;
+        }
+    }
+
+    audio_tap_transform(tap, snapshot->magnitudes);
+
+    // Release publishes the slot contents, acquire takes ownership of the slot reader left in the middle
+    uint32_t previousMiddleSlot = atomic_exchange_explicit(&tap->middleSlot,
+                                                           tap->backSlot | RDMPEG_AUDIO_TAP_SLOT_FRESH,
+                                                           memory_order_acq_rel);
+    tap->backSlot = previousMiddleSlot & RDMPEG_AUDIO_TAP_SLOT_INDEX_MASK;
+}
+
+// In-place iterative radix-2 FFT of windowed mix, input is loaded in bit-reversed order
+static void audio_tap_transform(RDMPEGAudioTap *tap, float *magnitudes) {
+    float *real = tap->real;
+    float *imaginary = tap->imaginary;
+
+    for (uint32_t i = 0; i < RDMPEG_AUDIO_TAP_BLOCK_SIZE; i++) {
+        uint32_t source = tap->bitReversed[i];
+        real[i] = tap->mix[source] * tap->window[source];
+        imaginary[i] = 0.0f;
+    }
+
+    for (uint32_t size = 2; size <= RDMPEG_AUDIO_TAP_BLOCK_SIZE; size *= 2) {
+        uint32_t halfSize = size / 2;
+        uint32_t tableStep = RDMPEG_AUDIO_TAP_BLOCK_SIZE / size;
+
+        for (uint32_t start = 0; start < RDMPEG_AUDIO_TAP_BLOCK_SIZE; start += size) {
+            for (uint32_t k = 0; k < halfSize; k++) {
+                float twiddleReal = tap->cosines[k * tableStep];
+                float twiddleImaginary = -tap->sines[k * tableStep];
+
+                uint32_t even = start + k;
+                uint32_t odd = even + halfSize;
+
+                float oddReal = twiddleReal * real[odd] - twiddleImaginary * imaginary[odd];
+                float oddImaginary = twiddleReal * imaginary[odd] + twiddleImaginary * real[odd];
+
+                real[odd] = real[even] - oddReal;
+                imaginary[odd] = imaginary[even] - oddImaginary;
+                real[even] += oddReal;
+                imaginary[even] += oddImaginary;
+            }
+        }
+    }
+
+    // Sine amplitude is split between positive and negative frequency, window scales it by its sum
+    float scale = 2.0f / tap->windowSum;
+
+    for (uint32_t bin = 0; bin < RDMPEG_AUDIO_TAP_BINS_COUNT; bin++) {
+        magnitudes[bin] = sqrtf(real[bin] * real[bin] + imaginary[bin] * imaginary[bin]) * scale;
+    }
+
+    magnitudes[0] *= 0.5f;
+}
+
+// MARK: - Reader
+
+bool rdmpeg_audio_tap_read(RDMPEGAudioTap *tap, RDMPEGAudioTapSnapshot *snapshot) {
+    if ((atomic_load_explicit(&tap->middleSlot, memory_order_relaxed) & RDMPEG_AUDIO_TAP_SLOT_FRESH) == 0) {
+        return false;
+    }
+
+    uint32_t previousMiddleSlot = atomic_exchange_explicit(&tap->middleSlot, tap->frontSlot, memory_order_acq_rel);
+    tap->frontSlot = previousMiddleSlot & RDMPEG_AUDIO_TAP_SLOT_INDEX_MASK;
+
+    memcpy(snapshot, &tap->slots[tap->frontSlot], sizeof(RDMPEGAudioTapSnapshot));
+
+    return true;
+}
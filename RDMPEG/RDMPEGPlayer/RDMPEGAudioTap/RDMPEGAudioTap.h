@@ -0,0 +1,59 @@
+//
+//  RDMPEGAudioTap.h
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGAudioTap_h
+#define RDMPEGAudioTap_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Level and spectrum tap of rendered audio for visualisers, plain C so it builds and is tested on Linux too.
+//
+// Audio thread writes interleaved float samples right before they are handed to the output. Every block of
+// RDMPEG_AUDIO_TAP_BLOCK_SIZE frames tap measures RMS and peak level of each channel and magnitude spectrum
+// of their mix (Hann window, radix-2 FFT with precomputed tables), and publishes them through a lock-free
+// triple buffer. Writer neither allocates nor locks. Reader takes the latest snapshot at its own rate,
+// snapshots published in between are skipped.
+// Writer functions may only be called from one thread at a time, reader functions from another one.
+
+#define RDMPEG_AUDIO_TAP_BLOCK_SIZE 1024
+#define RDMPEG_AUDIO_TAP_BINS_COUNT (RDMPEG_AUDIO_TAP_BLOCK_SIZE / 2)
+#define RDMPEG_AUDIO_TAP_MAX_CHANNELS 8
+
+typedef struct RDMPEGAudioTap RDMPEGAudioTap;
+
+typedef struct RDMPEGAudioTapSnapshot {
+    // Number of blocks published so far, including this one
+    uint64_t sequence;
+    double samplingRate;
+    uint32_t channelsCount;
+    float rms[RDMPEG_AUDIO_TAP_MAX_CHANNELS];
+    float peak[RDMPEG_AUDIO_TAP_MAX_CHANNELS];
+    // Amplitude at bin frequency (index * samplingRate / RDMPEG_AUDIO_TAP_BLOCK_SIZE), full scale sine gives 1
+    float magnitudes[RDMPEG_AUDIO_TAP_BINS_COUNT];
+} RDMPEGAudioTapSnapshot;
+
+// Tap is created disabled, returns NULL when out of memory
+RDMPEGAudioTap *rdmpeg_audio_tap_create(void);
+void rdmpeg_audio_tap_destroy(RDMPEGAudioTap *tap);
+
+// May be called from any thread, disabled tap ignores written samples and drops the partial block
+void rdmpeg_audio_tap_set_enabled(RDMPEGAudioTap *tap, bool enabled);
+bool rdmpeg_audio_tap_is_enabled(RDMPEGAudioTap *tap);
+
+// Writer. Partial block is dropped when channels count or sampling rate changes
+void rdmpeg_audio_tap_write(RDMPEGAudioTap *tap,
+                            const float *samples,
+                            uint32_t framesCount,
+                            uint32_t channelsCount,
+                            double samplingRate);
+
+// Reader. Copies the latest snapshot, returns false (snapshot is untouched) if nothing was published since
+// the previous call
+bool rdmpeg_audio_tap_read(RDMPEGAudioTap *tap, RDMPEGAudioTapSnapshot *snapshot);
+
+#endif /* RDMPEGAudioTap_h */
@@ -0,0 +1,208 @@
+//
+//  RDMPEGBufferingController.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+import Log4Cocoa
+
+private let RDMPEGBufferingMinimumDuration: TimeInterval = 0.2
+private let RDMPEGBufferingMaximumDuration: TimeInterval = 1.0
+private let RDMPEGBufferingDurationCeiling: TimeInterval = 8.0
+private let RDMPEGBufferingMaximumUnderrunBoost: Double = 4.0
+// Underrun boost halves every time that much media is decoded without another underrun
+private let RDMPEGBufferingUnderrunBoostHalfLife: TimeInterval = 10.0
+// Decoder producing media slower than that is treated as barely keeping up with playback
+private let RDMPEGBufferingComfortableDecodeSpeed: Double = 2.0
+
+// Decides how much decoded media player keeps ahead of playback.
+//
+// Buffer is ready (decoding pauses) once it holds the low-water duration and full (decoding stops even
+// when other streams lag behind) at the high-water duration. Both marks start at the former constants
+// (0.2 and 1.0 seconds) and adapt:
+// - Decode step time is tracked as smoothed mean. Time the step spent waiting for IO and the rest of it are
+//   tracked as deviations, the same way TCP estimates RTO, so a single slow read (network IO) or slow keyframe
+//   is covered by low-water duration.
+// - Decoder which is barely faster than realtime gets proportionally more headroom.
+// - Every underrun boosts low-water duration, boost decays with media decoded since.
+// Byte budget caps the video buffer regardless of duration, so high resolution BGRA frames can't
+// take gigabytes of memory. Reaching the byte budget makes buffer both ready and full. Player's own budget
+// is further limited by its share of decode pool budget, whichever is smaller applies.
+//
+// Decoding queue reports steps and asks for readiness, main thread reports underruns, statistics
+// may be read from any thread. Readiness checks have no side effects, water marks only move with reported
+// steps and underruns.
+class RDMPEGBufferingController {
+    private let lock = NSLock()
+
+    private var byteBudgetValue: Int
+    private var sharedByteBudgetValue: Int = 0
+    private var smoothedStepTime: TimeInterval = 0
+    private var decodeTimeDeviation: TimeInterval = 0
+    private var smoothedIOTime: TimeInterval = 0
+    private var ioTimeDeviation: TimeInterval = 0
+    private var smoothedDecodeSpeed: Double = 0
+    private var underrunBoost: Double = 1
+    private var underrunCount: UInt = 0
+    private var peakBufferedBytes: Int = 0
+    private var lowWaterDuration = RDMPEGBufferingMinimumDuration
+    private var highWaterDuration = RDMPEGBufferingMaximumDuration
+
+    var byteBudget: Int {
+        get {
+            lock.withLock { byteBudgetValue }
+        }
+        set {
+            lock.withLock { byteBudgetValue = max(newValue, 0) }
+        }
+    }
+
+    // Share of decode pool frame memory budget, 0 means there is no shared limit
+    var sharedByteBudget: Int {
+        get {
+            lock.withLock { sharedByteBudgetValue }
+        }
+        set {
+            lock.withLock { sharedByteBudgetValue = max(newValue, 0) }
+        }
+    }
+
+    var minimumAudioDuration: TimeInterval {
+        lock.withLock { lowWaterDuration }
+    }
+
+    init(byteBudget: Int) {
+        self.byteBudgetValue = byteBudget
+    }
+
+    func isVideoBufferReady(duration: TimeInterval, byteSize: Int) -> Bool {
+        lock.withLock {
+            peakBufferedBytes = max(peakBufferedBytes, byteSize)
+            return duration > lowWaterDuration || isOverBudget(byteSize)
+        }
+    }
+
+    func isVideoBufferFull(duration: TimeInterval, byteSize: Int) -> Bool {
+        lock.withLock {
+            duration >= highWaterDuration || isOverBudget(byteSize)
+        }
+    }
+
+    func isAudioBufferReady(duration: TimeInterval) -> Bool {
+        lock.withLock {
+            duration > lowWaterDuration
+        }
+    }
+
+    // IO time is the part of the step decoder spent in stream reads
+    func recordDecodeStep(time: TimeInterval, ioTime: TimeInterval, mediaDuration: TimeInterval) {
+        guard time > 0 else { return }
+
+        let ioTime = min(max(ioTime, 0), time)
+        let decodeTime = time - ioTime
+
+        lock.withLock {
+            if smoothedStepTime == 0 {
+                smoothedStepTime = time
+                smoothedIOTime = ioTime
+                decodeTimeDeviation = decodeTime / 2
+                ioTimeDeviation = ioTime / 2
+                smoothedDecodeSpeed = mediaDuration / time
+            }
+            else {
+                let smoothedDecodeTime = smoothedStepTime - smoothedIOTime
+                decodeTimeDeviation += (abs(decodeTime - smoothedDecodeTime) - decodeTimeDeviation) / 4
+                ioTimeDeviation += (abs(ioTime - smoothedIOTime) - ioTimeDeviation) / 4
+                smoothedStepTime += (time - smoothedStepTime) / 8
+                smoothedIOTime += (ioTime - smoothedIOTime) / 8
+                smoothedDecodeSpeed += (mediaDuration / time - smoothedDecodeSpeed) / 8
+            }
+
+            if underrunBoost > 1 && mediaDuration > 0 {
+                underrunBoost = max(1, underrunBoost * pow(0.5, mediaDuration / RDMPEGBufferingUnderrunBoostHalfLife))
+            }
+
+            updateWaterMarks()
+        }
+    }
+
+    func recordUnderrun() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        let (count, lowWater, highWater) = lock.withLock {
+            underrunCount += 1
+            underrunBoost = min(RDMPEGBufferingMaximumUnderrunBoost, underrunBoost * 1.5)
+            updateWaterMarks()
+
+            return (underrunCount, lowWaterDuration, highWaterDuration)
+        }
+
+        // Decoding queue waits for the lock on every step, so logging is done without it
+        log4Debug("Buffer underrun #\(count), buffering window: \(lowWater)...\(highWater) s")
+    }
+
+    func statistics(
+        bufferedVideoDuration: TimeInterval,
+        bufferedAudioDuration: TimeInterval,
+        bufferedVideoBytes: Int,
+        bufferedAudioBytes: Int
+    ) -> RDMPEGBufferingStatistics {
+        lock.withLock {
+            RDMPEGBufferingStatistics(
+                bufferedVideoDuration: bufferedVideoDuration,
+                bufferedAudioDuration: bufferedAudioDuration,
+                bufferedVideoBytes: bufferedVideoBytes,
+                bufferedAudioBytes: bufferedAudioBytes,
+                peakBufferedBytes: peakBufferedBytes,
+                lowWaterDuration: lowWaterDuration,
+                highWaterDuration: highWaterDuration,
+                byteBudget: effectiveByteBudget,
+                underrunCount: underrunCount,
+                decodeSpeed: smoothedDecodeSpeed,
+                decodeStepTime: smoothedStepTime,
+                decodeStepTimeDeviation: decodeTimeDeviation + ioTimeDeviation,
+                ioTime: smoothedIOTime,
+                ioTimeDeviation: ioTimeDeviation
+            )
+        }
+    }
+
+    // MARK: - Private
+
+    private var effectiveByteBudget: Int {
+        if byteBudgetValue > 0 && sharedByteBudgetValue > 0 {
+            return min(byteBudgetValue, sharedByteBudgetValue)
+        }
+
+        return max(byteBudgetValue, sharedByteBudgetValue)
+    }
+
+    private func isOverBudget(_ byteSize: Int) -> Bool {
+        let byteBudget = effectiveByteBudget
+        return byteBudget > 0 && byteSize >= byteBudget
+    }
+
+    private func updateWaterMarks() {
+        // Worst case single step stall the buffer should survive, slow decode and slow read may coincide
+        let stallDuration = smoothedStepTime + 4 * (decodeTimeDeviation + ioTimeDeviation)
+
+        var speedFactor: Double = 1
+        if smoothedDecodeSpeed > 0 && smoothedDecodeSpeed < RDMPEGBufferingComfortableDecodeSpeed {
+            speedFactor = RDMPEGBufferingComfortableDecodeSpeed / max(smoothedDecodeSpeed, 1)
+        }
+
+        let lowWater = max(RDMPEGBufferingMinimumDuration, stallDuration) * speedFactor * underrunBoost
+        lowWaterDuration = min(lowWater, RDMPEGBufferingDurationCeiling / 2)
+
+        let headroom = RDMPEGBufferingMaximumDuration - RDMPEGBufferingMinimumDuration
+        highWaterDuration = min(lowWaterDuration + headroom * speedFactor, RDMPEGBufferingDurationCeiling)
+    }
+}
+
+extension RDMPEGBufferingController {
+    class var l4Logger: L4Logger {
+        return L4Logger(forName: "rd.mediaplayer.RDMPEGBufferingController")
+    }
+}
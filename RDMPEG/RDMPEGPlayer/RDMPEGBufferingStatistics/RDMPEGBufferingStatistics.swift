@@ -0,0 +1,69 @@
+//
+//  RDMPEGBufferingStatistics.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Immutable snapshot of player buffer occupancy and the buffering window it currently targets
+@objcMembers
+public class RDMPEGBufferingStatistics: NSObject {
+    public let bufferedVideoDuration: TimeInterval
+    public let bufferedAudioDuration: TimeInterval
+    public let bufferedVideoBytes: Int
+    public let bufferedAudioBytes: Int
+    public let peakBufferedBytes: Int
+    // Decoding pauses once buffer holds low-water duration and never runs past high-water duration
+    public let lowWaterDuration: TimeInterval
+    public let highWaterDuration: TimeInterval
+    // 0 means video buffer is limited by duration only
+    public let byteBudget: Int
+    // Number of times playback stalled waiting for decoder
+    public let underrunCount: UInt
+    // Smoothed media seconds decoded per wall clock second
+    public let decodeSpeed: Double
+    public let decodeStepTime: TimeInterval
+    public let decodeStepTimeDeviation: TimeInterval
+    // Smoothed time a decode step waits for stream reads, and its deviation
+    public let ioTime: TimeInterval
+    public let ioTimeDeviation: TimeInterval
+
+    public var byteBudgetOccupancy: Double {
+        byteBudget > 0 ? Double(bufferedVideoBytes) / Double(byteBudget) : 0
+    }
+
+    public init(
+        bufferedVideoDuration: TimeInterval,
+        bufferedAudioDuration: TimeInterval,
+        bufferedVideoBytes: Int,
+        bufferedAudioBytes: Int,
+        peakBufferedBytes: Int,
+        lowWaterDuration: TimeInterval,
+        highWaterDuration: TimeInterval,
+        byteBudget: Int,
+        underrunCount: UInt,
+        decodeSpeed: Double,
+        decodeStepTime: TimeInterval,
+        decodeStepTimeDeviation: TimeInterval,
+        ioTime: TimeInterval,
+        ioTimeDeviation: TimeInterval
+    ) {
+        self.bufferedVideoDuration = bufferedVideoDuration
+        self.bufferedAudioDuration = bufferedAudioDuration
+        self.bufferedVideoBytes = bufferedVideoBytes
+        self.bufferedAudioBytes = bufferedAudioBytes
+        self.peakBufferedBytes = peakBufferedBytes
+        self.lowWaterDuration = lowWaterDuration
+        self.highWaterDuration = highWaterDuration
+        self.byteBudget = byteBudget
+        self.underrunCount = underrunCount
+        self.decodeSpeed = decodeSpeed
+        self.decodeStepTime = decodeStepTime
+        self.decodeStepTimeDeviation = decodeStepTimeDeviation
+        self.ioTime = ioTime
+        self.ioTimeDeviation = ioTimeDeviation
+        super.init()
+    }
+}
@@ -7,29 +7,78 @@
 //
 
 import Foundation
-import Log4Cocoa
 
+// Audio clock farther than that from the playback clock is a discontinuity (seek, underrun), not a drift
+let RDMPEGCorrectionInfoDiscontinuityThreshold: TimeInterval = 0.1
+// Part of the drift removed on every audio clock update, audio callbacks come every ~10-20 ms
+private let RDMPEGCorrectionInfoSlewFactor: Double = 0.1
+
+// Playback clock, maps monotonic host time to media time.
+//
+// Clock runs from the position playback started at, at playback rate. While audio is playing it's the master:
+// audio callback reports media position of samples it renders and the host time they will be heard at
+// (render time plus output latency). Small drift is slewed out gradually, so video scheduled against
+// the clock doesn't jitter with audio callback period, while discontinuities are applied at once.
+// Without audio (or before audio starts) clock is driven by host time only.
+//
+// Clock may be read and updated from any thread.
 class RDMPEGCorrectionInfo: NSObject {
-    private let playbackStartDate: Date
-    private let playbackStartTime: TimeInterval
+    static var hostTime: TimeInterval {
+        ProcessInfo.processInfo.systemUptime
+    }
 
-    init(playbackStartDate: Date, playbackStartTime: TimeInterval) {
-        self.playbackStartDate = playbackStartDate
-        self.playbackStartTime = playbackStartTime
+    let playbackRate: Double
+
+    private let lock = NSLock()
+    private var anchorHostTime: TimeInterval
+    private var anchorPosition: TimeInterval
+    private var audioSynchronized = false
+
+    var isAudioSynchronized: Bool {
+        lock.withLock { audioSynchronized }
+    }
+
+    init(
+        playbackStartTime: TimeInterval,
+        playbackRate: Double,
+        hostTime: TimeInterval = RDMPEGCorrectionInfo.hostTime
+    ) {
+        self.anchorHostTime = hostTime
+        self.anchorPosition = playbackStartTime
+        self.playbackRate = playbackRate
         super.init()
     }
 
-    func correctionInterval(withCurrentTime currentTime: TimeInterval) -> TimeInterval {
-        let continuousPlaybackRealTime = Date().timeIntervalSince(playbackStartDate)
+    func position(atHostTime hostTime: TimeInterval = RDMPEGCorrectionInfo.hostTime) -> TimeInterval {
+        lock.withLock { unsafePosition(atHostTime: hostTime) }
+    }
+
+    // Correction is measured in media time, divide it by playback rate to get real time interval
+    func correctionInterval(
+        withCurrentTime currentTime: TimeInterval,
+        hostTime: TimeInterval = RDMPEGCorrectionInfo.hostTime
+    ) -> TimeInterval {
+        currentTime - position(atHostTime: hostTime)
+    }
+
+    func synchronize(withAudioPosition audioPosition: TimeInterval, hostTime: TimeInterval) {
+        lock.withLock {
+            let drift = audioPosition - unsafePosition(atHostTime: hostTime)
 
-        if continuousPlaybackRealTime < 0.0 {
-            log4Assert(false, "Seems like playback start date is incorrect")
-            return 0.0
+            if !audioSynchronized || abs(drift) > RDMPEGCorrectionInfoDiscontinuityThreshold {
+                anchorHostTime = hostTime
+                anchorPosition = audioPosition
+                audioSynchronized = true
+            }
+            else {
+                anchorPosition += drift * RDMPEGCorrectionInfoSlewFactor
+            }
         }
+    }
 
-        let continuousPlaybackPlayedTime = currentTime - playbackStartTime
+    // MARK: - Private
 
-        let correctionInterval = continuousPlaybackPlayedTime - continuousPlaybackRealTime
-        return correctionInterval
+    private func unsafePosition(atHostTime hostTime: TimeInterval) -> TimeInterval {
+        anchorPosition + (hostTime - anchorHostTime) * playbackRate
     }
 }
@@ -0,0 +1,30 @@
+//
+//  RDMPEGDecodeOperation.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Decoding operation whose work may outlive its execution blocks.
+//
+// Once decode pool has no free slot, the operation returns from its block and decoding continues in an operation
+// queued when pool grants a slot. Operation is finished by then, and cancel() of a finished operation doesn't
+// have to mark it cancelled, so the flag is kept here and continuation checks it the same way as before.
+final class RDMPEGDecodeOperation: BlockOperation {
+    private let lock = NSLock()
+    private var isCancelledValue = false
+
+    override var isCancelled: Bool {
+        lock.withLock { isCancelledValue } || super.isCancelled
+    }
+
+    override func cancel() {
+        lock.withLock {
+            isCancelledValue = true
+        }
+
+        super.cancel()
+    }
+}
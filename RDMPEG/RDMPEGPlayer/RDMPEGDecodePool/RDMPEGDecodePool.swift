@@ -0,0 +1,374 @@
+//
+//  RDMPEGDecodePool.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+// swiftlint:disable file_types_order
+
+import Foundation
+import Log4Cocoa
+
+// About 160 decoded 1080p YUV frames shared by all players
+private let RDMPEGDecodePoolDefaultFrameMemoryBudget = 512 * 1024 * 1024
+
+@objc
+public enum RDMPEGDecodePriority: Int {
+    case offscreen
+    case visible
+    case focused
+
+    // Share of frame memory budget relative to other players
+    fileprivate var budgetWeight: Int {
+        switch self {
+        case .offscreen:
+            return 1
+        case .visible:
+            return 2
+        case .focused:
+            return 4
+        }
+    }
+}
+
+// Waiting step gains one priority level per that much time, so lower priority steps can't starve
+private let RDMPEGDecodePoolAgingInterval: TimeInterval = 0.1
+
+// Process-wide scheduler of decoding work done by all players at once.
+//
+// Pool has as many slots as there are active cores, and every decode step of every player runs holding one.
+// Players submit steps with their priority: a step takes a free slot at once, otherwise it waits in pool without
+// holding any thread, and pool runs it once a slot frees up (see RDMPEGDecodeStepScheduler for the order).
+// Decoder state can't move between threads mid-stream, so a submitted step doesn't run on a pool thread,
+// pool hands it back to its player, which queues it on its own serial decoding queue. This way at most as many
+// players decode at once as there are cores, and waiting ones leave their queue threads free. Single steps
+// whose result is shown right away (seek, trick play keyframes) wait for a slot on their thread instead.
+// Pool also splits frame memory budget between players in proportion to their priority, so a grid of players
+// can't hold more decoded frames than one budget allows.
+//
+// May be used from any thread.
+@objcMembers
+public class RDMPEGDecodePool: NSObject {
+    public static let shared = RDMPEGDecodePool()
+
+    typealias SlotRequest = (RDMPEGDecodeSlot) -> Void
+
+    private enum Waiter {
+        // Thread blocked in performStep(of:_:)
+        case thread(DispatchSemaphore)
+        case request(SlotRequest)
+    }
+
+    private let lock = NSLock()
+    private let clients = NSHashTable<RDMPEGDecodePoolClient>.weakObjects()
+    private var frameMemoryBudgetValue = RDMPEGDecodePoolDefaultFrameMemoryBudget
+    private var scheduler = RDMPEGDecodeStepScheduler(
+        maximumConcurrentSteps: ProcessInfo.processInfo.activeProcessorCount,
+        agingInterval: RDMPEGDecodePoolAgingInterval
+    )
+    // Waiting steps by scheduler step identifier
+    private var waiters: [Int: Waiter] = [:]
+
+    // Defaults to the number of active cores
+    public var maximumConcurrentSteps: Int {
+        get {
+            lock.withLock { scheduler.maximumConcurrentSteps }
+        }
+        set {
+            let grantedRequests = lock.withLock {
+                scheduler.maximumConcurrentSteps = max(newValue, 1)
+                return startGrantedSteps()
+            }
+
+            callGrantedRequests(grantedRequests)
+        }
+    }
+
+    // Decoded video all players may keep ahead of playback, 0 disables the shared limit
+    public var frameMemoryBudget: Int {
+        get {
+            lock.withLock { frameMemoryBudgetValue }
+        }
+        set {
+            lock.withLock { frameMemoryBudgetValue = max(newValue, 0) }
+        }
+    }
+
+    override private init() {
+        super.init()
+    }
+
+    func makeClient(priority: RDMPEGDecodePriority) -> RDMPEGDecodePoolClient {
+        let client = RDMPEGDecodePoolClient(pool: self, priority: priority)
+
+        lock.withLock {
+            clients.add(client)
+        }
+
+        return client
+    }
+
+    // MARK: - Fileprivate
+
+    fileprivate func priority(of client: RDMPEGDecodePoolClient) -> RDMPEGDecodePriority {
+        lock.withLock { client.priorityValue }
+    }
+
+    fileprivate func setPriority(_ priority: RDMPEGDecodePriority, of client: RDMPEGDecodePoolClient) {
+        lock.withLock {
+            client.priorityValue = priority
+        }
+    }
+
+    fileprivate func byteBudget(of client: RDMPEGDecodePoolClient) -> Int {
+        lock.withLock {
+            guard frameMemoryBudgetValue > 0 else {
+                return 0
+            }
+
+            let totalWeight = clients.allObjects.reduce(0) { $0 + $1.priorityValue.budgetWeight }
+            return frameMemoryBudgetValue / max(totalWeight, 1) * client.priorityValue.budgetWeight
+        }
+    }
+
+    fileprivate func acquireSlot(
+        of client: RDMPEGDecodePoolClient,
+        orRequest request: @escaping SlotRequest
+    ) -> RDMPEGDecodeSlot? {
+        var acquiredSlot: RDMPEGDecodeSlot?
+
+        let grantedRequests = lock.withLock {
+            let stepIdentifier = scheduler.enqueueStep(
+                priority: client.priorityValue,
+                time: ProcessInfo.processInfo.systemUptime
+            )
+            waiters[stepIdentifier] = .request(request)
+
+            return startGrantedSteps().filter { grantedRequest in
+                guard grantedRequest.stepIdentifier == stepIdentifier else {
+                    return true
+                }
+
+                acquiredSlot = grantedRequest.slot
+                return false
+            }
+        }
+
+        callGrantedRequests(grantedRequests)
+
+        return acquiredSlot
+    }
+
+    fileprivate func performStep<T>(of client: RDMPEGDecodePoolClient, _ step: () throws -> T) rethrows -> T {
+        let semaphore = DispatchSemaphore(value: 0)
+
+        let grantedRequests = lock.withLock {
+            let stepIdentifier = scheduler.enqueueStep(
+                priority: client.priorityValue,
+                time: ProcessInfo.processInfo.systemUptime
+            )
+            waiters[stepIdentifier] = .thread(semaphore)
+            return startGrantedSteps()
+        }
+
+        callGrantedRequests(grantedRequests)
+
+        // Slot is handed over by whoever granted it, it's already counted as active
+        semaphore.wait()
+
+        let slot = RDMPEGDecodeSlot(pool: self)
+        defer { slot.release() }
+
+        return try step()
+    }
+
+    fileprivate func releaseSlot(_ slot: RDMPEGDecodeSlot) {
+        let grantedRequests: [GrantedRequest] = lock.withLock {
+            guard !slot.isReleased else {
+                return []
+            }
+
+            slot.isReleased = true
+
+            log4Assert(scheduler.activeStepsCount > 0, "Decode step finished without a slot")
+            scheduler.finishStep()
+            return startGrantedSteps()
+        }
+
+        callGrantedRequests(grantedRequests)
+    }
+
+    // MARK: - Private
+
+    private struct GrantedRequest {
+        let stepIdentifier: Int
+        let slot: RDMPEGDecodeSlot
+        let request: SlotRequest
+    }
+
+    // Called under lock. Blocked threads are woken right away, requests are returned to be called without lock
+    private func startGrantedSteps() -> [GrantedRequest] {
+        var grantedRequests: [GrantedRequest] = []
+
+        for stepIdentifier in scheduler.grantSlots(time: ProcessInfo.processInfo.systemUptime) {
+            switch waiters.removeValue(forKey: stepIdentifier) {
+            case .thread(let semaphore):
+                semaphore.signal()
+            case .request(let request):
+                grantedRequests.append(
+                    GrantedRequest(stepIdentifier: stepIdentifier, slot: RDMPEGDecodeSlot(pool: self), request: request)
+                )
+            case nil:
+                log4AssertionFailure("Granted decode step \(stepIdentifier) isn't waiting")
+            }
+        }
+
+        return grantedRequests
+    }
+
+    private func callGrantedRequests(_ grantedRequests: [GrantedRequest]) {
+        for grantedRequest in grantedRequests {
+            grantedRequest.request(grantedRequest.slot)
+        }
+    }
+}
+
+// Decode pool slot held by a running step. It's released explicitly once the step is done, or at the latest
+// when it's deallocated, so a step dropped on its way (cancelled operation, deallocated player) can't take
+// the slot with it.
+final class RDMPEGDecodeSlot {
+    private let pool: RDMPEGDecodePool
+    // Guarded by pool
+    fileprivate var isReleased = false
+
+    fileprivate init(pool: RDMPEGDecodePool) {
+        self.pool = pool
+    }
+
+    deinit {
+        pool.releaseSlot(self)
+    }
+
+    // May be called from any thread, more than once
+    func release() {
+        pool.releaseSlot(self)
+    }
+}
+
+// Order in which decode pool hands slots to waiting steps.
+//
+// Step of higher priority goes first, but waiting step gains one priority level per aging interval, so steps
+// of a lower priority player wait at most a couple of intervals even while higher priority players decode
+// without a pause. Among steps of equal (aged) priority the one waiting longer goes first.
+//
+// Plain value, pool guards it. Time is any monotonic clock in seconds.
+struct RDMPEGDecodeStepScheduler {
+    private struct Step {
+        let identifier: Int
+        let priority: RDMPEGDecodePriority
+        let enqueueTime: TimeInterval
+    }
+
+    let agingInterval: TimeInterval
+    var maximumConcurrentSteps: Int
+    private(set) var activeStepsCount = 0
+    private var waitingSteps: [Step] = []
+    private var nextStepIdentifier = 0
+
+    var waitingStepsCount: Int {
+        waitingSteps.count
+    }
+
+    init(maximumConcurrentSteps: Int, agingInterval: TimeInterval) {
+        self.maximumConcurrentSteps = max(maximumConcurrentSteps, 1)
+        self.agingInterval = agingInterval
+    }
+
+    // Returns identifier of the step, it waits until returned by grantSlots(time:)
+    mutating func enqueueStep(priority: RDMPEGDecodePriority, time: TimeInterval) -> Int {
+        let identifier = nextStepIdentifier
+        nextStepIdentifier += 1
+        waitingSteps.append(Step(identifier: identifier, priority: priority, enqueueTime: time))
+        return identifier
+    }
+
+    // Identifiers of steps which take free slots now, in order
+    mutating func grantSlots(time: TimeInterval) -> [Int] {
+        var grantedSteps: [Int] = []
+
+        while activeStepsCount < maximumConcurrentSteps, let index = nextStepIndex(time: time) {
+            grantedSteps.append(waitingSteps.remove(at: index).identifier)
+            activeStepsCount += 1
+        }
+
+        return grantedSteps
+    }
+
+    mutating func finishStep() {
+        activeStepsCount = max(activeStepsCount - 1, 0)
+    }
+
+    // MARK: - Private
+
+    private func nextStepIndex(time: TimeInterval) -> Int? {
+        var nextIndex: Int?
+        var nextPriority = -Double.infinity
+
+        // Steps are in enqueue order, so the first one of the highest priority waits longest
+        for (index, step) in waitingSteps.enumerated() {
+            let priority = agedPriority(of: step, time: time)
+            if priority > nextPriority {
+                nextIndex = index
+                nextPriority = priority
+            }
+        }
+
+        return nextIndex
+    }
+
+    private func agedPriority(of step: Step, time: TimeInterval) -> Double {
+        let waitingTime = max(time - step.enqueueTime, 0)
+        return Double(step.priority.rawValue) + (waitingTime / agingInterval).rounded(.down)
+    }
+}
+
+// Player's membership in decode pool
+class RDMPEGDecodePoolClient: NSObject {
+    private unowned let pool: RDMPEGDecodePool
+    // Guarded by pool
+    fileprivate var priorityValue: RDMPEGDecodePriority
+
+    var priority: RDMPEGDecodePriority {
+        get { pool.priority(of: self) }
+        set { pool.setPriority(newValue, of: self) }
+    }
+
+    // Player's share of pool frame memory budget, 0 means there is no shared limit
+    var byteBudget: Int {
+        pool.byteBudget(of: self)
+    }
+
+    fileprivate init(pool: RDMPEGDecodePool, priority: RDMPEGDecodePriority) {
+        self.pool = pool
+        self.priorityValue = priority
+        super.init()
+    }
+
+    // Returns a slot right away if pool has one free for the step. Otherwise returns nil, and pool calls request
+    // with the slot once one frees up, on the thread which freed it, so request should only queue the step
+    func acquireDecodeSlot(orRequest request: @escaping (RDMPEGDecodeSlot) -> Void) -> RDMPEGDecodeSlot? {
+        pool.acquireSlot(of: self, orRequest: request)
+    }
+
+    // Blocks calling thread until pool hands a slot over to the step, for steps whose caller needs the result
+    func performDecodeStep<T>(_ step: () throws -> T) rethrows -> T {
+        try pool.performStep(of: self, step)
+    }
+}
+
+extension RDMPEGDecodePool {
+    override public class func l4Logger() -> L4Logger {
+        return L4Logger(forName: "rd.mediaplayer.RDMPEGDecodePool")
+    }
+}
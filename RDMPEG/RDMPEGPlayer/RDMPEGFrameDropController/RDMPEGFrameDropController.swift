@@ -0,0 +1,147 @@
+//
+//  RDMPEGFrameDropController.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+import Log4Cocoa
+
+// Frame presented later than that (in real time) counts as late
+private let RDMPEGFrameDropLatenessThreshold: TimeInterval = 0.04
+// Consecutive late or dropped frames which make decoder skip more
+private let RDMPEGFrameDropEscalationFrames = 8
+// Time without late frames after which decoder skips less
+private let RDMPEGFrameDropRecoveryInterval: TimeInterval = 3.0
+
+// Decides what to do with video frames when decoding can't keep up with playback.
+//
+// Main thread reports presented and dropped frames along with their lateness. When frames keep coming late
+// decoder frame skip escalates one level at a time (non-reference -> bidirectional -> non-key), and it's
+// relaxed back the same way once playback stays on time for a while.
+// Controller also shares playback clock with decoding queue, so it can drop frames playback already passed
+// before converting them. Stopping the clock (pause, underrun) keeps frame skip and late frames streak: when
+// decoding can't keep up the buffer drains and underruns follow late frames, that's when skipping is needed
+// most. Frame skip starts over only when content or its pace changes (seek, rate change, next item).
+class RDMPEGFrameDropController {
+    private let lock = NSLock()
+
+    private var clock: RDMPEGCorrectionInfo?
+    private var clockRate: Double = 1
+    private var frameSkipValue: RDMPEGDecoderFrameSkip = .none
+    private var lateFramesStreak = 0
+    private var lastLateFrameHostTime: TimeInterval = 0
+    private var droppedFrames: UInt = 0
+    private var lateFrames: UInt = 0
+    private var presentedFrames: UInt = 0
+    private var skipEscalations: UInt = 0
+
+    var frameSkip: RDMPEGDecoderFrameSkip {
+        lock.withLock { frameSkipValue }
+    }
+
+    // Media position playback clock reached, nil while playback clock isn't running
+    var clockPosition: TimeInterval? {
+        lock.withLock { clock }?.position()
+    }
+
+    func startClock(_ clock: RDMPEGCorrectionInfo) {
+        lock.withLock {
+            self.clock = clock
+            clockRate = clock.playbackRate
+        }
+    }
+
+    func stopClock() {
+        lock.withLock {
+            clock = nil
+        }
+    }
+
+    // Lateness measured before seek, rate change or item change says nothing about what comes next
+    func resetFrameSkip() {
+        lock.withLock {
+            lateFramesStreak = 0
+
+            if frameSkipValue != .none {
+                frameSkipValue = .none
+                log4Debug("Playback starts over, resetting decoder frame skip")
+            }
+        }
+    }
+
+    // Lateness is measured in media time, positive when frame is behind playback clock
+    func recordPresentedFrame(lateness: TimeInterval, hostTime: TimeInterval = RDMPEGCorrectionInfo.hostTime) {
+        lock.withLock {
+            presentedFrames += 1
+
+            if lateness / clockRate > RDMPEGFrameDropLatenessThreshold {
+                lateFrames += 1
+                recordLateFrame(hostTime: hostTime)
+            }
+            else {
+                lateFramesStreak = 0
+                relaxFrameSkipIfNeeded(hostTime: hostTime)
+            }
+        }
+    }
+
+    func recordDroppedFrame(hostTime: TimeInterval = RDMPEGCorrectionInfo.hostTime) {
+        lock.withLock {
+            droppedFrames += 1
+            recordLateFrame(hostTime: hostTime)
+        }
+    }
+
+    func statistics() -> RDMPEGFrameDropStatistics {
+        lock.withLock {
+            RDMPEGFrameDropStatistics(
+                droppedFrames: droppedFrames,
+                lateFrames: lateFrames,
+                presentedFrames: presentedFrames,
+                skipEscalations: skipEscalations,
+                frameSkip: frameSkipValue
+            )
+        }
+    }
+
+    // MARK: - Private
+
+    private func recordLateFrame(hostTime: TimeInterval) {
+        lateFramesStreak += 1
+        lastLateFrameHostTime = hostTime
+
+        guard lateFramesStreak >= RDMPEGFrameDropEscalationFrames, frameSkipValue != .nonKey else {
+            return
+        }
+
+        frameSkipValue = RDMPEGDecoderFrameSkip(rawValue: frameSkipValue.rawValue + 1) ?? .nonKey
+        lateFramesStreak = 0
+        skipEscalations += 1
+
+        log4Debug("Playback falls behind, escalating decoder frame skip to \(frameSkipValue.rawValue)")
+    }
+
+    private func relaxFrameSkipIfNeeded(hostTime: TimeInterval) {
+        guard frameSkipValue != .none else {
+            return
+        }
+
+        guard hostTime - lastLateFrameHostTime > RDMPEGFrameDropRecoveryInterval else {
+            return
+        }
+
+        frameSkipValue = RDMPEGDecoderFrameSkip(rawValue: frameSkipValue.rawValue - 1) ?? .none
+        // Next level is relaxed only after another recovery interval
+        lastLateFrameHostTime = hostTime
+
+        log4Debug("Playback keeps up, relaxing decoder frame skip to \(frameSkipValue.rawValue)")
+    }
+}
+
+extension RDMPEGFrameDropController {
+    class var l4Logger: L4Logger {
+        return L4Logger(forName: "rd.mediaplayer.RDMPEGFrameDropController")
+    }
+}
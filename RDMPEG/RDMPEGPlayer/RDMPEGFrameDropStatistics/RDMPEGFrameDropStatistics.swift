@@ -0,0 +1,36 @@
+//
+//  RDMPEGFrameDropStatistics.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Immutable snapshot of video frames player dropped or presented late because decoding fell behind
+@objcMembers
+public class RDMPEGFrameDropStatistics: NSObject {
+    // Frames popped from buffer and never presented as playback already passed them
+    public let droppedFrames: UInt
+    // Frames presented behind playback clock
+    public let lateFrames: UInt
+    public let presentedFrames: UInt
+    // Number of times decoder frame skip was raised because lateness persisted
+    public let skipEscalations: UInt
+    public let frameSkip: RDMPEGDecoderFrameSkip
+
+    public init(
+        droppedFrames: UInt,
+        lateFrames: UInt,
+        presentedFrames: UInt,
+        skipEscalations: UInt,
+        frameSkip: RDMPEGDecoderFrameSkip
+    ) {
+        self.droppedFrames = droppedFrames
+        self.lateFrames = lateFrames
+        self.presentedFrames = presentedFrames
+        self.skipEscalations = skipEscalations
+        self.frameSkip = frameSkip
+        super.init()
+    }
+}
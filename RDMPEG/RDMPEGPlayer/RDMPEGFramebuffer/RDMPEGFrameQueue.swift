@@ -0,0 +1,133 @@
+//
+//  RDMPEGFrameQueue.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// FIFO ring deque with running duration and byte size totals.
+// Push, pop and totals are O(1), storage only grows (doubling) when queue outgrows its capacity,
+// so at steady queue depth there are no allocations at all.
+// Duration and byte size are captured on push, so totals stay consistent even if element changes while queued.
+// Not thread safe, callers synchronize access.
+struct RDMPEGFrameQueue<Element> {
+    private struct Entry {
+        let element: Element
+        let duration: TimeInterval
+        let byteSize: Int
+    }
+
+    private var entries: [Entry?]
+    private var head = 0
+    private var mask: Int
+
+    private(set) var count = 0
+    private(set) var duration: TimeInterval = 0
+    private(set) var byteSize = 0
+
+    var capacity: Int {
+        entries.count
+    }
+
+    var isEmpty: Bool {
+        count == 0
+    }
+
+    var first: Element? {
+        count > 0 ? entries[head]?.element : nil
+    }
+
+    var last: Element? {
+        count > 0 ? entries[(head + count - 1) & mask]?.element : nil
+    }
+
+    init(capacity: Int) {
+        var powerOfTwoCapacity = 1
+        while powerOfTwoCapacity < capacity {
+            powerOfTwoCapacity <<= 1
+        }
+
+        self.entries = Array(repeating: nil, count: powerOfTwoCapacity)
+        self.mask = powerOfTwoCapacity - 1
+    }
+
+    mutating func append(_ element: Element, duration: TimeInterval, byteSize: Int) {
+        if count == entries.count {
+            grow()
+        }
+
+        entries[(head + count) & mask] = Entry(element: element, duration: duration, byteSize: byteSize)
+        count += 1
+        self.duration += duration
+        self.byteSize += byteSize
+    }
+
+    mutating func popFirst() -> Element? {
+        guard count > 0, let entry = entries[head] else { return nil }
+
+        entries[head] = nil
+        head = (head + 1) & mask
+        count -= 1
+
+        if count == 0 {
+            // Drop accumulated floating point error whenever queue drains
+            duration = 0
+            byteSize = 0
+        }
+        else {
+            duration -= entry.duration
+            byteSize -= entry.byteSize
+        }
+
+        return entry.element
+    }
+
+    mutating func removeAll() {
+        for index in 0..<count {
+            entries[(head + index) & mask] = nil
+        }
+
+        head = 0
+        count = 0
+        duration = 0
+        byteSize = 0
+    }
+
+    private mutating func grow() {
+        var grownEntries = [Entry?](repeating: nil, count: entries.count * 2)
+        for index in 0..<count {
+            grownEntries[index] = entries[(head + index) & mask]
+        }
+
+        entries = grownEntries
+        head = 0
+        mask = grownEntries.count - 1
+    }
+}
+
+extension RDMPEGFrameQueue: Sequence {
+    struct Iterator: IteratorProtocol {
+        private let queue: RDMPEGFrameQueue
+        private var index = 0
+
+        fileprivate init(queue: RDMPEGFrameQueue) {
+            self.queue = queue
+        }
+
+        mutating func next() -> Element? {
+            guard index < queue.count else { return nil }
+            defer { index += 1 }
+            return queue.entries[(queue.head + index) & queue.mask]?.element
+        }
+    }
+
+    func makeIterator() -> Iterator {
+        Iterator(queue: self)
+    }
+
+    var underestimatedCount: Int {
+        count
+    }
+}
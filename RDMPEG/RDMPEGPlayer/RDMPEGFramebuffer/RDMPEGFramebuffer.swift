@@ -9,47 +9,51 @@
 import Foundation
 import Log4Cocoa
 
+// Video and subtitle frames go through lock-free SPSC queues: decoding queue is the only producer
+// (it pushes and purges), main thread is the only consumer (it peeks and pops). Buffered totals may be
+// read from any thread. Audio frames are consumed by audio render callback, which also peeks and
+// skips frames in place, so audio queue stays behind a lock.
 class RDMPEGFramebuffer {
     private(set) var artworkFrame: RDMPEGArtworkFrame?
 
-    private var videoFrames: [RDMPEGVideoFrame] = []
-    private var audioFrames: [RDMPEGAudioFrame] = []
-    private var subtitleFrames: [RDMPEGSubtitleFrame] = []
-    private var videoFramesLock = NSRecursiveLock()
+    // Bounds are far above what buffering controller lets decoder run ahead
+    private let videoFrames = RDMPEGSPSCQueue<RDMPEGVideoFrame>(capacity: 1024)
+    private let subtitleFrames = RDMPEGSPSCQueue<RDMPEGSubtitleFrame>(capacity: 256)
+    private var audioFrames = RDMPEGFrameQueue<RDMPEGAudioFrame>(capacity: 256)
     private var audioFramesLock = NSRecursiveLock()
-    private var subtitleFramesLock = NSRecursiveLock()
+    // Producer side only
+    private var subtitleEndPosition: TimeInterval?
+
+    // Called on decoding queue after frames are pushed, set it before decoding starts
+    var framesPushedHandler: (() -> Void)?
 
     var bufferedVideoDuration: TimeInterval {
-        videoFramesLock.withLock {
-            return videoFrames.reduce(0) { $0 + $1.duration }
-        }
+        videoFrames.duration
     }
 
     var bufferedAudioDuration: TimeInterval {
         audioFramesLock.withLock {
-            return audioFrames.reduce(0) { $0 + $1.duration }
+            return audioFrames.duration
         }
     }
 
-    var bufferedSubtitleDuration: TimeInterval {
-        subtitleFramesLock.withLock {
-            guard let first = subtitleFrames.first else { return 0 }
-            var minPosition = first.position
-            var maxPosition = first.position + first.duration
-
-            for frame in subtitleFrames {
-                minPosition = min(minPosition, frame.position)
-                maxPosition = max(maxPosition, frame.position + frame.duration)
-            }
+    var bufferedVideoByteSize: Int {
+        videoFrames.byteSize
+    }
 
-            return maxPosition - minPosition
+    var bufferedAudioByteSize: Int {
+        audioFramesLock.withLock {
+            return audioFrames.byteSize
         }
     }
 
+    // Latest end time among subtitle frames pushed since last purge, producer side only
+    var bufferedSubtitleEndPosition: TimeInterval? {
+        subtitleEndPosition
+    }
+
     var bufferedVideoFramesCount: Int {
-        videoFramesLock.withLock {
-            return videoFrames.count
-        }
+        videoFrames.count
     }
 
     var bufferedAudioFramesCount: Int {
@@ -59,15 +63,12 @@ class RDMPEGFramebuffer {
     }
 
     var bufferedSubtitleFramesCount: Int {
-        subtitleFramesLock.withLock {
-            return subtitleFrames.count
-        }
+        subtitleFrames.count
     }
 
+    // Consumer side only
     var nextVideoFrame: RDMPEGVideoFrame? {
-        videoFramesLock.withLock {
-            return videoFrames.first
-        }
+        videoFrames.firstObject
     }
 
     var nextAudioFrame: RDMPEGAudioFrame? {
@@ -76,10 +77,9 @@ class RDMPEGFramebuffer {
         }
     }
 
+    // Consumer side only
     var nextSubtitleFrame: RDMPEGSubtitleFrame? {
-        subtitleFramesLock.withLock {
-            return subtitleFrames.first
-        }
+        subtitleFrames.firstObject
     }
 
     class var l4Logger: L4Logger {
@@ -94,9 +94,12 @@ class RDMPEGFramebuffer {
                     #if RD_DEBUG_MPEG_PLAYER
                     log4Debug("Pushed video frame: \(frame.position) \(frame.duration)")
                     #endif
-                    videoFramesLock.withLock {
-                        videoFrames.append(videoFrame)
-                    }
+                    let isPushed = videoFrames.push(
+                        videoFrame,
+                        duration: videoFrame.duration,
+                        byteSize: videoFrame.byteSize
+                    )
+                    log4Assert(isPushed, "Video queue overflow, frame \(videoFrame.position) dropped")
                 }
             case .audio:
                 if let audioFrame = frame as? RDMPEGAudioFrame {
@@ -104,7 +107,7 @@ class RDMPEGFramebuffer {
                     log4Debug("Pushed audio frame: \(frame.position) \(frame.duration)")
                     #endif
                     audioFramesLock.withLock {
-                        audioFrames.append(audioFrame)
+                        audioFrames.append(audioFrame, duration: audioFrame.duration, byteSize: audioFrame.byteSize)
                     }
                 }
             case .subtitle:
@@ -115,8 +118,16 @@ class RDMPEGFramebuffer {
                         \(subtitleFrame.position) \(subtitleFrame.duration) \(subtitleFrame.text ?? "")
                     """)
                     #endif
-                    subtitleFramesLock.withLock {
-                        subtitleFrames.append(subtitleFrame)
+                    let isPushed = subtitleFrames.push(
+                        subtitleFrame,
+                        duration: subtitleFrame.duration,
+                        byteSize: subtitleFrame.byteSize
+                    )
+                    log4Assert(isPushed, "Subtitle queue overflow, frame \(subtitleFrame.position) dropped")
+
+                    if isPushed {
+                        let endPosition = subtitleFrame.position + subtitleFrame.duration
+                        subtitleEndPosition = max(subtitleEndPosition ?? endPosition, endPosition)
                     }
                 }
             case .artwork:
@@ -128,34 +139,25 @@ class RDMPEGFramebuffer {
                 break
             }
         }
+
+        if !frames.isEmpty {
+            framesPushedHandler?()
+        }
     }
 
     func popVideoFrame() -> RDMPEGVideoFrame? {
-        videoFramesLock.withLock {
-            guard !videoFrames.isEmpty else { return nil }
-            return videoFrames.removeFirst()
-        }
+        videoFrames.pop()
     }
 
     func popAudioFrame() -> RDMPEGAudioFrame? {
         audioFramesLock.withLock {
-            guard !audioFrames.isEmpty else { return nil }
-            return audioFrames.removeFirst()
+            return audioFrames.popFirst()
         }
     }
 
     @discardableResult
     public func popSubtitleFrame() -> RDMPEGSubtitleFrame? {
-        subtitleFramesLock.withLock {
-            guard !subtitleFrames.isEmpty else { return nil }
-            return subtitleFrames.removeFirst()
-        }
-    }
-
-    func atomicVideoFramesAccess(_ accessBlock: () -> Void) {
-        videoFramesLock.withLock {
-            accessBlock()
-        }
+        subtitleFrames.pop()
     }
 
     func atomicAudioFramesAccess(_ accessBlock: () -> Void) {
@@ -164,12 +166,6 @@ class RDMPEGFramebuffer {
         }
     }
 
-    func atomicSubtitleFramesAccess(_ accessBlock: () -> Void) {
-        subtitleFramesLock.withLock {
-            accessBlock()
-        }
-    }
-
     func purge() {
         purgeVideoFrames()
         purgeAudioFrames()
@@ -178,9 +174,7 @@ class RDMPEGFramebuffer {
     }
 
     func purgeVideoFrames() {
-        videoFramesLock.withLock {
-            videoFrames.removeAll()
-        }
+        videoFrames.purge()
     }
 
     func purgeAudioFrames() {
@@ -190,9 +184,8 @@ class RDMPEGFramebuffer {
     }
 
     func purgeSubtitleFrames() {
-        subtitleFramesLock.withLock {
-            subtitleFrames.removeAll()
-        }
+        subtitleFrames.purge()
+        subtitleEndPosition = nil
     }
 
     func purgeArtworkFrame() {
@@ -0,0 +1,47 @@
+//
+//  RDMPEGSPSCQueue.h
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Bounded lock-free single producer / single consumer FIFO with running duration and byte size totals.
+// Producer methods may only be called from one thread (or serial queue), consumer methods from another one.
+// Purge is lock-free too: producer bumps generation and totals drop to zero immediately, while objects of
+// previous generations are released by consumer the next time it touches the queue. Until then purged
+// objects still occupy their slots, so push may fail right after purge if consumer hasn't drained them yet.
+// Totals may be read from any thread, they're exact on producer and consumer threads and
+// at most one push or pop stale elsewhere.
+@interface RDMPEGSPSCQueue<ObjectType> : NSObject
+
+@property (nonatomic, readonly) NSUInteger capacity;
+@property (nonatomic, readonly) NSUInteger count;
+@property (nonatomic, readonly) NSTimeInterval duration;
+@property (nonatomic, readonly) NSUInteger byteSize;
+
+- (instancetype)init NS_UNAVAILABLE;
+// Capacity is rounded up to power of two
+- (instancetype)initWithCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+#pragma mark Producer
+
+// Returns NO when queue is full
+- (BOOL)pushObject:(ObjectType)object
+          duration:(NSTimeInterval)duration
+          byteSize:(NSUInteger)byteSize NS_SWIFT_NAME(push(_:duration:byteSize:));
+- (void)purge;
+
+#pragma mark Consumer
+
+// Both release purged objects first, object purged while pop removes it is released instead of returned
+@property (nonatomic, readonly, nullable) ObjectType firstObject;
+
+- (nullable ObjectType)popObject NS_SWIFT_NAME(pop());
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,215 @@
+//
+//  RDMPEGSPSCQueue.m
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#import "RDMPEGSPSCQueue.h"
+#import <stdatomic.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Totals are kept as prefix sums, so neither side ever rewrites what the other one published:
+// producer accumulates pushed totals and stamps every slot with totals including it,
+// consumer publishes stamp of the last slot it removed, purge publishes pushed totals at purge time.
+// Buffered amount is pushed total minus the larger of consumed and purged totals.
+typedef struct RDMPEGSPSCTotals {
+    _Atomic uint64_t count;
+    _Atomic int64_t duration; // nanoseconds
+    _Atomic uint64_t byteSize;
+} RDMPEGSPSCTotals;
+
+typedef struct RDMPEGSPSCSlot {
+    void * _Nullable object; // retained
+    uint64_t generation;
+    uint64_t count;
+    int64_t duration;
+    uint64_t byteSize;
+} RDMPEGSPSCSlot;
+
+static int64_t spsc_duration_from_interval(NSTimeInterval interval);
+
+
+
+@interface RDMPEGSPSCQueue () {
+    RDMPEGSPSCSlot *_slots;
+    uint64_t _mask;
+    
+    // Producer side
+    _Atomic uint64_t _head;
+    _Atomic uint64_t _generation;
+    RDMPEGSPSCTotals _pushed;
+    RDMPEGSPSCTotals _purged;
+    
+    // Consumer side
+    _Atomic uint64_t _tail;
+    RDMPEGSPSCTotals _consumed;
+}
+
+@end
+
+
+
+@implementation RDMPEGSPSCQueue
+
+#pragma mark - Lifecycle
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    self = [super init];
+    if (self) {
+        NSUInteger powerOfTwoCapacity = 1;
+        while (powerOfTwoCapacity < capacity) {
+            powerOfTwoCapacity <<= 1;
+        }
+        
+        _capacity = powerOfTwoCapacity;
+        _mask = powerOfTwoCapacity - 1;
+        _slots = calloc(powerOfTwoCapacity, sizeof(RDMPEGSPSCSlot));
+    }
+    return self;
+}
+
+- (void)dealloc {
+    // Both sides are gone by now, so whatever is left belongs to us
+    uint64_t tail = atomic_load_explicit(&_tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&_head, memory_order_relaxed);
+    
+    for (uint64_t index = tail; index < head; index++) {
+        RDMPEGSPSCSlot *slot = &_slots[index & _mask];
+        if (slot->object) {
+            CFRelease(slot->object);
+        }
+    }
+    
+    free(_slots);
+}
+
+#pragma mark - Public Accessors
+
+- (NSUInteger)count {
+    uint64_t pushed = atomic_load_explicit(&_pushed.count, memory_order_acquire);
+    uint64_t removed = MAX(atomic_load_explicit(&_consumed.count, memory_order_acquire),
+                           atomic_load_explicit(&_purged.count, memory_order_acquire));
+    return pushed > removed ? (NSUInteger)(pushed - removed) : 0;
+}
+
+- (NSTimeInterval)duration {
+    int64_t pushed = atomic_load_explicit(&_pushed.duration, memory_order_acquire);
+    int64_t removed = MAX(atomic_load_explicit(&_consumed.duration, memory_order_acquire),
+                          atomic_load_explicit(&_purged.duration, memory_order_acquire));
+    return pushed > removed ? (NSTimeInterval)(pushed - removed) / NSEC_PER_SEC : 0.0;
+}
+
+- (NSUInteger)byteSize {
+    uint64_t pushed = atomic_load_explicit(&_pushed.byteSize, memory_order_acquire);
+    uint64_t removed = MAX(atomic_load_explicit(&_consumed.byteSize, memory_order_acquire),
+                           atomic_load_explicit(&_purged.byteSize, memory_order_acquire));
+    return pushed > removed ? (NSUInteger)(pushed - removed) : 0;
+}
+
+#pragma mark Producer
+
+- (BOOL)pushObject:(id)object duration:(NSTimeInterval)duration byteSize:(NSUInteger)byteSize {
+    uint64_t head = atomic_load_explicit(&_head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&_tail, memory_order_acquire);
+    
+    if (head - tail == _capacity) {
+        return NO;
+    }
+    
+    uint64_t count = atomic_load_explicit(&_pushed.count, memory_order_relaxed) + 1;
+    int64_t totalDuration = atomic_load_explicit(&_pushed.duration, memory_order_relaxed) + spsc_duration_from_interval(duration);
+    uint64_t totalByteSize = atomic_load_explicit(&_pushed.byteSize, memory_order_relaxed) + byteSize;
+    
+    RDMPEGSPSCSlot *slot = &_slots[head & _mask];
+    slot->object = (void *)CFBridgingRetain(object);
+    slot->generation = atomic_load_explicit(&_generation, memory_order_relaxed);
+    slot->count = count;
+    slot->duration = totalDuration;
+    slot->byteSize = totalByteSize;
+    
+    atomic_store_explicit(&_pushed.count, count, memory_order_release);
+    atomic_store_explicit(&_pushed.duration, totalDuration, memory_order_release);
+    atomic_store_explicit(&_pushed.byteSize, totalByteSize, memory_order_release);
+    atomic_store_explicit(&_head, head + 1, memory_order_release);
+    
+    return YES;
+}
+
+- (void)purge {
+    atomic_fetch_add_explicit(&_generation, 1, memory_order_release);
+    
+    atomic_store_explicit(&_purged.count, atomic_load_explicit(&_pushed.count, memory_order_relaxed), memory_order_release);
+    atomic_store_explicit(&_purged.duration, atomic_load_explicit(&_pushed.duration, memory_order_relaxed), memory_order_release);
+    atomic_store_explicit(&_purged.byteSize, atomic_load_explicit(&_pushed.byteSize, memory_order_relaxed), memory_order_release);
+}
+
+#pragma mark Consumer
+
+- (nullable id)firstObject {
+    RDMPEGSPSCSlot *slot = [self firstCurrentSlot];
+    return slot ? (__bridge id)slot->object : nil;
+}
+
+- (nullable id)popObject {
+    while (YES) {
+        RDMPEGSPSCSlot *slot = [self firstCurrentSlot];
+        if (slot == NULL) {
+            return nil;
+        }
+        
+        void *object = slot->object;
+        uint64_t generation = slot->generation;
+        [self removeFirstSlot:slot];
+        
+        // Producer may have purged the queue after the slot was checked, purged object is never handed out
+        if (generation == atomic_load_explicit(&_generation, memory_order_acquire)) {
+            return CFBridgingRelease(object);
+        }
+        
+        CFRelease(object);
+    }
+}
+
+#pragma mark - Private Methods
+
+// Releases objects purged by producer and returns first slot of current generation
+- (nullable RDMPEGSPSCSlot *)firstCurrentSlot {
+    while (YES) {
+        uint64_t tail = atomic_load_explicit(&_tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&_head, memory_order_acquire);
+        
+        if (tail == head) {
+            return NULL;
+        }
+        
+        RDMPEGSPSCSlot *slot = &_slots[tail & _mask];
+        if (slot->generation == atomic_load_explicit(&_generation, memory_order_acquire)) {
+            return slot;
+        }
+        
+        void *object = slot->object;
+        [self removeFirstSlot:slot];
+        CFRelease(object);
+    }
+}
+
+- (void)removeFirstSlot:(RDMPEGSPSCSlot *)slot {
+    slot->object = NULL;
+    
+    atomic_store_explicit(&_consumed.count, slot->count, memory_order_release);
+    atomic_store_explicit(&_consumed.duration, slot->duration, memory_order_release);
+    atomic_store_explicit(&_consumed.byteSize, slot->byteSize, memory_order_release);
+    atomic_fetch_add_explicit(&_tail, 1, memory_order_release);
+}
+
+@end
+
+
+
+static int64_t spsc_duration_from_interval(NSTimeInterval interval) {
+    return interval > 0.0 ? (int64_t)llround(interval * NSEC_PER_SEC) : 0;
+}
+
+NS_ASSUME_NONNULL_END
@@ -7,12 +7,31 @@
 //
 
 import Foundation
+import Accelerate
 import Log4Cocoa
 import ReaddleLib
 
-private let RDMPEGPlayerMinVideoBufferSize: TimeInterval = 0.2
-private let RDMPEGPlayerMaxVideoBufferSize: TimeInterval = 1.0
-private let RDMPEGPlayerMinAudioBufferSize: TimeInterval = 0.2
+// About 40 decoded 1080p YUV frames or 4 frames of 4K BGRA
+private let RDMPEGPlayerDefaultBufferByteBudget = 128 * 1024 * 1024
+
+// Audio off the clock farther than that is skipped or delayed. Clock snaps to audio at the same distance,
+// so audio closer than that is only slewed by the clock
+private let RDMPEGPlayerAudioDiscontinuityThreshold = RDMPEGCorrectionInfoDiscontinuityThreshold
+
+// Video of the current item outlasting its audio by less than that doesn't delay the next item,
+// so audio continues sample-contiguously
+private let RDMPEGPlayerItemVideoOverrunTolerance: TimeInterval = 0.1
+
+// Scheduler polls audio buffer that many times per its minimum duration in audio-only playback
+private let RDMPEGPlayerAudioOnlyPollsPerBuffer = 4.0
+
+private let RDMPEGPlayerMinimumRate = 0.25
+private let RDMPEGPlayerMaximumRate = 4.0
+
+private let RDMPEGPlayerTrickPlayMinimumRate = 2.0
+private let RDMPEGPlayerTrickPlayMaximumRate = 64.0
+// Keyframes are shown briefly, so they are decoded at no more than the view resolution and at least halved
+private let RDMPEGPlayerTrickPlayMinimumScaleFactor = 2
 
 private let RDMPEGPlayerInputDecoderKey = "RDMPEGPlayerInputDecoderKey"
 private let RDMPEGPlayerInputNameKey = "RDMPEGPlayerInputNameKey"
@@ -35,6 +54,8 @@ public protocol RDMPEGPlayerDelegate: AnyObject {
     func mpegPlayer(_ player: RDMPEGPlayer, didUpdateCurrentTime currentTime: TimeInterval)
     func mpegPlayerDidAttachInput(_ player: RDMPEGPlayer)
     func mpegPlayerDidFinishPlaying(_ player: RDMPEGPlayer)
+    @objc optional func mpegPlayer(_ player: RDMPEGPlayer, didAdvanceToInputAtPath filePath: String)
+    @objc optional func mpegPlayer(_ player: RDMPEGPlayer, didMeasureStartup metrics: RDMPEGStartupMetrics)
 }
 
 @objc
@@ -46,10 +67,13 @@ public class RDMPEGPlayer: NSObject {
     @objc public private(set) var subtitleStreams: [RDMPEGSelectableInputStream]?
     @objc public private(set) var activeAudioStreamIndex: NSNumber?
     @objc public private(set) var activeSubtitleStreamIndex: NSNumber?
-    @objc public var currentTime: TimeInterval { currentInternalTime }
+    @objc public var currentTime: TimeInterval { currentInternalTime - itemStartTime }
     @objc public private(set) var duration: TimeInterval
     @objc public private(set) var isBuffering: Bool
     @objc public private(set) var isSeeking: Bool
+    @objc public private(set) var isTrickPlaying: Bool
+    // Signed multiplier of keyframe-only playback, negative rewinds
+    @objc public private(set) var trickPlayRate: Double
     @objc public var timeObservingInterval: TimeInterval {
         didSet {
             if timeObservingInterval != oldValue {
@@ -70,34 +94,199 @@ public class RDMPEGPlayer: NSObject {
             }
         }
     }
+    // Playback speed multiplier, audio pitch is preserved.
+    // Audio buffered before the change was stretched at the previous rate and isn't decoded again. With video
+    // presented audio callback keeps it in sync with the clock running at the new rate, so speeding up skips part
+    // of it and slowing down inserts silence. Without video the clock follows audio, so it plays out at the previous
+    // speed. Either way the transition lasts at most the buffered audio duration
+    @objc public var rate: Double {
+        didSet {
+            log4Assert(Thread.isMainThread, "Property '\(#function)' changed from wrong thread")
+
+            // Assignment from observer doesn't trigger it again
+            rate = min(max(rate, RDMPEGPlayerMinimumRate), RDMPEGPlayerMaximumRate)
+
+            if rate != oldValue {
+                // Clock restarts at the new rate from the frame being presented
+                correctionInfo = nil
+                frameDropController.stopClock()
+                frameDropController.resetFrameSkip()
+
+                decodingQueue.addOperation { [weak self] in
+                    guard let self = self else { return }
+                    self.decoder?.playbackRate = self.rate
+                    self.externalAudioDecoder?.playbackRate = self.rate
+                }
+
+                // Sleeping scheduler would keep the interval computed at the previous rate
+                scheduler.wake()
+            }
+        }
+    }
+    // Video isn't decoded while enabled (e.g. app is in background or player view is hidden), audio keeps playing
+    // and drives the clock. Once disabled, video resumes from the keyframe preceding the current time
+    @objc public var isAudioOnlyMode: Bool {
+        didSet {
+            log4Assert(Thread.isMainThread, "Property '\(#function)' changed from wrong thread")
+
+            if isAudioOnlyMode != oldValue {
+                if isAudioOnlyMode {
+                    suspendVideoIfNeeded()
+                }
+                else {
+                    resumeVideoIfNeeded()
+                }
+            }
+        }
+    }
+    // Gain in dB applied to audio output, e.g. RDMPEGLoudness.normalizationGain of the input.
+    // It's applied in the audio callback, so it takes effect at once and buffered audio isn't decoded again
+    @objc public var audioGain: Double {
+        didSet {
+            audioGainFactor = Float(pow(10, audioGain / 20))
+        }
+    }
+    // How multichannel audio is mixed down when output has fewer channels, e.g. 5.1 on stereo headphones
+    @objc public var audioDownmix: RDMPEGDecoderDownmix {
+        didSet {
+            if audioDownmix != oldValue {
+                decodingQueue.addOperation { [weak self] in
+                    guard let self = self else { return }
+                    self.decoder?.downmix = self.audioDownmix
+                    self.externalAudioDecoder?.downmix = self.audioDownmix
+                }
+            }
+        }
+    }
+    // Fast suits low-end devices, high is for hi-fi output. Applies to audio streams activated afterwards too
+    @objc public var audioResamplerQuality: RDMPEGDecoderResamplerQuality {
+        didSet {
+            if audioResamplerQuality != oldValue {
+                decodingQueue.addOperation { [weak self] in
+                    guard let self = self else { return }
+                    self.decoder?.resamplerQuality = self.audioResamplerQuality
+                    self.externalAudioDecoder?.resamplerQuality = self.audioResamplerQuality
+                }
+            }
+        }
+    }
+    // Rendered audio is measured for audioSpectrum() while enabled, measuring runs on the audio thread
+    @objc public var isAudioSpectrumEnabled: Bool {
+        didSet {
+            audioRenderer.isAudioTapEnabled = isAudioSpectrumEnabled
+        }
+    }
+    @objc public var isDecodeStatisticsEnabled: Bool {
+        didSet {
+            if isDecodeStatisticsEnabled != oldValue {
+                decodingQueue.addOperation { [weak self] in
+                    guard let self = self else { return }
+                    self.decoder?.isDecodeStatisticsEnabled = self.isDecodeStatisticsEnabled
+                }
+            }
+        }
+    }
+    // Statistics of the item being presented
+    @objc public var ioStatistics: RDMPEGIOStatistics? { presentedDecoder?.ioStatistics }
+    @objc public var decodeStatistics: RDMPEGDecodeStatistics? { presentedDecoder?.decodeStatistics }
+    // Memory limit of decoded video kept ahead of playback, 0 disables the limit
+    @objc public var bufferByteBudget: Int {
+        get { bufferingController.byteBudget }
+        set { bufferingController.byteBudget = newValue }
+    }
+    @objc public var bufferingStatistics: RDMPEGBufferingStatistics {
+        bufferingController.statistics(
+            bufferedVideoDuration: framebuffer.bufferedVideoDuration,
+            bufferedAudioDuration: framebuffer.bufferedAudioDuration,
+            bufferedVideoBytes: framebuffer.bufferedVideoByteSize,
+            bufferedAudioBytes: framebuffer.bufferedAudioByteSize
+        )
+    }
+    @objc public var frameDropStatistics: RDMPEGFrameDropStatistics {
+        frameDropController.statistics()
+    }
+    // Decides how player competes with other players for shared decoding slots and frame memory
+    @objc public var decodePriority: RDMPEGDecodePriority {
+        get {
+            decodePoolClient.priority
+        }
+        set {
+            decodePoolClient.priority = newValue
+            decodingQueue.qualityOfService = RDMPEGPlayer.qualityOfService(for: newValue)
+        }
+    }
+    // Inputs which play after the current one without a gap
+    @objc public var queuedInputPaths: [String] { playerQueue.filePaths }
     @objc public weak var delegate: RDMPEGPlayerDelegate?
 
     private var filePath: String
     private var decodingQueue: OperationQueue
     private var externalInputsQueue: OperationQueue
     private var framebuffer: RDMPEGFramebuffer
+    private var bufferingController: RDMPEGBufferingController
+    private var frameDropController: RDMPEGFrameDropController
+    private var playerQueue: RDMPEGPlayerQueue
+    private let decodePoolClient: RDMPEGDecodePoolClient
     private var audioRenderer: RDMPEGAudioRenderer
+    // Audio callback measures device clock, decoding queue compensates it
+    private let audioClockSkew = RDMPEGAudioClockSkew()
+    // Player state audio callback shares with other threads, lock-free (see RDMPEGAudioCallbackFlags.h)
+    private let audioCallbackFlags: OpaquePointer
     private var stream: RDMPEGIOStream?
+    // Decoder of the item being decoded, decoding queue moves it to the next item ahead of presentation
     private var decoder: RDMPEGDecoder?
+    // Decoder of the item being presented, main thread only
+    private var presentedDecoder: RDMPEGDecoder?
     private var externalAudioDecoder: RDMPEGDecoder?
     private var externalSubtitleDecoder: RDMPEGDecoder?
     private var selectableInputs: [Dictionary<String, Any>]?
-    private var scheduler: RDMPEGRenderScheduler?
+    private let scheduler: RDMPEGRenderScheduler
     private var timeObservingTimer: Timer?
     private var currentSubtitleFrames: [RDMPEGSubtitleFrame]
     private var playingBeforeSeek: Bool = false
+    private var playingBeforeTrickPlay: Bool = false
+    private var trickPlay: RDMPEGTrickPlay<RDMPEGVideoFrame>?
     private var rawAudioFrame: RDMPEGRawAudioFrame?
+    // Linear audio gain, audio callback reads it
+    private var audioGainFactor: Float = 1
     private var correctionInfo: RDMPEGCorrectionInfo?
     private weak var decodingOperation: Operation?
     private weak var seekOperation: Operation?
     private var internalState: RDMPEGPlayerState = .stopped
     private var currentInternalTime: TimeInterval = 0
+    // Items play on one continuous timeline, so clock and buffered frames don't restart at item boundaries.
+    // Start of the presented item (main thread) and of the decoded one (decoding queue) on that timeline
+    private var itemStartTime: TimeInterval = 0
+    private var decodingItemStartTime: TimeInterval = 0
+    private var decodedAudioEndPosition: TimeInterval?
+    private var decodedVideoEndPosition: TimeInterval?
+    // Audio decoded again after video resync, it's buffered already (decoding queue)
+    private var audioDropPosition: TimeInterval?
     private var preparedToPlay: Bool = false
     private var decodingFinished: Bool = false
+    // Startup measurement, main thread only except the flag audio callback takes (audio callback flags)
+    private var startupRequestTime: TimeInterval?
+    private var startupFrameTime: TimeInterval?
+    private var startupAudioTime: TimeInterval?
+    private var prerollTime: TimeInterval?
     private var videoStreamExist: Bool = false
     private var audioStreamExist: Bool = false
     private var subtitleStreamExist: Bool = false
 
+    // Audio-only mode, video isn't decoded and presented until resync finishes (audio callback flags)
+    private var isVideoSuspended: Bool {
+        get {
+            rdmpeg_audio_callback_flags_get(audioCallbackFlags, RDMPEGAudioCallbackFlagVideoSuspended)
+        }
+        set {
+            rdmpeg_audio_callback_flags_set(audioCallbackFlags, RDMPEGAudioCallbackFlagVideoSuspended, newValue)
+        }
+    }
+
+    private var isVideoPresented: Bool {
+        videoStreamExist && !isVideoSuspended
+    }
+
     @objc
     public init(filePath: String) {
         self.filePath = filePath
@@ -105,6 +294,13 @@ public class RDMPEGPlayer: NSObject {
         self.decodingQueue = OperationQueue()
         self.externalInputsQueue = OperationQueue()
         self.framebuffer = RDMPEGFramebuffer()
+        self.bufferingController = RDMPEGBufferingController(byteBudget: RDMPEGPlayerDefaultBufferByteBudget)
+        self.frameDropController = RDMPEGFrameDropController()
+        self.playerQueue = RDMPEGPlayerQueue()
+        self.decodePoolClient = RDMPEGDecodePool.shared.makeClient(priority: .visible)
+        // Fails only when out of memory
+        self.audioCallbackFlags = rdmpeg_audio_callback_flags_create()!
+        self.scheduler = RDMPEGRenderScheduler()
         self.playerView = RDMPEGPlayerView()
         self.audioRenderer = RDMPEGAudioRenderer()
         self.selectableInputs = []
@@ -112,15 +308,30 @@ public class RDMPEGPlayer: NSObject {
         self.currentSubtitleFrames = []
         self.isBuffering = false
         self.isSeeking = false
+        self.isTrickPlaying = false
+        self.trickPlayRate = 0
         self.duration = 0
         self.isDeinterlacingEnabled = false
+        self.isAudioOnlyMode = false
+        self.audioGain = 0
+        self.audioDownmix = .ITU
+        self.audioResamplerQuality = .balanced
+        self.isAudioSpectrumEnabled = false
+        self.isDecodeStatisticsEnabled = false
+        self.rate = 1.0
 
         super.init()
 
         self.decodingQueue.name = "RDMPEGPlayer Decoding Queue"
         self.decodingQueue.maxConcurrentOperationCount = 1
+        self.decodingQueue.qualityOfService = RDMPEGPlayer.qualityOfService(for: .visible)
         self.externalInputsQueue.name = "RDMPEGPlayer External Inputs Queue"
         self.externalInputsQueue.maxConcurrentOperationCount = 1
+
+        // Scheduler sleeps while there is nothing to render
+        self.framebuffer.framesPushedHandler = { [weak self] in
+            self?.scheduler.wake()
+        }
     }
 
     @objc
@@ -130,6 +341,13 @@ public class RDMPEGPlayer: NSObject {
         self.decodingQueue = OperationQueue()
         self.externalInputsQueue = OperationQueue()
         self.framebuffer = RDMPEGFramebuffer()
+        self.bufferingController = RDMPEGBufferingController(byteBudget: RDMPEGPlayerDefaultBufferByteBudget)
+        self.frameDropController = RDMPEGFrameDropController()
+        self.playerQueue = RDMPEGPlayerQueue()
+        self.decodePoolClient = RDMPEGDecodePool.shared.makeClient(priority: .visible)
+        // Fails only when out of memory
+        self.audioCallbackFlags = rdmpeg_audio_callback_flags_create()!
+        self.scheduler = RDMPEGRenderScheduler()
         self.playerView = RDMPEGPlayerView()
         self.audioRenderer = RDMPEGAudioRenderer()
         self.selectableInputs = []
@@ -137,15 +355,39 @@ public class RDMPEGPlayer: NSObject {
         self.currentSubtitleFrames = []
         self.isBuffering = false
         self.isSeeking = false
+        self.isTrickPlaying = false
+        self.trickPlayRate = 0
         self.duration = 0
         self.isDeinterlacingEnabled = false
+        self.isAudioOnlyMode = false
+        self.audioGain = 0
+        self.audioDownmix = .ITU
+        self.audioResamplerQuality = .balanced
+        self.isAudioSpectrumEnabled = false
+        self.isDecodeStatisticsEnabled = false
+        self.rate = 1.0
 
         super.init()
 
         self.decodingQueue.name = "RDMPEGPlayer Decoding Queue"
         self.decodingQueue.maxConcurrentOperationCount = 1
+        self.decodingQueue.qualityOfService = RDMPEGPlayer.qualityOfService(for: .visible)
         self.externalInputsQueue.name = "RDMPEGPlayer External Inputs Queue"
         self.externalInputsQueue.maxConcurrentOperationCount = 1
+
+        // Scheduler sleeps while there is nothing to render
+        self.framebuffer.framesPushedHandler = { [weak self] in
+            self?.scheduler.wake()
+        }
+    }
+
+    // Remote stream is read through the cache, already fetched ranges are never requested again
+    @objc
+    public convenience init(filePath: String, stream: RDMPEGIOStream, cache: RDMPEGIOCache, contentKey: String) {
+        self.init(
+            filePath: filePath,
+            stream: RDMPEGCachingIOStream(stream: stream, cache: cache, contentKey: contentKey)
+        )
     }
 
     deinit {
@@ -154,6 +396,8 @@ public class RDMPEGPlayer: NSObject {
         stopTimeObservingTimer()
         decodingQueue.cancelAllOperations()
         externalInputsQueue.cancelAllOperations()
+        // Audio callback holds player weakly, so it can't reach flags once deinit runs
+        rdmpeg_audio_callback_flags_destroy(audioCallbackFlags)
     }
 
     @objc
@@ -191,14 +435,115 @@ public class RDMPEGPlayer: NSObject {
         }
     }
 
+    @objc
+    public func enqueueInput(filePath: String, stream: RDMPEGIOStream?) {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        playerQueue.enqueue(RDMPEGPlayerItem(filePath: filePath, stream: stream))
+
+        if preparedToPlay {
+            openNextQueuedItemIfNeeded()
+        }
+    }
+
+    // Items decoding already switched to are kept, they're about to be presented
+    @objc
+    public func removeAllQueuedInputs() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        playerQueue.removeAllQueuedItems()
+    }
+
+    // Opens input and decodes up to buffering targets, first video frame is presented. Completion is called
+    // on main thread with false if preparation failed or preroll was interrupted by seek or play
+    @objc
+    public func preroll(completion: ((Bool) -> Void)?) {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        let prerollStartTime = RDMPEGCorrectionInfo.hostTime
+
+        prepareToPlayIfNeeded(successCallback: { [weak self] in
+            guard let self = self else { return }
+
+            if self.internalState == .playing {
+                completion?(true)
+                return
+            }
+
+            self.decodingOperation?.cancel()
+
+            // Main thread only
+            var isReported = false
+            let reportPrerolled = { (prerolled: Bool) in
+                if !isReported {
+                    isReported = true
+                    completion?(prerolled)
+                }
+            }
+
+            let prerollOperation = RDMPEGDecodeOperation()
+            prerollOperation.name = "Preroll Operation"
+
+            prerollOperation.addExecutionBlock { [weak self, weak prerollOperation] in
+                guard let self = self, let prerollOperation = prerollOperation else { return }
+
+                self.decodeUntilBuffersReady(prerollOperation) { [weak self] in
+                    var prerolled = false
+
+                    DispatchQueue.main.sync {
+                        guard let self = self, !prerollOperation.isCancelled, self.internalState != .playing else {
+                            return
+                        }
+
+                        self.showPrerolledVideoFrame()
+                        self.prerollTime = RDMPEGCorrectionInfo.hostTime - prerollStartTime
+                        prerolled = true
+                    }
+
+                    DispatchQueue.main.async {
+                        reportPrerolled(prerolled)
+                    }
+                }
+            }
+
+            // Called even if operation is cancelled before it starts, decoding reports the result otherwise.
+            // Operation may finish while its decoding waits for a pool slot, so only cancellation is reported here
+            prerollOperation.completionBlock = { [weak prerollOperation] in
+                guard prerollOperation?.isCancelled ?? true else {
+                    return
+                }
+
+                DispatchQueue.main.async {
+                    reportPrerolled(false)
+                }
+            }
+
+            self.decodingOperation = prerollOperation
+            self.decodingQueue.addOperation(prerollOperation)
+        }, failureCallback: {
+            completion?(false)
+        })
+    }
+
     @objc
     public func play() {
         log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
 
+        if isTrickPlaying {
+            playingBeforeTrickPlay = true
+            endTrickPlay()
+            return
+        }
+
+        let playRequestTime = RDMPEGCorrectionInfo.hostTime
+
         prepareToPlayIfNeeded { [weak self] in
             guard let self = self else { return }
 
             if self.internalState != .playing {
+                self.beginStartupMeasurement(at: playRequestTime)
+                self.startClockFromBufferedVideoFrameIfPossible()
+
                 if self.activeAudioStreamIndex != nil {
                     self.setAudioOutputEnabled(true)
                 }
@@ -224,7 +569,9 @@ public class RDMPEGPlayer: NSObject {
 
             self.decodingOperation?.cancel()
             self.correctionInfo = nil
+            self.frameDropController.stopClock()
             self.rawAudioFrame = nil
+            self.cancelStartupMeasurement()
 
             self.setBufferingStateIfNeededAndNotify(false)
             self.updateStateIfNeededAndNotify(.paused, error: nil)
@@ -252,9 +599,21 @@ public class RDMPEGPlayer: NSObject {
         prepareToPlayIfNeeded { [weak self] in
             guard let self = self else { return }
 
+            // Frame at the position is decoded in full, so trick play ends
+            self.stopTrickPlayIfNeeded()
+
             self.decodingOperation?.cancel()
             self.seekOperation?.cancel()
 
+            // Seek cancels video resync in progress, video resumes from the keyframe it decodes from instead
+            if self.isVideoSuspended && !self.isAudioOnlyMode {
+                self.isVideoSuspended = false
+
+                self.decodingQueue.addOperation { [weak self] in
+                    self?.decoder?.isVideoDiscarded = false
+                }
+            }
+
             let seekOperation = BlockOperation()
             seekOperation.name = "Seek Operation"
 
@@ -263,14 +622,24 @@ public class RDMPEGPlayer: NSObject {
 
                 self.framebuffer.purge()
                 self.rawAudioFrame = nil
+                self.frameDropController.stopClock()
+                self.frameDropController.resetFrameSkip()
+
+                self.revertDecodingToPresentedItemIfNeeded()
+                self.decodedAudioEndPosition = nil
+                self.decodedVideoEndPosition = nil
+                self.audioDropPosition = nil
 
                 self.moveDecoders(to: time, includingMainDecoder: true)
 
                 self.decodingFinished = self.decoder?.isEndReached ?? false
 
-                self.decodeFrames()
+                // Frame is shown right below, so the step waits for a pool slot in place
+                self.decodePoolClient.performDecodeStep {
+                    self.decodeFrames()
+                }
 
-                if self.videoStreamExist {
+                if self.isVideoPresented {
                     DispatchQueue.main.sync {
                         if self.seekOperation != nil && self.seekOperation != seekOperation {
                             return
@@ -278,11 +647,16 @@ public class RDMPEGPlayer: NSObject {
 
                         _ = self.showNextVideoFrame()
 
-                        self.delegate?.mpegPlayer(self, didUpdateCurrentTime: self.currentInternalTime)
+                        self.delegate?.mpegPlayer(self, didUpdateCurrentTime: self.currentTime)
                     }
                 }
             }
 
+            // Scheduler sleeps while seeking
+            seekOperation.completionBlock = { [weak self] in
+                self?.scheduler.wake()
+            }
+
             self.seekOperation = seekOperation
             self.decodingQueue.addOperation(seekOperation)
         }
@@ -302,6 +676,68 @@ public class RDMPEGPlayer: NSObject {
         }
     }
 
+    // Keyframe-only fast forward (positive rate) or rewind (negative rate), magnitude is clamped to 2x-64x.
+    // Playback pauses, so audio is muted, and keyframes are shown downscaled until endTrickPlay()
+    @objc
+    public func beginTrickPlay(rate: Double) {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard rate != 0 else {
+            log4AssertionFailure("Trick play rate should be nonzero")
+            return
+        }
+
+        prepareToPlayIfNeeded { [weak self] in
+            guard let self = self else { return }
+
+            guard self.isVideoPresented else {
+                log4Info("Trick play isn't supported without video")
+                return
+            }
+
+            if !self.isTrickPlaying {
+                self.isTrickPlaying = true
+
+                if self.internalState == .playing {
+                    self.playingBeforeTrickPlay = true
+                    self.pause()
+                }
+            }
+
+            let rateMagnitude = min(max(abs(rate), RDMPEGPlayerTrickPlayMinimumRate), RDMPEGPlayerTrickPlayMaximumRate)
+            self.trickPlayRate = rate > 0 ? rateMagnitude : -rateMagnitude
+
+            self.startTrickPlayOperation()
+        }
+    }
+
+    // Decodes frame at the reached position in full and resumes playback if it was playing before trick play
+    @objc
+    public func endTrickPlay() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard isTrickPlaying else {
+            return
+        }
+
+        let resumePlaying = playingBeforeTrickPlay
+
+        seek(to: currentTime)
+
+        if resumePlaying {
+            play()
+        }
+    }
+
+    // Latest levels and spectrum of audio being heard, meant to be polled at display rate (e.g. from CADisplayLink).
+    // Returns nil while isAudioSpectrumEnabled is false or if nothing new was rendered since the previous call
+    @objc
+    public func audioSpectrum() -> RDMPEGAudioSpectrum? {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        return audioRenderer.readAudioTap()
+    }
+
     @objc
     public func activateAudioStream(at streamIndex: NSNumber?) {
         if !preparedToPlay {
@@ -352,6 +788,9 @@ public class RDMPEGPlayer: NSObject {
                 self.decoder?.deactivateAudioStream()
 
                 self.externalAudioDecoder = decoder
+                self.externalAudioDecoder?.playbackRate = self.rate
+                self.externalAudioDecoder?.downmix = self.audioDownmix
+                self.externalAudioDecoder?.resamplerQuality = self.audioResamplerQuality
                 self.externalAudioDecoder?
                     .activateAudioStream(
                         atIndex: decoderStreamToActivate,
@@ -359,7 +798,7 @@ public class RDMPEGPlayer: NSObject {
                         outputChannels: UInt(outputChannelsCount)
                     )
 
-                self.moveDecoders(to: self.currentInternalTime, includingMainDecoder: false)
+                self.moveDecoders(to: self.currentTime, includingMainDecoder: false)
             }
         }
     }
@@ -407,7 +846,7 @@ public class RDMPEGPlayer: NSObject {
                 self.externalSubtitleDecoder = decoder
                 self.externalSubtitleDecoder?.activateSubtitleStream(atIndex: decoderStreamToActivate)
 
-                self.moveDecoders(to: self.currentInternalTime, includingMainDecoder: false)
+                self.moveDecoders(to: self.currentTime, includingMainDecoder: false)
             }
         }
     }
@@ -437,7 +876,10 @@ public class RDMPEGPlayer: NSObject {
     }
 
     // swiftlint:disable:next cyclomatic_complexity function_body_length
-    private func prepareToPlayIfNeeded(successCallback: @escaping () -> Void) {
+    private func prepareToPlayIfNeeded(
+        successCallback: @escaping () -> Void,
+        failureCallback: (() -> Void)? = nil
+    ) {
         log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
 
         if preparedToPlay {
@@ -446,6 +888,7 @@ public class RDMPEGPlayer: NSObject {
         }
 
         if internalState == .failed {
+            failureCallback?()
             return
         }
 
@@ -485,35 +928,35 @@ public class RDMPEGPlayer: NSObject {
                 if preparedToPlay {
                     if justPreparedToPlay {
                         self.preparedToPlay = true
+                        // Decoding queue waits for this block, so decoder can be read here
+                        self.presentedDecoder = self.decoder
                         self.duration = self.decoder?.duration ?? 0
 
                         self.decoder?.isDeinterlacingEnabled = self.isDeinterlacingEnabled
+                        self.decoder?.isDecodeStatisticsEnabled = self.isDecodeStatisticsEnabled
+                        self.decoder?.playbackRate = self.rate
+                        self.decoder?.downmix = self.audioDownmix
+                        self.decoder?.resamplerQuality = self.audioResamplerQuality
 
-                        let textureSampler: RDMPEGTextureSampler
-                        if self.decoder?.actualVideoFrameFormat == .YUV {
-                            textureSampler = RDMPEGTextureSamplerYUV()
-                        }
-                        else {
-                            textureSampler = RDMPEGTextureSamplerBGRA()
-                        }
-
-                        self.playerView.renderView = RDMPEGRenderView(
-                            frame: self.playerView.bounds,
-                            textureSampler: textureSampler,
-                            frameWidth: Int(self.decoder?.frameWidth ?? 0),
-                            frameHeight: Int(self.decoder?.frameHeight ?? 0)
-                        )
+                        self.updateRenderView(for: self.decoder)
 
                         self.videoStreamExist = self.decoder?.isVideoStreamExist ?? false
                         self.audioStreamExist = self.decoder?.isAudioStreamExist ?? false
                         self.subtitleStreamExist = self.decoder?.isSubtitleStreamExist ?? false
 
+                        if let decoder = self.decoder, self.shouldDiscardVideo(of: decoder) {
+                            decoder.isVideoDiscarded = true
+                            self.isVideoSuspended = true
+                        }
+
                         self.registerSelectableInputFromDecoderIfNeeded(self.decoder, inputName: nil)
 
                         self.activeAudioStreamIndex = self.decoder?.activeAudioStreamIndex
                         self.activeSubtitleStreamIndex = self.decoder?.activeSubtitleStreamIndex
 
                         self.delegate?.mpegPlayerDidPrepareToPlay(self)
+
+                        self.openNextQueuedItemIfNeeded()
                     }
 
                     if !prepareOperation.isCancelled {
@@ -523,6 +966,7 @@ public class RDMPEGPlayer: NSObject {
                 else {
                     if !prepareOperation.isCancelled {
                         self.updateStateIfNeededAndNotify(.failed, error: prepareError)
+                        failureCallback?()
                     }
                 }
             }
@@ -548,6 +992,21 @@ public class RDMPEGPlayer: NSObject {
             return false
         }
 
+        if let loadError = loadStreams(
+            of: decoder,
+            audioSamplingRate: audioSamplingRate,
+            outputChannelsCount: outputChannelsCount
+        ) {
+            error = loadError
+            log4AssertionFailure("Decoder should contain valid video and/or valid audio")
+            return false
+        }
+
+        self.decoder = decoder
+        return true
+    }
+
+    private func loadStreams(of decoder: RDMPEGDecoder, audioSamplingRate: Double, outputChannelsCount: Int) -> Error? {
         let videoError = decoder.loadVideoStream(
             withPreferredVideoFrameFormat: .YUV,
             actualVideoFrameFormat: nil
@@ -558,13 +1017,53 @@ public class RDMPEGPlayer: NSObject {
         )
 
         if videoError == nil || audioError == nil {
-            self.decoder = decoder
-            return true
+            return nil
+        }
+
+        return videoError
+    }
+
+    // Next queued item is opened on external inputs queue while the current one plays
+    private func openNextQueuedItemIfNeeded() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard preparedToPlay, let item = playerQueue.beginOpeningNextItem() else {
+            return
         }
 
-        error = videoError
-        log4AssertionFailure("Decoder should contain valid video and/or valid audio")
-        return false
+        let samplingRate = audioRenderer.samplingRate
+        let outputChannelsCount = audioRenderer.outputChannelsCount
+
+        externalInputsQueue.addOperation { [weak self] in
+            guard let self = self else { return }
+
+            let decoder = RDMPEGDecoder(
+                path: item.filePath,
+                ioStream: item.stream,
+                subtitleEncoding: nil
+            ) { [weak self] in
+                self == nil
+            }
+
+            let openError = decoder.openInput() ?? self.loadStreams(
+                of: decoder,
+                audioSamplingRate: samplingRate,
+                outputChannelsCount: outputChannelsCount
+            )
+
+            if let openError = openError {
+                log4Error("Unable to open queued input \(item.filePath): \(openError)")
+            }
+
+            DispatchQueue.main.async {
+                self.playerQueue.finishOpening(item, decoder: openError == nil ? decoder : nil)
+
+                // Decoding may already wait for the item, or playback for the end of the queue
+                self.scheduler.wake()
+
+                self.openNextQueuedItemIfNeeded()
+            }
+        }
     }
 
     private func decodeFrames() {
@@ -580,73 +1079,232 @@ public class RDMPEGPlayer: NSObject {
             return
         }
 
-        guard !(decoder?.isEndReached ?? true) else {
+        guard !(decoder?.isEndReached ?? true) || switchDecodingToNextItemIfNeeded() else {
             log4Assert(decodingFinished, "This properties expected to be synchronized")
             decodingFinished = true
             return
         }
 
+        if videoStreamExist {
+            decoder?.frameSkip = frameDropController.frameSkip
+            decoder?.videoDropPosition = (frameDropController.clockPosition ?? -.infinity) - decodingItemStartTime
+        }
+
+        if externalAudioDecoder == nil {
+            compensateAudioClockSkew(of: decoder)
+        }
+
         autoreleasepool {
+            let stepStartTime = ProcessInfo.processInfo.systemUptime
+            let stepStartIOTime = decoder?.ioReadTime ?? 0
+
             if let frames = decoder?.decodeFrames() {
-                framebuffer.pushFrames(frames)
+                pushDecodedFrames(frames)
+
+                // Buffering window follows the stream that drives decoding
+                let primaryFrameType: RDMPEGFrameType = videoStreamExist && decoder?.isVideoDiscarded == false ?
+                    .video : .audio
+                let mediaDuration = frames.reduce(0) { $0 + ($1.type == primaryFrameType ? $1.duration : 0) }
+
+                bufferingController.recordDecodeStep(
+                    time: ProcessInfo.processInfo.systemUptime - stepStartTime,
+                    ioTime: (decoder?.ioReadTime ?? 0) - stepStartIOTime,
+                    mediaDuration: mediaDuration
+                )
             }
         }
 
+        if decoder?.isEndReached ?? true {
+            switchDecodingToNextItemIfNeeded()
+        }
+
         decodingFinished = decoder?.isEndReached ?? true
-    }
 
-    private func decodeExternalAudioFrames() {
-        guard let externalAudioDecoder = externalAudioDecoder else {
-            log4AssertionFailure("External audio decoder isn't selected")
-            return
+        if decodingFinished {
+            // Sleeping scheduler finishes playback once buffered frames are played out
+            scheduler.wake()
         }
+    }
 
-        while true {
-            if externalAudioDecoder.isEndReached {
+    // Frames are moved from decoder (item) time to player timeline
+    private func pushDecodedFrames(_ frames: [RDMPEGFrame]) {
+        log4Assert(OperationQueue.current == decodingQueue, "Method '\(#function)' called from wrong queue")
+
+        for frame in frames {
+            frame.position += decodingItemStartTime
+
+            switch frame.type {
+            case .audio:
+                decodedAudioEndPosition = max(decodedAudioEndPosition ?? 0, frame.position + frame.duration)
+            case .video:
+                decodedVideoEndPosition = max(decodedVideoEndPosition ?? 0, frame.position + frame.duration)
+            default:
                 break
             }
+        }
 
-            autoreleasepool {
-                if let audioFrames = externalAudioDecoder.decodeFrames() {
-                    let filteredAudioFrames = audioFrames.compactMap { $0 as? RDMPEGAudioFrame }
+        var pushedFrames = frames
 
-                    if !filteredAudioFrames.isEmpty {
-                        framebuffer.pushFrames(filteredAudioFrames)
+        if let audioDropPosition = audioDropPosition {
+            // Decoder reproduces the same frames, so the one centered around the position is the boundary
+            pushedFrames.removeAll { $0.type == .audio && $0.position + $0.duration / 2 < audioDropPosition }
 
-                        if let nextAudioFrame = framebuffer.nextAudioFrame {
-                            let externalAudioBufferOverrun =
-                                nextAudioFrame.position + framebuffer.bufferedAudioDuration - currentInternalTime
-                            if externalAudioBufferOverrun > RDMPEGPlayerMinAudioBufferSize {
-                                return
-                            }
-                        }
-                    }
-                }
+            if pushedFrames.contains(where: { $0.type == .audio }) {
+                self.audioDropPosition = nil
             }
         }
+
+        framebuffer.pushFrames(pushedFrames)
     }
 
-    private func decodeExternalSubtitleFrames() {
-        guard let externalSubtitleDecoder = externalSubtitleDecoder else {
-            log4AssertionFailure("External subtitle decoder isn't selected")
-            return
+    // Once decoder reaches the end, decoding continues with the next item if it's opened already.
+    // Next item starts right after the last decoded audio, so there is neither gap nor overlap in audio,
+    // unless video of the current item lasts noticeably longer
+    @discardableResult
+    private func switchDecodingToNextItemIfNeeded() -> Bool {
+        log4Assert(OperationQueue.current == decodingQueue, "Method '\(#function)' called from wrong queue")
+
+        guard let decoder = decoder, decoder.isEndReached else {
+            return false
         }
 
-        while true {
-            if externalSubtitleDecoder.isEndReached {
-                break
-            }
+        var startTime = decodedAudioEndPosition ?? decodedVideoEndPosition ?? decodingItemStartTime
+        if let decodedVideoEndPosition = decodedVideoEndPosition,
+           decodedVideoEndPosition - startTime > RDMPEGPlayerItemVideoOverrunTolerance {
+            startTime = decodedVideoEndPosition
+        }
 
-            autoreleasepool {
-                if let subtitleFrames = externalSubtitleDecoder.decodeFrames() {
+        let takenItem = playerQueue.takeOpenedItem { item in
+            item.startTime = startTime
+            item.previousDecoder = decoder
+            item.previousExternalAudioDecoder = externalAudioDecoder
+            item.previousExternalSubtitleDecoder = externalSubtitleDecoder
+            item.previousStartTime = decodingItemStartTime
+        }
+
+        guard let item = takenItem, let nextDecoder = item.decoder else {
+            return false
+        }
+
+        log4Info("Switching decoding to \(item.filePath) at \(startTime)")
+
+        nextDecoder.isDeinterlacingEnabled = isDeinterlacingEnabled
+        nextDecoder.isDecodeStatisticsEnabled = isDecodeStatisticsEnabled
+        nextDecoder.playbackRate = rate
+        nextDecoder.downmix = audioDownmix
+        nextDecoder.resamplerQuality = audioResamplerQuality
+        nextDecoder.isVideoDiscarded = shouldDiscardVideo(of: nextDecoder)
+
+        // Resampler carries samples it still holds into the next item, audio renderer is shared anyway
+        if nextDecoder.continueAudio(of: decoder) {
+            log4Info("Audio resampler continues into \(item.filePath)")
+        }
+
+        self.decoder = nextDecoder
+        externalAudioDecoder = nil
+        externalSubtitleDecoder = nil
+        decodingItemStartTime = startTime
+        decodedAudioEndPosition = nil
+        decodedVideoEndPosition = nil
+        decodingFinished = false
+
+        DispatchQueue.main.async { [weak self] in
+            self?.openNextQueuedItemIfNeeded()
+        }
+
+        return true
+    }
+
+    // Seek addresses presented item, so decoding returns to it if it already switched to the next items
+    private func revertDecodingToPresentedItemIfNeeded() {
+        log4Assert(OperationQueue.current == decodingQueue, "Method '\(#function)' called from wrong queue")
+
+        let revertedItems = playerQueue.revertPendingItems()
+
+        guard let presentedItemSuccessor = revertedItems.first else {
+            return
+        }
+
+        decoder = presentedItemSuccessor.previousDecoder
+        externalAudioDecoder = presentedItemSuccessor.previousExternalAudioDecoder
+        externalSubtitleDecoder = presentedItemSuccessor.previousExternalSubtitleDecoder
+        decodingItemStartTime = presentedItemSuccessor.previousStartTime
+
+        for item in revertedItems {
+            item.previousDecoder = nil
+            item.previousExternalAudioDecoder = nil
+            item.previousExternalSubtitleDecoder = nil
+            item.decoder?.move(atPosition: 0)
+        }
+    }
+
+    private func compensateAudioClockSkew(of decoder: RDMPEGDecoder?) {
+        guard let decoder = decoder else {
+            return
+        }
+
+        // Buffered duration is media time, compensation works in output time
+        let bufferedAudioDuration = framebuffer.bufferedAudioDuration /
+            max(decoder.playbackRate, RDMPEGPlayerMinimumRate)
+
+        if let skew = audioClockSkew.takeCompensation(bufferedDuration: bufferedAudioDuration) {
+            decoder.compensateAudioClockSkew(skew, overDuration: audioClockSkew.compensationDuration)
+        }
+    }
+
+    private func decodeExternalAudioFrames() {
+        guard let externalAudioDecoder = externalAudioDecoder else {
+            log4AssertionFailure("External audio decoder isn't selected")
+            return
+        }
+
+        while true {
+            if externalAudioDecoder.isEndReached {
+                break
+            }
+
+            compensateAudioClockSkew(of: externalAudioDecoder)
+
+            autoreleasepool {
+                if let audioFrames = externalAudioDecoder.decodeFrames() {
+                    let filteredAudioFrames = audioFrames.compactMap { $0 as? RDMPEGAudioFrame }
+
+                    if !filteredAudioFrames.isEmpty {
+                        pushDecodedFrames(filteredAudioFrames)
+
+                        if let nextAudioFrame = framebuffer.nextAudioFrame {
+                            let externalAudioBufferOverrun =
+                                nextAudioFrame.position + framebuffer.bufferedAudioDuration - currentInternalTime
+                            if externalAudioBufferOverrun > bufferingController.minimumAudioDuration {
+                                return
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    private func decodeExternalSubtitleFrames() {
+        guard let externalSubtitleDecoder = externalSubtitleDecoder else {
+            log4AssertionFailure("External subtitle decoder isn't selected")
+            return
+        }
+
+        while true {
+            if externalSubtitleDecoder.isEndReached {
+                break
+            }
+
+            autoreleasepool {
+                if let subtitleFrames = externalSubtitleDecoder.decodeFrames() {
                     let filteredSubtitleFrames = subtitleFrames.compactMap { $0 as? RDMPEGSubtitleFrame }
 
                     if !subtitleFrames.isEmpty {
-                        framebuffer.pushFrames(filteredSubtitleFrames)
+                        pushDecodedFrames(filteredSubtitleFrames)
 
-                        if let nextSubtitleFrame = framebuffer.nextSubtitleFrame {
-                            let externalSubtitleBufferOverrun =
-                            nextSubtitleFrame.position + framebuffer.bufferedSubtitleDuration - currentInternalTime
+                        if let subtitleEndPosition = framebuffer.bufferedSubtitleEndPosition {
+                            let externalSubtitleBufferOverrun = subtitleEndPosition - currentInternalTime
                             if externalSubtitleBufferOverrun > 0.0 {
                                 return
                             }
@@ -657,49 +1315,281 @@ public class RDMPEGPlayer: NSObject {
         }
     }
 
-    // swiftlint:disable:next cyclomatic_complexity
     private func asyncDecodeFramesIfNeeded() {
         if let decodingOperation = decodingOperation, !decodingOperation.isCancelled {
             return
         }
 
-        let decodingOperation = BlockOperation()
+        let decodingOperation = RDMPEGDecodeOperation()
         decodingOperation.name = "Decoding Operation"
 
         decodingOperation.addExecutionBlock { [weak self, weak decodingOperation] in
             guard let self = self, let decodingOperation = decodingOperation else { return }
+            self.decodeUntilBuffersReady(decodingOperation)
+        }
 
-            while !decodingOperation.isCancelled {
-                if self.isVideoBufferReady && self.isAudioBufferReady && self.isSubtitleBufferReady {
-                    break
-                }
+        self.decodingOperation = decodingOperation
+        decodingQueue.addOperation(decodingOperation)
+    }
 
-                if !self.isVideoBufferReady {
-                    self.decodeFrames()
+    // Decodes until buffers are ready, each step holds a decode pool slot. Without a free slot decoding doesn't
+    // keep the queue thread, it continues in an operation queued once pool grants a slot. Completion is called
+    // on decoding queue once buffers are ready or operation is cancelled
+    private func decodeUntilBuffersReady(
+        _ operation: RDMPEGDecodeOperation,
+        grantedSlot: RDMPEGDecodeSlot? = nil,
+        completion: (() -> Void)? = nil
+    ) {
+        log4Assert(OperationQueue.current == decodingQueue, "Method '\(#function)' called from wrong queue")
+
+        var grantedSlot = grantedSlot
+
+        while !operation.isCancelled {
+            // Next item could get opened after the current one was decoded to the end
+            switchDecodingToNextItemIfNeeded()
+
+            bufferingController.sharedByteBudget = decodePoolClient.byteBudget
+
+            if isVideoBufferReady && isAudioBufferReady && isSubtitleBufferReady {
+                break
+            }
+
+            guard let slot = grantedSlot ?? acquireDecodeSlot(continuing: operation, completion: completion) else {
+                return
+            }
+
+            grantedSlot = nil
+            decodeBuffersStep()
+            slot.release()
+        }
+
+        grantedSlot?.release()
+        completion?()
+    }
+
+    private func acquireDecodeSlot(
+        continuing operation: RDMPEGDecodeOperation,
+        completion: (() -> Void)?
+    ) -> RDMPEGDecodeSlot? {
+        let decodingQueue = self.decodingQueue
+
+        return decodePoolClient.acquireDecodeSlot { [weak self] slot in
+            // Operation is retained until decoding ends, so player keeps seeing it in progress
+            decodingQueue.addOperation { [weak self] in
+                guard let self = self else {
+                    slot.release()
+                    completion?()
+                    return
                 }
 
-                if !self.isAudioBufferReady {
-                    if self.decoder?.activeAudioStreamIndex != nil {
-                        self.decodeFrames()
-                    }
-                    else if self.externalAudioDecoder?.activeAudioStreamIndex != nil {
-                        self.decodeExternalAudioFrames()
-                    }
+                self.decodeUntilBuffersReady(operation, grantedSlot: slot, completion: completion)
+            }
+        }
+    }
+
+    private func decodeBuffersStep() {
+        if !isVideoBufferReady {
+            decodeFrames()
+        }
+
+        if !isAudioBufferReady {
+            if decoder?.activeAudioStreamIndex != nil {
+                decodeFrames()
+            }
+            else if externalAudioDecoder?.activeAudioStreamIndex != nil {
+                decodeExternalAudioFrames()
+            }
+        }
+
+        if !isSubtitleBufferReady {
+            if decoder?.activeSubtitleStreamIndex != nil {
+                decodeFrames()
+            }
+            else if externalSubtitleDecoder?.activeSubtitleStreamIndex != nil {
+                decodeExternalSubtitleFrames()
+            }
+        }
+    }
+
+    private func startTrickPlayOperation() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        trickPlay?.cancel()
+        decodingOperation?.cancel()
+        seekOperation?.cancel()
+
+        let trickPlayOperation = BlockOperation()
+        trickPlayOperation.name = "Trick Play Operation"
+
+        trickPlayOperation.addExecutionBlock { [weak self] in
+            guard let self = self else { return }
+
+            self.framebuffer.purge()
+            self.rawAudioFrame = nil
+            self.frameDropController.stopClock()
+            self.frameDropController.resetFrameSkip()
+
+            self.revertDecodingToPresentedItemIfNeeded()
+            self.decodedAudioEndPosition = nil
+            self.decodedVideoEndPosition = nil
+            self.audioDropPosition = nil
+        }
+
+        decodingOperation = trickPlayOperation
+        decodingQueue.addOperation(trickPlayOperation)
+
+        let scaleFactor = trickPlayScaleFactor()
+
+        // Keyframe operations are queued after the one above. Normal decoding doesn't start while trick play runs,
+        // nothing asks for it with scheduler stopped
+        let trickPlay = RDMPEGTrickPlay<RDMPEGVideoFrame>(
+            startPosition: currentTime,
+            rate: trickPlayRate,
+            decodingQueue: decodingQueue,
+            decodeKeyframe: { [weak self] targetPosition, forward in
+                guard let self = self, let decoder = self.decoder else { return nil }
+
+                return self.decodePoolClient.performDecodeStep {
+                    decoder.decodeKeyframe(from: targetPosition, forward: forward, scaleFactor: scaleFactor)
                 }
+            },
+            presentKeyframe: { [weak self] keyframe in
+                self?.showTrickPlayKeyframe(keyframe)
+            }
+        )
 
-                if !self.isSubtitleBufferReady {
-                    if self.decoder?.activeSubtitleStreamIndex != nil {
-                        self.decodeFrames()
-                    }
-                    else if self.externalSubtitleDecoder?.activeSubtitleStreamIndex != nil {
-                        self.decodeExternalSubtitleFrames()
+        self.trickPlay = trickPlay
+        trickPlay.start()
+    }
+
+    private func stopTrickPlayIfNeeded() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard isTrickPlaying else {
+            return
+        }
+
+        isTrickPlaying = false
+        trickPlayRate = 0
+        playingBeforeTrickPlay = false
+
+        trickPlay?.cancel()
+        trickPlay = nil
+
+        // Keyframes were downscaled
+        updateRenderView(for: presentedDecoder)
+    }
+
+    private func trickPlayScaleFactor() -> Int {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        let viewPixelWidth = playerView.bounds.width * playerView.contentScaleFactor
+
+        guard let decoder = presentedDecoder, viewPixelWidth > 0 else {
+            return RDMPEGPlayerTrickPlayMinimumScaleFactor
+        }
+
+        return max(RDMPEGPlayerTrickPlayMinimumScaleFactor, Int(CGFloat(decoder.frameWidth) / viewPixelWidth))
+    }
+
+    // Without audio nothing would drive the clock, so such inputs keep decoding video in audio-only mode
+    private func shouldDiscardVideo(of decoder: RDMPEGDecoder) -> Bool {
+        isAudioOnlyMode && decoder.isVideoStreamExist && decoder.isAudioStreamExist
+    }
+
+    private func suspendVideoIfNeeded() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard preparedToPlay, videoStreamExist, audioStreamExist, !isVideoSuspended else {
+            return
+        }
+
+        if isTrickPlaying {
+            endTrickPlay()
+        }
+
+        isVideoSuspended = true
+        frameDropController.stopClock()
+        frameDropController.resetFrameSkip()
+
+        // Video resync may be in progress
+        decodingOperation?.cancel()
+
+        decodingQueue.addOperation { [weak self] in
+            guard let self = self else { return }
+
+            self.decoder?.isVideoDiscarded = true
+            self.framebuffer.purgeVideoFrames()
+            self.decodedVideoEndPosition = nil
+        }
+    }
+
+    private func resumeVideoIfNeeded() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard isVideoSuspended else {
+            return
+        }
+
+        guard internalState == .playing else {
+            isVideoSuspended = false
+
+            decodingQueue.addOperation { [weak self] in
+                self?.decoder?.isVideoDiscarded = false
+            }
+
+            // Frame at the current time is shown at once
+            seek(to: currentTime)
+            return
+        }
+
+        startVideoResyncOperation()
+    }
+
+    // Audio keeps playing from the buffer while video is decoded from the keyframe preceding the clock.
+    // Frames before the clock are dropped without conversion, audio decoded again is dropped as well
+    private func startVideoResyncOperation() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        decodingOperation?.cancel()
+
+        if let correctionInfo = correctionInfo {
+            frameDropController.startClock(correctionInfo)
+        }
+
+        // Clock is main thread state, decoding queue gets the position to resync at
+        let resyncTime = correctionInfo?.position() ?? currentInternalTime
+
+        let resyncOperation = RDMPEGDecodeOperation()
+        resyncOperation.name = "Video Resync Operation"
+
+        resyncOperation.addExecutionBlock { [weak self, weak resyncOperation] in
+            guard let self = self, let resyncOperation = resyncOperation, let decoder = self.decoder else { return }
+
+            let position = resyncTime - self.decodingItemStartTime
+
+            decoder.isVideoDiscarded = false
+            self.audioDropPosition = self.decodedAudioEndPosition
+            self.decodedVideoEndPosition = nil
+
+            decoder.moveToKeyframe(before: max(0, position))
+            self.decodingFinished = decoder.isEndReached
+
+            self.decodeUntilBuffersReady(resyncOperation) { [weak self] in
+                DispatchQueue.main.async {
+                    // Seek or stop cancels resync, audio-only mode could be enabled again meanwhile
+                    guard let self = self, !resyncOperation.isCancelled, !self.isAudioOnlyMode else {
+                        return
                     }
+
+                    self.isVideoSuspended = false
+                    self.scheduler.wake()
                 }
             }
         }
 
-        self.decodingOperation = decodingOperation
-        decodingQueue.addOperation(decodingOperation)
+        decodingOperation = resyncOperation
+        decodingQueue.addOperation(resyncOperation)
     }
 
     private func moveDecoders(to time: TimeInterval, includingMainDecoder: Bool) {
@@ -720,22 +1610,41 @@ public class RDMPEGPlayer: NSObject {
     }
 
     private func startScheduler() {
-        guard scheduler?.isScheduling != true else {
+        guard !scheduler.isScheduling else {
             log4AssertionFailure("Video scheduler already started")
             return
         }
 
-        scheduler = RDMPEGRenderScheduler()
-        scheduler?.start { [weak self] in
-            guard let self = self, self.seekOperation == nil else {
+        scheduler.start { [weak self] in
+            guard let self = self, self.seekOperation?.isFinished ?? true else {
                 return nil
             }
 
-            if self.videoStreamExist {
+            self.presentPendingItemsIfReached(self.correctionInfo?.position() ?? self.currentInternalTime)
+
+            if self.isVideoPresented {
+                self.dropLateVideoFrames()
+
                 guard let presentedFrame = self.showNextVideoFrame() else {
+                    // Last frame stays on screen until playback reaches the next item (e.g. one without video)
+                    if let pendingItemStartTime = self.playerQueue.pendingItemStartTime {
+                        guard let correctionInfo = self.correctionInfo else {
+                            // Clock isn't running, so there is nothing to wait for
+                            self.presentPendingItemsIfReached(.infinity)
+                            return 0
+                        }
+
+                        return max(0, pendingItemStartTime - correctionInfo.position()) / self.rate
+                    }
+
+                    if self.correctionInfo != nil && !self.decodingFinished {
+                        self.bufferingController.recordUnderrun()
+                    }
+
                     self.correctionInfo = nil
+                    self.frameDropController.stopClock()
 
-                    if self.decodingFinished {
+                    if self.decodingFinished && self.playerQueue.isEmpty {
                         self.finishPlaying()
                     }
                     else {
@@ -747,24 +1656,32 @@ public class RDMPEGPlayer: NSObject {
                 }
 
                 if self.correctionInfo == nil {
-                    self.correctionInfo = RDMPEGCorrectionInfo(
-                        playbackStartDate: Date(),
-                        playbackStartTime: self.currentInternalTime
+                    let correctionInfo = RDMPEGCorrectionInfo(
+                        playbackStartTime: self.currentInternalTime,
+                        playbackRate: self.rate
                     )
+                    self.correctionInfo = correctionInfo
+                    self.frameDropController.startClock(correctionInfo)
                     self.setBufferingStateIfNeededAndNotify(false)
                 }
 
+                if self.startupRequestTime != nil && self.startupFrameTime == nil {
+                    self.startupFrameTime = RDMPEGCorrectionInfo.hostTime
+                    self.reportStartupMetricsIfNeeded()
+                }
+
                 let correctionInterval = self.correctionInfo?.correctionInterval(
                     withCurrentTime: self.currentInternalTime
                 ) ?? 0
-                let nextFrameInterval = presentedFrame.duration + correctionInterval
+                self.frameDropController.recordPresentedFrame(lateness: -correctionInterval)
+                let nextFrameInterval = (presentedFrame.duration + correctionInterval) / self.rate
 
                 self.asyncDecodeFramesIfNeeded()
 
-                return Date(timeIntervalSinceNow: nextFrameInterval)
+                return nextFrameInterval
             }
             else {
-                if self.decodingFinished {
+                if self.decodingFinished && self.playerQueue.isEmpty {
                     if self.framebuffer.nextAudioFrame == nil {
                         self.finishPlaying()
                         return nil
@@ -774,23 +1691,84 @@ public class RDMPEGPlayer: NSObject {
                     self.asyncDecodeFramesIfNeeded()
                 }
 
-                if let nextAudioFrame = self.framebuffer.nextAudioFrame {
-                    return Date(timeIntervalSinceNow: nextAudioFrame.duration)
-                }
-                else {
-                    return Date(timeIntervalSinceNow: 0.01)
+                // There is no video to present, audio callback plays audio on its own. It neither locks nor calls
+                // into libdispatch timers from the render thread, so scheduler polls a few times per minimum
+                // buffered audio to keep decoding ahead of it. Underruns are reported to main thread, which wakes it
+                let pollInterval = self.bufferingController.minimumAudioDuration /
+                    RDMPEGPlayerAudioOnlyPollsPerBuffer / self.rate
+
+                if let pendingItemStartTime = self.playerQueue.pendingItemStartTime,
+                   let correctionInfo = self.correctionInfo {
+                    return min(pollInterval, max(0, pendingItemStartTime - correctionInfo.position()) / self.rate)
                 }
+
+                return pollInterval
             }
         }
     }
 
+    // With warm buffers clock starts at once, so audio isn't silenced until scheduler presents the first frame
+    private func startClockFromBufferedVideoFrameIfPossible() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard isVideoPresented, correctionInfo == nil, let nextVideoFrame = framebuffer.nextVideoFrame else {
+            return
+        }
+
+        let correctionInfo = RDMPEGCorrectionInfo(playbackStartTime: nextVideoFrame.position, playbackRate: rate)
+        self.correctionInfo = correctionInfo
+        frameDropController.startClock(correctionInfo)
+    }
+
     private func stopScheduler() {
-        guard scheduler?.isScheduling == true else {
+        guard scheduler.isScheduling else {
+            return
+        }
+
+        scheduler.stop()
+    }
+
+    private func dropLateVideoFrames() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard let correctionInfo = correctionInfo else {
+            return
+        }
+
+        // Last buffered frame is always presented, so there is something on screen until decoder catches up
+        while framebuffer.bufferedVideoFramesCount > 1, let nextVideoFrame = framebuffer.nextVideoFrame {
+            let lateness = -correctionInfo.correctionInterval(
+                withCurrentTime: nextVideoFrame.position + nextVideoFrame.duration
+            )
+
+            guard lateness > 0 else {
+                break
+            }
+
+#if RD_DEBUG_MPEG_PLAYER
+            log4debug("Dropping late video frame: \(nextVideoFrame.position) \(lateness)")
+#endif
+
+            _ = framebuffer.popVideoFrame()
+            frameDropController.recordDroppedFrame()
+        }
+    }
+
+    // Frame stays buffered, so playback presents it once again when it starts
+    private func showPrerolledVideoFrame() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard let videoFrame = framebuffer.nextVideoFrame else {
             return
         }
 
-        scheduler?.stop()
-        scheduler = nil
+        currentInternalTime = videoFrame.position
+
+        playerView.renderView?.render(videoFrame)
+
+        showSubtitleForCurrentVideoFrame()
+
+        delegate?.mpegPlayer(self, didUpdateCurrentTime: currentTime)
     }
 
     private func showNextVideoFrame() -> RDMPEGVideoFrame? {
@@ -807,6 +1785,8 @@ public class RDMPEGPlayer: NSObject {
         log4debug("Rendering video frame: \(videoFrame.position) \(videoFrame.duration)")
 #endif
 
+        presentPendingItemsIfReached(videoFrame.position)
+
         currentInternalTime = videoFrame.position
 
         playerView.renderView?.render(videoFrame)
@@ -816,6 +1796,118 @@ public class RDMPEGPlayer: NSObject {
         return videoFrame
     }
 
+    private func showTrickPlayKeyframe(_ keyframe: RDMPEGVideoFrame) {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        updateRenderView(
+            frameFormat: presentedDecoder?.actualVideoFrameFormat,
+            frameWidth: Int(keyframe.width),
+            frameHeight: Int(keyframe.height)
+        )
+
+        currentInternalTime = itemStartTime + keyframe.position
+
+        playerView.renderView?.render(keyframe)
+
+        delegate?.mpegPlayer(self, didUpdateCurrentTime: currentTime)
+    }
+
+    private func presentPendingItemsIfReached(_ position: TimeInterval) {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        while let item = playerQueue.takePendingItem(reachedAt: position) {
+            presentItem(item)
+        }
+    }
+
+    private func presentItem(_ item: RDMPEGPlayerItem) {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard let decoder = item.decoder else {
+            log4AssertionFailure("Item is presented before it's opened")
+            return
+        }
+
+        log4Info("Advancing to \(item.filePath) at \(item.startTime)")
+
+        presentedDecoder = decoder
+        filePath = item.filePath
+        stream = item.stream
+        itemStartTime = item.startTime
+        currentInternalTime = max(currentInternalTime, item.startTime)
+        duration = decoder.duration
+
+        let videoSuspended = shouldDiscardVideo(of: decoder)
+
+        // Next item's decoding cost has nothing to do with the previous one
+        frameDropController.resetFrameSkip()
+
+        if decoder.isVideoStreamExist {
+            updateRenderView(for: decoder)
+
+            // Clock keeps running through the boundary, item after audio-only one joins it
+            if !isVideoPresented, !videoSuspended, let correctionInfo = correctionInfo {
+                frameDropController.startClock(correctionInfo)
+            }
+        }
+        else if isVideoPresented {
+            frameDropController.stopClock()
+        }
+
+        isVideoSuspended = videoSuspended
+        videoStreamExist = decoder.isVideoStreamExist
+        audioStreamExist = decoder.isAudioStreamExist
+        subtitleStreamExist = decoder.isSubtitleStreamExist
+
+        // External inputs were attached to the previous item
+        selectableInputs = []
+        audioStreams = nil
+        subtitleStreams = nil
+        currentSubtitleFrames.removeAll()
+        registerSelectableInputFromDecoderIfNeeded(decoder, inputName: nil)
+
+        activeAudioStreamIndex = decoder.activeAudioStreamIndex
+        activeSubtitleStreamIndex = decoder.activeSubtitleStreamIndex
+
+        if internalState == .playing && activeAudioStreamIndex != nil {
+            setAudioOutputEnabled(true)
+        }
+
+        delegate?.mpegPlayer?(self, didAdvanceToInputAtPath: item.filePath)
+    }
+
+    private func updateRenderView(for decoder: RDMPEGDecoder?) {
+        updateRenderView(
+            frameFormat: decoder?.actualVideoFrameFormat,
+            frameWidth: Int(decoder?.frameWidth ?? 0),
+            frameHeight: Int(decoder?.frameHeight ?? 0)
+        )
+    }
+
+    private func updateRenderView(frameFormat: RDMPEGVideoFrameFormat?, frameWidth: Int, frameHeight: Int) {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        let textureSampler: RDMPEGTextureSampler
+        if frameFormat == .YUV {
+            textureSampler = RDMPEGTextureSamplerYUV()
+        }
+        else {
+            textureSampler = RDMPEGTextureSamplerBGRA()
+        }
+
+        if let renderView = playerView.renderView,
+           renderView.canRender(frameWidth: frameWidth, frameHeight: frameHeight, textureSampler: textureSampler) {
+            return
+        }
+
+        playerView.renderView = RDMPEGRenderView(
+            frame: playerView.bounds,
+            textureSampler: textureSampler,
+            frameWidth: frameWidth,
+            frameHeight: frameHeight
+        )
+    }
+
     private func showSubtitleForCurrentVideoFrame() {
         log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
 
@@ -829,26 +1921,24 @@ public class RDMPEGPlayer: NSObject {
             }
         }
 
-        framebuffer.atomicSubtitleFramesAccess {
-            while let nextSubtitleFrame = self.framebuffer.nextSubtitleFrame {
-                let nextSubtitleStartTime = nextSubtitleFrame.position
-                let nextSubtitleEndTime = nextSubtitleStartTime + nextSubtitleFrame.duration
+        while let nextSubtitleFrame = framebuffer.nextSubtitleFrame {
+            let nextSubtitleStartTime = nextSubtitleFrame.position
+            let nextSubtitleEndTime = nextSubtitleStartTime + nextSubtitleFrame.duration
 
-                if nextSubtitleStartTime <= currentInternalTime {
-                    if currentInternalTime < nextSubtitleEndTime {
-                        if let subtitleFrame = self.framebuffer.popSubtitleFrame() {
-                            currentSubtitleFrames.append(subtitleFrame)
-                        }
-                        break
-                    }
-                    else {
-                        _ = self.framebuffer.popSubtitleFrame()
+            if nextSubtitleStartTime <= currentInternalTime {
+                if currentInternalTime < nextSubtitleEndTime {
+                    if let subtitleFrame = framebuffer.popSubtitleFrame() {
+                        currentSubtitleFrames.append(subtitleFrame)
                     }
+                    break
                 }
                 else {
-                    break
+                    _ = framebuffer.popSubtitleFrame()
                 }
             }
+            else {
+                break
+            }
         }
 
         let subtitleString = currentSubtitleFrames.map { $0.text }.joined(separator: "\n")
@@ -872,10 +1962,24 @@ public class RDMPEGPlayer: NSObject {
 
     // swiftlint:disable:next cyclomatic_complexity function_body_length
     private func audioCallbackFillData(_ outData: UnsafeMutablePointer<Float>, numFrames: UInt32, numChannels: UInt32) {
+        defer {
+            applyAudioGain(to: outData, samplesCount: Int(numFrames) * Int(numChannels))
+        }
+
         autoreleasepool {
             var outData = outData
+            let callbackHostTime = RDMPEGCorrectionInfo.hostTime
+            // Main thread may suspend or resume video meanwhile, the callback sticks to one value
+            let isVideoPresented = self.isVideoPresented
+            var clockSynchronized = false
+
+            audioClockSkew.recordCallback(
+                framesCount: Int(numFrames),
+                samplingRate: audioRenderer.samplingRate,
+                hostTime: callbackHostTime
+            )
 
-            if videoStreamExist && correctionInfo == nil {
+            if isVideoPresented && correctionInfo == nil {
 #if RD_DEBUG_MPEG_PLAYER
                 L4Logger.logger(forName: "rd.mediaplayer.RDMPEGPlayer").debug("Silence audio while correcting video")
 #endif
@@ -898,11 +2002,15 @@ public class RDMPEGPlayer: NSObject {
 
                     framebuffer.atomicAudioFramesAccess {
                         if let nextFrame = self.framebuffer.nextAudioFrame {
+                            // Frame is compared with the clock at the moment it will be heard
+                            let renderedFramesCount = Int(numFrames - numFramesLeft)
                             let delta = self.correctionInfo?.correctionInterval(
-                                withCurrentTime: nextFrame.position
+                                withCurrentTime: nextFrame.position,
+                                hostTime: callbackHostTime + self.audioRenderer.outputLatency +
+                                    Double(renderedFramesCount) / self.audioRenderer.samplingRate
                             ) ?? 0
 
-                            if delta > 0.1 {
+                            if delta > RDMPEGPlayerAudioDiscontinuityThreshold {
 #if RD_DEBUG_MPEG_PLAYER
                                 loggingScope.debug("""
                                     Desync audio (outrun) wait 
@@ -916,11 +2024,12 @@ public class RDMPEGPlayer: NSObject {
 
                             nextAudioFrame = self.framebuffer.popAudioFrame()
 
-                            if !videoStreamExist {
+                            if !isVideoPresented {
                                 currentInternalTime = nextAudioFrame?.position ?? 0
                             }
 
-                            if delta < -0.1, self.framebuffer.nextAudioFrame != nil {
+                            let isLagging = delta < -RDMPEGPlayerAudioDiscontinuityThreshold
+                            if isLagging, self.framebuffer.nextAudioFrame != nil {
 #if RD_DEBUG_MPEG_PLAYER
                                 loggingScope.debug("""
                                     Desync audio (lags) skip \(self.currentInternalTime) \(nextFrame.position) \(delta)
@@ -947,12 +2056,16 @@ public class RDMPEGPlayer: NSObject {
                             .debug("Audio frame will be rendered: \(audioFrame.position) \(audioFrame.duration)")
 #endif
 
-                        rawAudioFrame = RDMPEGRawAudioFrame(rawAudioData: audioFrame.samples)
+                        rawAudioFrame = RDMPEGRawAudioFrame(
+                            rawAudioData: audioFrame.samples,
+                            position: audioFrame.position,
+                            duration: audioFrame.duration
+                        )
 
-                        if !videoStreamExist {
+                        if !isVideoPresented && correctionInfo == nil {
                             correctionInfo = RDMPEGCorrectionInfo(
-                                playbackStartDate: Date(),
-                                playbackStartTime: currentInternalTime
+                                playbackStartTime: currentInternalTime,
+                                playbackRate: rate
                             )
 
                             DispatchQueue.main.async {
@@ -960,11 +2073,20 @@ public class RDMPEGPlayer: NSObject {
                             }
                         }
                     }
-                    else if !videoStreamExist {
+                    else if !isVideoPresented {
+                        // Buffering controller is locked by decoding queue on every step, so it's left to main thread
+                        let isUnderrun = correctionInfo != nil && !decodingFinished
+
                         correctionInfo = nil
 
                         DispatchQueue.main.async {
+                            if isUnderrun {
+                                self.bufferingController.recordUnderrun()
+                            }
+
                             self.setBufferingStateIfNeededAndNotify(true)
+                            // Underrun or end of playback, both are handled by scheduler
+                            self.scheduler.wake()
                         }
                     }
                 }
@@ -974,6 +2096,26 @@ public class RDMPEGPlayer: NSObject {
                     L4Logger.logger(forName: "rd.mediaplayer.RDMPEGPlayer").debug("Rendering raw audio frame")
 #endif
 
+                    let renderedFramesCount = Int(numFrames - numFramesLeft)
+                    let renderedHostTime = callbackHostTime + audioRenderer.outputLatency +
+                        Double(renderedFramesCount) / audioRenderer.samplingRate
+
+                    if !clockSynchronized, let correctionInfo = correctionInfo {
+                        // Clock follows the first samples rendered by this callback
+                        correctionInfo.synchronize(
+                            withAudioPosition: rawAudioFrame.offsetPosition,
+                            hostTime: renderedHostTime
+                        )
+                        clockSynchronized = true
+                    }
+
+                    if takeAwaitingFirstAudio() {
+                        DispatchQueue.main.async {
+                            self.startupAudioTime = renderedHostTime
+                            self.reportStartupMetricsIfNeeded()
+                        }
+                    }
+
                     let bytes = rawAudioFrame.rawAudioData.withUnsafeBytes { $0.baseAddress! }
                         .advanced(by: rawAudioFrame.rawAudioDataOffset)
                     let bytesLeft = rawAudioFrame.rawAudioData.count - rawAudioFrame.rawAudioDataOffset
@@ -1007,6 +2149,16 @@ public class RDMPEGPlayer: NSObject {
         }
     }
 
+    private func applyAudioGain(to data: UnsafeMutablePointer<Float>, samplesCount: Int) {
+        var gainFactor = audioGainFactor
+
+        guard gainFactor != 1 else {
+            return
+        }
+
+        vDSP_vsmul(data, 1, &gainFactor, data, 1, vDSP_Length(samplesCount))
+    }
+
     private func setBufferingStateIfNeededAndNotify(_ buffering: Bool) {
         log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
 
@@ -1023,6 +2175,59 @@ public class RDMPEGPlayer: NSObject {
         delegate?.mpegPlayer(self, didChangeBufferingState: isBuffering ? .paused : .playing)
     }
 
+    private func beginStartupMeasurement(at requestTime: TimeInterval) {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        startupRequestTime = requestTime
+        startupFrameTime = nil
+        startupAudioTime = nil
+
+        rdmpeg_audio_callback_flags_set(
+            audioCallbackFlags,
+            RDMPEGAudioCallbackFlagAwaitingFirstAudio,
+            activeAudioStreamIndex != nil
+        )
+    }
+
+    private func cancelStartupMeasurement() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        startupRequestTime = nil
+        rdmpeg_audio_callback_flags_set(audioCallbackFlags, RDMPEGAudioCallbackFlagAwaitingFirstAudio, false)
+        prerollTime = nil
+    }
+
+    // True once per startup measurement, for the first audio rendered after it began
+    private func takeAwaitingFirstAudio() -> Bool {
+        rdmpeg_audio_callback_flags_take(audioCallbackFlags, RDMPEGAudioCallbackFlagAwaitingFirstAudio)
+    }
+
+    private func reportStartupMetricsIfNeeded() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard let startupRequestTime = startupRequestTime else {
+            return
+        }
+
+        if (isVideoPresented && startupFrameTime == nil) || (activeAudioStreamIndex != nil && startupAudioTime == nil) {
+            return
+        }
+
+        let metrics = RDMPEGStartupMetrics(
+            isPrerolled: prerollTime != nil,
+            prerollTime: prerollTime ?? 0,
+            timeToFirstFrame: startupFrameTime.map { $0 - startupRequestTime } ?? -1,
+            timeToFirstAudio: startupAudioTime.map { $0 - startupRequestTime } ?? -1
+        )
+
+        self.startupRequestTime = nil
+        prerollTime = nil
+
+        log4Info("Startup: first frame \(metrics.timeToFirstFrame) first audio \(metrics.timeToFirstAudio)")
+
+        delegate?.mpegPlayer?(self, didMeasureStartup: metrics)
+    }
+
     private func startTimeObservingTimer() {
         guard timeObservingTimer == nil else {
             log4AssertionFailure("Time observing timer already started")
@@ -1073,9 +2278,9 @@ public class RDMPEGPlayer: NSObject {
     private func finishPlaying() {
         pause()
 
-        currentInternalTime = duration
+        currentInternalTime = itemStartTime + duration
 
-        delegate?.mpegPlayer(self, didUpdateCurrentTime: currentInternalTime)
+        delegate?.mpegPlayer(self, didUpdateCurrentTime: currentTime)
         delegate?.mpegPlayerDidFinishPlaying(self)
     }
 
@@ -1180,11 +2385,21 @@ public class RDMPEGPlayer: NSObject {
     private var isVideoBufferReady: Bool {
         log4Assert(OperationQueue.current == decodingQueue, "Method '\(#function)' called from wrong queue")
 
-        guard let decoder = decoder, decoder.isVideoStreamExist, !decoder.isEndReached else {
+        guard let decoder = decoder, decoder.isVideoStreamExist, !decoder.isVideoDiscarded, !decoder.isEndReached else {
             return true
         }
 
-        return framebuffer.bufferedVideoDuration > RDMPEGPlayerMinVideoBufferSize
+        return bufferingController.isVideoBufferReady(
+            duration: framebuffer.bufferedVideoDuration,
+            byteSize: framebuffer.bufferedVideoByteSize
+        )
+    }
+
+    private var isVideoBufferFull: Bool {
+        bufferingController.isVideoBufferFull(
+            duration: framebuffer.bufferedVideoDuration,
+            byteSize: framebuffer.bufferedVideoByteSize
+        )
     }
 
     private var isAudioBufferReady: Bool {
@@ -1201,11 +2416,11 @@ public class RDMPEGPlayer: NSObject {
                     return true
                 }
 
-                if framebuffer.bufferedAudioDuration > RDMPEGPlayerMinAudioBufferSize {
+                if bufferingController.isAudioBufferReady(duration: framebuffer.bufferedAudioDuration) {
                     return true
                 }
 
-                if framebuffer.bufferedVideoDuration >= RDMPEGPlayerMaxVideoBufferSize {
+                if isVideoBufferFull {
                     return true
                 }
 
@@ -1216,7 +2431,7 @@ public class RDMPEGPlayer: NSObject {
                     return true
                 }
 
-                if framebuffer.bufferedAudioDuration > RDMPEGPlayerMinAudioBufferSize {
+                if bufferingController.isAudioBufferReady(duration: framebuffer.bufferedAudioDuration) {
                     return true
                 }
 
@@ -1231,7 +2446,7 @@ public class RDMPEGPlayer: NSObject {
                 return true
             }
 
-            return framebuffer.bufferedAudioDuration > RDMPEGPlayerMinAudioBufferSize
+            return bufferingController.isAudioBufferReady(duration: framebuffer.bufferedAudioDuration)
         }
     }
 
@@ -1249,7 +2464,7 @@ public class RDMPEGPlayer: NSObject {
                     return true
                 }
 
-                if framebuffer.bufferedVideoDuration >= RDMPEGPlayerMaxVideoBufferSize {
+                if isVideoBufferFull {
                     return true
                 }
 
@@ -1260,7 +2475,7 @@ public class RDMPEGPlayer: NSObject {
                     return true
                 }
 
-                if framebuffer.bufferedVideoDuration >= RDMPEGPlayerMaxVideoBufferSize {
+                if isVideoBufferFull {
                     return true
                 }
 
@@ -1276,6 +2491,21 @@ public class RDMPEGPlayer: NSObject {
     }
 }
 
+extension RDMPEGPlayer {
+    private static func qualityOfService(for decodePriority: RDMPEGDecodePriority) -> QualityOfService {
+        switch decodePriority {
+        case .offscreen:
+            return .utility
+        case .visible:
+            return .default
+        case .focused:
+            return .userInitiated
+        }
+    }
+}
+
+extension RDMPEGVideoFrame: RDMPEGTrickPlayKeyframe {}
+
 extension RDMPEGPlayer {
     class var l4Logger: L4Logger {
         return L4Logger(forName: "rd.mediaplayer.RDMPEGPlayer")
@@ -0,0 +1,37 @@
+//
+//  RDMPEGPlayerItem.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Input queued for gapless playback after the current one
+class RDMPEGPlayerItem {
+    enum State {
+        case queued
+        case opening
+        case opened
+    }
+
+    let filePath: String
+    let stream: RDMPEGIOStream?
+
+    // Guarded by player queue lock
+    var state: State = .queued
+    var decoder: RDMPEGDecoder?
+    // Position on player timeline the item starts at, set when decoding switches to the item
+    var startTime: TimeInterval = 0
+    // Decoders (and start time) of the item decoding switched from, kept until the item is presented,
+    // so seek could go back to them
+    var previousDecoder: RDMPEGDecoder?
+    var previousExternalAudioDecoder: RDMPEGDecoder?
+    var previousExternalSubtitleDecoder: RDMPEGDecoder?
+    var previousStartTime: TimeInterval = 0
+
+    init(filePath: String, stream: RDMPEGIOStream?) {
+        self.filePath = filePath
+        self.stream = stream
+    }
+}
@@ -0,0 +1,124 @@
+//
+//  RDMPEGPlayerQueue.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+import Log4Cocoa
+
+// Inputs played one after another without a gap.
+//
+// Only the first queued item is opened ahead of time (on a background queue), the rest wait their turn.
+// Once the current decoder reaches the end, decoding queue takes the opened item and continues decoding it
+// while frames of the previous item are still buffered, so the item becomes pending. Main thread takes
+// pending items as playback reaches their start time. Seek reverts pending items back to the queue, since
+// seek addresses the item which is still presented.
+class RDMPEGPlayerQueue {
+    private let lock = NSLock()
+
+    private var queuedItems: [RDMPEGPlayerItem] = []
+    private var pendingItems: [RDMPEGPlayerItem] = []
+
+    var isEmpty: Bool {
+        lock.withLock { queuedItems.isEmpty && pendingItems.isEmpty }
+    }
+
+    // Items which follow the presented one
+    var filePaths: [String] {
+        lock.withLock { (pendingItems + queuedItems).map { $0.filePath } }
+    }
+
+    var pendingItemStartTime: TimeInterval? {
+        lock.withLock { pendingItems.first?.startTime }
+    }
+
+    func enqueue(_ item: RDMPEGPlayerItem) {
+        lock.withLock {
+            queuedItems.append(item)
+        }
+    }
+
+    func removeAllQueuedItems() {
+        lock.withLock {
+            queuedItems.removeAll()
+        }
+    }
+
+    // Marks the first queued item as opening, nil when it's already opening or opened
+    func beginOpeningNextItem() -> RDMPEGPlayerItem? {
+        lock.withLock {
+            guard let item = queuedItems.first, item.state == .queued else {
+                return nil
+            }
+
+            item.state = .opening
+            return item
+        }
+    }
+
+    // Nil decoder means item failed to open, it's removed then. Item could also be removed while opening
+    func finishOpening(_ item: RDMPEGPlayerItem, decoder: RDMPEGDecoder?) {
+        lock.withLock {
+            log4Assert(item.state == .opening, "Item isn't being opened")
+
+            guard queuedItems.contains(where: { $0 === item }) else {
+                return
+            }
+
+            if let decoder = decoder {
+                item.decoder = decoder
+                item.state = .opened
+            }
+            else {
+                queuedItems.removeAll { $0 === item }
+            }
+        }
+    }
+
+    // Decoding queue side, item is set up for the switch before main thread may see it
+    func takeOpenedItem(_ prepare: (RDMPEGPlayerItem) -> Void) -> RDMPEGPlayerItem? {
+        lock.withLock {
+            guard let item = queuedItems.first, item.state == .opened else {
+                return nil
+            }
+
+            prepare(item)
+            queuedItems.removeFirst()
+            pendingItems.append(item)
+            return item
+        }
+    }
+
+    // Main thread side
+    func takePendingItem(reachedAt position: TimeInterval) -> RDMPEGPlayerItem? {
+        lock.withLock {
+            guard let item = pendingItems.first, item.startTime <= position else {
+                return nil
+            }
+
+            pendingItems.removeFirst()
+            item.previousDecoder = nil
+            item.previousExternalAudioDecoder = nil
+            item.previousExternalSubtitleDecoder = nil
+            return item
+        }
+    }
+
+    // Decoding queue side
+    func revertPendingItems() -> [RDMPEGPlayerItem] {
+        lock.withLock {
+            let revertedItems = pendingItems
+            queuedItems.insert(contentsOf: revertedItems, at: 0)
+            pendingItems.removeAll()
+            return revertedItems
+        }
+    }
+}
+
+extension RDMPEGPlayerQueue {
+    class var l4Logger: L4Logger {
+        return L4Logger(forName: "rd.mediaplayer.RDMPEGPlayerQueue")
+    }
+}
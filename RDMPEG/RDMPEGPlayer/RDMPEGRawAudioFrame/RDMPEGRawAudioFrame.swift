@@ -10,9 +10,19 @@ import Foundation
 
 class RDMPEGRawAudioFrame {
     private(set) var rawAudioData: Data
+    private(set) var position: TimeInterval
+    private(set) var duration: TimeInterval
     var rawAudioDataOffset: Int = 0
 
-    init(rawAudioData: Data) {
+    // Media position of the sample at current offset
+    var offsetPosition: TimeInterval {
+        guard !rawAudioData.isEmpty else { return position }
+        return position + duration * Double(rawAudioDataOffset) / Double(rawAudioData.count)
+    }
+
+    init(rawAudioData: Data, position: TimeInterval, duration: TimeInterval) {
         self.rawAudioData = rawAudioData
+        self.position = position
+        self.duration = duration
     }
 }
@@ -9,46 +9,99 @@
 import Foundation
 import Log4Cocoa
 
+// Calls render callback on main queue at deadlines on monotonic clock.
+//
+// Callback returns interval until the next deadline, or nil when there is nothing to render yet. In the latter
+// case scheduler sleeps (no polling) until it's explicitly woken, e.g. by framebuffer when decoded frames arrive.
+// Wake requested while callback runs isn't lost, callback is just called once again.
 class RDMPEGRenderScheduler: NSObject {
-    private var timer: Timer?
-    private var callback: (() -> Date?)?
+    typealias Callback = () -> TimeInterval?
+
+    private let lock = NSLock()
+    private var timer: DispatchSourceTimer?
+    private var callback: Callback?
+    private var isWaitingForWake = false
+    private var isWakeRequested = false
 
     var isScheduling: Bool {
-        return timer != nil
+        lock.withLock { timer != nil }
     }
 
     deinit {
         stop()
     }
 
-    func start(with callback: @escaping () -> Date?) {
+    func start(with callback: @escaping Callback) {
         guard !isScheduling else {
             log4Assert(false, "Already scheduling")
             return
         }
 
-        self.callback = callback
-
-        let newTimer = Timer(timeInterval: 0.0, repeats: true) { [weak self] in
-            self?.renderTimerFired($0)
+        let newTimer = DispatchSource.makeTimerSource(flags: .strict, queue: .main)
+        newTimer.setEventHandler { [weak self, weak newTimer] in
+            guard let self = self, let newTimer = newTimer else { return }
+            self.timerFired(newTimer)
         }
 
-        RunLoop.main.add(newTimer, forMode: .common)
+        lock.withLock {
+            self.callback = callback
+            self.timer = newTimer
+            isWaitingForWake = false
+            isWakeRequested = false
+        }
 
-        timer = newTimer
+        newTimer.schedule(deadline: .now(), leeway: .nanoseconds(0))
+        newTimer.resume()
     }
 
     func stop() {
-        guard isScheduling else { return }
+        lock.withLock {
+            timer?.cancel()
+            timer = nil
+            callback = nil
+        }
+    }
+
+    // May be called from any thread
+    func wake() {
+        lock.withLock {
+            guard let timer = timer else { return }
+
+            isWakeRequested = true
 
-        timer?.invalidate()
-        timer = nil
-        callback = nil
+            if isWaitingForWake {
+                isWaitingForWake = false
+                timer.schedule(deadline: .now(), leeway: .nanoseconds(0))
+            }
+        }
     }
 
-    private func renderTimerFired(_ timer: Timer) {
-        let nextFireDate = callback?() ?? Date(timeIntervalSinceNow: 0.01)
-        timer.fireDate = nextFireDate
+    private func timerFired(_ firedTimer: DispatchSourceTimer) {
+        let callback: Callback? = lock.withLock {
+            guard timer === firedTimer else { return nil }
+            isWakeRequested = false
+            return self.callback
+        }
+
+        guard let callback = callback else { return }
+
+        let nextFrameInterval = callback()
+
+        lock.withLock {
+            // Callback could stop (or restart) scheduling
+            guard timer === firedTimer else { return }
+
+            if let nextFrameInterval = nextFrameInterval {
+                firedTimer.schedule(deadline: .now() + max(0, nextFrameInterval), leeway: .nanoseconds(0))
+            }
+            else if isWakeRequested {
+                firedTimer.schedule(deadline: .now(), leeway: .nanoseconds(0))
+            }
+            else {
+                isWaitingForWake = true
+                firedTimer.schedule(deadline: .distantFuture, leeway: .nanoseconds(0))
+            }
+        }
     }
 }
 
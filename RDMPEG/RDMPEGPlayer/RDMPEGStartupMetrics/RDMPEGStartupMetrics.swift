@@ -0,0 +1,35 @@
+//
+//  RDMPEGStartupMetrics.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// How long playback took to start, measured from play() call to the moment the first video frame
+// was presented and the first audio samples were heard (output latency included)
+@objcMembers
+public class RDMPEGStartupMetrics: NSObject {
+    // Buffers were filled by preroll before play() was called
+    public let isPrerolled: Bool
+    // Time preroll took to open input and fill buffers, 0 without preroll
+    public let prerollTime: TimeInterval
+    // Negative when there is no video
+    public let timeToFirstFrame: TimeInterval
+    // Negative when there is no active audio stream
+    public let timeToFirstAudio: TimeInterval
+
+    public init(
+        isPrerolled: Bool,
+        prerollTime: TimeInterval,
+        timeToFirstFrame: TimeInterval,
+        timeToFirstAudio: TimeInterval
+    ) {
+        self.isPrerolled = isPrerolled
+        self.prerollTime = prerollTime
+        self.timeToFirstFrame = timeToFirstFrame
+        self.timeToFirstAudio = timeToFirstAudio
+        super.init()
+    }
+}
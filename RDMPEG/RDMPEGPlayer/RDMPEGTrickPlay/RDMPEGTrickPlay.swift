@@ -0,0 +1,195 @@
+//
+//  RDMPEGTrickPlay.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+import Log4Cocoa
+
+// Timestamp rounding may find the same keyframe again, decoding is retried once the clock moved that much
+private let RDMPEGTrickPlayRetryInterval: TimeInterval = 0.01
+
+protocol RDMPEGTrickPlayKeyframe: AnyObject {
+    var position: TimeInterval { get }
+    var duration: TimeInterval { get }
+}
+
+// Keyframe-only playback at a rate.
+//
+// Trick play runs its own clock from the start position at the rate. Every keyframe is shown when the clock
+// reaches it, keyframes the clock passed while previous one was decoded are hopped over.
+// Keyframes are decoded one at a time, each by its own operation on player decoding queue, and presented on main
+// queue by render scheduler at the keyframe's deadline. Nothing waits in between, so cancel takes effect at once
+// and decoding queue is free for other operations while a keyframe waits for its time.
+//
+// Main thread only, decode closure is called on decoding queue.
+final class RDMPEGTrickPlay<Keyframe: RDMPEGTrickPlayKeyframe> {
+    typealias DecodeKeyframe = (_ targetPosition: TimeInterval, _ forward: Bool) -> Keyframe?
+    typealias PresentKeyframe = (Keyframe) -> Void
+
+    private enum State {
+        // Next keyframe is decoded once host time reaches that
+        case decodingNeeded(hostTime: TimeInterval)
+        case decoding(Operation)
+        case presentationPending(Keyframe)
+        case finished
+    }
+
+    let startPosition: TimeInterval
+    let rate: Double
+    private let decodingQueue: OperationQueue
+    private let decodeKeyframe: DecodeKeyframe
+    private let presentKeyframe: PresentKeyframe
+    private let scheduler = RDMPEGRenderScheduler()
+    private var startHostTime: TimeInterval = 0
+    private var state = State.finished
+    private var previousKeyframe: Keyframe?
+
+    // False once cancelled or when there is no keyframe left in that direction
+    var isRunning: Bool {
+        scheduler.isScheduling
+    }
+
+    init(
+        startPosition: TimeInterval,
+        rate: Double,
+        decodingQueue: OperationQueue,
+        decodeKeyframe: @escaping DecodeKeyframe,
+        presentKeyframe: @escaping PresentKeyframe
+    ) {
+        log4Assert(rate != 0, "Trick play rate should be nonzero")
+
+        self.startPosition = startPosition
+        self.rate = rate
+        self.decodingQueue = decodingQueue
+        self.decodeKeyframe = decodeKeyframe
+        self.presentKeyframe = presentKeyframe
+    }
+
+    func start() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        guard !scheduler.isScheduling else {
+            log4Assert(false, "Trick play already started")
+            return
+        }
+
+        startHostTime = RDMPEGCorrectionInfo.hostTime
+        previousKeyframe = nil
+        state = .decodingNeeded(hostTime: startHostTime)
+
+        scheduler.start { [weak self] in
+            self?.scheduledStep()
+        }
+    }
+
+    func cancel() {
+        log4Assert(Thread.isMainThread, "Method '\(#function)' called from wrong thread")
+
+        if case let .decoding(operation) = state {
+            operation.cancel()
+        }
+
+        state = .finished
+        scheduler.stop()
+    }
+
+    // MARK: - Private
+
+    private func scheduledStep() -> TimeInterval? {
+        let hostTime = RDMPEGCorrectionInfo.hostTime
+
+        switch state {
+        case let .decodingNeeded(decodingHostTime):
+            if decodingHostTime > hostTime {
+                return decodingHostTime - hostTime
+            }
+
+            startDecoding(at: hostTime)
+            return nil
+
+        case let .presentationPending(keyframe):
+            let presentationHostTime = startHostTime + (keyframe.position - startPosition) / rate
+            if presentationHostTime > hostTime {
+                return presentationHostTime - hostTime
+            }
+
+            previousKeyframe = keyframe
+            state = .decodingNeeded(hostTime: hostTime)
+
+            presentKeyframe(keyframe)
+
+            // Presentation could cancel trick play
+            guard case .decodingNeeded = state else {
+                return nil
+            }
+
+            startDecoding(at: hostTime)
+            return nil
+
+        case .decoding, .finished:
+            // Decoding operation wakes scheduler when it's done
+            return nil
+        }
+    }
+
+    private func startDecoding(at hostTime: TimeInterval) {
+        let isForward = rate > 0
+        var targetPosition = startPosition + (hostTime - startHostTime) * rate
+
+        if let previousKeyframe = previousKeyframe {
+            targetPosition = isForward ?
+                max(targetPosition, previousKeyframe.position + previousKeyframe.duration) :
+                min(targetPosition, previousKeyframe.position - previousKeyframe.duration)
+        }
+
+        let decodingOperation = BlockOperation()
+        decodingOperation.name = "Trick Play Keyframe Operation"
+
+        decodingOperation.addExecutionBlock { [weak self, weak decodingOperation] in
+            guard let self = self, let decodingOperation = decodingOperation, !decodingOperation.isCancelled else {
+                return
+            }
+
+            let keyframe = self.decodeKeyframe(targetPosition, isForward)
+
+            DispatchQueue.main.async { [weak self] in
+                guard !decodingOperation.isCancelled else { return }
+                self?.keyframeDecoded(keyframe)
+            }
+        }
+
+        state = .decoding(decodingOperation)
+        decodingQueue.addOperation(decodingOperation)
+    }
+
+    private func keyframeDecoded(_ keyframe: Keyframe?) {
+        guard case .decoding = state else {
+            return
+        }
+
+        // Trick play stays at the first or the last keyframe
+        guard let keyframe = keyframe else {
+            state = .finished
+            scheduler.stop()
+            return
+        }
+
+        if let previousKeyframe = previousKeyframe, keyframe.position == previousKeyframe.position {
+            state = .decodingNeeded(hostTime: RDMPEGCorrectionInfo.hostTime + RDMPEGTrickPlayRetryInterval)
+        }
+        else {
+            state = .presentationPending(keyframe)
+        }
+
+        scheduler.wake()
+    }
+}
+
+extension RDMPEGTrickPlay {
+    class var l4Logger: L4Logger {
+        return L4Logger(forName: "rd.mediaplayer.RDMPEGTrickPlay")
+    }
+}
@@ -71,6 +71,13 @@ class RDMPEGRenderView: MTKView {
         updateVertices()
     }
 
+    // Render view is reused across playlist items with frames of the same size and format
+    func canRender(frameWidth: Int, frameHeight: Int, textureSampler: RDMPEGTextureSampler) -> Bool {
+        frameWidth == self.frameWidth &&
+            frameHeight == self.frameHeight &&
+            type(of: textureSampler) == type(of: self.textureSampler)
+    }
+
     func render(_ videoFrame: RDMPEGVideoFrame?) {
         guard isAbleToRender else {
             log4Assert(videoFrame == nil, "Attempt to render frame in invalid state")
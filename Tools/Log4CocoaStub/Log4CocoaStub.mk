@@ -0,0 +1,12 @@
+# Log4Cocoa stub module shared by Swift tests. Included after the default target of the test Makefile,
+# which links with $(LOG4COCOA_STUB_FLAGS) and depends on $(LOG4COCOA_STUB_LIBRARY).
+
+LOG4COCOA_STUB_SOURCE := $(dir $(lastword $(MAKEFILE_LIST)))Log4CocoaStub.swift
+LOG4COCOA_STUB_DIR ?= build
+LOG4COCOA_STUB_LIBRARY = $(LOG4COCOA_STUB_DIR)/libLog4Cocoa.a
+LOG4COCOA_STUB_FLAGS = -I $(LOG4COCOA_STUB_DIR) -L $(LOG4COCOA_STUB_DIR) -lLog4Cocoa
+
+$(LOG4COCOA_STUB_LIBRARY): $(LOG4COCOA_STUB_SOURCE)
+	mkdir -p $(LOG4COCOA_STUB_DIR)
+	$(SWIFTC) $(SWIFTFLAGS) -parse-as-library -emit-library -static -emit-module -module-name Log4Cocoa \
+		-emit-module-path $(LOG4COCOA_STUB_DIR)/Log4Cocoa.swiftmodule -o $@ $(LOG4COCOA_STUB_SOURCE)
@@ -0,0 +1,53 @@
+//
+//  Log4CocoaStub.swift
+//  RDMPEG
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Minimal stand-in for Log4Cocoa, so framework sources build with swiftc outside of the framework.
+// Failed assertion ends the process with non-zero status, so a test never reports PASS past one.
+
+public class L4Logger: NSObject {
+    public let name: String
+
+    public init(forName name: String) {
+        self.name = name
+        super.init()
+    }
+}
+
+#if canImport(ObjectiveC)
+extension NSObject {
+    @objc open class func l4Logger() -> L4Logger {
+        return L4Logger(forName: NSStringFromClass(self))
+    }
+}
+#endif
+
+public func log4Assert(_ condition: @autoclosure () -> Bool, _ message: @autoclosure () -> String) {
+    if !condition() {
+        assertionFailed(message())
+    }
+}
+
+public func log4AssertionFailure(_ message: @autoclosure () -> String) {
+    assertionFailed(message())
+}
+
+public func log4Debug(_ message: @autoclosure () -> String) {
+}
+
+public func log4Info(_ message: @autoclosure () -> String) {
+}
+
+public func log4Error(_ message: @autoclosure () -> String) {
+    print("Error: \(message())")
+}
+
+private func assertionFailed(_ message: String) {
+    print("Assertion failed: \(message)")
+    exit(EXIT_FAILURE)
+}
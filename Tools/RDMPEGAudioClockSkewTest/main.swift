@@ -0,0 +1,277 @@
+//
+//  main.swift
+//  RDMPEGAudioClockSkewTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Plays simulated audio through a device whose sample clock is skewed against host clock and checks
+// RDMPEGAudioClockSkew: the estimate converges to the skew despite callback jitter, compensation is handed out
+// at most once per window, and audio compensated by it stops drifting from host time without oscillating.
+//
+// Decoder model keeps half a second of audio buffered and stretches newly decoded audio the way resampler
+// compensation does (sample delta over compensation duration, then back to no stretching). Host time doesn't
+// count while paused, offset is media heard minus host time played.
+
+let samplingRate: Double = 48_000
+let callbackFrames = 512
+let decodeChunkDuration: TimeInterval = 0.01
+let bufferedDuration: TimeInterval = 0.5
+let simulatedDuration: TimeInterval = 120
+// Measurement window of RDMPEGAudioClockSkew, compensation spans two of them
+let window: TimeInterval = 4
+// Estimate and residual drift once settled, in parts per million
+let maximumEstimateError = 5e-6
+let maximumSettledDrift = 15e-6
+// Windows compensation has to settle within
+let settleWindows = 3
+var failuresCount = 0
+
+func check(_ condition: Bool, _ message: @autoclosure () -> String) {
+    if !condition {
+        print("FAIL: \(message())")
+        failuresCount += 1
+    }
+}
+
+func ppm(_ value: Double) -> String {
+    String(format: "%.1f ppm", value * 1e6)
+}
+
+// Deterministic jitter, so runs are reproducible
+struct LinearCongruentialGenerator {
+    private var state: UInt64
+
+    init(seed: UInt64) {
+        self.state = seed
+    }
+
+    mutating func next(in range: ClosedRange<Double>) -> Double {
+        state = state &* 6_364_136_223_846_793_005 &+ 1_442_695_040_888_963_407
+        let unit = Double(state >> 11) / Double(1 << 53)
+        return range.lowerBound + unit * (range.upperBound - range.lowerBound)
+    }
+}
+
+struct Scenario {
+    let name: String
+    let skew: Double
+    let callbackJitter: TimeInterval
+    var compensated = true
+    // Device stops calling back for a while (pause) at the host time
+    var pause: (hostTime: TimeInterval, duration: TimeInterval)?
+}
+
+struct Result {
+    var estimate: Double?
+    // Host time and skew handed to decoder
+    var compensations: [(hostTime: TimeInterval, skew: Double)] = []
+    // Host time and media heard minus host time elapsed, sampled every callback
+    var offsets: [(hostTime: TimeInterval, offset: TimeInterval)] = []
+
+    // Offset change per host second over the window starting at the host time
+    func drift(from hostTime: TimeInterval, over interval: TimeInterval) -> Double? {
+        guard
+            let start = offsets.first(where: { $0.hostTime >= hostTime }),
+            let end = offsets.first(where: { $0.hostTime >= hostTime + interval })
+        else {
+            return nil
+        }
+
+        return (end.offset - start.offset) / (end.hostTime - start.hostTime)
+    }
+}
+
+// Decoded audio waiting for the device, chunks of output samples and media they hold
+struct AudioBuffer {
+    private var chunks: [(samples: Double, media: TimeInterval)] = []
+    private var firstChunkIndex = 0
+    private(set) var samples: Double = 0
+
+    mutating func append(samples: Double, media: TimeInterval) {
+        chunks.append((samples, media))
+        self.samples += samples
+    }
+
+    // Returns media consumed
+    mutating func consume(samples: Double) -> TimeInterval {
+        var samplesLeft = samples
+        var media: TimeInterval = 0
+
+        while samplesLeft > 0 && firstChunkIndex < chunks.count {
+            let chunk = chunks[firstChunkIndex]
+            let taken = min(samplesLeft, chunk.samples)
+            let takenMedia = chunk.media * taken / chunk.samples
+
+            media += takenMedia
+            samplesLeft -= taken
+            self.samples -= taken
+            chunks[firstChunkIndex] = (chunk.samples - taken, chunk.media - takenMedia)
+
+            if chunks[firstChunkIndex].samples <= 1e-9 {
+                firstChunkIndex += 1
+            }
+        }
+
+        if firstChunkIndex > 1024 {
+            chunks.removeFirst(firstChunkIndex)
+            firstChunkIndex = 0
+        }
+
+        return media
+    }
+}
+
+// Stretches decoded audio the way swr_set_compensation does: rounded sample delta over a distance
+struct ResamplerModel {
+    private var stretch: Double = 0
+    private var remainingSamples: Double = 0
+
+    mutating func setCompensation(skew: Double, duration: TimeInterval) {
+        let distance = (duration * samplingRate).rounded()
+        let sampleDelta = (skew * distance).rounded()
+        stretch = sampleDelta != 0 ? sampleDelta / distance : 0
+        remainingSamples = sampleDelta != 0 ? distance : 0
+    }
+
+    mutating func resample(media: TimeInterval) -> Double {
+        let stretch = remainingSamples > 0 ? self.stretch : 0
+        let samples = media * samplingRate * (1 + stretch)
+        remainingSamples -= samples
+        return samples
+    }
+}
+
+func run(_ scenario: Scenario) -> Result {
+    let clockSkew = RDMPEGAudioClockSkew()
+    var jitter = LinearCongruentialGenerator(seed: 0x5EED)
+    var buffer = AudioBuffer()
+    var resampler = ResamplerModel()
+    var result = Result()
+    var hostTime: TimeInterval = 0
+    var mediaHeard: TimeInterval = 0
+    var pausedTime: TimeInterval = 0
+    var paused = false
+    let callbackInterval = Double(callbackFrames) / (samplingRate * (1 + scenario.skew))
+
+    while hostTime < simulatedDuration {
+        // Decoding queue: compensation is asked for every decode step, buffer is topped up
+        if scenario.compensated,
+           let skew = clockSkew.takeCompensation(bufferedDuration: buffer.samples / samplingRate) {
+            result.compensations.append((hostTime, skew))
+            resampler.setCompensation(skew: skew, duration: clockSkew.compensationDuration)
+        }
+
+        while buffer.samples < bufferedDuration * samplingRate {
+            buffer.append(samples: resampler.resample(media: decodeChunkDuration), media: decodeChunkDuration)
+        }
+
+        if let pause = scenario.pause, !paused, hostTime >= pause.hostTime {
+            // Neither device nor host playback time advances while paused
+            paused = true
+            hostTime += pause.duration
+            pausedTime = pause.duration
+        }
+
+        let callbackHostTime = hostTime + jitter.next(in: -scenario.callbackJitter...scenario.callbackJitter)
+        clockSkew.recordCallback(framesCount: callbackFrames, samplingRate: samplingRate, hostTime: callbackHostTime)
+
+        mediaHeard += buffer.consume(samples: Double(callbackFrames))
+        hostTime += callbackInterval
+        result.offsets.append((hostTime, mediaHeard - (hostTime - pausedTime)))
+    }
+
+    result.estimate = clockSkew.skew
+    return result
+}
+
+func testConvergence(_ scenario: Scenario) {
+    let result = run(scenario)
+
+    guard let estimate = result.estimate else {
+        check(false, "\(scenario.name): no estimate")
+        return
+    }
+
+    check(abs(estimate - scenario.skew) < maximumEstimateError,
+          "\(scenario.name): estimate \(ppm(estimate)), skew \(ppm(scenario.skew))")
+
+    // At most once per window
+    let windowsCount = Int(simulatedDuration / window)
+    check(result.compensations.count <= windowsCount && result.compensations.count >= windowsCount - 2,
+          "\(scenario.name): \(result.compensations.count) compensations in \(windowsCount) windows")
+    for (previous, next) in zip(result.compensations, result.compensations.dropFirst()) {
+        check(next.hostTime - previous.hostTime >= window - 0.05,
+              "\(scenario.name): compensations \(next.hostTime - previous.hostTime) s apart")
+    }
+
+    // No oscillation: once settled, each compensation is close to the skew and audio stops drifting
+    for compensation in result.compensations.dropFirst(settleWindows) {
+        check(abs(compensation.skew - scenario.skew) < maximumSettledDrift,
+              "\(scenario.name): compensation \(ppm(compensation.skew)) at \(compensation.hostTime) s")
+    }
+
+    var windowStart = Double(settleWindows + 1) * window
+    while windowStart + window < simulatedDuration {
+        if let drift = result.drift(from: windowStart, over: window) {
+            check(abs(drift) < maximumSettledDrift, "\(scenario.name): drift \(ppm(drift)) at \(windowStart) s")
+        }
+        windowStart += window
+    }
+
+    let settledOffsets = result.offsets.filter { $0.hostTime >= Double(settleWindows + 1) * window }.map(\.offset)
+    let offsetSpan = (settledOffsets.max() ?? 0) - (settledOffsets.min() ?? 0)
+    check(offsetSpan < 0.002, "\(scenario.name): offset moves \(offsetSpan * 1000) ms after settling")
+
+    let initialDrift = result.drift(from: 0.1, over: window) ?? 0
+    print("""
+        \(scenario.name): estimate \(ppm(estimate)), first window drift \(ppm(initialDrift)), \
+        settled offset span \(String(format: "%.3f", offsetSpan * 1000)) ms, \
+        \(result.compensations.count) compensations
+        """)
+}
+
+func testUncompensatedDrift() {
+    // Reference: without compensation audio drifts from host time by the skew
+    let skew = 300e-6
+    let result = run(Scenario(name: "uncompensated", skew: skew, callbackJitter: 0.001, compensated: false))
+    let drift = result.drift(from: 10, over: 100) ?? 0
+
+    check(abs(drift - skew) < 2e-6, "uncompensated drift \(ppm(drift)), skew \(ppm(skew))")
+    check(result.compensations.isEmpty, "uncompensated run compensated")
+}
+
+func testSamplingRateChange() {
+    let clockSkew = RDMPEGAudioClockSkew()
+    var hostTime: TimeInterval = 0
+
+    while hostTime < 10 {
+        clockSkew.recordCallback(framesCount: callbackFrames, samplingRate: samplingRate, hostTime: hostTime)
+        hostTime += Double(callbackFrames) / samplingRate / (1 + 200e-6)
+    }
+    check(clockSkew.skew != nil, "no estimate after 10 s")
+    check(clockSkew.takeCompensation(bufferedDuration: 0) != nil, "no compensation after 10 s")
+    check(clockSkew.takeCompensation(bufferedDuration: 0) == nil, "compensation handed out twice per measurement")
+
+    clockSkew.recordCallback(framesCount: callbackFrames, samplingRate: 44_100, hostTime: hostTime)
+    check(clockSkew.skew == nil, "estimate of the previous device kept")
+    check(clockSkew.takeCompensation(bufferedDuration: 0) == nil, "compensation without estimate")
+}
+
+testConvergence(Scenario(name: "fast device", skew: 250e-6, callbackJitter: 0.001))
+testConvergence(Scenario(name: "slow device", skew: -400e-6, callbackJitter: 0.001))
+testConvergence(Scenario(name: "jittery callbacks", skew: 100e-6, callbackJitter: 0.003))
+testConvergence(Scenario(name: "pause", skew: 250e-6, callbackJitter: 0.001, pause: (30, 2)))
+testUncompensatedDrift()
+testSamplingRateChange()
+
+if failuresCount == 0 {
+    print("PASS")
+    exit(0)
+}
+else {
+    print("FAIL: \(failuresCount) checks")
+    exit(1)
+}
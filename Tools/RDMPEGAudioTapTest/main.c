@@ -0,0 +1,190 @@
+//
+//  main.c
+//  RDMPEGAudioTapTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "../../RDMPEG/RDMPEGPlayer/RDMPEGAudioTap/RDMPEGAudioTap.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks levels and spectrum of RDMPEGAudioTap against synthetic signals, and that snapshots a reader takes
+// while audio thread keeps publishing are never torn: every block of the concurrent test is a constant level
+// derived from its sequence number, so torn snapshot has levels which don't match its sequence.
+
+#define SAMPLING_RATE 48000.0
+#define CALLBACK_FRAMES 512
+#define CONCURRENT_BLOCKS_COUNT 200000
+
+static int failuresCount = 0;
+
+static void check(int condition, const char *description) {
+    printf("%s %s\n", condition ? "PASS" : "FAIL", description);
+    if (!condition) {
+        failuresCount++;
+    }
+}
+
+static float level_for_sequence(uint64_t sequence) {
+    return (float)(sequence % 97 + 1) / 128.0f;
+}
+
+static void write_sine(RDMPEGAudioTap *tap,
+                       double frequency,
+                       float amplitude,
+                       uint32_t channelsCount,
+                       uint32_t framesCount) {
+    float samples[CALLBACK_FRAMES * 2];
+
+    for (uint32_t written = 0; written < framesCount; written += CALLBACK_FRAMES) {
+        for (uint32_t frame = 0; frame < CALLBACK_FRAMES; frame++) {
+            float sample = amplitude * (float)sin(2.0 * M_PI * frequency * (written + frame) / SAMPLING_RATE);
+            for (uint32_t channel = 0; channel < channelsCount; channel++) {
+                samples[frame * channelsCount + channel] = sample;
+            }
+        }
+
+        rdmpeg_audio_tap_write(tap, samples, CALLBACK_FRAMES, channelsCount, SAMPLING_RATE);
+    }
+}
+
+static void test_sine(void) {
+    RDMPEGAudioTap *tap = rdmpeg_audio_tap_create();
+    RDMPEGAudioTapSnapshot snapshot;
+
+    write_sine(tap, 1000.0, 0.5f, 2, RDMPEG_AUDIO_TAP_BLOCK_SIZE * 2);
+    check(rdmpeg_audio_tap_read(tap, &snapshot) == false, "disabled tap publishes nothing");
+
+    rdmpeg_audio_tap_set_enabled(tap, true);
+
+    // Bin centred frequency, so the whole amplitude lands in one bin
+    uint32_t bin = 64;
+    double frequency = bin * SAMPLING_RATE / RDMPEG_AUDIO_TAP_BLOCK_SIZE;
+    write_sine(tap, frequency, 0.5f, 2, RDMPEG_AUDIO_TAP_BLOCK_SIZE * 4);
+
+    check(rdmpeg_audio_tap_read(tap, &snapshot), "snapshot is published");
+    check(snapshot.sequence == 4, "snapshots skipped by reader aren't delivered");
+    check(snapshot.channelsCount == 2 && snapshot.samplingRate == SAMPLING_RATE, "snapshot format");
+    check(fabsf(snapshot.rms[0] - 0.5f / sqrtf(2.0f)) < 1e-3f && fabsf(snapshot.rms[1] - snapshot.rms[0]) < 1e-6f,
+          "sine RMS is amplitude / sqrt(2)");
+    check(fabsf(snapshot.peak[0] - 0.5f) < 1e-3f, "sine peak is amplitude");
+
+    uint32_t peakBin = 0;
+    for (uint32_t i = 1; i < RDMPEG_AUDIO_TAP_BINS_COUNT; i++) {
+        if (snapshot.magnitudes[i] > snapshot.magnitudes[peakBin]) {
+            peakBin = i;
+        }
+    }
+
+    printf("     peak bin %u magnitude %.4f, neighbours %.4f %.4f, far bin %.6f\n", peakBin,
+           snapshot.magnitudes[peakBin], snapshot.magnitudes[bin - 1], snapshot.magnitudes[bin + 1],
+           snapshot.magnitudes[bin * 2]);
+
+    check(peakBin == bin, "spectrum peaks at sine frequency");
+    check(fabsf(snapshot.magnitudes[bin] - 0.5f) < 1e-3f, "bin magnitude is sine amplitude");
+    check(snapshot.magnitudes[bin * 2] < 1e-4f, "no leakage to distant bins");
+    check(rdmpeg_audio_tap_read(tap, &snapshot) == false, "nothing new after the latest snapshot was read");
+
+    // Partial block is dropped when format changes
+    write_sine(tap, frequency, 0.5f, 2, CALLBACK_FRAMES);
+    write_sine(tap, frequency, 0.25f, 1, RDMPEG_AUDIO_TAP_BLOCK_SIZE);
+    check(rdmpeg_audio_tap_read(tap, &snapshot) && snapshot.channelsCount == 1 &&
+          fabsf(snapshot.peak[0] - 0.25f) < 1e-3f, "format change starts a new block");
+
+    rdmpeg_audio_tap_destroy(tap);
+}
+
+typedef struct ConcurrentTest {
+    RDMPEGAudioTap *tap;
+    atomic_bool finished;
+    uint64_t snapshotsCount;
+    uint64_t tornCount;
+    uint64_t reorderedCount;
+} ConcurrentTest;
+
+static void *write_blocks(void *context) {
+    ConcurrentTest *test = context;
+    float samples[CALLBACK_FRAMES * 2];
+
+    for (uint64_t block = 1; block <= CONCURRENT_BLOCKS_COUNT; block++) {
+        float level = level_for_sequence(block);
+
+        for (uint32_t i = 0; i < CALLBACK_FRAMES * 2; i++) {
+            samples[i] = level;
+        }
+
+        for (uint32_t written = 0; written < RDMPEG_AUDIO_TAP_BLOCK_SIZE; written += CALLBACK_FRAMES) {
+            rdmpeg_audio_tap_write(test->tap, samples, CALLBACK_FRAMES, 2, SAMPLING_RATE);
+        }
+    }
+
+    atomic_store(&test->finished, true);
+    return NULL;
+}
+
+static void *read_snapshots(void *context) {
+    ConcurrentTest *test = context;
+    RDMPEGAudioTapSnapshot snapshot;
+    uint64_t lastSequence = 0;
+
+    while (!atomic_load(&test->finished)) {
+        if (!rdmpeg_audio_tap_read(test->tap, &snapshot)) {
+            continue;
+        }
+
+        test->snapshotsCount++;
+
+        float level = level_for_sequence(snapshot.sequence);
+
+        if (snapshot.rms[0] != level || snapshot.peak[1] != level || fabsf(snapshot.magnitudes[0] - level) > 1e-4f) {
+            test->tornCount++;
+        }
+
+        if (snapshot.sequence <= lastSequence) {
+            test->reorderedCount++;
+        }
+
+        lastSequence = snapshot.sequence;
+    }
+
+    return NULL;
+}
+
+static void test_concurrent(void) {
+    ConcurrentTest test = { .tap = rdmpeg_audio_tap_create() };
+    atomic_init(&test.finished, false);
+    rdmpeg_audio_tap_set_enabled(test.tap, true);
+
+    pthread_t writer;
+    pthread_t reader;
+    pthread_create(&reader, NULL, read_snapshots, &test);
+    pthread_create(&writer, NULL, write_blocks, &test);
+    pthread_join(writer, NULL);
+    pthread_join(reader, NULL);
+
+    printf("     %d blocks published, %llu snapshots read\n", CONCURRENT_BLOCKS_COUNT,
+           (unsigned long long)test.snapshotsCount);
+
+    check(test.snapshotsCount > 0, "reader gets snapshots while writer publishes");
+    check(test.tornCount == 0, "no torn snapshots");
+    check(test.reorderedCount == 0, "snapshots come in publishing order");
+
+    rdmpeg_audio_tap_destroy(test.tap);
+}
+
+int main(void) {
+    test_sine();
+    test_concurrent();
+
+    if (failuresCount > 0) {
+        printf("FAIL: %d checks failed\n", failuresCount);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,821 @@
+//
+//  RDMPEGBenchmark.c
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include <dirent.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <libavutil/avutil.h>
+#include "RDMPEGBenchmarkAllocations.h"
+#include "RDMPEGBenchmarkBudgets.h"
+#include "RDMPEGBenchmarkMedia.h"
+#include "RDMPEGBenchmarkReport.h"
+#include "RDMPEGBenchmarkResampler.h"
+
+typedef struct RDMPEGBenchmarkOptions {
+    unsigned int passes;
+    int openIterations;
+    int seekCount;
+    unsigned int seed;
+    int64_t maxFrames;
+    int64_t reverseByteBudget;
+    int deinterlace;
+    const char *outputPath;
+    const char *budgetsPath;
+} RDMPEGBenchmarkOptions;
+
+// Pass writes its results into json and the values budgets may refer to into metrics
+typedef int (*RDMPEGBenchmarkPassFunction)(const char *path,
+                                           const RDMPEGBenchmarkOptions *options,
+                                           RDMPEGBenchmarkJSON *json,
+                                           RDMPEGBenchmarkMetrics *metrics);
+
+typedef struct RDMPEGBenchmarkPass {
+    const char *name;
+    RDMPEGBenchmarkPassFunction function;
+} RDMPEGBenchmarkPass;
+
+// Metric names are kept by pointer, so they are spelled out for every profile
+typedef struct RDMPEGBenchmarkResamplerPass {
+    const RDMPEGResamplerProfile *profile;
+    const char *realtimeFactorMetric;
+    const char *lowToneSNRMetric;
+    const char *highToneGainMetric;
+} RDMPEGBenchmarkResamplerPass;
+
+typedef struct RDMPEGBenchmarkCorpus {
+    char **paths;
+    size_t count;
+    size_t capacity;
+} RDMPEGBenchmarkCorpus;
+
+static int run_open_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics);
+static int run_decode_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics);
+static int run_seek_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics);
+static int run_audio_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics);
+static int run_reverse_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics);
+static int run_resampler_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics);
+static int run_decode_to_null(const char *path,
+                              int streams,
+                              const RDMPEGBenchmarkOptions *options,
+                              RDMPEGBenchmarkJSON *json,
+                              RDMPEGBenchmarkMetrics *metrics);
+static void write_error(RDMPEGBenchmarkJSON *json, int status);
+static void write_memory(RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics, int isRSSPerPass);
+static unsigned int parse_passes(const char *list);
+static void corpus_add_path(RDMPEGBenchmarkCorpus *corpus, const char *path);
+static void corpus_free(RDMPEGBenchmarkCorpus *corpus);
+static int compare_strings(const void *lhs, const void *rhs);
+static void print_usage(const char *executable);
+
+static const RDMPEGBenchmarkPass benchmark_passes[] = {
+    {"open", run_open_pass},
+    {"decode", run_decode_pass},
+    {"seek", run_seek_pass},
+    {"audio", run_audio_pass},
+    {"reverse", run_reverse_pass},
+    {"resampler", run_resampler_pass},
+};
+
+static const RDMPEGBenchmarkResamplerPass resampler_passes[] = {
+    {&RDMPEGResamplerProfileFast, "fast_realtime_factor", "fast_snr_1k_db", "fast_hf_gain_db"},
+    {&RDMPEGResamplerProfileBalanced, "balanced_realtime_factor", "balanced_snr_1k_db", "balanced_hf_gain_db"},
+    {&RDMPEGResamplerProfileHigh, "high_realtime_factor", "high_snr_1k_db", "high_hf_gain_db"},
+};
+
+#define RDMPEG_BENCHMARK_RESAMPLER_PASSES_COUNT (sizeof(resampler_passes) / sizeof(resampler_passes[0]))
+
+#define RDMPEG_BENCHMARK_PASSES_COUNT (sizeof(benchmark_passes) / sizeof(benchmark_passes[0]))
+
+// Same as RDMPEGReverseDecoder keyframe search step
+#define RDMPEG_BENCHMARK_KEYFRAME_SEARCH_STEP 0.001
+
+
+
+int main(int argc, char *argv[]) {
+    RDMPEGBenchmarkOptions options = {
+        .passes = (1u << RDMPEG_BENCHMARK_PASSES_COUNT) - 1,
+        .openIterations = 5,
+        .seekCount = 50,
+        .seed = 1,
+        .maxFrames = 0,
+        .reverseByteBudget = 128 * 1024 * 1024,
+        .deinterlace = 0,
+        .outputPath = NULL,
+        .budgetsPath = NULL,
+    };
+    int verbose = 0;
+
+    static const struct option longOptions[] = {
+        {"passes", required_argument, NULL, 'p'},
+        {"open-iterations", required_argument, NULL, 'i'},
+        {"seeks", required_argument, NULL, 's'},
+        {"seed", required_argument, NULL, 'r'},
+        {"max-frames", required_argument, NULL, 'm'},
+        {"reverse-budget", required_argument, NULL, 'c'},
+        {"deinterlace", no_argument, NULL, 'd'},
+        {"output", required_argument, NULL, 'o'},
+        {"budgets", required_argument, NULL, 'b'},
+        {"verbose", no_argument, NULL, 'v'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "p:i:s:r:m:c:do:b:vh", longOptions, NULL)) != -1) {
+        switch (option) {
+            case 'p': options.passes = parse_passes(optarg); break;
+            case 'i': options.openIterations = atoi(optarg); break;
+            case 's': options.seekCount = atoi(optarg); break;
+            case 'r': options.seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'm': options.maxFrames = strtoll(optarg, NULL, 10); break;
+            case 'c': options.reverseByteBudget = strtoll(optarg, NULL, 10) * 1024 * 1024; break;
+            case 'd': options.deinterlace = 1; break;
+            case 'o': options.outputPath = optarg; break;
+            case 'b': options.budgetsPath = optarg; break;
+            case 'v': verbose = 1; break;
+            case 'h': print_usage(argv[0]); return EXIT_SUCCESS;
+            default: print_usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (options.passes == 0 || optind >= argc) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    av_log_set_level(verbose ? AV_LOG_INFO : AV_LOG_ERROR);
+    rdmpeg_benchmark_allocations_start();
+
+    RDMPEGBenchmarkBudgets budgets = {0};
+    if (options.budgetsPath && rdmpeg_benchmark_budgets_load(&budgets, options.budgetsPath) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    RDMPEGBenchmarkCorpus corpus = {0};
+    for (int i = optind; i < argc; i++) {
+        corpus_add_path(&corpus, argv[i]);
+    }
+
+    if (corpus.count == 0) {
+        fprintf(stderr, "No media files found\n");
+        rdmpeg_benchmark_budgets_free(&budgets);
+        return EXIT_FAILURE;
+    }
+
+    FILE *output = stdout;
+    if (options.outputPath && (output = fopen(options.outputPath, "w")) == NULL) {
+        perror(options.outputPath);
+        rdmpeg_benchmark_budgets_free(&budgets);
+        corpus_free(&corpus);
+        return EXIT_FAILURE;
+    }
+
+    RDMPEGBenchmarkJSON json = {.file = output};
+    int failures = 0;
+    size_t budgetViolations = 0;
+    int64_t peakRSS = rdmpeg_benchmark_peak_rss();
+
+    rdmpeg_benchmark_json_begin_object(&json, NULL);
+    rdmpeg_benchmark_json_string(&json, "tool", "rdmpeg-benchmark");
+    rdmpeg_benchmark_json_string(&json, "ffmpeg_version", av_version_info());
+    rdmpeg_benchmark_json_int(&json, "seed", options.seed);
+    rdmpeg_benchmark_json_begin_array(&json, "files");
+
+    for (size_t i = 0; i < corpus.count; i++) {
+        const char *path = corpus.paths[i];
+        fprintf(stderr, "[%zu/%zu] %s\n", i + 1, corpus.count, path);
+
+        rdmpeg_benchmark_json_begin_object(&json, NULL);
+        rdmpeg_benchmark_json_string(&json, "path", path);
+        rdmpeg_benchmark_json_begin_object(&json, "passes");
+
+        for (size_t passIndex = 0; passIndex < RDMPEG_BENCHMARK_PASSES_COUNT; passIndex++) {
+            if ((options.passes & (1u << passIndex)) == 0) {
+                continue;
+            }
+
+            const RDMPEGBenchmarkPass *pass = &benchmark_passes[passIndex];
+            RDMPEGBenchmarkMetrics metrics = {0};
+
+            rdmpeg_benchmark_json_begin_object(&json, pass->name);
+            rdmpeg_benchmark_allocations_reset();
+            int isRSSPerPass = rdmpeg_benchmark_reset_peak_rss() == 0;
+
+            if (pass->function(path, &options, &json, &metrics) < 0) {
+                failures++;
+            }
+
+            int64_t passPeakRSS = rdmpeg_benchmark_peak_rss();
+            peakRSS = passPeakRSS > peakRSS ? passPeakRSS : peakRSS;
+            write_memory(&json, &metrics, isRSSPerPass);
+
+            if (metrics.count > 0) {
+                budgetViolations += rdmpeg_benchmark_budgets_check(&budgets, path, pass->name, &metrics, &json);
+            }
+            rdmpeg_benchmark_json_end_object(&json);
+        }
+
+        rdmpeg_benchmark_json_end_object(&json);
+        rdmpeg_benchmark_json_end_object(&json);
+    }
+
+    rdmpeg_benchmark_json_end_array(&json);
+    rdmpeg_benchmark_json_int(&json, "peak_rss_bytes", peakRSS);
+    rdmpeg_benchmark_json_int(&json, "heap_in_use_bytes", rdmpeg_benchmark_heap_in_use());
+    rdmpeg_benchmark_json_int(&json, "failures", failures);
+    rdmpeg_benchmark_json_int(&json, "budget_violations", (int64_t)budgetViolations);
+    rdmpeg_benchmark_json_end_object(&json);
+
+    if (output != stdout) {
+        fclose(output);
+    }
+
+    rdmpeg_benchmark_budgets_free(&budgets);
+    corpus_free(&corpus);
+
+    return failures > 0 || budgetViolations > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+
+// MARK: - Passes
+
+static int run_open_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics) {
+    RDMPEGBenchmarkSamples latencies = {0};
+    int status = 0;
+
+    for (int i = 0; i < options->openIterations; i++) {
+        RDMPEGBenchmarkMedia media = {0};
+
+        double startTime = rdmpeg_benchmark_now();
+        status = rdmpeg_benchmark_media_open(&media, path, RDMPEG_BENCHMARK_MEDIA_VIDEO | RDMPEG_BENCHMARK_MEDIA_AUDIO);
+        double openTime = rdmpeg_benchmark_now() - startTime;
+
+        if (status < 0) {
+            break;
+        }
+
+        rdmpeg_benchmark_samples_add(&latencies, openTime);
+        rdmpeg_benchmark_media_close(&media);
+    }
+
+    if (status < 0) {
+        write_error(json, status);
+    }
+    else {
+        rdmpeg_benchmark_json_latency(json, "latency", &latencies);
+        rdmpeg_benchmark_metrics_set(metrics, "latency_p50_ms", rdmpeg_benchmark_samples_percentile(&latencies, 50) * 1000.0);
+        rdmpeg_benchmark_metrics_set(metrics, "latency_max_ms", rdmpeg_benchmark_samples_percentile(&latencies, 100) * 1000.0);
+    }
+
+    rdmpeg_benchmark_samples_free(&latencies);
+
+    return status;
+}
+
+static int run_decode_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics) {
+    return run_decode_to_null(path, RDMPEG_BENCHMARK_MEDIA_VIDEO | RDMPEG_BENCHMARK_MEDIA_AUDIO, options, json, metrics);
+}
+
+static int run_audio_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics) {
+    return run_decode_to_null(path, RDMPEG_BENCHMARK_MEDIA_AUDIO, options, json, metrics);
+}
+
+static int run_seek_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics) {
+    RDMPEGBenchmarkMedia media = {.deinterlace = options->deinterlace};
+
+    int status = rdmpeg_benchmark_media_open(&media, path, RDMPEG_BENCHMARK_MEDIA_VIDEO | RDMPEG_BENCHMARK_MEDIA_AUDIO);
+    if (status < 0) {
+        write_error(json, status);
+        return status;
+    }
+
+    double duration = rdmpeg_benchmark_media_duration(&media);
+    if (duration <= 0.0) {
+        rdmpeg_benchmark_media_close(&media);
+        write_error(json, AVERROR(ERANGE));
+        return AVERROR(ERANGE);
+    }
+
+    int primaryFrameType = media.videoStreamIndex >= 0 ? RDMPEGBenchmarkFrameTypeVideo : RDMPEGBenchmarkFrameTypeAudio;
+    RDMPEGBenchmarkSamples latencies = {0};
+    RDMPEGBenchmarkSamples errors = {0};
+    int failedSeeks = 0;
+
+    // Deterministic pseudo random positions (LCG), so runs with the same seed are comparable
+    uint32_t state = options->seed;
+
+    for (int i = 0; i < options->seekCount; i++) {
+        state = state * 1664525u + 1013904223u;
+        double target = duration * 0.95 * ((double)state / (double)UINT32_MAX);
+
+        double startTime = rdmpeg_benchmark_now();
+        status = rdmpeg_benchmark_media_seek(&media, target);
+
+        double position = 0.0;
+        int frameType = RDMPEGBenchmarkFrameTypeNone;
+        if (status >= 0) {
+            do {
+                frameType = rdmpeg_benchmark_media_next_frame(&media, &position);
+            } while (frameType > 0 && frameType != primaryFrameType);
+        }
+
+        if (frameType != primaryFrameType) {
+            failedSeeks++;
+            continue;
+        }
+
+        rdmpeg_benchmark_samples_add(&latencies, rdmpeg_benchmark_now() - startTime);
+        rdmpeg_benchmark_samples_add(&errors, position > target ? position - target : target - position);
+    }
+
+    rdmpeg_benchmark_json_double(json, "duration_s", duration);
+    rdmpeg_benchmark_json_int(json, "failed", failedSeeks);
+    rdmpeg_benchmark_json_latency(json, "latency", &latencies);
+    rdmpeg_benchmark_json_latency(json, "position_error", &errors);
+
+    rdmpeg_benchmark_metrics_set(metrics, "failed", failedSeeks);
+    rdmpeg_benchmark_metrics_set(metrics, "latency_p50_ms", rdmpeg_benchmark_samples_percentile(&latencies, 50) * 1000.0);
+    rdmpeg_benchmark_metrics_set(metrics, "latency_p90_ms", rdmpeg_benchmark_samples_percentile(&latencies, 90) * 1000.0);
+    rdmpeg_benchmark_metrics_set(metrics, "latency_p99_ms", rdmpeg_benchmark_samples_percentile(&latencies, 99) * 1000.0);
+    rdmpeg_benchmark_metrics_set(metrics, "position_error_p90_ms", rdmpeg_benchmark_samples_percentile(&errors, 90) * 1000.0);
+
+    rdmpeg_benchmark_samples_free(&latencies);
+    rdmpeg_benchmark_samples_free(&errors);
+    rdmpeg_benchmark_media_close(&media);
+
+    return failedSeeks == options->seekCount ? AVERROR(EIO) : 0;
+}
+
+// Plays video backwards from the end with RDMPEGReverseDecoder segment algorithm, so reverse playback is measured
+// on Linux too: GOP is decoded from its keyframe, frames before the keyframe (open GOP leading frames) are skipped,
+// frames closest to the segment end which fit the half of the budget are handed out in descending order and the
+// rest is decoded again from the same keyframe. Frames aren't kept, segment holds only their positions, the cost
+// is in decoding frames more than once. Tools/RDMPEGReverseBenchmark runs the decoder itself on macOS.
+static int run_reverse_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics) {
+    RDMPEGBenchmarkMedia media = {.deinterlace = options->deinterlace};
+
+    int status = rdmpeg_benchmark_media_open(&media, path, RDMPEG_BENCHMARK_MEDIA_VIDEO);
+    if (status == AVERROR_STREAM_NOT_FOUND) {
+        rdmpeg_benchmark_json_string(json, "skipped", "no video stream");
+        return 0;
+    }
+    if (status < 0) {
+        write_error(json, status);
+        return status;
+    }
+
+    double duration = rdmpeg_benchmark_media_duration(&media);
+    if (duration <= 0.0) {
+        rdmpeg_benchmark_media_close(&media);
+        write_error(json, AVERROR(ERANGE));
+        return AVERROR(ERANGE);
+    }
+
+    // Byte size of RDMPEGVideoFrame data: YUV planes or BGRA
+    int64_t frameBytes = (int64_t)media.videoCodecContext->width * media.videoCodecContext->height;
+    frameBytes = media.videoFrameYUV ? frameBytes * 3 / 2 : frameBytes * 4;
+
+    // Segment keeps at least one frame, as the decoder does
+    int64_t segmentFramesLimit = frameBytes > 0 ? options->reverseByteBudget / 2 / frameBytes : 0;
+    segmentFramesLimit = segmentFramesLimit > 0 ? segmentFramesLimit : 1;
+
+    // Ring of the last positions of the segment
+    double *segmentPositions = malloc((size_t)segmentFramesLimit * sizeof(double));
+    RDMPEGBenchmarkSamples gopLengths = {0};
+    int64_t framesCount = 0;
+    int64_t decodedFramesCount = 0;
+    int64_t segmentsCount = 0;
+    int64_t outOfOrderFramesCount = 0;
+    double lastPosition = INFINITY;
+
+    double endPosition = duration;
+    double keyframeSearchPosition = duration - RDMPEG_BENCHMARK_KEYFRAME_SEARCH_STEP;
+    double keyframeSearchStep = RDMPEG_BENCHMARK_KEYFRAME_SEARCH_STEP;
+    int isGOPStart = 1;
+
+    double startTime = rdmpeg_benchmark_now();
+
+    while (options->maxFrames == 0 || framesCount < options->maxFrames) {
+        status = rdmpeg_benchmark_media_seek_keyframe(&media, keyframeSearchPosition > 0.0 ? keyframeSearchPosition : 0.0);
+        if (status < 0) {
+            break;
+        }
+
+        double keyframePosition = 0.0;
+        int keyframeFound = 0;
+        int64_t segmentFramesCount = 0;
+
+        while (1) {
+            double position = 0.0;
+            status = rdmpeg_benchmark_media_next_frame(&media, &position);
+            if (status <= 0) {
+                break;
+            }
+
+            decodedFramesCount++;
+
+            if (keyframeFound == 0) {
+                // Leading frames of open GOP come out before the keyframe and belong to the previous segment
+                if (media.videoFrameKeyframe == 0) {
+                    continue;
+                }
+
+                keyframePosition = position;
+                keyframeFound = 1;
+            }
+
+            if (position >= endPosition) {
+                break;
+            }
+
+            segmentPositions[segmentFramesCount % segmentFramesLimit] = position;
+            segmentFramesCount++;
+        }
+
+        if (status < 0) {
+            break;
+        }
+
+        if (segmentFramesCount == 0) {
+            // Timestamp rounding landed on the keyframe which starts the next segment, or there is no video
+            if (keyframeSearchPosition <= 0.0) {
+                status = 0;
+                break;
+            }
+
+            keyframeSearchPosition -= keyframeSearchStep;
+            keyframeSearchStep *= 2.0;
+            continue;
+        }
+
+        if (isGOPStart) {
+            rdmpeg_benchmark_samples_add(&gopLengths, (double)segmentFramesCount);
+        }
+
+        segmentsCount++;
+
+        int isSplit = segmentFramesCount > segmentFramesLimit;
+        int64_t keptFramesCount = isSplit ? segmentFramesLimit : segmentFramesCount;
+
+        // Kept frames are handed out from the newest one
+        for (int64_t i = 1; i <= keptFramesCount; i++) {
+            double position = segmentPositions[(segmentFramesCount - i) % segmentFramesLimit];
+
+            if (position >= lastPosition) {
+                outOfOrderFramesCount++;
+            }
+
+            lastPosition = position;
+        }
+
+        framesCount += keptFramesCount;
+
+        if (isSplit) {
+            // Oldest kept position ends the part decoded again from the same keyframe
+            endPosition = segmentPositions[segmentFramesCount % segmentFramesLimit];
+            isGOPStart = 0;
+        }
+        else {
+            endPosition = keyframePosition;
+            keyframeSearchPosition = keyframePosition - RDMPEG_BENCHMARK_KEYFRAME_SEARCH_STEP;
+            isGOPStart = 1;
+        }
+
+        keyframeSearchStep = RDMPEG_BENCHMARK_KEYFRAME_SEARCH_STEP;
+    }
+
+    double wallTime = rdmpeg_benchmark_now() - startTime;
+    double reverseFPS = wallTime > 0.0 ? framesCount / wallTime : 0.0;
+    double decodeRatio = framesCount > 0 ? (double)decodedFramesCount / framesCount : 0.0;
+    double gopFramesMax = rdmpeg_benchmark_samples_percentile(&gopLengths, 100);
+
+    if (status < 0) {
+        write_error(json, status);
+    }
+
+    rdmpeg_benchmark_json_double(json, "wall_s", wallTime);
+    rdmpeg_benchmark_json_int(json, "byte_budget", options->reverseByteBudget);
+    rdmpeg_benchmark_json_int(json, "segment_frames_limit", segmentFramesLimit);
+    rdmpeg_benchmark_json_int(json, "gops", (int64_t)gopLengths.count);
+    rdmpeg_benchmark_json_double(json, "gop_frames_p50", rdmpeg_benchmark_samples_percentile(&gopLengths, 50));
+    rdmpeg_benchmark_json_double(json, "gop_frames_max", gopFramesMax);
+    rdmpeg_benchmark_json_int(json, "segments", segmentsCount);
+    rdmpeg_benchmark_json_int(json, "video_frames", framesCount);
+    rdmpeg_benchmark_json_int(json, "decoded_frames", decodedFramesCount);
+    rdmpeg_benchmark_json_int(json, "out_of_order_frames", outOfOrderFramesCount);
+    rdmpeg_benchmark_json_double(json, "decode_ratio", decodeRatio);
+    rdmpeg_benchmark_json_double(json, "reverse_fps", reverseFPS);
+
+    rdmpeg_benchmark_metrics_set(metrics, "reverse_fps", reverseFPS);
+    rdmpeg_benchmark_metrics_set(metrics, "decode_ratio", decodeRatio);
+    rdmpeg_benchmark_metrics_set(metrics, "gop_frames_max", gopFramesMax);
+    rdmpeg_benchmark_metrics_set(metrics, "out_of_order_frames", (double)outOfOrderFramesCount);
+
+    free(segmentPositions);
+    rdmpeg_benchmark_samples_free(&gopLengths);
+    rdmpeg_benchmark_media_close(&media);
+
+    return status < 0 ? status : 0;
+}
+
+// Decodes audio once per resampler profile, resampling to 48 kHz (44.1 kHz for 48 kHz input, so rate is always
+// converted) and measures time spent in resampler. Quality of the profile at the same rates is measured with tones.
+static int run_resampler_pass(const char *path, const RDMPEGBenchmarkOptions *options, RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics) {
+    RDMPEGBenchmarkMedia media = {0};
+
+    int status = rdmpeg_benchmark_media_open(&media, path, RDMPEG_BENCHMARK_MEDIA_AUDIO);
+    if (status == AVERROR_STREAM_NOT_FOUND) {
+        rdmpeg_benchmark_json_string(json, "skipped", "no audio stream");
+        return 0;
+    }
+    if (status < 0) {
+        write_error(json, status);
+        return status;
+    }
+
+    int inputSampleRate = media.audioCodecContext->sample_rate;
+    int outputSampleRate = inputSampleRate == 48000 ? 44100 : 48000;
+    rdmpeg_benchmark_media_close(&media);
+
+    rdmpeg_benchmark_json_int(json, "input_sample_rate", inputSampleRate);
+    rdmpeg_benchmark_json_int(json, "output_sample_rate", outputSampleRate);
+    rdmpeg_benchmark_json_begin_object(json, "profiles");
+
+    for (size_t passIndex = 0; passIndex < RDMPEG_BENCHMARK_RESAMPLER_PASSES_COUNT && status >= 0; passIndex++) {
+        const RDMPEGBenchmarkResamplerPass *pass = &resampler_passes[passIndex];
+
+        media = (RDMPEGBenchmarkMedia){0};
+        media.resamplerProfile = pass->profile;
+        media.outputSampleRate = outputSampleRate;
+
+        status = rdmpeg_benchmark_media_open(&media, path, RDMPEG_BENCHMARK_MEDIA_AUDIO);
+        if (status < 0) {
+            break;
+        }
+
+        double lastPosition = 0.0;
+        int64_t framesCount = 0;
+
+        while (options->maxFrames == 0 || framesCount < options->maxFrames) {
+            double position = 0.0;
+            status = rdmpeg_benchmark_media_next_frame(&media, &position);
+            if (status <= 0) {
+                break;
+            }
+
+            lastPosition = position > lastPosition ? position : lastPosition;
+            framesCount++;
+        }
+
+        double resampleTime = media.resampleTime;
+        rdmpeg_benchmark_media_close(&media);
+
+        if (status < 0) {
+            break;
+        }
+
+        RDMPEGBenchmarkResamplerQuality quality = {0};
+        status = rdmpeg_benchmark_resampler_quality(pass->profile, inputSampleRate, outputSampleRate, &quality);
+        if (status < 0) {
+            break;
+        }
+
+        double realtimeFactor = resampleTime > 0.0 ? lastPosition / resampleTime : 0.0;
+
+        rdmpeg_benchmark_json_begin_object(json, pass->profile->name);
+        rdmpeg_benchmark_json_double(json, "resample_s", resampleTime);
+        rdmpeg_benchmark_json_double(json, "media_s", lastPosition);
+        rdmpeg_benchmark_json_double(json, "realtime_factor", realtimeFactor);
+        rdmpeg_benchmark_json_double(json, "snr_1k_db", quality.lowToneSNR);
+        rdmpeg_benchmark_json_double(json, "hf_frequency", quality.highToneFrequency);
+        rdmpeg_benchmark_json_double(json, "hf_gain_db", quality.highToneGain);
+        rdmpeg_benchmark_json_double(json, "hf_snr_db", quality.highToneSNR);
+        if (isnan(quality.aliasLevel) == 0) {
+            rdmpeg_benchmark_json_double(json, "alias_db", quality.aliasLevel);
+        }
+        rdmpeg_benchmark_json_end_object(json);
+
+        rdmpeg_benchmark_metrics_set(metrics, pass->realtimeFactorMetric, realtimeFactor);
+        rdmpeg_benchmark_metrics_set(metrics, pass->lowToneSNRMetric, quality.lowToneSNR);
+        rdmpeg_benchmark_metrics_set(metrics, pass->highToneGainMetric, quality.highToneGain);
+    }
+
+    rdmpeg_benchmark_json_end_object(json);
+
+    if (status < 0) {
+        write_error(json, status);
+    }
+
+    return status < 0 ? status : 0;
+}
+
+static int run_decode_to_null(const char *path,
+                              int streams,
+                              const RDMPEGBenchmarkOptions *options,
+                              RDMPEGBenchmarkJSON *json,
+                              RDMPEGBenchmarkMetrics *metrics) {
+    RDMPEGBenchmarkMedia media = {.deinterlace = options->deinterlace};
+
+    int status = rdmpeg_benchmark_media_open(&media, path, streams);
+    if (status == AVERROR_STREAM_NOT_FOUND && streams == RDMPEG_BENCHMARK_MEDIA_AUDIO) {
+        rdmpeg_benchmark_json_string(json, "skipped", "no audio stream");
+        return 0;
+    }
+    if (status < 0) {
+        write_error(json, status);
+        return status;
+    }
+
+    RDMPEGBenchmarkSamples videoLatencies = {0};
+    RDMPEGBenchmarkSamples audioLatencies = {0};
+    double lastPosition = 0.0;
+    int64_t framesCount = 0;
+
+    double startTime = rdmpeg_benchmark_now();
+    double frameStartTime = startTime;
+
+    while (options->maxFrames == 0 || framesCount < options->maxFrames) {
+        double position = 0.0;
+        status = rdmpeg_benchmark_media_next_frame(&media, &position);
+        if (status <= 0) {
+            break;
+        }
+
+        double frameEndTime = rdmpeg_benchmark_now();
+        rdmpeg_benchmark_samples_add(status == RDMPEGBenchmarkFrameTypeVideo ? &videoLatencies : &audioLatencies,
+                                     frameEndTime - frameStartTime);
+        frameStartTime = frameEndTime;
+
+        lastPosition = position > lastPosition ? position : lastPosition;
+        framesCount++;
+    }
+
+    double wallTime = rdmpeg_benchmark_now() - startTime;
+    double realtimeFactor = wallTime > 0.0 ? lastPosition / wallTime : 0.0;
+    double videoFPS = wallTime > 0.0 ? videoLatencies.count / wallTime : 0.0;
+
+    if (status < 0) {
+        write_error(json, status);
+    }
+
+    rdmpeg_benchmark_json_double(json, "wall_s", wallTime);
+    rdmpeg_benchmark_json_double(json, "media_s", lastPosition);
+    rdmpeg_benchmark_json_double(json, "realtime_factor", realtimeFactor);
+    rdmpeg_benchmark_json_int(json, "video_frames", (int64_t)videoLatencies.count);
+    rdmpeg_benchmark_json_int(json, "audio_frames", (int64_t)audioLatencies.count);
+    rdmpeg_benchmark_json_double(json, "video_fps", videoFPS);
+    rdmpeg_benchmark_json_int(json, "bytes_copied", (int64_t)media.bytesCopied);
+    if (options->deinterlace) {
+        rdmpeg_benchmark_json_int(json, "frames_deinterlaced", (int64_t)media.framesDeinterlaced);
+    }
+    rdmpeg_benchmark_json_latency(json, "video_frame_latency", &videoLatencies);
+    rdmpeg_benchmark_json_latency(json, "audio_frame_latency", &audioLatencies);
+
+    rdmpeg_benchmark_metrics_set(metrics, "realtime_factor", realtimeFactor);
+    rdmpeg_benchmark_metrics_set(metrics, "media_s", lastPosition);
+    rdmpeg_benchmark_metrics_set(metrics, "video_fps", videoFPS);
+    rdmpeg_benchmark_metrics_set(metrics, "video_frame_latency_p99_ms", rdmpeg_benchmark_samples_percentile(&videoLatencies, 99) * 1000.0);
+    rdmpeg_benchmark_metrics_set(metrics, "audio_frame_latency_p99_ms", rdmpeg_benchmark_samples_percentile(&audioLatencies, 99) * 1000.0);
+
+    rdmpeg_benchmark_samples_free(&videoLatencies);
+    rdmpeg_benchmark_samples_free(&audioLatencies);
+    rdmpeg_benchmark_media_close(&media);
+
+    return status < 0 ? status : 0;
+}
+
+static void write_error(RDMPEGBenchmarkJSON *json, int status) {
+    char description[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(status, description, sizeof(description));
+    rdmpeg_benchmark_json_string(json, "error", description);
+}
+
+// Heap peak is counted from what was in use when pass started, so it's what the pass itself needed on top
+static void write_memory(RDMPEGBenchmarkJSON *json, RDMPEGBenchmarkMetrics *metrics, int isRSSPerPass) {
+    RDMPEGBenchmarkAllocations allocations;
+    rdmpeg_benchmark_allocations_get(&allocations);
+
+    rdmpeg_benchmark_json_int(json, "allocations", allocations.count);
+    rdmpeg_benchmark_json_int(json, "peak_heap_bytes", allocations.peakBytes);
+    rdmpeg_benchmark_json_int(json, "heap_in_use_bytes", allocations.bytesInUse);
+    rdmpeg_benchmark_json_int(json, "peak_rss_bytes", rdmpeg_benchmark_peak_rss());
+    rdmpeg_benchmark_json_string(json, "peak_rss_scope", isRSSPerPass ? "pass" : "process");
+
+    if (allocations.count >= 0) {
+        rdmpeg_benchmark_metrics_set(metrics, "allocations", (double)allocations.count);
+        rdmpeg_benchmark_metrics_set(metrics, "peak_heap_mb", allocations.peakBytes / (1024.0 * 1024.0));
+    }
+}
+
+
+
+// MARK: - Arguments
+
+static unsigned int parse_passes(const char *list) {
+    unsigned int passes = 0;
+    char *listCopy = strdup(list);
+    char *context = NULL;
+
+    for (char *name = strtok_r(listCopy, ",", &context); name; name = strtok_r(NULL, ",", &context)) {
+        size_t passIndex = 0;
+        while (passIndex < RDMPEG_BENCHMARK_PASSES_COUNT && strcmp(benchmark_passes[passIndex].name, name) != 0) {
+            passIndex++;
+        }
+
+        if (passIndex == RDMPEG_BENCHMARK_PASSES_COUNT) {
+            fprintf(stderr, "Unknown pass: %s\n", name);
+            free(listCopy);
+            return 0;
+        }
+
+        passes |= 1u << passIndex;
+    }
+
+    free(listCopy);
+    return passes;
+}
+
+static void corpus_add_path(RDMPEGBenchmarkCorpus *corpus, const char *path) {
+    struct stat pathStat;
+    if (stat(path, &pathStat) != 0) {
+        perror(path);
+        return;
+    }
+
+    if (S_ISDIR(pathStat.st_mode) == 0) {
+        if (corpus->count == corpus->capacity) {
+            corpus->capacity = corpus->capacity > 0 ? corpus->capacity * 2 : 16;
+            corpus->paths = realloc(corpus->paths, corpus->capacity * sizeof(char *));
+        }
+        corpus->paths[corpus->count++] = strdup(path);
+        return;
+    }
+
+    DIR *directory = opendir(path);
+    if (directory == NULL) {
+        perror(path);
+        return;
+    }
+
+    // Directory entries are sorted so reports of the same corpus are always in the same order
+    size_t firstIndex = corpus->count;
+    struct dirent *entry;
+
+    while ((entry = readdir(directory))) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        size_t length = strlen(path) + strlen(entry->d_name) + 2;
+        char *entryPath = malloc(length);
+        snprintf(entryPath, length, "%s/%s", path, entry->d_name);
+
+        struct stat entryStat;
+        if (stat(entryPath, &entryStat) == 0 && S_ISREG(entryStat.st_mode)) {
+            corpus_add_path(corpus, entryPath);
+        }
+
+        free(entryPath);
+    }
+
+    closedir(directory);
+
+    qsort(corpus->paths + firstIndex, corpus->count - firstIndex, sizeof(char *), compare_strings);
+}
+
+static void corpus_free(RDMPEGBenchmarkCorpus *corpus) {
+    for (size_t i = 0; i < corpus->count; i++) {
+        free(corpus->paths[i]);
+    }
+    free(corpus->paths);
+}
+
+static int compare_strings(const void *lhs, const void *rhs) {
+    return strcmp(*(char * const *)lhs, *(char * const *)rhs);
+}
+
+static void print_usage(const char *executable) {
+    fprintf(stderr,
+            "Usage: %s [options] <file or directory>...\n"
+            "\n"
+            "Options:\n"
+            "  -p, --passes LIST          comma separated passes: open,decode,seek,audio,reverse,resampler (default: all)\n"
+            "  -i, --open-iterations N    number of open latency measurements (default: 5)\n"
+            "  -s, --seeks N              number of seeks in seek storm (default: 50)\n"
+            "  -r, --seed N               seed for seek positions (default: 1)\n"
+            "  -m, --max-frames N         stop decode passes after N frames (default: unlimited)\n"
+            "  -c, --reverse-budget MB    RDMPEGReverseDecoder byteBudget of reverse pass (default: 128)\n"
+            "  -d, --deinterlace          deinterlace interlaced video, as RDMPEGDecoder isDeinterlacingEnabled\n"
+            "  -o, --output FILE          write JSON report to FILE instead of stdout\n"
+            "  -b, --budgets FILE         check pass metrics against budgets in FILE, exit with failure on violation\n"
+            "  -v, --verbose              keep libav info logging\n",
+            executable);
+}
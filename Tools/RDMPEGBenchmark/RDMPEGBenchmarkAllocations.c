@@ -0,0 +1,281 @@
+//
+//  RDMPEGBenchmarkAllocations.c
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGBenchmarkAllocations.h"
+#include <errno.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#include <mach/mach.h>
+#endif
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#define RDMPEG_BENCHMARK_ALLOCATIONS_TRACKED 1
+#else
+#define RDMPEG_BENCHMARK_ALLOCATIONS_TRACKED 0
+#endif
+
+static _Atomic int64_t allocations_count;
+static _Atomic int64_t allocations_bytes_in_use;
+static _Atomic int64_t allocations_peak_bytes;
+
+static void allocations_record_allocation(size_t size);
+static void allocations_record_free(size_t size);
+
+
+
+void rdmpeg_benchmark_allocations_reset(void) {
+    atomic_store_explicit(&allocations_count, 0, memory_order_relaxed);
+    atomic_store_explicit(&allocations_peak_bytes,
+                          atomic_load_explicit(&allocations_bytes_in_use, memory_order_relaxed),
+                          memory_order_relaxed);
+}
+
+void rdmpeg_benchmark_allocations_get(RDMPEGBenchmarkAllocations *allocations) {
+    if (RDMPEG_BENCHMARK_ALLOCATIONS_TRACKED == 0) {
+        allocations->count = -1;
+        allocations->bytesInUse = -1;
+        allocations->peakBytes = -1;
+        return;
+    }
+
+    allocations->count = atomic_load_explicit(&allocations_count, memory_order_relaxed);
+    allocations->bytesInUse = atomic_load_explicit(&allocations_bytes_in_use, memory_order_relaxed);
+    allocations->peakBytes = atomic_load_explicit(&allocations_peak_bytes, memory_order_relaxed);
+}
+
+static void allocations_record_allocation(size_t size) {
+    atomic_fetch_add_explicit(&allocations_count, 1, memory_order_relaxed);
+
+    int64_t bytesInUse = atomic_fetch_add_explicit(&allocations_bytes_in_use, (int64_t)size, memory_order_relaxed);
+    bytesInUse += (int64_t)size;
+
+    int64_t peakBytes = atomic_load_explicit(&allocations_peak_bytes, memory_order_relaxed);
+    while (bytesInUse > peakBytes &&
+           atomic_compare_exchange_weak_explicit(&allocations_peak_bytes,
+                                                 &peakBytes,
+                                                 bytesInUse,
+                                                 memory_order_relaxed,
+                                                 memory_order_relaxed) == 0) {
+    }
+}
+
+static void allocations_record_free(size_t size) {
+    atomic_fetch_sub_explicit(&allocations_bytes_in_use, (int64_t)size, memory_order_relaxed);
+}
+
+
+
+#if defined(__GLIBC__)
+
+// MARK: - glibc
+
+// glibc supports replacing its allocator in the executable, these forward to the original one
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+extern void __libc_free(void *pointer);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+
+static void *allocations_recorded(void *pointer);
+
+void rdmpeg_benchmark_allocations_start(void) {
+}
+
+void *malloc(size_t size) {
+    return allocations_recorded(__libc_malloc(size));
+}
+
+void *calloc(size_t count, size_t size) {
+    return allocations_recorded(__libc_calloc(count, size));
+}
+
+void *realloc(void *pointer, size_t size) {
+    size_t previousSize = pointer ? malloc_usable_size(pointer) : 0;
+    void *reallocatedPointer = __libc_realloc(pointer, size);
+
+    // Block is kept when reallocation fails, and freed when it's resized to zero
+    if (reallocatedPointer || (pointer && size == 0)) {
+        allocations_record_free(previousSize);
+    }
+
+    return allocations_recorded(reallocatedPointer);
+}
+
+void *reallocarray(void *pointer, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    return realloc(pointer, count * size);
+}
+
+void free(void *pointer) {
+    if (pointer) {
+        allocations_record_free(malloc_usable_size(pointer));
+    }
+
+    __libc_free(pointer);
+}
+
+void *memalign(size_t alignment, size_t size) {
+    return allocations_recorded(__libc_memalign(alignment, size));
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    return allocations_recorded(__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void **pointer, size_t alignment, size_t size) {
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+
+    void *alignedPointer = allocations_recorded(__libc_memalign(alignment, size));
+    if (alignedPointer == NULL) {
+        return ENOMEM;
+    }
+
+    *pointer = alignedPointer;
+    return 0;
+}
+
+void *valloc(size_t size) {
+    return allocations_recorded(__libc_valloc(size));
+}
+
+void *pvalloc(size_t size) {
+    return allocations_recorded(__libc_pvalloc(size));
+}
+
+static void *allocations_recorded(void *pointer) {
+    if (pointer) {
+        allocations_record_allocation(malloc_usable_size(pointer));
+    }
+
+    return pointer;
+}
+
+#elif defined(__APPLE__)
+
+// MARK: - macOS
+
+// Functions of the zone malloc() uses are replaced, the original ones are called by wrappers
+
+static malloc_zone_t allocations_original_zone;
+
+static void *allocations_zone_recorded(malloc_zone_t *zone, void *pointer);
+static void *allocations_zone_malloc(malloc_zone_t *zone, size_t size);
+static void *allocations_zone_calloc(malloc_zone_t *zone, size_t count, size_t size);
+static void *allocations_zone_valloc(malloc_zone_t *zone, size_t size);
+static void *allocations_zone_realloc(malloc_zone_t *zone, void *pointer, size_t size);
+static void *allocations_zone_memalign(malloc_zone_t *zone, size_t alignment, size_t size);
+static void allocations_zone_free(malloc_zone_t *zone, void *pointer);
+static void allocations_zone_free_definite_size(malloc_zone_t *zone, void *pointer, size_t size);
+
+void rdmpeg_benchmark_allocations_start(void) {
+    vm_address_t *zones = NULL;
+    unsigned int zonesCount = 0;
+
+    if (allocations_original_zone.malloc ||
+        malloc_get_all_zones(mach_task_self(), NULL, &zones, &zonesCount) != KERN_SUCCESS ||
+        zonesCount == 0) {
+        return;
+    }
+
+    malloc_zone_t *zone = (malloc_zone_t *)zones[0];
+    allocations_original_zone = *zone;
+
+    vm_address_t page = trunc_page((vm_address_t)zone);
+    vm_size_t length = round_page((vm_address_t)zone + sizeof(*zone)) - page;
+
+    if (vm_protect(mach_task_self(), page, length, 0, VM_PROT_READ | VM_PROT_WRITE) != KERN_SUCCESS) {
+        return;
+    }
+
+    zone->malloc = allocations_zone_malloc;
+    zone->calloc = allocations_zone_calloc;
+    zone->valloc = allocations_zone_valloc;
+    zone->realloc = allocations_zone_realloc;
+    zone->free = allocations_zone_free;
+
+    if (zone->version >= 5) {
+        zone->memalign = allocations_zone_memalign;
+    }
+    if (zone->version >= 6) {
+        zone->free_definite_size = allocations_zone_free_definite_size;
+    }
+
+    vm_protect(mach_task_self(), page, length, 0, VM_PROT_READ);
+}
+
+static void *allocations_zone_malloc(malloc_zone_t *zone, size_t size) {
+    return allocations_zone_recorded(zone, allocations_original_zone.malloc(zone, size));
+}
+
+static void *allocations_zone_calloc(malloc_zone_t *zone, size_t count, size_t size) {
+    return allocations_zone_recorded(zone, allocations_original_zone.calloc(zone, count, size));
+}
+
+static void *allocations_zone_valloc(malloc_zone_t *zone, size_t size) {
+    return allocations_zone_recorded(zone, allocations_original_zone.valloc(zone, size));
+}
+
+static void *allocations_zone_realloc(malloc_zone_t *zone, void *pointer, size_t size) {
+    size_t previousSize = pointer ? allocations_original_zone.size(zone, pointer) : 0;
+    void *reallocatedPointer = allocations_original_zone.realloc(zone, pointer, size);
+
+    if (reallocatedPointer) {
+        allocations_record_free(previousSize);
+    }
+
+    return allocations_zone_recorded(zone, reallocatedPointer);
+}
+
+static void *allocations_zone_memalign(malloc_zone_t *zone, size_t alignment, size_t size) {
+    return allocations_zone_recorded(zone, allocations_original_zone.memalign(zone, alignment, size));
+}
+
+static void allocations_zone_free(malloc_zone_t *zone, void *pointer) {
+    if (pointer) {
+        allocations_record_free(allocations_original_zone.size(zone, pointer));
+    }
+
+    allocations_original_zone.free(zone, pointer);
+}
+
+static void allocations_zone_free_definite_size(malloc_zone_t *zone, void *pointer, size_t size) {
+    if (pointer) {
+        allocations_record_free(allocations_original_zone.size(zone, pointer));
+    }
+
+    allocations_original_zone.free_definite_size(zone, pointer, size);
+}
+
+static void *allocations_zone_recorded(malloc_zone_t *zone, void *pointer) {
+    if (pointer) {
+        allocations_record_allocation(allocations_original_zone.size(zone, pointer));
+    }
+
+    return pointer;
+}
+
+#else
+
+void rdmpeg_benchmark_allocations_start(void) {
+}
+
+#endif
@@ -0,0 +1,32 @@
+//
+//  RDMPEGBenchmarkAllocations.h
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGBenchmarkAllocations_h
+#define RDMPEGBenchmarkAllocations_h
+
+#include <stdint.h>
+
+// Heap allocations of the whole process (libav* included), counted by replacing malloc family functions with
+// wrappers around glibc ones, or by hooking the default malloc zone on macOS. Values are -1 elsewhere.
+
+typedef struct RDMPEGBenchmarkAllocations {
+    // malloc, calloc, realloc and aligned allocations since the last reset
+    int64_t count;
+    // Heap bytes in use now and at most since the last reset, as malloc_usable_size reports them
+    int64_t bytesInUse;
+    int64_t peakBytes;
+} RDMPEGBenchmarkAllocations;
+
+// Installs the hooks where they need it, call before anything is measured
+void rdmpeg_benchmark_allocations_start(void);
+
+// Starts a new measurement: count is zeroed and peak is set to what is in use now
+void rdmpeg_benchmark_allocations_reset(void);
+
+void rdmpeg_benchmark_allocations_get(RDMPEGBenchmarkAllocations *allocations);
+
+#endif /* RDMPEGBenchmarkAllocations_h */
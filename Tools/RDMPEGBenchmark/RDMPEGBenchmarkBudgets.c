@@ -0,0 +1,166 @@
+//
+//  RDMPEGBenchmarkBudgets.c
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGBenchmarkBudgets.h"
+#include <fnmatch.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int metrics_find(const RDMPEGBenchmarkMetrics *metrics, const char *name, double *value);
+static const char *path_file_name(const char *path);
+
+
+
+void rdmpeg_benchmark_metrics_set(RDMPEGBenchmarkMetrics *metrics, const char *name, double value) {
+    for (size_t i = 0; i < metrics->count; i++) {
+        if (strcmp(metrics->names[i], name) == 0) {
+            metrics->values[i] = value;
+            return;
+        }
+    }
+
+    if (metrics->count < RDMPEG_BENCHMARK_METRICS_CAPACITY) {
+        metrics->names[metrics->count] = name;
+        metrics->values[metrics->count] = value;
+        metrics->count++;
+    }
+}
+
+int rdmpeg_benchmark_budgets_load(RDMPEGBenchmarkBudgets *budgets, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    char line[512];
+    int lineNumber = 0;
+    int status = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        lineNumber++;
+
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+
+        char pattern[128], pass[64], metric[64], operator[3];
+        double limit = 0.0;
+        int fieldsCount = sscanf(line, "%127s %63s %63s %2s %lf", pattern, pass, metric, operator, &limit);
+
+        if (fieldsCount <= 0) {
+            continue;
+        }
+
+        int isUpperBound = strcmp(operator, "<=") == 0;
+        if (fieldsCount != 5 || (isUpperBound == 0 && strcmp(operator, ">=") != 0)) {
+            fprintf(stderr, "%s:%d: expected \"<file pattern> <pass> <metric> <= | >= <limit>\"\n", path, lineNumber);
+            status = -1;
+            break;
+        }
+
+        if (budgets->count == budgets->capacity) {
+            budgets->capacity = budgets->capacity > 0 ? budgets->capacity * 2 : 16;
+            budgets->items = realloc(budgets->items, budgets->capacity * sizeof(RDMPEGBenchmarkBudget));
+        }
+
+        budgets->items[budgets->count++] = (RDMPEGBenchmarkBudget){
+            .pattern = strdup(pattern),
+            .pass = strdup(pass),
+            .metric = strdup(metric),
+            .isUpperBound = isUpperBound,
+            .limit = limit,
+        };
+    }
+
+    fclose(file);
+    return status;
+}
+
+void rdmpeg_benchmark_budgets_free(RDMPEGBenchmarkBudgets *budgets) {
+    for (size_t i = 0; i < budgets->count; i++) {
+        free(budgets->items[i].pattern);
+        free(budgets->items[i].pass);
+        free(budgets->items[i].metric);
+    }
+    free(budgets->items);
+    budgets->items = NULL;
+    budgets->count = 0;
+    budgets->capacity = 0;
+}
+
+size_t rdmpeg_benchmark_budgets_check(const RDMPEGBenchmarkBudgets *budgets,
+                                      const char *path,
+                                      const char *pass,
+                                      const RDMPEGBenchmarkMetrics *metrics,
+                                      RDMPEGBenchmarkJSON *json) {
+    const char *fileName = path_file_name(path);
+    size_t violationsCount = 0;
+    int hasArray = 0;
+
+    for (size_t i = 0; i < budgets->count; i++) {
+        const RDMPEGBenchmarkBudget *budget = &budgets->items[i];
+        if (strcmp(budget->pass, pass) != 0 || fnmatch(budget->pattern, fileName, 0) != 0) {
+            continue;
+        }
+
+        double value = 0.0;
+        int hasValue = metrics_find(metrics, budget->metric, &value);
+        int isMet = hasValue && (budget->isUpperBound ? value <= budget->limit : value >= budget->limit);
+
+        if (hasArray == 0) {
+            rdmpeg_benchmark_json_begin_array(json, "budgets");
+            hasArray = 1;
+        }
+
+        rdmpeg_benchmark_json_begin_object(json, NULL);
+        rdmpeg_benchmark_json_string(json, "metric", budget->metric);
+        rdmpeg_benchmark_json_string(json, "operator", budget->isUpperBound ? "<=" : ">=");
+        rdmpeg_benchmark_json_double(json, "limit", budget->limit);
+        if (hasValue) {
+            rdmpeg_benchmark_json_double(json, "value", value);
+        }
+        rdmpeg_benchmark_json_string(json, "verdict", isMet ? "met" : "violated");
+        rdmpeg_benchmark_json_end_object(json);
+
+        if (isMet == 0) {
+            violationsCount++;
+
+            if (hasValue) {
+                fprintf(stderr, "  budget violated: %s %s = %.3f, expected %s %.3f\n",
+                        pass, budget->metric, value, budget->isUpperBound ? "<=" : ">=", budget->limit);
+            }
+            else {
+                fprintf(stderr, "  budget violated: %s %s wasn't measured\n", pass, budget->metric);
+            }
+        }
+    }
+
+    if (hasArray) {
+        rdmpeg_benchmark_json_end_array(json);
+    }
+
+    return violationsCount;
+}
+
+
+
+static int metrics_find(const RDMPEGBenchmarkMetrics *metrics, const char *name, double *value) {
+    for (size_t i = 0; i < metrics->count; i++) {
+        if (strcmp(metrics->names[i], name) == 0) {
+            *value = metrics->values[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static const char *path_file_name(const char *path) {
+    const char *separator = strrchr(path, '/');
+    return separator ? separator + 1 : path;
+}
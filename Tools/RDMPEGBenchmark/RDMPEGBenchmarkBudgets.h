@@ -0,0 +1,53 @@
+//
+//  RDMPEGBenchmarkBudgets.h
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGBenchmarkBudgets_h
+#define RDMPEGBenchmarkBudgets_h
+
+#include <stddef.h>
+#include "RDMPEGBenchmarkReport.h"
+
+// Flat list of named values a pass produced, budgets are checked against them
+#define RDMPEG_BENCHMARK_METRICS_CAPACITY 16
+
+typedef struct RDMPEGBenchmarkMetrics {
+    const char *names[RDMPEG_BENCHMARK_METRICS_CAPACITY];
+    double values[RDMPEG_BENCHMARK_METRICS_CAPACITY];
+    size_t count;
+} RDMPEGBenchmarkMetrics;
+
+void rdmpeg_benchmark_metrics_set(RDMPEGBenchmarkMetrics *metrics, const char *name, double value);
+
+// Budget file is a list of lines "<file pattern> <pass> <metric> <= | >= <limit>", '#' starts a comment.
+// File pattern is fnmatch(3) pattern matched against file name without directory.
+typedef struct RDMPEGBenchmarkBudget {
+    char *pattern;
+    char *pass;
+    char *metric;
+    int isUpperBound;
+    double limit;
+} RDMPEGBenchmarkBudget;
+
+typedef struct RDMPEGBenchmarkBudgets {
+    RDMPEGBenchmarkBudget *items;
+    size_t count;
+    size_t capacity;
+} RDMPEGBenchmarkBudgets;
+
+// Returns 0 on success or -1, errors are printed to stderr
+int rdmpeg_benchmark_budgets_load(RDMPEGBenchmarkBudgets *budgets, const char *path);
+void rdmpeg_benchmark_budgets_free(RDMPEGBenchmarkBudgets *budgets);
+
+// Writes "budgets" array with every budget matching path and pass, returns number of violated ones.
+// Budget for metric missing from metrics counts as violated, so caller should skip passes that produced nothing.
+size_t rdmpeg_benchmark_budgets_check(const RDMPEGBenchmarkBudgets *budgets,
+                                      const char *path,
+                                      const char *pass,
+                                      const RDMPEGBenchmarkMetrics *metrics,
+                                      RDMPEGBenchmarkJSON *json);
+
+#endif /* RDMPEGBenchmarkBudgets_h */
@@ -0,0 +1,473 @@
+//
+//  RDMPEGBenchmarkMedia.c
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGBenchmarkMedia.h"
+#include "RDMPEGBenchmarkReport.h"
+#include <stdlib.h>
+#include <string.h>
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+
+static int open_codec(AVFormatContext *formatContext, int streamIndex, AVCodecContext **codecContext);
+static int setup_video_conversion(RDMPEGBenchmarkMedia *media);
+static int setup_audio_conversion(RDMPEGBenchmarkMedia *media);
+static int receive_deinterlaced_frame(RDMPEGBenchmarkMedia *media, double *position);
+static int handle_decoded_video_frame(RDMPEGBenchmarkMedia *media, double *position);
+static int handle_video_frame(RDMPEGBenchmarkMedia *media, AVFrame *frame, double *position);
+static int handle_audio_frame(RDMPEGBenchmarkMedia *media, double *position);
+static int copy_plane(RDMPEGBenchmarkMedia *media, const uint8_t *source, int linesize, int width, int height);
+static void reset_decoding(RDMPEGBenchmarkMedia *media);
+
+
+
+int rdmpeg_benchmark_media_open(RDMPEGBenchmarkMedia *media, const char *path, int streams) {
+    media->videoStreamIndex = -1;
+    media->audioStreamIndex = -1;
+
+    int status = avformat_open_input(&media->formatContext, path, NULL, NULL);
+    if (status < 0) {
+        return status;
+    }
+
+    status = avformat_find_stream_info(media->formatContext, NULL);
+    if (status < 0) {
+        rdmpeg_benchmark_media_close(media);
+        return status;
+    }
+
+    if (streams & RDMPEG_BENCHMARK_MEDIA_VIDEO) {
+        int streamIndex = av_find_best_stream(media->formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+        AVStream *stream = streamIndex >= 0 ? media->formatContext->streams[streamIndex] : NULL;
+
+        // Attached pictures are handled as artwork by RDMPEGDecoder, not as video
+        if (stream && (stream->disposition & AV_DISPOSITION_ATTACHED_PIC) == 0 &&
+            open_codec(media->formatContext, streamIndex, &media->videoCodecContext) == 0) {
+            media->videoStreamIndex = streamIndex;
+            rdmpeg_decode_core_stream_fps_timebase(stream, 0.04, NULL, &media->videoTimeBase);
+        }
+    }
+
+    if (streams & RDMPEG_BENCHMARK_MEDIA_AUDIO) {
+        int streamIndex = av_find_best_stream(media->formatContext, AVMEDIA_TYPE_AUDIO, -1, -1, NULL, 0);
+        if (streamIndex >= 0 && open_codec(media->formatContext, streamIndex, &media->audioCodecContext) == 0) {
+            media->audioStreamIndex = streamIndex;
+            rdmpeg_decode_core_stream_fps_timebase(media->formatContext->streams[streamIndex], 0.025, NULL,
+                                                   &media->audioTimeBase);
+        }
+    }
+
+    if (media->videoStreamIndex < 0 && media->audioStreamIndex < 0) {
+        rdmpeg_benchmark_media_close(media);
+        return AVERROR_STREAM_NOT_FOUND;
+    }
+
+    for (unsigned int i = 0; i < media->formatContext->nb_streams; i++) {
+        if ((int)i != media->videoStreamIndex && (int)i != media->audioStreamIndex) {
+            media->formatContext->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    media->packet = av_packet_alloc();
+    media->frame = av_frame_alloc();
+    if (media->packet == NULL || media->frame == NULL) {
+        rdmpeg_benchmark_media_close(media);
+        return AVERROR(ENOMEM);
+    }
+
+    if (media->videoCodecContext && (status = setup_video_conversion(media)) < 0) {
+        rdmpeg_benchmark_media_close(media);
+        return status;
+    }
+
+    if (media->audioCodecContext && (status = setup_audio_conversion(media)) < 0) {
+        rdmpeg_benchmark_media_close(media);
+        return status;
+    }
+
+    return 0;
+}
+
+void rdmpeg_benchmark_media_close(RDMPEGBenchmarkMedia *media) {
+    avcodec_free_context(&media->videoCodecContext);
+    avcodec_free_context(&media->audioCodecContext);
+    avformat_close_input(&media->formatContext);
+    av_packet_free(&media->packet);
+    av_frame_free(&media->frame);
+    sws_freeContext(media->swsContext);
+    rdmpeg_decode_core_bgra_frame_free(&media->bgraFrame);
+    avfilter_graph_free(&media->deinterlacer);
+    av_frame_free(&media->deinterlacedFrame);
+    swr_free(&media->swrContext);
+    free(media->swrBuffer);
+
+    memset(media, 0, sizeof(*media));
+    media->videoStreamIndex = -1;
+    media->audioStreamIndex = -1;
+}
+
+int rdmpeg_benchmark_media_next_frame(RDMPEGBenchmarkMedia *media, double *position) {
+    while (1) {
+        if (media->deinterlacerPending) {
+            int frameType = receive_deinterlaced_frame(media, position);
+            if (frameType != RDMPEGBenchmarkFrameTypeNone) {
+                return frameType;
+            }
+            continue;
+        }
+
+        if (media->pendingCodecContext) {
+            int status = avcodec_receive_frame(media->pendingCodecContext, media->frame);
+
+            if (status == 0) {
+                int frameType = media->pendingCodecContext == media->videoCodecContext ?
+                    handle_decoded_video_frame(media, position) :
+                    handle_audio_frame(media, position);
+
+                av_frame_unref(media->frame);
+
+                if (frameType != RDMPEGBenchmarkFrameTypeNone) {
+                    return frameType;
+                }
+                continue;
+            }
+
+            if (status != AVERROR(EAGAIN) && status != AVERROR_EOF) {
+                return status;
+            }
+
+            media->pendingCodecContext = NULL;
+        }
+
+        if (media->draining) {
+            // Flush decoders one by one once demuxer is exhausted
+            AVCodecContext *codecContexts[2] = {media->videoCodecContext, media->audioCodecContext};
+
+            while (media->drainIndex < 2 && codecContexts[media->drainIndex] == NULL) {
+                media->drainIndex++;
+            }
+
+            if (media->drainIndex >= 2) {
+                return RDMPEGBenchmarkFrameTypeNone;
+            }
+
+            avcodec_send_packet(codecContexts[media->drainIndex], NULL);
+            media->pendingCodecContext = codecContexts[media->drainIndex];
+            media->drainIndex++;
+            continue;
+        }
+
+        int status = av_read_frame(media->formatContext, media->packet);
+        if (status == AVERROR_EOF) {
+            media->draining = 1;
+            media->drainIndex = 0;
+            continue;
+        }
+        if (status < 0) {
+            return status;
+        }
+
+        AVCodecContext *codecContext = NULL;
+        if (media->packet->stream_index == media->videoStreamIndex) {
+            codecContext = media->videoCodecContext;
+        }
+        else if (media->packet->stream_index == media->audioStreamIndex) {
+            codecContext = media->audioCodecContext;
+        }
+
+        if (codecContext) {
+            status = avcodec_send_packet(codecContext, media->packet);
+            if (status >= 0) {
+                media->pendingCodecContext = codecContext;
+            }
+        }
+
+        av_packet_unref(media->packet);
+    }
+}
+
+int rdmpeg_benchmark_media_seek(RDMPEGBenchmarkMedia *media, double position) {
+    int status = media->videoStreamIndex >= 0 ?
+        rdmpeg_decode_core_seek(media->formatContext, media->videoStreamIndex, media->videoTimeBase, position) :
+        rdmpeg_decode_core_seek(media->formatContext, media->audioStreamIndex, media->audioTimeBase, position);
+
+    reset_decoding(media);
+
+    return status;
+}
+
+int rdmpeg_benchmark_media_seek_keyframe(RDMPEGBenchmarkMedia *media, double position) {
+    if (media->videoStreamIndex < 0) {
+        return rdmpeg_benchmark_media_seek(media, position);
+    }
+
+    int status = rdmpeg_decode_core_seek_keyframe(media->formatContext,
+                                                  media->videoStreamIndex,
+                                                  media->videoTimeBase,
+                                                  position);
+
+    reset_decoding(media);
+
+    return status;
+}
+
+double rdmpeg_benchmark_media_duration(const RDMPEGBenchmarkMedia *media) {
+    if (media->formatContext == NULL || media->formatContext->duration == AV_NOPTS_VALUE) {
+        return 0.0;
+    }
+
+    return (double)media->formatContext->duration / AV_TIME_BASE;
+}
+
+
+
+static int open_codec(AVFormatContext *formatContext, int streamIndex, AVCodecContext **codecContext) {
+    AVStream *stream = formatContext->streams[streamIndex];
+    const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (codec == NULL) {
+        return AVERROR_DECODER_NOT_FOUND;
+    }
+
+    *codecContext = avcodec_alloc_context3(codec);
+    if (*codecContext == NULL) {
+        return AVERROR(ENOMEM);
+    }
+
+    int status = avcodec_parameters_to_context(*codecContext, stream->codecpar);
+    if (status >= 0) {
+        (*codecContext)->pkt_timebase = stream->time_base;
+        status = avcodec_open2(*codecContext, codec, NULL);
+    }
+
+    if (status < 0) {
+        avcodec_free_context(codecContext);
+    }
+
+    return status;
+}
+
+static int setup_video_conversion(RDMPEGBenchmarkMedia *media) {
+    AVCodecContext *codecContext = media->videoCodecContext;
+
+    media->videoFrameYUV = rdmpeg_decode_core_is_yuv_format(codecContext->pix_fmt);
+    if (media->videoFrameYUV) {
+        return 0;
+    }
+
+    media->bgraFrame = rdmpeg_decode_core_bgra_frame_create(codecContext);
+    if (media->bgraFrame == NULL) {
+        return AVERROR(ENOMEM);
+    }
+
+    media->swsContext = rdmpeg_decode_core_bgra_scaler(NULL, codecContext, media->bgraFrame);
+
+    return media->swsContext ? 0 : AVERROR(EINVAL);
+}
+
+static int setup_audio_conversion(RDMPEGBenchmarkMedia *media) {
+    AVCodecContext *codecContext = media->audioCodecContext;
+
+    if (media->outputSampleRate <= 0) {
+        media->outputSampleRate = RDMPEG_BENCHMARK_OUTPUT_SAMPLE_RATE;
+    }
+    media->outputChannels = RDMPEG_BENCHMARK_OUTPUT_CHANNELS;
+
+    // Same condition as RDMPEGDecoder uses to skip resampling
+    if (codecContext->sample_fmt == AV_SAMPLE_FMT_S16 &&
+        codecContext->sample_rate == media->outputSampleRate &&
+        rdmpeg_decode_core_channels_count(codecContext) == media->outputChannels) {
+        return 0;
+    }
+
+    media->swrContext = rdmpeg_decode_core_resampler_create(codecContext,
+                                                            media->outputSampleRate,
+                                                            media->outputChannels,
+                                                            AV_SAMPLE_FMT_S16,
+                                                            RDMPEGDownmixLevelsITU,
+                                                            media->resamplerProfile ?
+                                                                media->resamplerProfile :
+                                                                &RDMPEGResamplerProfileBalanced);
+
+    return media->swrContext ? 0 : AVERROR(EINVAL);
+}
+
+// Same flow as RDMPEGDecoder decodeFrames: interlaced frames go through yadif when deinterlacing is enabled,
+// graph is created on the first of them
+static int handle_decoded_video_frame(RDMPEGBenchmarkMedia *media, double *position) {
+#ifdef AV_FRAME_FLAG_INTERLACED
+    int isInterlaced = (media->frame->flags & AV_FRAME_FLAG_INTERLACED) != 0;
+#else
+    int isInterlaced = media->frame->interlaced_frame != 0;
+#endif
+
+    if (media->deinterlace == 0 || isInterlaced == 0) {
+        return handle_video_frame(media, media->frame, position);
+    }
+
+    if (media->deinterlacer == NULL) {
+        media->deinterlacer = rdmpeg_decode_core_deinterlacer_create(media->videoCodecContext);
+        media->deinterlacedFrame = av_frame_alloc();
+
+        if (media->deinterlacer == NULL || media->deinterlacedFrame == NULL) {
+            return AVERROR(ENOMEM);
+        }
+    }
+
+    int status = av_buffersrc_add_frame_flags(media->deinterlacer->filters[0],
+                                              media->frame,
+                                              AV_BUFFERSRC_FLAG_KEEP_REF);
+    if (status < 0) {
+        return status;
+    }
+
+    media->deinterlacerPending = 1;
+
+    return receive_deinterlaced_frame(media, position);
+}
+
+static int receive_deinterlaced_frame(RDMPEGBenchmarkMedia *media, double *position) {
+    int status = av_buffersink_get_frame(media->deinterlacer->filters[1], media->deinterlacedFrame);
+
+    if (status == AVERROR(EAGAIN) || status == AVERROR_EOF) {
+        media->deinterlacerPending = 0;
+        return RDMPEGBenchmarkFrameTypeNone;
+    }
+    if (status < 0) {
+        media->deinterlacerPending = 0;
+        return status;
+    }
+
+    media->framesDeinterlaced++;
+
+    int frameType = handle_video_frame(media, media->deinterlacedFrame, position);
+    av_frame_unref(media->deinterlacedFrame);
+
+    return frameType;
+}
+
+static int handle_video_frame(RDMPEGBenchmarkMedia *media, AVFrame *frame, double *position) {
+    AVCodecContext *codecContext = media->videoCodecContext;
+
+    if (frame->data[0] == NULL) {
+        return RDMPEGBenchmarkFrameTypeNone;
+    }
+
+    int status;
+
+    if (media->videoFrameYUV) {
+        int width = codecContext->width;
+        int height = codecContext->height;
+
+        if ((status = copy_plane(media, frame->data[0], frame->linesize[0], width, height)) < 0 ||
+            (status = copy_plane(media, frame->data[1], frame->linesize[1], width / 2, height / 2)) < 0 ||
+            (status = copy_plane(media, frame->data[2], frame->linesize[2], width / 2, height / 2)) < 0) {
+            return status;
+        }
+    }
+    else {
+        sws_scale(media->swsContext,
+                  (const uint8_t * const *)frame->data,
+                  frame->linesize,
+                  0,
+                  codecContext->height,
+                  media->bgraFrame->data,
+                  media->bgraFrame->linesize);
+
+        // RDMPEGDecoder keeps padded BGRA rows, so the whole linesize is copied
+        int linesize = media->bgraFrame->linesize[0];
+        if ((status = copy_plane(media, media->bgraFrame->data[0], linesize, linesize, codecContext->height)) < 0) {
+            return status;
+        }
+    }
+
+    *position = rdmpeg_decode_core_frame_position(media->formatContext->streams[media->videoStreamIndex],
+                                                  media->videoTimeBase,
+                                                  frame);
+    media->videoFrameKeyframe = rdmpeg_decode_core_is_keyframe(frame);
+
+    return RDMPEGBenchmarkFrameTypeVideo;
+}
+
+static int handle_audio_frame(RDMPEGBenchmarkMedia *media, double *position) {
+    AVFrame *frame = media->frame;
+
+    if (frame->data[0] == NULL) {
+        return RDMPEGBenchmarkFrameTypeNone;
+    }
+
+    const int16_t *audioData;
+    int samplesCount;
+
+    if (media->swrContext) {
+        double resampleStartTime = rdmpeg_benchmark_now();
+        samplesCount = rdmpeg_decode_core_resample(media->swrContext,
+                                                   media->audioCodecContext,
+                                                   frame,
+                                                   media->outputSampleRate,
+                                                   media->outputChannels,
+                                                   &media->swrBuffer,
+                                                   &media->swrBufferSize);
+        media->resampleTime += rdmpeg_benchmark_now() - resampleStartTime;
+        if (samplesCount < 0) {
+            return samplesCount;
+        }
+
+        audioData = (const int16_t *)media->swrBuffer;
+    }
+    else {
+        audioData = (const int16_t *)frame->data[0];
+        samplesCount = frame->nb_samples;
+    }
+
+    // Stands in for the NSMutableData of RDMPEGAudioFrame
+    const size_t elementsCount = (size_t)samplesCount * media->outputChannels;
+    float *samples = malloc(elementsCount * sizeof(float));
+    if (samples == NULL && elementsCount > 0) {
+        return AVERROR(ENOMEM);
+    }
+
+    rdmpeg_decode_core_samples_to_float(audioData, samples, elementsCount);
+    free(samples);
+
+    media->bytesCopied += elementsCount * sizeof(float);
+
+    *position = rdmpeg_decode_core_frame_position(media->formatContext->streams[media->audioStreamIndex],
+                                                  media->audioTimeBase,
+                                                  frame);
+
+    return RDMPEGBenchmarkFrameTypeAudio;
+}
+
+// Stands in for copy_frame_data of RDMPEGDecoder, which returns a new NSData per plane
+static int copy_plane(RDMPEGBenchmarkMedia *media, const uint8_t *source, int linesize, int width, int height) {
+    size_t size = rdmpeg_decode_core_plane_size(linesize, width, height);
+    uint8_t *plane = malloc(size);
+    if (plane == NULL && size > 0) {
+        return AVERROR(ENOMEM);
+    }
+
+    rdmpeg_decode_core_copy_plane(plane, source, linesize, width, height);
+    free(plane);
+
+    media->bytesCopied += size;
+
+    return 0;
+}
+
+static void reset_decoding(RDMPEGBenchmarkMedia *media) {
+    if (media->videoCodecContext) {
+        avcodec_flush_buffers(media->videoCodecContext);
+    }
+    if (media->audioCodecContext) {
+        avcodec_flush_buffers(media->audioCodecContext);
+    }
+
+    // Deinterlacer is kept over seeks as RDMPEGDecoder keeps it
+    media->deinterlacerPending = 0;
+    media->pendingCodecContext = NULL;
+    media->draining = 0;
+    media->drainIndex = 0;
+}
@@ -0,0 +1,87 @@
+//
+//  RDMPEGBenchmarkMedia.h
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGBenchmarkMedia_h
+#define RDMPEGBenchmarkMedia_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "RDMPEGDecodeCore.h"
+
+// RDMPEGDecoder hot path without Objective-C: demux and decode, then the decoder's own conversions from
+// RDMPEGDecodeCore (deinterlacing, YUV plane copy or BGRA scaling for video, S16 resampling and float scaling for
+// audio). Converted frames are allocated per frame and released right away, as the decoder's NSData are.
+
+#define RDMPEG_BENCHMARK_MEDIA_VIDEO (1 << 0)
+#define RDMPEG_BENCHMARK_MEDIA_AUDIO (1 << 1)
+
+#define RDMPEG_BENCHMARK_OUTPUT_SAMPLE_RATE 44100
+#define RDMPEG_BENCHMARK_OUTPUT_CHANNELS 2
+
+typedef enum RDMPEGBenchmarkFrameType {
+    RDMPEGBenchmarkFrameTypeNone = 0,
+    RDMPEGBenchmarkFrameTypeVideo,
+    RDMPEGBenchmarkFrameTypeAudio,
+} RDMPEGBenchmarkFrameType;
+
+typedef struct RDMPEGBenchmarkMedia {
+    // May be set before opening: resampler profile (balanced when NULL), output sampling rate
+    // (RDMPEG_BENCHMARK_OUTPUT_SAMPLE_RATE when 0) and deinterlacing of interlaced frames, as isDeinterlacingEnabled
+    const RDMPEGResamplerProfile *resamplerProfile;
+    int outputSampleRate;
+    int deinterlace;
+
+    AVFormatContext *formatContext;
+    AVCodecContext *videoCodecContext;
+    AVCodecContext *audioCodecContext;
+    int videoStreamIndex;
+    int audioStreamIndex;
+    double videoTimeBase;
+    double audioTimeBase;
+    AVPacket *packet;
+    AVFrame *frame;
+    AVCodecContext *pendingCodecContext;
+    int draining;
+    int drainIndex;
+
+    int videoFrameYUV;
+    struct SwsContext *swsContext;
+    AVFrame *bgraFrame;
+    AVFilterGraph *deinterlacer;
+    AVFrame *deinterlacedFrame;
+    int deinterlacerPending;
+
+    SwrContext *swrContext;
+    uint8_t *swrBuffer;
+    int swrBufferSize;
+    int outputChannels;
+    // Time spent in the resampler
+    double resampleTime;
+
+    uint64_t bytesCopied;
+    uint64_t framesDeinterlaced;
+    // Last video frame returned decodes without the preceding ones, see rdmpeg_decode_core_is_keyframe
+    int videoFrameKeyframe;
+} RDMPEGBenchmarkMedia;
+
+// Returns 0 on success or negative AVERROR code. Media should be zero initialized.
+int rdmpeg_benchmark_media_open(RDMPEGBenchmarkMedia *media, const char *path, int streams);
+void rdmpeg_benchmark_media_close(RDMPEGBenchmarkMedia *media);
+
+// Decodes and converts next frame. Returns frame type, RDMPEGBenchmarkFrameTypeNone at the end of input or
+// negative AVERROR code.
+int rdmpeg_benchmark_media_next_frame(RDMPEGBenchmarkMedia *media, double *position);
+
+// Seeks the same way RDMPEGDecoder moveAtPosition: does, returns 0 or negative AVERROR code.
+int rdmpeg_benchmark_media_seek(RDMPEGBenchmarkMedia *media, double position);
+
+// Seeks to the keyframe at or before the position the same way RDMPEGDecoder moveAtKeyframeBeforePosition: does.
+int rdmpeg_benchmark_media_seek_keyframe(RDMPEGBenchmarkMedia *media, double position);
+
+double rdmpeg_benchmark_media_duration(const RDMPEGBenchmarkMedia *media);
+
+#endif /* RDMPEGBenchmarkMedia_h */
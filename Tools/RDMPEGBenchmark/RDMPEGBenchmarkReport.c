@@ -0,0 +1,253 @@
+//
+//  RDMPEGBenchmarkReport.c
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGBenchmarkReport.h"
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+static int compare_doubles(const void *lhs, const void *rhs);
+static void json_key(RDMPEGBenchmarkJSON *json, const char *key);
+static void json_escaped_string(FILE *file, const char *value);
+
+
+
+double rdmpeg_benchmark_now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+void rdmpeg_benchmark_samples_add(RDMPEGBenchmarkSamples *samples, double value) {
+    if (samples->count == samples->capacity) {
+        size_t capacity = samples->capacity > 0 ? samples->capacity * 2 : 1024;
+        double *values = realloc(samples->values, capacity * sizeof(double));
+        if (values == NULL) {
+            return;
+        }
+        samples->values = values;
+        samples->capacity = capacity;
+    }
+
+    samples->values[samples->count++] = value;
+}
+
+void rdmpeg_benchmark_samples_free(RDMPEGBenchmarkSamples *samples) {
+    free(samples->values);
+    samples->values = NULL;
+    samples->count = 0;
+    samples->capacity = 0;
+}
+
+double rdmpeg_benchmark_samples_percentile(RDMPEGBenchmarkSamples *samples, double percentile) {
+    if (samples->count == 0) {
+        return 0.0;
+    }
+
+    qsort(samples->values, samples->count, sizeof(double), compare_doubles);
+
+    // Nearest-rank method
+    size_t rank = (size_t)ceil(percentile / 100.0 * (double)samples->count);
+    rank = rank > 0 ? rank - 1 : 0;
+    if (rank >= samples->count) {
+        rank = samples->count - 1;
+    }
+
+    return samples->values[rank];
+}
+
+double rdmpeg_benchmark_samples_sum(const RDMPEGBenchmarkSamples *samples) {
+    double sum = 0.0;
+    for (size_t i = 0; i < samples->count; i++) {
+        sum += samples->values[i];
+    }
+    return sum;
+}
+
+int64_t rdmpeg_benchmark_peak_rss(void) {
+#if defined(__linux__)
+    // Unlike ru_maxrss, high water mark in status goes down when it's reset
+    FILE *status = fopen("/proc/self/status", "r");
+    if (status) {
+        char line[256];
+        long long peakKilobytes = -1;
+
+        while (fgets(line, sizeof(line), status)) {
+            if (sscanf(line, "VmHWM: %lld kB", &peakKilobytes) == 1) {
+                break;
+            }
+        }
+
+        fclose(status);
+
+        if (peakKilobytes >= 0) {
+            return (int64_t)peakKilobytes * 1024;
+        }
+    }
+#endif
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+
+#if defined(__APPLE__)
+    return (int64_t)usage.ru_maxrss;
+#else
+    return (int64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+int64_t rdmpeg_benchmark_heap_in_use(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return (int64_t)(info.uordblks + info.hblkhd);
+#elif defined(__APPLE__)
+    malloc_statistics_t statistics;
+    malloc_zone_statistics(NULL, &statistics);
+    return (int64_t)statistics.size_in_use;
+#else
+    return -1;
+#endif
+}
+
+int rdmpeg_benchmark_reset_peak_rss(void) {
+#if defined(__linux__)
+    FILE *clearRefs = fopen("/proc/self/clear_refs", "w");
+    if (clearRefs == NULL) {
+        return -1;
+    }
+
+    // "5" resets the high water mark of RSS
+    int status = fputs("5", clearRefs) >= 0 ? 0 : -1;
+    if (fclose(clearRefs) != 0) {
+        status = -1;
+    }
+
+    return status;
+#else
+    return -1;
+#endif
+}
+
+void rdmpeg_benchmark_json_begin_object(RDMPEGBenchmarkJSON *json, const char *key) {
+    json_key(json, key);
+    fputc('{', json->file);
+    json->depth++;
+    json->needsComma = 0;
+}
+
+void rdmpeg_benchmark_json_end_object(RDMPEGBenchmarkJSON *json) {
+    json->depth--;
+    fprintf(json->file, "\n%*s}", json->depth * 2, "");
+    json->needsComma = 1;
+
+    if (json->depth == 0) {
+        fputc('\n', json->file);
+    }
+}
+
+void rdmpeg_benchmark_json_begin_array(RDMPEGBenchmarkJSON *json, const char *key) {
+    json_key(json, key);
+    fputc('[', json->file);
+    json->depth++;
+    json->needsComma = 0;
+}
+
+void rdmpeg_benchmark_json_end_array(RDMPEGBenchmarkJSON *json) {
+    json->depth--;
+    fprintf(json->file, "\n%*s]", json->depth * 2, "");
+    json->needsComma = 1;
+}
+
+void rdmpeg_benchmark_json_string(RDMPEGBenchmarkJSON *json, const char *key, const char *value) {
+    json_key(json, key);
+    json_escaped_string(json->file, value ? value : "");
+    json->needsComma = 1;
+}
+
+void rdmpeg_benchmark_json_int(RDMPEGBenchmarkJSON *json, const char *key, int64_t value) {
+    json_key(json, key);
+    fprintf(json->file, "%lld", (long long)value);
+    json->needsComma = 1;
+}
+
+void rdmpeg_benchmark_json_double(RDMPEGBenchmarkJSON *json, const char *key, double value) {
+    json_key(json, key);
+    if (isfinite(value)) {
+        fprintf(json->file, "%.6f", value);
+    }
+    else {
+        fputs("null", json->file);
+    }
+    json->needsComma = 1;
+}
+
+void rdmpeg_benchmark_json_latency(RDMPEGBenchmarkJSON *json, const char *key, RDMPEGBenchmarkSamples *samples) {
+    rdmpeg_benchmark_json_begin_object(json, key);
+    rdmpeg_benchmark_json_int(json, "count", (int64_t)samples->count);
+    rdmpeg_benchmark_json_double(json, "total_s", rdmpeg_benchmark_samples_sum(samples));
+    rdmpeg_benchmark_json_double(json, "p50_ms", rdmpeg_benchmark_samples_percentile(samples, 50) * 1000.0);
+    rdmpeg_benchmark_json_double(json, "p90_ms", rdmpeg_benchmark_samples_percentile(samples, 90) * 1000.0);
+    rdmpeg_benchmark_json_double(json, "p99_ms", rdmpeg_benchmark_samples_percentile(samples, 99) * 1000.0);
+    rdmpeg_benchmark_json_double(json, "max_ms", rdmpeg_benchmark_samples_percentile(samples, 100) * 1000.0);
+    rdmpeg_benchmark_json_end_object(json);
+}
+
+
+
+static int compare_doubles(const void *lhs, const void *rhs) {
+    double left = *(const double *)lhs;
+    double right = *(const double *)rhs;
+    return (left > right) - (left < right);
+}
+
+static void json_key(RDMPEGBenchmarkJSON *json, const char *key) {
+    if (json->needsComma) {
+        fputc(',', json->file);
+    }
+
+    if (json->depth > 0) {
+        fprintf(json->file, "\n%*s", json->depth * 2, "");
+    }
+
+    if (key) {
+        json_escaped_string(json->file, key);
+        fputs(": ", json->file);
+    }
+}
+
+static void json_escaped_string(FILE *file, const char *value) {
+    fputc('"', file);
+
+    for (const unsigned char *character = (const unsigned char *)value; *character; character++) {
+        switch (*character) {
+            case '"': fputs("\\\"", file); break;
+            case '\\': fputs("\\\\", file); break;
+            case '\n': fputs("\\n", file); break;
+            case '\r': fputs("\\r", file); break;
+            case '\t': fputs("\\t", file); break;
+            default:
+                if (*character < 0x20) {
+                    fprintf(file, "\\u%04x", *character);
+                }
+                else {
+                    fputc(*character, file);
+                }
+                break;
+        }
+    }
+
+    fputc('"', file);
+}
@@ -0,0 +1,54 @@
+//
+//  RDMPEGBenchmarkReport.h
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGBenchmarkReport_h
+#define RDMPEGBenchmarkReport_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+double rdmpeg_benchmark_now(void);
+
+// Growable list of latency samples (seconds)
+typedef struct RDMPEGBenchmarkSamples {
+    double *values;
+    size_t count;
+    size_t capacity;
+} RDMPEGBenchmarkSamples;
+
+void rdmpeg_benchmark_samples_add(RDMPEGBenchmarkSamples *samples, double value);
+void rdmpeg_benchmark_samples_free(RDMPEGBenchmarkSamples *samples);
+// Sorts samples in place, percentile is in 0...100 range
+double rdmpeg_benchmark_samples_percentile(RDMPEGBenchmarkSamples *samples, double percentile);
+double rdmpeg_benchmark_samples_sum(const RDMPEGBenchmarkSamples *samples);
+
+// Returns -1 when value isn't available on current platform
+int64_t rdmpeg_benchmark_peak_rss(void);
+int64_t rdmpeg_benchmark_heap_in_use(void);
+// Starts peak RSS over from the current RSS, so it's measured per pass. Works on Linux only, returns -1 where peak
+// can't be reset and stays process-wide.
+int rdmpeg_benchmark_reset_peak_rss(void);
+
+// Minimal streaming JSON writer, takes care of commas and indentation
+typedef struct RDMPEGBenchmarkJSON {
+    FILE *file;
+    int depth;
+    int needsComma;
+} RDMPEGBenchmarkJSON;
+
+void rdmpeg_benchmark_json_begin_object(RDMPEGBenchmarkJSON *json, const char *key);
+void rdmpeg_benchmark_json_end_object(RDMPEGBenchmarkJSON *json);
+void rdmpeg_benchmark_json_begin_array(RDMPEGBenchmarkJSON *json, const char *key);
+void rdmpeg_benchmark_json_end_array(RDMPEGBenchmarkJSON *json);
+void rdmpeg_benchmark_json_string(RDMPEGBenchmarkJSON *json, const char *key, const char *value);
+void rdmpeg_benchmark_json_int(RDMPEGBenchmarkJSON *json, const char *key, int64_t value);
+void rdmpeg_benchmark_json_double(RDMPEGBenchmarkJSON *json, const char *key, double value);
+// Writes count, sum and p50/p90/p99/max of samples as nested object
+void rdmpeg_benchmark_json_latency(RDMPEGBenchmarkJSON *json, const char *key, RDMPEGBenchmarkSamples *samples);
+
+#endif /* RDMPEGBenchmarkReport_h */
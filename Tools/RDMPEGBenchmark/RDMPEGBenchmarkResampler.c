@@ -0,0 +1,215 @@
+//
+//  RDMPEGBenchmarkResampler.c
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "RDMPEGBenchmarkResampler.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define RDMPEG_BENCHMARK_TONE_AMPLITUDE 0.5
+#define RDMPEG_BENCHMARK_LOW_TONE_FREQUENCY 1000.0
+// Output samples affected by filter start and end, they are left out of the fit
+#define RDMPEG_BENCHMARK_TONE_EDGE_SAMPLES 1024
+
+typedef struct RDMPEGBenchmarkToneFit {
+    double amplitude;
+    double residualPower;
+} RDMPEGBenchmarkToneFit;
+
+static int resample_tone(const RDMPEGResamplerProfile *profile,
+                         int inputSampleRate,
+                         int outputSampleRate,
+                         double frequency,
+                         float **output,
+                         int *outputCount);
+static int fit_tone(const float *samples, int count, int sampleRate, double frequency, RDMPEGBenchmarkToneFit *fit);
+static int fit_silence(const float *samples, int count, int sampleRate, RDMPEGBenchmarkToneFit *fit);
+static double level(double power);
+
+
+
+int rdmpeg_benchmark_resampler_quality(const RDMPEGResamplerProfile *profile,
+                                       int inputSampleRate,
+                                       int outputSampleRate,
+                                       RDMPEGBenchmarkResamplerQuality *quality) {
+    const double tonePower = RDMPEG_BENCHMARK_TONE_AMPLITUDE * RDMPEG_BENCHMARK_TONE_AMPLITUDE / 2.0;
+    const int lowerSampleRate = inputSampleRate < outputSampleRate ? inputSampleRate : outputSampleRate;
+
+    double frequencies[3] = {
+        RDMPEG_BENCHMARK_LOW_TONE_FREQUENCY,
+        0.9 * lowerSampleRate / 2.0,
+        (outputSampleRate / 2.0 + inputSampleRate / 2.0) / 2.0,
+    };
+    RDMPEGBenchmarkToneFit fits[3] = {{0}};
+    int tonesCount = inputSampleRate > outputSampleRate ? 3 : 2;
+
+    for (int i = 0; i < tonesCount; i++) {
+        float *output = NULL;
+        int outputCount = 0;
+
+        int status = resample_tone(profile, inputSampleRate, outputSampleRate, frequencies[i], &output, &outputCount);
+        if (status >= 0) {
+            // Alias tone should be gone from output, all of output is residual
+            status = i < 2 ?
+                fit_tone(output, outputCount, outputSampleRate, frequencies[i], &fits[i]) :
+                fit_silence(output, outputCount, outputSampleRate, &fits[i]);
+        }
+
+        free(output);
+
+        if (status < 0) {
+            return status;
+        }
+    }
+
+    quality->lowToneSNR = level(tonePower / fits[0].residualPower);
+    quality->highToneFrequency = frequencies[1];
+    quality->highToneGain = level(fits[1].amplitude * fits[1].amplitude / 2.0 / tonePower);
+    quality->highToneSNR = level(fits[1].amplitude * fits[1].amplitude / 2.0 / fits[1].residualPower);
+    quality->aliasLevel = tonesCount > 2 ? level(fits[2].residualPower / tonePower) : NAN;
+
+    return 0;
+}
+
+static int resample_tone(const RDMPEGResamplerProfile *profile,
+                         int inputSampleRate,
+                         int outputSampleRate,
+                         double frequency,
+                         float **output,
+                         int *outputCount) {
+    // Resampler is set up by the decoder's own code, as for a mono float stream, only its output stays float
+    AVCodecContext *codecContext = avcodec_alloc_context3(NULL);
+    if (codecContext == NULL) {
+        return AVERROR(ENOMEM);
+    }
+
+    codecContext->sample_rate = inputSampleRate;
+    codecContext->sample_fmt = AV_SAMPLE_FMT_FLT;
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    av_channel_layout_from_mask(&codecContext->ch_layout, AV_CH_LAYOUT_MONO);
+#else
+    codecContext->channels = 1;
+    codecContext->channel_layout = AV_CH_LAYOUT_MONO;
+#endif
+
+    SwrContext *swrContext = rdmpeg_decode_core_resampler_create(codecContext,
+                                                                 outputSampleRate,
+                                                                 1,
+                                                                 AV_SAMPLE_FMT_FLT,
+                                                                 RDMPEGDownmixLevelsITU,
+                                                                 profile);
+    avcodec_free_context(&codecContext);
+
+    if (swrContext == NULL) {
+        return AVERROR(EINVAL);
+    }
+
+    int inputCount = inputSampleRate;
+    float *input = malloc((size_t)inputCount * sizeof(float));
+    int outputCapacity = swr_get_out_samples(swrContext, inputCount) + outputSampleRate / 10;
+    *output = malloc((size_t)outputCapacity * sizeof(float));
+
+    if (input == NULL || *output == NULL) {
+        free(input);
+        swr_free(&swrContext);
+        return AVERROR(ENOMEM);
+    }
+
+    for (int i = 0; i < inputCount; i++) {
+        input[i] = (float)(RDMPEG_BENCHMARK_TONE_AMPLITUDE * sin(2.0 * M_PI * frequency * i / inputSampleRate));
+    }
+
+    const uint8_t *inputPlanes[1] = {(const uint8_t *)input};
+    uint8_t *outputPlanes[1] = {(uint8_t *)*output};
+
+    int status = swr_convert(swrContext, outputPlanes, outputCapacity, inputPlanes, inputCount);
+
+    if (status >= 0) {
+        *outputCount = status;
+
+        // Flush samples resampler holds for the filter
+        outputPlanes[0] = (uint8_t *)(*output + *outputCount);
+        status = swr_convert(swrContext, outputPlanes, outputCapacity - *outputCount, NULL, 0);
+
+        if (status >= 0) {
+            *outputCount += status;
+        }
+    }
+
+    free(input);
+    swr_free(&swrContext);
+
+    return status < 0 ? status : 0;
+}
+
+static int fit_tone(const float *samples, int count, int sampleRate, double frequency, RDMPEGBenchmarkToneFit *fit) {
+    int start = RDMPEG_BENCHMARK_TONE_EDGE_SAMPLES;
+    int end = count - RDMPEG_BENCHMARK_TONE_EDGE_SAMPLES;
+
+    if (end - start < sampleRate / 4) {
+        return AVERROR(ERANGE);
+    }
+
+    double cosCos = 0.0;
+    double sinSin = 0.0;
+    double cosSin = 0.0;
+    double sampleCos = 0.0;
+    double sampleSin = 0.0;
+
+    for (int i = start; i < end; i++) {
+        double phase = 2.0 * M_PI * frequency * i / sampleRate;
+        double cosine = cos(phase);
+        double sine = sin(phase);
+
+        cosCos += cosine * cosine;
+        sinSin += sine * sine;
+        cosSin += cosine * sine;
+        sampleCos += samples[i] * cosine;
+        sampleSin += samples[i] * sine;
+    }
+
+    double determinant = cosCos * sinSin - cosSin * cosSin;
+    double cosineWeight = (sampleCos * sinSin - sampleSin * cosSin) / determinant;
+    double sineWeight = (sampleSin * cosCos - sampleCos * cosSin) / determinant;
+
+    double residualPower = 0.0;
+
+    for (int i = start; i < end; i++) {
+        double phase = 2.0 * M_PI * frequency * i / sampleRate;
+        double residual = samples[i] - cosineWeight * cos(phase) - sineWeight * sin(phase);
+        residualPower += residual * residual;
+    }
+
+    fit->amplitude = sqrt(cosineWeight * cosineWeight + sineWeight * sineWeight);
+    fit->residualPower = residualPower / (end - start);
+
+    return 0;
+}
+
+static int fit_silence(const float *samples, int count, int sampleRate, RDMPEGBenchmarkToneFit *fit) {
+    int start = RDMPEG_BENCHMARK_TONE_EDGE_SAMPLES;
+    int end = count - RDMPEG_BENCHMARK_TONE_EDGE_SAMPLES;
+
+    if (end - start < sampleRate / 4) {
+        return AVERROR(ERANGE);
+    }
+
+    double power = 0.0;
+
+    for (int i = start; i < end; i++) {
+        power += (double)samples[i] * samples[i];
+    }
+
+    fit->amplitude = 0.0;
+    fit->residualPower = power / (end - start);
+
+    return 0;
+}
+
+static double level(double power) {
+    // Floor keeps exact results (e.g. no resampling at all) finite in JSON
+    return 10.0 * log10(power > 1e-30 ? power : 1e-30);
+}
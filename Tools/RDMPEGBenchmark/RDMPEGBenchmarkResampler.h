@@ -0,0 +1,35 @@
+//
+//  RDMPEGBenchmarkResampler.h
+//  RDMPEGBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#ifndef RDMPEGBenchmarkResampler_h
+#define RDMPEGBenchmarkResampler_h
+
+#include "RDMPEGBenchmarkMedia.h"
+
+// Quality of resampler profile measured with synthetic tones. Every tone is a second of half scale sine, resampled
+// by a resampler rdmpeg_decode_core_resampler_create sets up as the decoder does, except that it outputs float
+// (so S16 quantization of decoder output doesn't hide differences between profiles). Tone in output is found by
+// least squares fit at its frequency, what's left after subtracting it is noise and distortion.
+typedef struct RDMPEGBenchmarkResamplerQuality {
+    // 1 kHz tone
+    double lowToneSNR;
+    // Tone at 90% of the lower Nyquist frequency, shows passband width and images or aliases near the band edge
+    double highToneFrequency;
+    double highToneGain;
+    double highToneSNR;
+    // Level of tone halfway between output and input Nyquist frequencies relative to the tone, which should be
+    // filtered out completely. NAN when input rate isn't higher than output one
+    double aliasLevel;
+} RDMPEGBenchmarkResamplerQuality;
+
+// Returns 0 or negative AVERROR code, levels are in dB
+int rdmpeg_benchmark_resampler_quality(const RDMPEGResamplerProfile *profile,
+                                       int inputSampleRate,
+                                       int outputSampleRate,
+                                       RDMPEGBenchmarkResamplerQuality *quality);
+
+#endif /* RDMPEGBenchmarkResampler_h */
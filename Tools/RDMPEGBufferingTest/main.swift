@@ -0,0 +1,191 @@
+//
+//  main.swift
+//  RDMPEGBufferingTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Feeds RDMPEGBufferingController with synthetic decode steps and underruns and checks how its water marks
+// move: IO jitter and slow decoding widen the window, underrun boost decays with decoded media only
+// (readiness checks never move the marks), byte budgets make the buffer ready and full.
+
+let minimumDuration: TimeInterval = 0.2
+let maximumDuration: TimeInterval = 1.0
+let tolerance: TimeInterval = 0.0001
+var failuresCount = 0
+
+func check(_ condition: Bool, _ message: @autoclosure () -> String) {
+    if !condition {
+        print("FAIL: \(message())")
+        failuresCount += 1
+    }
+}
+
+func statistics(_ controller: RDMPEGBufferingController) -> RDMPEGBufferingStatistics {
+    controller.statistics(
+        bufferedVideoDuration: 0,
+        bufferedAudioDuration: 0,
+        bufferedVideoBytes: 0,
+        bufferedAudioBytes: 0
+    )
+}
+
+func recordSteps(
+    _ controller: RDMPEGBufferingController,
+    count: Int,
+    decodeTime: TimeInterval,
+    ioTimes: [TimeInterval],
+    mediaDuration: TimeInterval
+) {
+    for index in 0..<count {
+        let ioTime = ioTimes[index % ioTimes.count]
+        controller.recordDecodeStep(time: decodeTime + ioTime, ioTime: ioTime, mediaDuration: mediaDuration)
+    }
+}
+
+func testInitialWaterMarks() {
+    let controller = RDMPEGBufferingController(byteBudget: 0)
+    let initial = statistics(controller)
+
+    check(abs(initial.lowWaterDuration - minimumDuration) < tolerance, "initial low water \(initial.lowWaterDuration)")
+    check(abs(initial.highWaterDuration - maximumDuration) < tolerance,
+          "initial high water \(initial.highWaterDuration)")
+    check(controller.isVideoBufferReady(duration: 0.25, byteSize: 0), "buffer above low water is not ready")
+    check(controller.isVideoBufferReady(duration: 0.15, byteSize: 0) == false, "buffer below low water is ready")
+    check(controller.isVideoBufferFull(duration: maximumDuration, byteSize: 0), "buffer at high water is not full")
+    check(controller.isVideoBufferFull(duration: 0.9, byteSize: 0) == false, "buffer below high water is full")
+    check(controller.isAudioBufferReady(duration: 0.25), "audio above low water is not ready")
+}
+
+func testFastSteadyDecoding() {
+    let controller = RDMPEGBufferingController(byteBudget: 0)
+    recordSteps(controller, count: 200, decodeTime: 0.005, ioTimes: [0.001], mediaDuration: 0.04)
+    let steady = statistics(controller)
+
+    // Steps are far shorter than minimum duration and decoder is 6x realtime, former constants apply
+    check(abs(steady.lowWaterDuration - minimumDuration) < tolerance, "steady low water \(steady.lowWaterDuration)")
+    check(abs(steady.highWaterDuration - maximumDuration) < tolerance, "steady high water \(steady.highWaterDuration)")
+    check(abs(steady.ioTime - 0.001) < tolerance, "smoothed IO time \(steady.ioTime)")
+    check(steady.ioTimeDeviation < tolerance, "IO time deviation \(steady.ioTimeDeviation) without jitter")
+}
+
+func testIOJitter() {
+    // Same mean step and IO time, one stream reads evenly, another stalls on every fourth read
+    let evenController = RDMPEGBufferingController(byteBudget: 0)
+    recordSteps(evenController, count: 400, decodeTime: 0.01, ioTimes: [0.05], mediaDuration: 0.1)
+    let jitteryController = RDMPEGBufferingController(byteBudget: 0)
+    recordSteps(jitteryController, count: 400, decodeTime: 0.01, ioTimes: [0, 0, 0, 0.2], mediaDuration: 0.1)
+
+    let even = statistics(evenController)
+    let jittery = statistics(jitteryController)
+
+    check(jittery.ioTimeDeviation > even.ioTimeDeviation + 0.05,
+          "IO deviation \(jittery.ioTimeDeviation) with stalls, \(even.ioTimeDeviation) without")
+    check(jittery.lowWaterDuration > even.lowWaterDuration,
+          "low water \(jittery.lowWaterDuration) with IO stalls, \(even.lowWaterDuration) without")
+    check(jittery.lowWaterDuration > 0.3, "low water \(jittery.lowWaterDuration) doesn't cover 0.2 s IO stall")
+    check(jittery.highWaterDuration - jittery.lowWaterDuration >= maximumDuration - minimumDuration - tolerance,
+          "window \(jittery.lowWaterDuration)...\(jittery.highWaterDuration) lost its headroom")
+}
+
+func testSlowDecoder() {
+    let controller = RDMPEGBufferingController(byteBudget: 0)
+    // 1.25x realtime
+    recordSteps(controller, count: 200, decodeTime: 0.032, ioTimes: [0], mediaDuration: 0.04)
+    let slow = statistics(controller)
+
+    check(abs(slow.decodeSpeed - 1.25) < 0.01, "decode speed \(slow.decodeSpeed)")
+    check(slow.lowWaterDuration > minimumDuration * 1.5, "slow decoder low water \(slow.lowWaterDuration)")
+    check(slow.highWaterDuration - slow.lowWaterDuration > maximumDuration - minimumDuration,
+          "slow decoder window \(slow.lowWaterDuration)...\(slow.highWaterDuration) has no extra headroom")
+}
+
+func testUnderrunBoostDecay() {
+    let controller = RDMPEGBufferingController(byteBudget: 0)
+    recordSteps(controller, count: 200, decodeTime: 0.005, ioTimes: [0.001], mediaDuration: 0.04)
+    let base = statistics(controller).lowWaterDuration
+
+    controller.recordUnderrun()
+    controller.recordUnderrun()
+    let boosted = statistics(controller)
+    check(boosted.underrunCount == 2, "underrun count \(boosted.underrunCount)")
+    check(abs(boosted.lowWaterDuration - base * 2.25) < tolerance,
+          "low water \(boosted.lowWaterDuration) after two underruns, \(base) before")
+
+    // Readiness checks are queries, however often decoding queue asks
+    for _ in 0..<1000 {
+        _ = controller.isVideoBufferFull(duration: boosted.highWaterDuration * 2, byteSize: 0)
+        _ = controller.isVideoBufferReady(duration: boosted.highWaterDuration * 2, byteSize: 0)
+    }
+    let queried = statistics(controller)
+    check(abs(queried.lowWaterDuration - boosted.lowWaterDuration) < tolerance,
+          "low water moved to \(queried.lowWaterDuration) by readiness checks")
+
+    // Boost halves per 10 s of decoded media
+    recordSteps(controller, count: 250, decodeTime: 0.005, ioTimes: [0.001], mediaDuration: 0.04)
+    let halved = statistics(controller)
+    check(abs(halved.lowWaterDuration - base * 1.125) < 0.001,
+          "low water \(halved.lowWaterDuration) after 10 s of media, expected \(base * 1.125)")
+
+    recordSteps(controller, count: 1000, decodeTime: 0.005, ioTimes: [0.001], mediaDuration: 0.04)
+    let recovered = statistics(controller)
+    check(abs(recovered.lowWaterDuration - base) < tolerance,
+          "low water \(recovered.lowWaterDuration) after 50 s of media, \(base) before underruns")
+
+    // Steps which decoded nothing of the primary stream don't decay the boost
+    controller.recordUnderrun()
+    let boostedAgain = statistics(controller).lowWaterDuration
+    recordSteps(controller, count: 3, decodeTime: 0.005, ioTimes: [0.001], mediaDuration: 0)
+    let idle = statistics(controller).lowWaterDuration
+    check(abs(idle - boostedAgain) < tolerance, "low water \(idle) decayed without decoded media")
+}
+
+func testBoostCeiling() {
+    let controller = RDMPEGBufferingController(byteBudget: 0)
+    for _ in 0..<20 {
+        controller.recordUnderrun()
+    }
+    let boosted = statistics(controller)
+
+    check(abs(boosted.lowWaterDuration - minimumDuration * 4) < tolerance,
+          "low water \(boosted.lowWaterDuration) exceeds maximum underrun boost")
+    check(boosted.highWaterDuration <= 8.0, "high water \(boosted.highWaterDuration) exceeds ceiling")
+}
+
+func testByteBudget() {
+    let controller = RDMPEGBufferingController(byteBudget: 1000)
+
+    check(controller.isVideoBufferReady(duration: 0, byteSize: 1000), "buffer at byte budget is not ready")
+    check(controller.isVideoBufferFull(duration: 0, byteSize: 1000), "buffer at byte budget is not full")
+    check(controller.isVideoBufferFull(duration: 0, byteSize: 999) == false, "buffer under byte budget is full")
+
+    controller.sharedByteBudget = 500
+    check(controller.isVideoBufferFull(duration: 0, byteSize: 600), "smaller shared budget is ignored")
+    check(statistics(controller).byteBudget == 500, "effective budget \(statistics(controller).byteBudget)")
+
+    controller.byteBudget = 0
+    check(controller.isVideoBufferFull(duration: 0, byteSize: 500), "shared budget alone is ignored")
+    check(controller.isVideoBufferFull(duration: 0, byteSize: 499) == false, "buffer under shared budget is full")
+
+    controller.sharedByteBudget = 0
+    check(controller.isVideoBufferFull(duration: 0, byteSize: Int.max) == false, "buffer without budget is full")
+}
+
+testInitialWaterMarks()
+testFastSteadyDecoding()
+testIOJitter()
+testSlowDecoder()
+testUnderrunBoostDecay()
+testBoostCeiling()
+testByteBudget()
+
+if failuresCount == 0 {
+    print("PASS")
+    exit(0)
+}
+else {
+    print("FAIL: \(failuresCount) checks")
+    exit(1)
+}
@@ -0,0 +1,908 @@
+//
+//  RDMPEGCorpusGenerator.c
+//  RDMPEGCorpus
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/avstring.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/pixdesc.h>
+
+// Synthesises deterministic clips covering formats RDMPEGDecoder handles.
+// Content is a function of frame / sample index only and every encoder runs single threaded in bitexact mode,
+// so the same FFmpeg build always produces byte identical corpus.
+
+#define RDMPEG_CORPUS_MAX_AUDIO_STREAMS 2
+#define RDMPEG_CORPUS_MAX_SUBTITLE_STREAMS 2
+#define RDMPEG_CORPUS_SUBTITLE_INTERVAL_MS 2000
+#define RDMPEG_CORPUS_SUBTITLE_DURATION_MS 1500
+
+typedef struct RDMPEGCorpusAudioTrack {
+    const char *encoders;
+    uint64_t channelLayout;
+    const char *language;
+} RDMPEGCorpusAudioTrack;
+
+typedef struct RDMPEGCorpusSubtitleTrack {
+    const char *encoder;
+    const char *language;
+} RDMPEGCorpusSubtitleTrack;
+
+typedef struct RDMPEGCorpusClip {
+    const char *name;
+    const char *description;
+    // Comma separated list, first encoder available in FFmpeg build is used
+    const char *videoEncoders;
+    int width;
+    int height;
+    enum AVPixelFormat pixelFormat;
+    int frameRate;
+    int gopSize;
+    int isInterlaced;
+    int isVariableFrameRate;
+    int isIndexBroken;
+    RDMPEGCorpusAudioTrack audioTracks[RDMPEG_CORPUS_MAX_AUDIO_STREAMS];
+    RDMPEGCorpusSubtitleTrack subtitleTracks[RDMPEG_CORPUS_MAX_SUBTITLE_STREAMS];
+} RDMPEGCorpusClip;
+
+typedef struct RDMPEGCorpusStream {
+    AVStream *stream;
+    AVCodecContext *codecContext;
+    AVFrame *frame;
+    int64_t nextPts;
+    int64_t sampleIndex;
+    double frequency;
+    int isFinished;
+} RDMPEGCorpusStream;
+
+typedef struct RDMPEGCorpusOutput {
+    AVFormatContext *formatContext;
+    AVPacket *packet;
+    RDMPEGCorpusStream video;
+    RDMPEGCorpusStream audio[RDMPEG_CORPUS_MAX_AUDIO_STREAMS];
+    RDMPEGCorpusStream subtitles[RDMPEG_CORPUS_MAX_SUBTITLE_STREAMS];
+    int audioCount;
+    int subtitleCount;
+    int64_t frameIndex;
+} RDMPEGCorpusOutput;
+
+static int generate_clip(const RDMPEGCorpusClip *clip, const char *directory, double duration);
+static int output_open(RDMPEGCorpusOutput *output, const RDMPEGCorpusClip *clip, const char *path);
+static void output_close(RDMPEGCorpusOutput *output);
+static int add_video_stream(RDMPEGCorpusOutput *output, const RDMPEGCorpusClip *clip);
+static int add_audio_stream(RDMPEGCorpusOutput *output, const RDMPEGCorpusAudioTrack *track);
+static int add_subtitle_stream(RDMPEGCorpusOutput *output, const RDMPEGCorpusSubtitleTrack *track);
+static const AVCodec *find_encoder(const char *encoders, enum AVPixelFormat pixelFormat);
+static int open_encoder(RDMPEGCorpusOutput *output, RDMPEGCorpusStream *stream, AVDictionary **options);
+static int write_video_frame(RDMPEGCorpusOutput *output, const RDMPEGCorpusClip *clip);
+static int write_audio_frame(RDMPEGCorpusOutput *output, RDMPEGCorpusStream *stream);
+static int write_subtitles_until(RDMPEGCorpusOutput *output, int64_t timeMs);
+static int encode_and_write(RDMPEGCorpusOutput *output, RDMPEGCorpusStream *stream, AVFrame *frame);
+static void fill_video_frame(AVFrame *frame, int64_t frameIndex, int isInterlaced);
+static void fill_audio_frame(AVFrame *frame, int64_t sampleIndex, double frequency);
+static int64_t variable_frame_duration(int64_t frameIndex, AVRational timeBase);
+static int damage_transport_stream(const char *path);
+static void print_usage(const char *executable);
+
+static const char subtitle_header[] =
+    "[Script Info]\r\n"
+    "ScriptType: v4.00+\r\n"
+    "PlayResX: 384\r\n"
+    "PlayResY: 288\r\n"
+    "\r\n"
+    "[V4+ Styles]\r\n"
+    "Format: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, Bold, Italic, "
+    "Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, Alignment, "
+    "MarginL, MarginR, MarginV, Encoding\r\n"
+    "Style: Default,Arial,16,&Hffffff,&Hffffff,&H0,&H0,0,0,0,0,100,100,0,0,1,1,0,2,10,10,10,0\r\n"
+    "\r\n"
+    "[Events]\r\n"
+    "Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\r\n";
+
+#define STEREO_AAC {"aac,mp2", AV_CH_LAYOUT_STEREO, "eng"}
+
+static const RDMPEGCorpusClip corpus_clips[] = {
+    {
+        .name = "h264_360p_gop12.mp4",
+        .description = "H.264 640x360, short GOP",
+        .videoEncoders = "libx264,libopenh264",
+        .width = 640, .height = 360, .pixelFormat = AV_PIX_FMT_YUV420P, .frameRate = 30, .gopSize = 12,
+        .audioTracks = {STEREO_AAC},
+    },
+    {
+        .name = "h264_720p_gop60.mp4",
+        .description = "H.264 1280x720, 2 second GOP",
+        .videoEncoders = "libx264,libopenh264",
+        .width = 1280, .height = 720, .pixelFormat = AV_PIX_FMT_YUV420P, .frameRate = 30, .gopSize = 60,
+        .audioTracks = {STEREO_AAC},
+    },
+    {
+        .name = "h264_1080p_gop250.mp4",
+        .description = "H.264 1920x1080, long GOP (expensive seeks)",
+        .videoEncoders = "libx264,libopenh264",
+        .width = 1920, .height = 1080, .pixelFormat = AV_PIX_FMT_YUV420P, .frameRate = 30, .gopSize = 250,
+        .audioTracks = {STEREO_AAC},
+    },
+    {
+        .name = "hevc_720p_gop48.mkv",
+        .description = "HEVC 1280x720",
+        .videoEncoders = "libx265",
+        .width = 1280, .height = 720, .pixelFormat = AV_PIX_FMT_YUV420P, .frameRate = 24, .gopSize = 48,
+        .audioTracks = {STEREO_AAC},
+    },
+    {
+        .name = "hevc_1080p_gop120.mkv",
+        .description = "HEVC 1920x1080, long GOP",
+        .videoEncoders = "libx265",
+        .width = 1920, .height = 1080, .pixelFormat = AV_PIX_FMT_YUV420P, .frameRate = 30, .gopSize = 120,
+        .audioTracks = {STEREO_AAC},
+    },
+    {
+        .name = "h264_576i_interlaced.ts",
+        .description = "H.264 720x576 interlaced, top field first (deinterlace path)",
+        .videoEncoders = "libx264",
+        .width = 720, .height = 576, .pixelFormat = AV_PIX_FMT_YUV420P, .frameRate = 25, .gopSize = 25,
+        .isInterlaced = 1,
+        .audioTracks = {{"mp2,aac", AV_CH_LAYOUT_STEREO, "eng"}},
+    },
+    {
+        .name = "pixfmt_yuv422p.mkv",
+        .description = "4:2:2 chroma (BGRA conversion path)",
+        .videoEncoders = "libx264,ffv1",
+        .width = 640, .height = 360, .pixelFormat = AV_PIX_FMT_YUV422P, .frameRate = 30, .gopSize = 30,
+    },
+    {
+        .name = "pixfmt_yuv444p.mkv",
+        .description = "4:4:4 chroma (BGRA conversion path)",
+        .videoEncoders = "libx264,ffv1",
+        .width = 640, .height = 360, .pixelFormat = AV_PIX_FMT_YUV444P, .frameRate = 30, .gopSize = 30,
+    },
+    {
+        .name = "pixfmt_yuv420p10.mkv",
+        .description = "10 bit 4:2:0 (BGRA conversion path)",
+        .videoEncoders = "libx265,libx264,ffv1",
+        .width = 1280, .height = 720, .pixelFormat = AV_PIX_FMT_YUV420P10LE, .frameRate = 30, .gopSize = 30,
+    },
+    {
+        .name = "multitrack.mkv",
+        .description = "2 audio and 2 subtitle streams",
+        .videoEncoders = "libx264,libopenh264",
+        .width = 640, .height = 360, .pixelFormat = AV_PIX_FMT_YUV420P, .frameRate = 30, .gopSize = 60,
+        .audioTracks = {
+            STEREO_AAC,
+            {"ac3,aac", AV_CH_LAYOUT_5POINT1, "deu"},
+        },
+        .subtitleTracks = {
+            {"ass", "eng"},
+            {"subrip", "fra"},
+        },
+    },
+    {
+        .name = "vfr_360p.mkv",
+        .description = "Variable frame rate, 24/30/60 fps segments",
+        .videoEncoders = "libx264,libopenh264",
+        .width = 640, .height = 360, .pixelFormat = AV_PIX_FMT_YUV420P, .frameRate = 30, .gopSize = 60,
+        .isVariableFrameRate = 1,
+        .audioTracks = {STEREO_AAC},
+    },
+    {
+        .name = "broken_index.ts",
+        .description = "MPEG-TS with damaged packets and truncated tail",
+        .videoEncoders = "libx264,libopenh264",
+        .width = 640, .height = 360, .pixelFormat = AV_PIX_FMT_YUV420P, .frameRate = 30, .gopSize = 30,
+        .isIndexBroken = 1,
+        .audioTracks = {{"aac,mp2", AV_CH_LAYOUT_STEREO, "eng"}},
+    },
+};
+
+#define RDMPEG_CORPUS_CLIPS_COUNT (sizeof(corpus_clips) / sizeof(corpus_clips[0]))
+
+
+
+int main(int argc, char *argv[]) {
+    double duration = 10.0;
+    const char *onlyName = NULL;
+    int verbose = 0;
+
+    static const struct option longOptions[] = {
+        {"duration", required_argument, NULL, 'd'},
+        {"only", required_argument, NULL, 'n'},
+        {"list", no_argument, NULL, 'l'},
+        {"verbose", no_argument, NULL, 'v'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "d:n:lvh", longOptions, NULL)) != -1) {
+        switch (option) {
+            case 'd': duration = atof(optarg); break;
+            case 'n': onlyName = optarg; break;
+            case 'v': verbose = 1; break;
+            case 'l':
+                for (size_t i = 0; i < RDMPEG_CORPUS_CLIPS_COUNT; i++) {
+                    printf("%-24s %s\n", corpus_clips[i].name, corpus_clips[i].description);
+                }
+                return EXIT_SUCCESS;
+            case 'h': print_usage(argv[0]); return EXIT_SUCCESS;
+            default: print_usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (duration <= 0.0 || optind != argc - 1) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    av_log_set_level(verbose ? AV_LOG_INFO : AV_LOG_ERROR);
+
+    const char *directory = argv[optind];
+    int generatedCount = 0;
+    int skippedCount = 0;
+    int failedCount = 0;
+
+    for (size_t i = 0; i < RDMPEG_CORPUS_CLIPS_COUNT; i++) {
+        const RDMPEGCorpusClip *clip = &corpus_clips[i];
+        if (onlyName && strcmp(onlyName, clip->name) != 0) {
+            continue;
+        }
+
+        int status = generate_clip(clip, directory, duration);
+        if (status == AVERROR_ENCODER_NOT_FOUND) {
+            fprintf(stderr, "%-24s skipped, FFmpeg build lacks required encoder\n", clip->name);
+            skippedCount++;
+        }
+        else if (status < 0) {
+            fprintf(stderr, "%-24s failed: %s\n", clip->name, av_err2str(status));
+            failedCount++;
+        }
+        else {
+            fprintf(stderr, "%-24s %s\n", clip->name, clip->description);
+            generatedCount++;
+        }
+    }
+
+    fprintf(stderr, "Generated %d, skipped %d, failed %d\n", generatedCount, skippedCount, failedCount);
+
+    return failedCount > 0 || generatedCount == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+
+// MARK: - Clip
+
+static int generate_clip(const RDMPEGCorpusClip *clip, const char *directory, double duration) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", directory, clip->name);
+
+    RDMPEGCorpusOutput output = {0};
+    int status = output_open(&output, clip, path);
+    if (status < 0) {
+        output_close(&output);
+        unlink(path);
+        return status;
+    }
+
+    int64_t durationMs = (int64_t)(duration * 1000.0);
+
+    while (status >= 0) {
+        // Interleave streams by always writing the one that is behind
+        RDMPEGCorpusStream *nextStream = output.video.isFinished ? NULL : &output.video;
+        for (int i = 0; i < output.audioCount; i++) {
+            RDMPEGCorpusStream *audio = &output.audio[i];
+            if (audio->isFinished) {
+                continue;
+            }
+            if (nextStream == NULL ||
+                av_compare_ts(audio->nextPts, audio->codecContext->time_base,
+                              nextStream->nextPts, nextStream->codecContext->time_base) < 0)
+            {
+                nextStream = audio;
+            }
+        }
+
+        if (nextStream == NULL) {
+            break;
+        }
+
+        int64_t timeMs = av_rescale_q(nextStream->nextPts, nextStream->codecContext->time_base, (AVRational){1, 1000});
+        if (timeMs >= durationMs) {
+            status = encode_and_write(&output, nextStream, NULL);
+            nextStream->isFinished = 1;
+            continue;
+        }
+
+        status = write_subtitles_until(&output, timeMs);
+        if (status < 0) {
+            break;
+        }
+
+        if (nextStream == &output.video) {
+            status = write_video_frame(&output, clip);
+        }
+        else {
+            status = write_audio_frame(&output, nextStream);
+        }
+    }
+
+    if (status >= 0) {
+        status = write_subtitles_until(&output, durationMs - RDMPEG_CORPUS_SUBTITLE_DURATION_MS);
+    }
+    if (status >= 0) {
+        status = av_write_trailer(output.formatContext);
+    }
+
+    output_close(&output);
+
+    if (status >= 0 && clip->isIndexBroken) {
+        status = damage_transport_stream(path);
+    }
+    if (status < 0) {
+        unlink(path);
+    }
+
+    return status;
+}
+
+static int output_open(RDMPEGCorpusOutput *output, const RDMPEGCorpusClip *clip, const char *path) {
+    int status = avformat_alloc_output_context2(&output->formatContext, NULL, NULL, path);
+    if (status < 0) {
+        return status;
+    }
+
+    output->formatContext->flags |= AVFMT_FLAG_BITEXACT;
+
+    output->packet = av_packet_alloc();
+    if (output->packet == NULL) {
+        return AVERROR(ENOMEM);
+    }
+
+    status = add_video_stream(output, clip);
+
+    for (int i = 0; status >= 0 && i < RDMPEG_CORPUS_MAX_AUDIO_STREAMS && clip->audioTracks[i].encoders; i++) {
+        status = add_audio_stream(output, &clip->audioTracks[i]);
+    }
+
+    for (int i = 0; status >= 0 && i < RDMPEG_CORPUS_MAX_SUBTITLE_STREAMS && clip->subtitleTracks[i].encoder; i++) {
+        status = add_subtitle_stream(output, &clip->subtitleTracks[i]);
+    }
+
+    if (status < 0) {
+        return status;
+    }
+
+    av_dict_set(&output->formatContext->metadata, "title", clip->description, 0);
+
+    status = avio_open(&output->formatContext->pb, path, AVIO_FLAG_WRITE);
+    if (status < 0) {
+        return status;
+    }
+
+    return avformat_write_header(output->formatContext, NULL);
+}
+
+static void output_close(RDMPEGCorpusOutput *output) {
+    RDMPEGCorpusStream *streams[1 + RDMPEG_CORPUS_MAX_AUDIO_STREAMS + RDMPEG_CORPUS_MAX_SUBTITLE_STREAMS] = {
+        &output->video,
+        &output->audio[0],
+        &output->audio[1],
+        &output->subtitles[0],
+        &output->subtitles[1],
+    };
+
+    for (size_t i = 0; i < sizeof(streams) / sizeof(streams[0]); i++) {
+        avcodec_free_context(&streams[i]->codecContext);
+        av_frame_free(&streams[i]->frame);
+    }
+
+    if (output->formatContext) {
+        if (output->formatContext->pb) {
+            avio_closep(&output->formatContext->pb);
+        }
+        avformat_free_context(output->formatContext);
+        output->formatContext = NULL;
+    }
+
+    av_packet_free(&output->packet);
+}
+
+
+
+// MARK: - Streams
+
+static int add_video_stream(RDMPEGCorpusOutput *output, const RDMPEGCorpusClip *clip) {
+    const AVCodec *codec = find_encoder(clip->videoEncoders, clip->pixelFormat);
+    if (codec == NULL) {
+        return AVERROR_ENCODER_NOT_FOUND;
+    }
+
+    RDMPEGCorpusStream *stream = &output->video;
+    stream->codecContext = avcodec_alloc_context3(codec);
+    stream->frame = av_frame_alloc();
+    if (stream->codecContext == NULL || stream->frame == NULL) {
+        return AVERROR(ENOMEM);
+    }
+
+    AVCodecContext *codecContext = stream->codecContext;
+    codecContext->width = clip->width;
+    codecContext->height = clip->height;
+    codecContext->pix_fmt = clip->pixelFormat;
+    codecContext->gop_size = clip->gopSize;
+    codecContext->keyint_min = clip->gopSize;
+    codecContext->max_b_frames = 2;
+    codecContext->sample_aspect_ratio = (AVRational){1, 1};
+
+    // Variable frame rate clip gets fine grained time base, so 24, 30 and 60 fps durations are all exact,
+    // frame rate stays as nominal rate for encoder rate control
+    codecContext->time_base = clip->isVariableFrameRate ? (AVRational){1, 90000} : (AVRational){1, clip->frameRate};
+    codecContext->framerate = (AVRational){clip->frameRate, 1};
+
+    if (clip->isInterlaced) {
+        codecContext->flags |= AV_CODEC_FLAG_INTERLACED_DCT | AV_CODEC_FLAG_INTERLACED_ME;
+        codecContext->field_order = AV_FIELD_TT;
+    }
+
+    char keyframeParameters[128];
+    AVDictionary *options = NULL;
+
+    if (strcmp(codec->name, "libx264") == 0) {
+        snprintf(keyframeParameters, sizeof(keyframeParameters),
+                 "keyint=%d:min-keyint=%d:scenecut=0", clip->gopSize, clip->gopSize);
+        av_dict_set(&options, "preset", "veryfast", 0);
+        av_dict_set(&options, "x264-params", keyframeParameters, 0);
+    }
+    else if (strcmp(codec->name, "libx265") == 0) {
+        snprintf(keyframeParameters, sizeof(keyframeParameters),
+                 "keyint=%d:min-keyint=%d:scenecut=0:log-level=error:pools=none:frame-threads=1",
+                 clip->gopSize, clip->gopSize);
+        av_dict_set(&options, "preset", "ultrafast", 0);
+        av_dict_set(&options, "x265-params", keyframeParameters, 0);
+    }
+    else if (strcmp(codec->name, "ffv1") == 0) {
+        av_dict_set(&options, "level", "3", 0);
+    }
+
+    int status = open_encoder(output, stream, &options);
+    av_dict_free(&options);
+    if (status < 0) {
+        return status;
+    }
+
+    if (clip->isVariableFrameRate == 0) {
+        stream->stream->avg_frame_rate = codecContext->framerate;
+    }
+
+    stream->frame->format = codecContext->pix_fmt;
+    stream->frame->width = codecContext->width;
+    stream->frame->height = codecContext->height;
+
+    return av_frame_get_buffer(stream->frame, 0);
+}
+
+static int add_audio_stream(RDMPEGCorpusOutput *output, const RDMPEGCorpusAudioTrack *track) {
+    const AVCodec *codec = find_encoder(track->encoders, AV_PIX_FMT_NONE);
+    if (codec == NULL) {
+        return AVERROR_ENCODER_NOT_FOUND;
+    }
+
+    RDMPEGCorpusStream *stream = &output->audio[output->audioCount];
+    stream->codecContext = avcodec_alloc_context3(codec);
+    stream->frame = av_frame_alloc();
+    if (stream->codecContext == NULL || stream->frame == NULL) {
+        return AVERROR(ENOMEM);
+    }
+
+    // Encoders in corpus take either planar float or interleaved 16 bit samples
+    enum AVSampleFormat sampleFormat = AV_SAMPLE_FMT_NONE;
+    for (const enum AVSampleFormat *format = codec->sample_fmts; format && *format != AV_SAMPLE_FMT_NONE; format++) {
+        if (*format == AV_SAMPLE_FMT_FLTP || *format == AV_SAMPLE_FMT_S16) {
+            sampleFormat = *format;
+            break;
+        }
+    }
+
+    if (sampleFormat == AV_SAMPLE_FMT_NONE) {
+        return AVERROR(ENOSYS);
+    }
+
+    AVCodecContext *codecContext = stream->codecContext;
+    codecContext->sample_fmt = sampleFormat;
+    codecContext->sample_rate = 48000;
+    // Channel masks were replaced by AVChannelLayout in FFmpeg 5.1 and removed in 7.0
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    av_channel_layout_from_mask(&codecContext->ch_layout, track->channelLayout);
+#else
+    codecContext->channel_layout = track->channelLayout;
+    codecContext->channels = av_get_channel_layout_nb_channels(track->channelLayout);
+#endif
+    codecContext->bit_rate = 64000 * av_popcount64(track->channelLayout);
+    codecContext->time_base = (AVRational){1, codecContext->sample_rate};
+
+    int status = open_encoder(output, stream, NULL);
+    if (status < 0) {
+        return status;
+    }
+
+    av_dict_set(&stream->stream->metadata, "language", track->language, 0);
+
+    // Every track gets its own tone, so mixed up streams are audible
+    stream->frequency = 440.0 * (output->audioCount + 1);
+    output->audioCount++;
+
+    stream->frame->format = codecContext->sample_fmt;
+    stream->frame->sample_rate = codecContext->sample_rate;
+    stream->frame->nb_samples = codecContext->frame_size > 0 ? codecContext->frame_size : 1024;
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    status = av_channel_layout_copy(&stream->frame->ch_layout, &codecContext->ch_layout);
+    if (status < 0) {
+        return status;
+    }
+#else
+    stream->frame->channel_layout = codecContext->channel_layout;
+    stream->frame->channels = codecContext->channels;
+#endif
+
+    return av_frame_get_buffer(stream->frame, 0);
+}
+
+static int add_subtitle_stream(RDMPEGCorpusOutput *output, const RDMPEGCorpusSubtitleTrack *track) {
+    const AVCodec *codec = avcodec_find_encoder_by_name(track->encoder);
+    if (codec == NULL) {
+        return AVERROR_ENCODER_NOT_FOUND;
+    }
+
+    RDMPEGCorpusStream *stream = &output->subtitles[output->subtitleCount];
+    stream->codecContext = avcodec_alloc_context3(codec);
+    if (stream->codecContext == NULL) {
+        return AVERROR(ENOMEM);
+    }
+
+    // Text subtitle encoders take ASS events and need script header to parse them
+    AVCodecContext *codecContext = stream->codecContext;
+    codecContext->time_base = (AVRational){1, 1000};
+    codecContext->subtitle_header = (uint8_t *)av_strdup(subtitle_header);
+    codecContext->subtitle_header_size = (int)strlen(subtitle_header);
+    if (codecContext->subtitle_header == NULL) {
+        return AVERROR(ENOMEM);
+    }
+
+    int status = open_encoder(output, stream, NULL);
+    if (status < 0) {
+        return status;
+    }
+
+    av_dict_set(&stream->stream->metadata, "language", track->language, 0);
+    output->subtitleCount++;
+
+    return 0;
+}
+
+static const AVCodec *find_encoder(const char *encoders, enum AVPixelFormat pixelFormat) {
+    char *encodersCopy = av_strdup(encoders);
+    char *context = NULL;
+    const AVCodec *codec = NULL;
+
+    for (char *name = av_strtok(encodersCopy, ",", &context); name && codec == NULL; name = av_strtok(NULL, ",", &context)) {
+        codec = avcodec_find_encoder_by_name(name);
+
+        // libx264 and libx265 list only bit depths they were built with
+        if (codec && pixelFormat != AV_PIX_FMT_NONE && codec->pix_fmts) {
+            const enum AVPixelFormat *format = codec->pix_fmts;
+            while (*format != AV_PIX_FMT_NONE && *format != pixelFormat) {
+                format++;
+            }
+            if (*format == AV_PIX_FMT_NONE) {
+                codec = NULL;
+            }
+        }
+    }
+
+    av_free(encodersCopy);
+    return codec;
+}
+
+static int open_encoder(RDMPEGCorpusOutput *output, RDMPEGCorpusStream *stream, AVDictionary **options) {
+    AVCodecContext *codecContext = stream->codecContext;
+    codecContext->thread_count = 1;
+    codecContext->flags |= AV_CODEC_FLAG_BITEXACT;
+
+    if (output->formatContext->oformat->flags & AVFMT_GLOBALHEADER) {
+        codecContext->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    int status = avcodec_open2(codecContext, codecContext->codec, options);
+    if (status < 0) {
+        return status;
+    }
+
+    stream->stream = avformat_new_stream(output->formatContext, NULL);
+    if (stream->stream == NULL) {
+        return AVERROR(ENOMEM);
+    }
+
+    stream->stream->time_base = codecContext->time_base;
+
+    return avcodec_parameters_from_context(stream->stream->codecpar, codecContext);
+}
+
+
+
+// MARK: - Encoding
+
+static int write_video_frame(RDMPEGCorpusOutput *output, const RDMPEGCorpusClip *clip) {
+    RDMPEGCorpusStream *stream = &output->video;
+    AVFrame *frame = stream->frame;
+
+    int status = av_frame_make_writable(frame);
+    if (status < 0) {
+        return status;
+    }
+
+    fill_video_frame(frame, output->frameIndex, clip->isInterlaced);
+
+    frame->pts = stream->nextPts;
+#ifdef AV_FRAME_FLAG_INTERLACED
+    if (clip->isInterlaced) {
+        frame->flags |= AV_FRAME_FLAG_INTERLACED | AV_FRAME_FLAG_TOP_FIELD_FIRST;
+    }
+    else {
+        frame->flags &= ~(AV_FRAME_FLAG_INTERLACED | AV_FRAME_FLAG_TOP_FIELD_FIRST);
+    }
+#else
+    frame->interlaced_frame = clip->isInterlaced;
+    frame->top_field_first = clip->isInterlaced;
+#endif
+    frame->pict_type = AV_PICTURE_TYPE_NONE;
+
+    if (clip->isVariableFrameRate) {
+        stream->nextPts += variable_frame_duration(output->frameIndex, stream->codecContext->time_base);
+    }
+    else {
+        stream->nextPts++;
+    }
+
+    output->frameIndex++;
+
+    return encode_and_write(output, stream, frame);
+}
+
+static int write_audio_frame(RDMPEGCorpusOutput *output, RDMPEGCorpusStream *stream) {
+    AVFrame *frame = stream->frame;
+
+    int status = av_frame_make_writable(frame);
+    if (status < 0) {
+        return status;
+    }
+
+    fill_audio_frame(frame, stream->sampleIndex, stream->frequency);
+
+    frame->pts = stream->nextPts;
+    stream->nextPts += frame->nb_samples;
+    stream->sampleIndex += frame->nb_samples;
+
+    return encode_and_write(output, stream, frame);
+}
+
+static int write_subtitles_until(RDMPEGCorpusOutput *output, int64_t timeMs) {
+    for (int i = 0; i < output->subtitleCount; i++) {
+        RDMPEGCorpusStream *stream = &output->subtitles[i];
+
+        // Subtitle stream nextPts is start of next event in milliseconds
+        while (stream->nextPts <= timeMs) {
+            int eventIndex = (int)(stream->nextPts / RDMPEG_CORPUS_SUBTITLE_INTERVAL_MS);
+            char dialogue[128];
+            snprintf(dialogue, sizeof(dialogue), "%d,0,Default,,0,0,0,,Track %d line %d", eventIndex, i + 1, eventIndex + 1);
+
+            AVSubtitleRect rect = {
+                .type = SUBTITLE_ASS,
+                .ass = dialogue,
+            };
+            AVSubtitleRect *rects[] = {&rect};
+            AVSubtitle subtitle = {
+                .num_rects = 1,
+                .rects = rects,
+                .pts = av_rescale_q(stream->nextPts, (AVRational){1, 1000}, AV_TIME_BASE_Q),
+                .start_display_time = 0,
+                .end_display_time = RDMPEG_CORPUS_SUBTITLE_DURATION_MS,
+            };
+
+            uint8_t buffer[1024];
+            int size = avcodec_encode_subtitle(stream->codecContext, buffer, sizeof(buffer), &subtitle);
+            if (size < 0) {
+                return size;
+            }
+
+            AVPacket *packet = output->packet;
+            av_packet_unref(packet);
+            packet->data = buffer;
+            packet->size = size;
+            packet->stream_index = stream->stream->index;
+            packet->pts = av_rescale_q(stream->nextPts, (AVRational){1, 1000}, stream->stream->time_base);
+            packet->dts = packet->pts;
+            packet->duration = av_rescale_q(RDMPEG_CORPUS_SUBTITLE_DURATION_MS, (AVRational){1, 1000}, stream->stream->time_base);
+
+            int status = av_interleaved_write_frame(output->formatContext, packet);
+            packet->data = NULL;
+            packet->size = 0;
+            if (status < 0) {
+                return status;
+            }
+
+            stream->nextPts += RDMPEG_CORPUS_SUBTITLE_INTERVAL_MS;
+        }
+    }
+
+    return 0;
+}
+
+static int encode_and_write(RDMPEGCorpusOutput *output, RDMPEGCorpusStream *stream, AVFrame *frame) {
+    int status = avcodec_send_frame(stream->codecContext, frame);
+    if (status < 0) {
+        return status;
+    }
+
+    AVPacket *packet = output->packet;
+
+    while ((status = avcodec_receive_packet(stream->codecContext, packet)) >= 0) {
+        av_packet_rescale_ts(packet, stream->codecContext->time_base, stream->stream->time_base);
+        packet->stream_index = stream->stream->index;
+
+        status = av_interleaved_write_frame(output->formatContext, packet);
+        if (status < 0) {
+            return status;
+        }
+    }
+
+    return status == AVERROR(EAGAIN) || status == AVERROR_EOF ? 0 : status;
+}
+
+
+
+// MARK: - Content
+
+static void fill_video_frame(AVFrame *frame, int64_t frameIndex, int isInterlaced) {
+    const AVPixFmtDescriptor *descriptor = av_pix_fmt_desc_get(frame->format);
+    int depth = descriptor->comp[0].depth;
+    int isWide = depth > 8;
+
+    // Diagonal gradient moving 2 pixels per frame with bright box bouncing across it, so motion
+    // search, skip blocks and deblocking all get exercised. For interlaced content the bottom field
+    // is rendered half a frame later, which produces combing when frame isn't deinterlaced.
+    int boxSize = frame->height / 6;
+    int64_t boxTravel = frame->width - boxSize > 0 ? frame->width - boxSize : 1;
+
+    for (int plane = 0; plane < 3; plane++) {
+        int shiftX = plane > 0 ? descriptor->log2_chroma_w : 0;
+        int shiftY = plane > 0 ? descriptor->log2_chroma_h : 0;
+        int planeWidth = AV_CEIL_RSHIFT(frame->width, shiftX);
+        int planeHeight = AV_CEIL_RSHIFT(frame->height, shiftY);
+
+        for (int y = 0; y < planeHeight; y++) {
+            double time = (double)frameIndex + (isInterlaced && (y & 1) ? 0.5 : 0.0);
+            int64_t boxPosition = (int64_t)(time * 8.0) % (2 * boxTravel);
+            int boxX = (int)(boxPosition < boxTravel ? boxPosition : 2 * boxTravel - boxPosition);
+            int boxY = frame->height / 3;
+            int lumaY = y << shiftY;
+
+            uint8_t *row = frame->data[plane] + (ptrdiff_t)y * frame->linesize[plane];
+
+            for (int x = 0; x < planeWidth; x++) {
+                int lumaX = x << shiftX;
+                int isInBox = lumaX >= boxX && lumaX < boxX + boxSize && lumaY >= boxY && lumaY < boxY + boxSize;
+                int value;
+
+                if (plane == 0) {
+                    value = isInBox ? 235 : 16 + (int)((lumaX + lumaY + (int64_t)(time * 2.0)) % 200);
+                }
+                else if (plane == 1) {
+                    value = isInBox ? 128 : 64 + (lumaX * 128) / frame->width;
+                }
+                else {
+                    value = isInBox ? 128 : 64 + (lumaY * 128) / frame->height;
+                }
+
+                if (isWide) {
+                    ((uint16_t *)row)[x] = (uint16_t)(value << (depth - 8));
+                }
+                else {
+                    row[x] = (uint8_t)value;
+                }
+            }
+        }
+    }
+}
+
+static void fill_audio_frame(AVFrame *frame, int64_t sampleIndex, double frequency) {
+#ifdef AV_CHANNEL_LAYOUT_MASK
+    int channels = frame->ch_layout.nb_channels;
+#else
+    int channels = frame->channels;
+#endif
+
+    for (int i = 0; i < frame->nb_samples; i++) {
+        for (int channel = 0; channel < channels; channel++) {
+            // Channels are detuned from each other, so downmix and channel mapping bugs change the output
+            double channelFrequency = frequency * (1.0 + 0.25 * channel);
+            double sample = 0.5 * sin(2.0 * M_PI * channelFrequency * (double)(sampleIndex + i) / frame->sample_rate);
+
+            if (frame->format == AV_SAMPLE_FMT_FLTP) {
+                ((float *)frame->extended_data[channel])[i] = (float)sample;
+            }
+            else {
+                ((int16_t *)frame->data[0])[i * channels + channel] = (int16_t)lrint(sample * INT16_MAX);
+            }
+        }
+    }
+}
+
+static int64_t variable_frame_duration(int64_t frameIndex, AVRational timeBase) {
+    // One second segments at 30, 60 and 24 fps
+    static const int frameRates[] = {30, 60, 24};
+    int frameRate = frameRates[(frameIndex / 30) % 3];
+    return av_rescale_q(1, (AVRational){1, frameRate}, timeBase);
+}
+
+
+
+// MARK: - Damage
+
+static int damage_transport_stream(const char *path) {
+    const long packetSize = 188;
+
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL) {
+        return AVERROR(errno);
+    }
+
+    fseek(file, 0, SEEK_END);
+    long packetsCount = ftell(file) / packetSize;
+
+    // Garbage over about 1% of packets after first third of the stream (some with sync byte lost),
+    // then tail truncated mid packet, so duration can't be read from the last PCR and seeks land on damage.
+    uint32_t state = 1;
+    for (long packetIndex = packetsCount / 3; packetIndex < packetsCount; packetIndex++) {
+        state = state * 1664525u + 1013904223u;
+        if (state % 100 != 0) {
+            continue;
+        }
+
+        uint8_t garbage[188];
+        for (size_t i = 0; i < sizeof(garbage); i++) {
+            state = state * 1664525u + 1013904223u;
+            garbage[i] = (uint8_t)(state >> 24);
+        }
+
+        int keepsSync = (state & 1) == 0;
+        fseek(file, packetIndex * packetSize + keepsSync, SEEK_SET);
+        fwrite(garbage, 1, (size_t)(packetSize - keepsSync), file);
+    }
+
+    fflush(file);
+    int status = ftruncate(fileno(file), (off_t)(packetsCount * packetSize - packetSize * 20 - packetSize / 2));
+    fclose(file);
+
+    return status == 0 ? 0 : AVERROR(errno);
+}
+
+
+
+static void print_usage(const char *executable) {
+    fprintf(stderr,
+            "Usage: %s [options] <output directory>\n"
+            "\n"
+            "Options:\n"
+            "  -d, --duration SECONDS     duration of every clip (default: 10)\n"
+            "  -n, --only NAME            generate only clip NAME\n"
+            "  -l, --list                 list clips and exit\n"
+            "  -v, --verbose              keep libav info logging\n",
+            executable);
+}
@@ -0,0 +1,47 @@
+#!/bin/bash
+#
+# Builds corpus generator and benchmark, generates corpus (once) and checks benchmark against budgets.txt.
+# On macOS reverse playback benchmark of RDMPEGReverseDecoder itself is checked against the same budgets.
+# Exits with non-zero status when any clip fails to decode or any budget is violated.
+#
+#   Tools/RDMPEGCorpus/regression.sh [--regenerate] [extra rdmpeg-benchmark options]
+
+set -euo pipefail
+
+CORPUS_DIR="$(cd "$(dirname "$0")" && pwd)"
+BENCHMARK_DIR="$CORPUS_DIR/../RDMPEGBenchmark"
+REVERSE_BENCHMARK_DIR="$CORPUS_DIR/../RDMPEGReverseBenchmark"
+MEDIA_DIR="$CORPUS_DIR/corpus"
+REPORT="$CORPUS_DIR/regression-report.json"
+REVERSE_REPORT="$CORPUS_DIR/regression-reverse-report.json"
+
+if [[ "${1:-}" == "--regenerate" ]]; then
+    rm -rf "$MEDIA_DIR"
+    shift
+fi
+
+make -s -C "$CORPUS_DIR"
+make -s -C "$BENCHMARK_DIR"
+
+if [[ ! -d "$MEDIA_DIR" ]]; then
+    mkdir -p "$MEDIA_DIR"
+    "$CORPUS_DIR/rdmpeg-corpus-generator" "$MEDIA_DIR" || { rm -rf "$MEDIA_DIR"; exit 1; }
+fi
+
+"$BENCHMARK_DIR/rdmpeg-benchmark" \
+    --budgets "$CORPUS_DIR/budgets.txt" \
+    --output "$REPORT" \
+    "$@" \
+    "$MEDIA_DIR"
+
+# Reverse decoder is an Objective-C class, so it's measured on macOS only
+if [[ "$(uname -s)" == "Darwin" ]]; then
+    make -s -C "$REVERSE_BENCHMARK_DIR"
+    "$REVERSE_BENCHMARK_DIR/rdmpeg-reverse-benchmark" \
+        --budgets "$CORPUS_DIR/budgets.txt" \
+        --output "$REVERSE_REPORT" \
+        "$MEDIA_DIR"
+    echo "Reverse report: $REVERSE_REPORT"
+fi
+
+echo "All budgets met, report: $REPORT"
@@ -0,0 +1,218 @@
+//
+//  main.swift
+//  RDMPEGDecodePoolTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Checks the order RDMPEGDecodeStepScheduler hands decode slots out in on a simulated clock: priority order,
+// first come first served among equal priorities, slot limit, and that a lower priority step gets a slot
+// within a bounded time while higher priority players keep the pool busy (and starves without aging).
+// The threaded pass runs the shared pool with one slot: focused players decode without a pause while
+// an offscreen player waits for a single step. Slot requests check that a step which finds the pool busy
+// is handed a slot once one frees up, and that a dropped slot frees up as well.
+
+let agingInterval: TimeInterval = 0.1
+let stepDuration: TimeInterval = 0.01
+var failuresCount = 0
+
+func check(_ condition: Bool, _ message: @autoclosure () -> String) {
+    if !condition {
+        print("FAIL: \(message())")
+        failuresCount += 1
+    }
+}
+
+func testPriorityOrder() {
+    var scheduler = RDMPEGDecodeStepScheduler(maximumConcurrentSteps: 1, agingInterval: agingInterval)
+
+    let running = scheduler.enqueueStep(priority: .offscreen, time: 0)
+    check(scheduler.grantSlots(time: 0) == [running], "free slot not granted")
+
+    let offscreen = scheduler.enqueueStep(priority: .offscreen, time: 0.001)
+    let visible = scheduler.enqueueStep(priority: .visible, time: 0.002)
+    let focused = scheduler.enqueueStep(priority: .focused, time: 0.003)
+    let secondVisible = scheduler.enqueueStep(priority: .visible, time: 0.004)
+    check(scheduler.grantSlots(time: 0.005).isEmpty, "slot granted while the only one is busy")
+
+    var order: [Int] = []
+    var time = 0.005
+    while scheduler.waitingStepsCount > 0 {
+        scheduler.finishStep()
+        order += scheduler.grantSlots(time: time)
+        time += 0.001
+    }
+
+    check(order == [focused, visible, secondVisible, offscreen], "grant order \(order)")
+}
+
+func testSlotLimit() {
+    var scheduler = RDMPEGDecodeStepScheduler(maximumConcurrentSteps: 2, agingInterval: agingInterval)
+
+    for _ in 0..<3 {
+        _ = scheduler.enqueueStep(priority: .visible, time: 0)
+    }
+    check(scheduler.grantSlots(time: 0).count == 2, "two slots not granted at once")
+    check(scheduler.activeStepsCount == 2 && scheduler.waitingStepsCount == 1, "third step didn't wait")
+
+    scheduler.finishStep()
+    check(scheduler.grantSlots(time: 0.01).count == 1, "freed slot not granted")
+
+    scheduler.maximumConcurrentSteps = 3
+    _ = scheduler.enqueueStep(priority: .visible, time: 0.02)
+    check(scheduler.grantSlots(time: 0.02).count == 1, "raised limit not used")
+}
+
+// Two focused players decode back to back, so one of their steps is always waiting. Returns time
+// the offscreen step enqueued at 0 gets a slot, nil if it doesn't within the duration.
+func offscreenGrantTime(agingInterval: TimeInterval, duration: TimeInterval) -> TimeInterval? {
+    var scheduler = RDMPEGDecodeStepScheduler(maximumConcurrentSteps: 1, agingInterval: agingInterval)
+    var focusedSteps = Set<Int>()
+
+    focusedSteps.insert(scheduler.enqueueStep(priority: .focused, time: 0))
+    let offscreen = scheduler.enqueueStep(priority: .offscreen, time: 0)
+    focusedSteps.insert(scheduler.enqueueStep(priority: .focused, time: 0))
+
+    var running = scheduler.grantSlots(time: 0)
+    var milliseconds = 0
+
+    while Double(milliseconds) / 1000 < duration {
+        check(running.count == 1 && focusedSteps.contains(running[0]), "focused step didn't run first")
+
+        milliseconds += Int(stepDuration * 1000)
+        let time = Double(milliseconds) / 1000
+
+        // Player finishes its step and asks for the next one right away
+        scheduler.finishStep()
+        running = scheduler.grantSlots(time: time)
+        focusedSteps.insert(scheduler.enqueueStep(priority: .focused, time: time))
+
+        if running == [offscreen] {
+            return time
+        }
+    }
+
+    return nil
+}
+
+func testStarvation() {
+    guard let grantTime = offscreenGrantTime(agingInterval: agingInterval, duration: 10) else {
+        check(false, "offscreen step starved")
+        return
+    }
+
+    // Offscreen step catches up with focused ones after two aging intervals and then waits longer than them
+    check(grantTime >= agingInterval * 2 - stepDuration, "offscreen step jumped ahead at \(grantTime) s")
+    check(grantTime <= agingInterval * 2 + stepDuration * 2, "offscreen step waited \(grantTime) s")
+    check(offscreenGrantTime(agingInterval: .infinity, duration: 10) == nil, "offscreen step ran without aging")
+
+    print("offscreen step granted after \(grantTime) s behind two busy focused players")
+}
+
+final class StepMeter {
+    private let lock = NSLock()
+    private var activeSteps = 0
+    private(set) var maximumActiveSteps = 0
+    private(set) var focusedStepsCount = 0
+
+    func step(focused: Bool) {
+        lock.withLock {
+            activeSteps += 1
+            maximumActiveSteps = max(maximumActiveSteps, activeSteps)
+            focusedStepsCount += focused ? 1 : 0
+        }
+
+        Thread.sleep(forTimeInterval: 0.002)
+
+        lock.withLock {
+            activeSteps -= 1
+        }
+    }
+}
+
+func testThreadedPool() {
+    let pool = RDMPEGDecodePool.shared
+    pool.maximumConcurrentSteps = 1
+
+    let meter = StepMeter()
+    let focusedClients = [pool.makeClient(priority: .focused), pool.makeClient(priority: .focused)]
+    let offscreenClient = pool.makeClient(priority: .offscreen)
+    let group = DispatchGroup()
+    let deadline = ProcessInfo.processInfo.systemUptime + 1.5
+    var offscreenWaitingTime: TimeInterval = 0
+
+    for client in focusedClients {
+        DispatchQueue.global().async(group: group) {
+            while ProcessInfo.processInfo.systemUptime < deadline {
+                client.performDecodeStep { meter.step(focused: true) }
+            }
+        }
+    }
+
+    DispatchQueue.global().async(group: group) {
+        Thread.sleep(forTimeInterval: 0.2)
+        let requestTime = ProcessInfo.processInfo.systemUptime
+        offscreenClient.performDecodeStep { meter.step(focused: false) }
+        offscreenWaitingTime = ProcessInfo.processInfo.systemUptime - requestTime
+    }
+
+    group.wait()
+
+    check(meter.maximumActiveSteps == 1, "\(meter.maximumActiveSteps) steps ran at once with one slot")
+    check(meter.focusedStepsCount > 100, "focused players made only \(meter.focusedStepsCount) steps")
+    check(offscreenWaitingTime < 0.5, "offscreen step waited \(offscreenWaitingTime) s")
+
+    print("""
+        threaded: \(meter.focusedStepsCount) focused steps, offscreen step waited \
+        \(String(format: "%.3f", offscreenWaitingTime)) s
+        """)
+}
+
+func testSlotRequests() {
+    let pool = RDMPEGDecodePool.shared
+    pool.maximumConcurrentSteps = 1
+
+    let client = pool.makeClient(priority: .visible)
+    var grantedSlots: [RDMPEGDecodeSlot] = []
+    let request = { (slot: RDMPEGDecodeSlot) in grantedSlots.append(slot) }
+
+    guard let slot = client.acquireDecodeSlot(orRequest: request) else {
+        check(false, "free slot not acquired")
+        return
+    }
+
+    check(client.acquireDecodeSlot(orRequest: request) == nil, "busy slot acquired")
+    check(client.acquireDecodeSlot(orRequest: request) == nil, "busy slot acquired")
+    check(grantedSlots.isEmpty, "request granted while the slot is busy")
+
+    slot.release()
+    slot.release()
+    check(grantedSlots.count == 1, "\(grantedSlots.count) requests granted by one released slot")
+
+    // Slot dropped without release frees up once deallocated
+    _ = grantedSlots.removeFirst()
+    check(grantedSlots.count == 1, "dropped slot didn't free up")
+
+    grantedSlots.removeFirst().release()
+
+    let freeSlot = client.acquireDecodeSlot { _ in check(false, "slot leaked") }
+    check(freeSlot != nil, "slot leaked")
+    freeSlot?.release()
+}
+
+testPriorityOrder()
+testSlotLimit()
+testStarvation()
+testThreadedPool()
+testSlotRequests()
+
+if failuresCount == 0 {
+    print("PASS")
+    exit(0)
+}
+else {
+    print("FAIL: \(failuresCount) checks")
+    exit(1)
+}
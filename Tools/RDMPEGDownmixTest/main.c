@@ -0,0 +1,145 @@
+//
+//  main.c
+//  RDMPEGDownmixTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "../../RDMPEG/RDMPEGDecoder/RDMPEGDownmix/RDMPEGDownmix.h"
+#include <math.h>
+#include <stdio.h>
+
+// Checks per-channel gains of downmix matrices of common layouts against values computed by hand: ITU-R BS.775
+// and dialogue boost levels, LFE dropped, rows normalized to the loudest one.
+
+#define LAYOUT_5POINT1 (RDMPEG_DOWNMIX_LAYOUT_STEREO | RDMPEG_DOWNMIX_CHANNEL_FRONT_CENTER | \
+                        RDMPEG_DOWNMIX_CHANNEL_LOW_FREQUENCY | RDMPEG_DOWNMIX_CHANNEL_SIDE_LEFT | \
+                        RDMPEG_DOWNMIX_CHANNEL_SIDE_RIGHT)
+#define LAYOUT_7POINT1 (LAYOUT_5POINT1 | RDMPEG_DOWNMIX_CHANNEL_BACK_LEFT | RDMPEG_DOWNMIX_CHANNEL_BACK_RIGHT)
+#define LAYOUT_SURROUND (RDMPEG_DOWNMIX_LAYOUT_STEREO | RDMPEG_DOWNMIX_CHANNEL_FRONT_CENTER)
+
+static int failuresCount = 0;
+
+static void check(int condition, const char *description) {
+    printf("%s %s\n", condition ? "PASS" : "FAIL", description);
+    if (!condition) {
+        failuresCount++;
+    }
+}
+
+static int gains_match(const double *matrix, const double *expected, int count) {
+    for (int i = 0; i < count; i++) {
+        if (fabs(matrix[i] - expected[i]) > 1e-6) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void print_matrix(const char *name, const double *matrix, int outputsCount, int stride) {
+    printf("     %s:", name);
+
+    for (int output = 0; output < outputsCount; output++) {
+        printf(output == 0 ? " " : " | ");
+
+        for (int input = 0; input < stride; input++) {
+            printf("%.4f ", matrix[output * stride + input]);
+        }
+    }
+
+    printf("\n");
+}
+
+static void test_5point1(void) {
+    // FL FR FC LFE SL SR
+    double matrix[2 * 6];
+    double ituSum = 1.0 + M_SQRT1_2 + M_SQRT1_2;
+    const double itu[2 * 6] = {
+        1.0 / ituSum, 0.0, M_SQRT1_2 / ituSum, 0.0, M_SQRT1_2 / ituSum, 0.0,
+        0.0, 1.0 / ituSum, M_SQRT1_2 / ituSum, 0.0, 0.0, M_SQRT1_2 / ituSum,
+    };
+
+    check(rdmpeg_downmix_matrix(LAYOUT_5POINT1, RDMPEG_DOWNMIX_LAYOUT_STEREO, RDMPEGDownmixLevelsITU, matrix, 6),
+          "5.1 to stereo needs matrix");
+    print_matrix("5.1 ITU", matrix, 2, 6);
+    check(gains_match(matrix, itu, 2 * 6), "5.1 ITU: centre and surrounds at -3 dB, LFE dropped");
+
+    const double boost[2 * 6] = {
+        0.4, 0.0, 0.4, 0.0, 0.2, 0.0,
+        0.0, 0.4, 0.4, 0.0, 0.0, 0.2,
+    };
+
+    rdmpeg_downmix_matrix(LAYOUT_5POINT1, RDMPEG_DOWNMIX_LAYOUT_STEREO, RDMPEGDownmixLevelsDialogueBoost, matrix, 6);
+    print_matrix("5.1 dialogue boost", matrix, 2, 6);
+    check(gains_match(matrix, boost, 2 * 6), "5.1 dialogue boost: centre as loud as fronts, surrounds at -6 dB");
+
+    double mono[6];
+    double monoSum = 0.5 + 0.5 + M_SQRT1_2 + 0.5 * M_SQRT1_2 * 2;
+    const double expectedMono[6] = {
+        0.5 / monoSum, 0.5 / monoSum, M_SQRT1_2 / monoSum, 0.0, 0.5 * M_SQRT1_2 / monoSum, 0.5 * M_SQRT1_2 / monoSum,
+    };
+
+    rdmpeg_downmix_matrix(LAYOUT_5POINT1, RDMPEG_DOWNMIX_LAYOUT_MONO, RDMPEGDownmixLevelsITU, mono, 6);
+    print_matrix("5.1 mono", mono, 1, 6);
+    check(gains_match(mono, expectedMono, 6), "5.1 to mono is the mean of stereo rows");
+}
+
+static void test_7point1(void) {
+    // FL FR FC LFE BL BR SL SR
+    double matrix[2 * 8];
+    double sum = 1.0 + M_SQRT1_2 * 3;
+    double front = 1.0 / sum;
+    double other = M_SQRT1_2 / sum;
+    const double expected[2 * 8] = {
+        front, 0.0, other, 0.0, other, 0.0, other, 0.0,
+        0.0, front, other, 0.0, 0.0, other, 0.0, other,
+    };
+
+    rdmpeg_downmix_matrix(LAYOUT_7POINT1, RDMPEG_DOWNMIX_LAYOUT_STEREO, RDMPEGDownmixLevelsITU, matrix, 8);
+    print_matrix("7.1 ITU", matrix, 2, 8);
+    check(gains_match(matrix, expected, 2 * 8), "7.1 ITU: back and side channels go to their side");
+}
+
+static void test_stride(void) {
+    // FL FR FC, padded rows
+    double matrix[2 * 4];
+    double sum = 1.0 + M_SQRT1_2;
+    const double expected[2 * 4] = {
+        1.0 / sum, 0.0, M_SQRT1_2 / sum, 0.0,
+        0.0, 1.0 / sum, M_SQRT1_2 / sum, 0.0,
+    };
+
+    rdmpeg_downmix_matrix(LAYOUT_SURROUND, RDMPEG_DOWNMIX_LAYOUT_STEREO, RDMPEGDownmixLevelsITU, matrix, 4);
+    check(gains_match(matrix, expected, 2 * 4), "3.0 with stride wider than inputs count");
+    check(rdmpeg_downmix_matrix(LAYOUT_SURROUND, RDMPEG_DOWNMIX_LAYOUT_STEREO, RDMPEGDownmixLevelsITU, matrix, 2) ==
+          false, "too narrow stride is rejected");
+}
+
+static void test_no_matrix(void) {
+    double matrix[8 * 8];
+
+    check(rdmpeg_downmix_matrix(RDMPEG_DOWNMIX_LAYOUT_STEREO, RDMPEG_DOWNMIX_LAYOUT_STEREO, RDMPEGDownmixLevelsITU,
+                                matrix, 8) == false, "stereo to stereo needs no matrix");
+    check(rdmpeg_downmix_matrix(LAYOUT_5POINT1, LAYOUT_7POINT1, RDMPEGDownmixLevelsITU, matrix, 8) == false,
+          "upmix is left to resampler");
+
+    double mono[2];
+    rdmpeg_downmix_matrix(RDMPEG_DOWNMIX_LAYOUT_STEREO, RDMPEG_DOWNMIX_LAYOUT_MONO, RDMPEGDownmixLevelsITU, mono, 2);
+    check(mono[0] == 0.5 && mono[1] == 0.5, "stereo to mono halves both channels");
+}
+
+int main(void) {
+    test_5point1();
+    test_7point1();
+    test_stride();
+    test_no_matrix();
+
+    if (failuresCount > 0) {
+        printf("FAIL: %d checks failed\n", failuresCount);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
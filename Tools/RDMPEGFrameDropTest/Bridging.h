@@ -0,0 +1,8 @@
+//
+//  Bridging.h
+//  RDMPEGFrameDropTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#import "../../RDMPEG/RDMPEGDecoder/RDMPEGDecoder.h"
@@ -0,0 +1,215 @@
+//
+//  main.swift
+//  RDMPEGFrameDropTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Reports presented and dropped frames to RDMPEGFrameDropController on a simulated host clock and checks
+// when decoder frame skip escalates (lateness threshold, consecutive late frames) and recovers (interval
+// without late frames), that frame skip holds across clock stops and underruns and starts over on reset.
+
+let latenessThreshold: TimeInterval = 0.04
+let escalationFrames = 8
+let recoveryInterval: TimeInterval = 3.0
+let frameInterval: TimeInterval = 1.0 / 30.0
+var failuresCount = 0
+
+func check(_ condition: Bool, _ message: @autoclosure () -> String) {
+    if !condition {
+        print("FAIL: \(message())")
+        failuresCount += 1
+    }
+}
+
+// Host time advances by frame interval with every reported frame
+final class FrameReporter {
+    let controller = RDMPEGFrameDropController()
+    var hostTime: TimeInterval = 1000
+
+    func present(lateness: TimeInterval, count: Int = 1) {
+        for _ in 0..<count {
+            hostTime += frameInterval
+            controller.recordPresentedFrame(lateness: lateness, hostTime: hostTime)
+        }
+    }
+
+    func drop(count: Int = 1) {
+        for _ in 0..<count {
+            hostTime += frameInterval
+            controller.recordDroppedFrame(hostTime: hostTime)
+        }
+    }
+
+    func presentOnTime(for interval: TimeInterval) {
+        present(lateness: 0, count: Int(interval / frameInterval))
+    }
+}
+
+func testLatenessThreshold() {
+    let reporter = FrameReporter()
+
+    reporter.present(lateness: latenessThreshold, count: escalationFrames * 4)
+    check(reporter.controller.frameSkip == .none, "frames late by exactly threshold escalated frame skip")
+    check(reporter.controller.statistics().lateFrames == 0, "frames at threshold counted as late")
+
+    reporter.present(lateness: latenessThreshold + 0.001, count: escalationFrames)
+    check(reporter.controller.frameSkip == .nonReference, "frames over threshold didn't escalate frame skip")
+
+    // At 2x rate media lateness covers half the real time
+    let fastReporter = FrameReporter()
+    fastReporter.controller.startClock(RDMPEGCorrectionInfo(playbackStartTime: 0, playbackRate: 2))
+    fastReporter.present(lateness: latenessThreshold * 1.5, count: escalationFrames * 4)
+    check(fastReporter.controller.frameSkip == .none, "lateness not scaled by playback rate")
+    fastReporter.present(lateness: latenessThreshold * 2.5, count: escalationFrames)
+    check(fastReporter.controller.frameSkip == .nonReference, "late frames at 2x rate didn't escalate")
+}
+
+func testEscalation() {
+    let reporter = FrameReporter()
+
+    reporter.present(lateness: 0.1, count: escalationFrames - 1)
+    check(reporter.controller.frameSkip == .none, "escalated before \(escalationFrames) late frames")
+
+    // On-time frame breaks the streak
+    reporter.present(lateness: 0)
+    reporter.present(lateness: 0.1, count: escalationFrames - 1)
+    check(reporter.controller.frameSkip == .none, "streak survived on-time frame")
+
+    reporter.present(lateness: 0.1)
+    check(reporter.controller.frameSkip == .nonReference, "\(escalationFrames) late frames didn't escalate")
+
+    // Dropped frames are late frames too, escalation goes one level at a time
+    reporter.drop(count: escalationFrames - 1)
+    check(reporter.controller.frameSkip == .nonReference, "escalated again before another streak")
+    reporter.drop()
+    check(reporter.controller.frameSkip == .bidirectional, "dropped frames didn't escalate")
+
+    reporter.present(lateness: 0.1, count: escalationFrames)
+    check(reporter.controller.frameSkip == .nonKey, "third streak didn't escalate to non-key")
+
+    reporter.present(lateness: 0.1, count: escalationFrames * 4)
+    check(reporter.controller.frameSkip == .nonKey, "escalated past non-key")
+
+    let statistics = reporter.controller.statistics()
+    check(statistics.skipEscalations == 3, "skip escalations \(statistics.skipEscalations)")
+    check(statistics.droppedFrames == UInt(escalationFrames), "dropped frames \(statistics.droppedFrames)")
+    check(statistics.frameSkip == .nonKey, "statistics frame skip \(statistics.frameSkip.rawValue)")
+}
+
+func testRecovery() {
+    let reporter = FrameReporter()
+    reporter.present(lateness: 0.1, count: escalationFrames * 3)
+    check(reporter.controller.frameSkip == .nonKey, "setup didn't escalate to non-key")
+
+    reporter.presentOnTime(for: recoveryInterval - 0.2)
+    check(reporter.controller.frameSkip == .nonKey, "relaxed before recovery interval")
+
+    reporter.presentOnTime(for: 0.4)
+    check(reporter.controller.frameSkip == .bidirectional, "didn't relax after recovery interval")
+
+    // Next level needs another full interval
+    reporter.presentOnTime(for: recoveryInterval - 0.2)
+    check(reporter.controller.frameSkip == .bidirectional, "relaxed two levels within one interval")
+
+    // Late frame restarts recovery interval without escalating
+    reporter.present(lateness: 0.1)
+    reporter.presentOnTime(for: recoveryInterval - 0.2)
+    check(reporter.controller.frameSkip == .bidirectional, "late frame didn't restart recovery interval")
+
+    reporter.presentOnTime(for: 0.4)
+    check(reporter.controller.frameSkip == .nonReference, "didn't relax to non-reference")
+
+    reporter.presentOnTime(for: recoveryInterval + 0.2)
+    check(reporter.controller.frameSkip == .none, "didn't relax to none")
+
+    reporter.presentOnTime(for: recoveryInterval * 3)
+    check(reporter.controller.frameSkip == .none, "relaxed past none")
+    check(reporter.controller.statistics().skipEscalations == 3, "recovery counted as escalation")
+}
+
+func testStopClock() {
+    let reporter = FrameReporter()
+    let clock = RDMPEGCorrectionInfo(playbackStartTime: 10, playbackRate: 1)
+    reporter.controller.startClock(clock)
+    check(reporter.controller.clockPosition != nil, "clock position missing while clock runs")
+
+    reporter.present(lateness: 0.1, count: escalationFrames * 2)
+    check(reporter.controller.frameSkip == .bidirectional, "setup didn't escalate to bidirectional")
+
+    reporter.controller.stopClock()
+    check(reporter.controller.clockPosition == nil, "clock position kept after stop")
+    check(reporter.controller.frameSkip == .bidirectional,
+          "frame skip \(reporter.controller.frameSkip.rawValue) reset by clock stop")
+
+    // Seek, rate or item change starts over, streak included
+    reporter.controller.resetFrameSkip()
+    check(reporter.controller.frameSkip == .none,
+          "frame skip \(reporter.controller.frameSkip.rawValue) kept after reset")
+
+    reporter.present(lateness: 0.1, count: escalationFrames - 1)
+    reporter.controller.resetFrameSkip()
+    reporter.controller.startClock(clock)
+    reporter.present(lateness: 0.1)
+    check(reporter.controller.frameSkip == .none, "late streak kept across reset")
+
+    let statistics = reporter.controller.statistics()
+    check(statistics.skipEscalations == 2, "skip escalations \(statistics.skipEscalations) reset by reset")
+}
+
+// Decoder that can't keep up drains the buffer, so underruns (clock stop and restart from the next frame)
+// come between late frames
+func testUnderruns() {
+    let reporter = FrameReporter()
+    let clock = RDMPEGCorrectionInfo(playbackStartTime: 10, playbackRate: 1)
+
+    func underrun() {
+        reporter.controller.stopClock()
+        reporter.hostTime += 0.5
+        reporter.controller.startClock(clock)
+    }
+
+    // Underrun doesn't break the streak
+    reporter.controller.startClock(clock)
+    reporter.present(lateness: 0.1, count: escalationFrames / 2)
+    underrun()
+    reporter.present(lateness: 0.1, count: escalationFrames - escalationFrames / 2)
+    check(reporter.controller.frameSkip == .nonReference, "underrun broke late frames streak")
+
+    for cycle in 0..<20 {
+        underrun()
+        reporter.present(lateness: 0.1, count: 3)
+        check(reporter.controller.frameSkip != .none, "frame skip reset by underrun in cycle \(cycle)")
+    }
+
+    check(reporter.controller.frameSkip == .nonKey,
+          "frame skip \(reporter.controller.frameSkip.rawValue) didn't keep escalating across underruns")
+
+    // Skip level holds through underruns while frames on time in between are shorter than recovery interval
+    for cycle in 0..<10 {
+        underrun()
+        reporter.present(lateness: 0)
+        reporter.present(lateness: 0.1, count: 2)
+        check(reporter.controller.frameSkip == .nonKey, "frame skip relaxed in underrun cycle \(cycle)")
+    }
+
+    let statistics = reporter.controller.statistics()
+    check(statistics.skipEscalations == 3, "skip escalations \(statistics.skipEscalations)")
+}
+
+testLatenessThreshold()
+testEscalation()
+testRecovery()
+testStopClock()
+testUnderruns()
+
+if failuresCount == 0 {
+    print("PASS")
+    exit(0)
+}
+else {
+    print("FAIL: \(failuresCount) checks")
+    exit(1)
+}
@@ -0,0 +1,79 @@
+//
+//  main.swift
+//  RDMPEGFrameQueueBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Compares RDMPEGFrameQueue with Array based queue framebuffer used before (append, removeFirst and reduce over durations).
+// Every iteration is what decoding and rendering loops do per frame at steady queue depth:
+// push, buffered duration query, pop.
+
+final class BenchmarkFrame {
+    let duration: TimeInterval
+    let byteSize: Int
+
+    init(duration: TimeInterval, byteSize: Int) {
+        self.duration = duration
+        self.byteSize = byteSize
+    }
+}
+
+let depths = [8, 32, 128, 512, 2048]
+let iterations = 100_000
+var checksum: Double = 0
+
+func measureNanosecondsPerIteration(_ body: () -> Double) -> Double {
+    let startTime = DispatchTime.now().uptimeNanoseconds
+    checksum += body()
+    let endTime = DispatchTime.now().uptimeNanoseconds
+    return Double(endTime - startTime) / Double(iterations)
+}
+
+@inline(never)
+func runFrameQueue(depth: Int, frames: [BenchmarkFrame]) -> Double {
+    var queue = RDMPEGFrameQueue<BenchmarkFrame>(capacity: 64)
+    for frame in frames.prefix(depth) {
+        queue.append(frame, duration: frame.duration, byteSize: frame.byteSize)
+    }
+
+    var bufferedDuration: Double = 0
+    for iteration in 0..<iterations {
+        let frame = frames[iteration % frames.count]
+        queue.append(frame, duration: frame.duration, byteSize: frame.byteSize)
+        bufferedDuration += queue.duration
+        _ = queue.popFirst()
+    }
+
+    return bufferedDuration
+}
+
+@inline(never)
+func runArrayQueue(depth: Int, frames: [BenchmarkFrame]) -> Double {
+    var queue = Array(frames.prefix(depth))
+
+    var bufferedDuration: Double = 0
+    for iteration in 0..<iterations {
+        queue.append(frames[iteration % frames.count])
+        bufferedDuration += queue.reduce(0) { $0 + $1.duration }
+        _ = queue.removeFirst()
+    }
+
+    return bufferedDuration
+}
+
+let frames = (0..<4096).map { index in
+    BenchmarkFrame(duration: index % 2 == 0 ? 1.0 / 30.0 : 1.0 / 60.0, byteSize: 1920 * 1080 * 3 / 2)
+}
+
+print("depth   RDMPEGFrameQueue ns/op   Array ns/op")
+for depth in depths {
+    let queueTime = measureNanosecondsPerIteration { runFrameQueue(depth: depth, frames: frames) }
+    let arrayTime = measureNanosecondsPerIteration { runArrayQueue(depth: depth, frames: frames) }
+    print(String(format: "%5d   %22.1f   %11.1f", depth, queueTime, arrayTime))
+}
+
+// Keeps optimizer from throwing measured loops away
+print(String(format: "checksum %.3f", checksum))
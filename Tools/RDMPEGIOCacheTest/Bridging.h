@@ -0,0 +1,11 @@
+//
+//  Bridging.h
+//  RDMPEGIOCacheTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#import "../../RDMPEG/RDMPEGDecoder/RDMPEGIOStream.h"
+
+// Same as libavformat/avio.h, the only libav* symbol cache sources use
+#define AVSEEK_FORCE 0x20000
@@ -0,0 +1,391 @@
+//
+//  main.swift
+//  RDMPEGIOCacheTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Reads content through RDMPEGCachingIOStream over a counting in-memory upstream and checks that ranges
+// which are already cached (by this cache instance or by a previous one over the same directory)
+// are never requested from upstream again, and that corrupted and evicted blocks are fetched again.
+// Crash recovery runs a copy of this test as a writer process and kills it while it writes.
+
+let blockSize = RDMPEGIOCache.blockSize
+let readSize = 32 * 1024
+let writerArgument = "writer"
+let crashKeysCount = 8
+let crashContentLength = 6 * blockSize + 1000
+// Keys the writer completes before it is killed, more than one round over all keys
+let crashCompletedKeysCount = 2 * crashKeysCount + 3
+// Never occurs in UTF-8, so logging of the writer can't be taken for it
+let crashKeyCompletedMarker: UInt8 = 0xff
+var failuresCount = 0
+
+func check(_ condition: Bool, _ message: @autoclosure () -> String) {
+    if !condition {
+        print("FAIL: \(message())")
+        failuresCount += 1
+    }
+}
+
+// Deterministic pseudo-random content
+func makeContent(length: Int, seed: UInt32) -> Data {
+    var state = seed
+    var content = Data(count: length)
+    for index in 0..<length {
+        state = state &* 1664525 &+ 1013904223
+        content[index] = UInt8(truncatingIfNeeded: state >> 24)
+    }
+    return content
+}
+
+// Remote stream stand-in, counts every byte and block range served
+final class CountingStream: NSObject, RDMPEGIOStream {
+    let content: Data
+    private(set) var bytesRead = 0
+    private(set) var seeksCount = 0
+    private(set) var fetchedBlocks = Set<Int>()
+    private var position = 0
+
+    init(content: Data) {
+        self.content = content
+        super.init()
+    }
+
+    func open() -> Bool {
+        position = 0
+        return true
+    }
+
+    func close() {
+    }
+
+    func readBuffer(_ buffer: UnsafeMutablePointer<UInt8>, length: Int) -> Int {
+        let bytesToCopy = min(length, content.count - position)
+        guard bytesToCopy > 0 else {
+            return 0
+        }
+
+        content.copyBytes(to: buffer, from: position..<(position + bytesToCopy))
+        fetchedBlocks.formUnion((position / blockSize)...((position + bytesToCopy - 1) / blockSize))
+        position += bytesToCopy
+        bytesRead += bytesToCopy
+        return bytesToCopy
+    }
+
+    func writeBuffer(_ buffer: UnsafeMutablePointer<UInt8>, length: Int) -> Int {
+        return -1
+    }
+
+    func seekOffset(_ offset: UInt64, whence: Int) -> UInt64 {
+        seeksCount += 1
+
+        switch Int32(whence) {
+        case SEEK_SET:
+            position = Int(offset)
+        case SEEK_CUR:
+            position += Int(Int64(bitPattern: offset))
+        case SEEK_END:
+            position = content.count + Int(Int64(bitPattern: offset))
+        default:
+            return UInt64.max
+        }
+        return UInt64(position)
+    }
+
+    func contentLength() -> UInt64 {
+        return UInt64(content.count)
+    }
+}
+
+// Reads range in demuxer sized chunks and compares it with content
+func read(_ stream: RDMPEGCachingIOStream, range: Range<Int>, content: Data, label: String) {
+    check(stream.seekOffset(UInt64(range.lowerBound), whence: Int(SEEK_SET)) == UInt64(range.lowerBound),
+          "\(label): seek to \(range.lowerBound)")
+
+    var buffer = [UInt8](repeating: 0, count: readSize)
+    var position = range.lowerBound
+
+    while position < range.upperBound {
+        let length = min(readSize, range.upperBound - position)
+        let result = stream.readBuffer(&buffer, length: length)
+
+        guard result > 0 else {
+            check(false, "\(label): read at \(position) returned \(result)")
+            return
+        }
+
+        if buffer[0..<result].elementsEqual(content[position..<(position + result)]) == false {
+            check(false, "\(label): wrong bytes at \(position)")
+            return
+        }
+
+        position += result
+    }
+}
+
+func makeDirectory() -> URL {
+    let directoryURL = FileManager.default.temporaryDirectory
+        .appendingPathComponent("rdmpeg-io-cache-test-\(UUID().uuidString)")
+    try? FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true)
+    return directoryURL
+}
+
+func fileSize(at url: URL) -> UInt64 {
+    return (try? FileManager.default.attributesOfItem(atPath: url.path)[.size] as? UInt64) ?? 0
+}
+
+func testRepeatedReads() {
+    let directoryURL = makeDirectory()
+    defer { try? FileManager.default.removeItem(at: directoryURL) }
+
+    let content = makeContent(length: 10 * blockSize + 1234, seed: 1)
+    let cache = RDMPEGIOCache(directoryURL: directoryURL, capacity: 64 * UInt64(blockSize))
+
+    let firstUpstream = CountingStream(content: content)
+    let firstStream = RDMPEGCachingIOStream(stream: firstUpstream, cache: cache, contentKey: "content")
+    check(firstStream.open(), "open")
+    read(firstStream, range: 0..<content.count, content: content, label: "first read")
+    check(firstUpstream.bytesRead == content.count,
+          "first read fetched \(firstUpstream.bytesRead) bytes, expected \(content.count)")
+
+    // Seeking back within the same stream doesn't reach upstream
+    read(firstStream, range: 3 * blockSize + 100..<5 * blockSize, content: content, label: "seek back")
+    check(firstUpstream.bytesRead == content.count,
+          "seek back fetched \(firstUpstream.bytesRead - content.count) bytes")
+    firstStream.close()
+
+    let journalURL = directoryURL.appendingPathComponent("index.rdjournal")
+    let journalSize = fileSize(at: journalURL)
+    check(journalSize > 0, "blocks aren't journaled")
+
+    // Reopened stream is served from cache completely, end of content included
+    let secondUpstream = CountingStream(content: content)
+    let secondStream = RDMPEGCachingIOStream(stream: secondUpstream, cache: cache, contentKey: "content")
+    check(secondStream.open(), "reopen")
+    read(secondStream, range: 0..<content.count, content: content, label: "second read")
+    check(secondStream.contentLength() == UInt64(content.count), "content length")
+    check(secondStream.seekOffset(0, whence: Int(SEEK_END)) == UInt64(content.count), "seek to end")
+
+    var buffer = [UInt8](repeating: 0, count: readSize)
+    check(secondStream.readBuffer(&buffer, length: readSize) == 0, "read at end")
+    check(secondUpstream.bytesRead == 0, "reopened stream fetched \(secondUpstream.bytesRead) bytes")
+    secondStream.close()
+
+    // Replaying cached content doesn't change the index
+    check(fileSize(at: journalURL) == journalSize,
+          "journal size changed by cached reads: \(journalSize) -> \(fileSize(at: journalURL)) bytes")
+    check(cache.totalSize == UInt64(content.count), "total size \(cache.totalSize), expected \(content.count)")
+}
+
+func testSparseRanges() {
+    let directoryURL = makeDirectory()
+    defer { try? FileManager.default.removeItem(at: directoryURL) }
+
+    let content = makeContent(length: 8 * blockSize, seed: 2)
+    let cache = RDMPEGIOCache(directoryURL: directoryURL, capacity: 64 * UInt64(blockSize))
+    let upstream = CountingStream(content: content)
+    let stream = RDMPEGCachingIOStream(stream: upstream, cache: cache, contentKey: "sparse")
+    check(stream.open(), "open")
+
+    read(stream, range: 4 * blockSize + 10..<5 * blockSize + 10, content: content, label: "blocks 4-5")
+    check(upstream.fetchedBlocks == [4, 5], "fetched blocks \(upstream.fetchedBlocks.sorted()), expected 4, 5")
+
+    // Overlapping range only fetches blocks which are missing
+    read(stream, range: 3 * blockSize..<7 * blockSize - 1, content: content, label: "blocks 3-6")
+    check(upstream.fetchedBlocks == [3, 4, 5, 6], "fetched blocks \(upstream.fetchedBlocks.sorted()), expected 3-6")
+    check(upstream.bytesRead == 4 * blockSize, "fetched \(upstream.bytesRead) bytes, expected \(4 * blockSize)")
+    stream.close()
+
+    // New cache instance over the same directory loads the index instead of fetching again
+    let reloadedCache = RDMPEGIOCache(directoryURL: directoryURL, capacity: 64 * UInt64(blockSize))
+    let reloadedUpstream = CountingStream(content: content)
+    let reloadedStream = RDMPEGCachingIOStream(stream: reloadedUpstream, cache: reloadedCache, contentKey: "sparse")
+    check(reloadedStream.open(), "reopen")
+    read(reloadedStream, range: 0..<content.count, content: content, label: "after reload")
+    check(reloadedUpstream.fetchedBlocks == [0, 1, 2, 7],
+          "fetched blocks after reload \(reloadedUpstream.fetchedBlocks.sorted()), expected 0, 1, 2, 7")
+    reloadedStream.close()
+}
+
+func testCorruptedBlock() {
+    let directoryURL = makeDirectory()
+    defer { try? FileManager.default.removeItem(at: directoryURL) }
+
+    let content = makeContent(length: 4 * blockSize, seed: 3)
+    let cache = RDMPEGIOCache(directoryURL: directoryURL, capacity: 64 * UInt64(blockSize))
+
+    let firstStream = RDMPEGCachingIOStream(stream: CountingStream(content: content), cache: cache, contentKey: "bad")
+    check(firstStream.open(), "open")
+    read(firstStream, range: 0..<content.count, content: content, label: "fill")
+    firstStream.close()
+
+    let fileURLs = (try? FileManager.default.contentsOfDirectory(
+        at: directoryURL,
+        includingPropertiesForKeys: nil
+    )) ?? []
+    let dataFileURLs = fileURLs.filter { $0.pathExtension == "rdcache" }
+    check(dataFileURLs.count == 1, "\(dataFileURLs.count) data files")
+
+    if let dataFileURL = dataFileURLs.first, let handle = try? FileHandle(forUpdating: dataFileURL) {
+        try? handle.seek(toOffset: UInt64(2 * blockSize + 7))
+        try? handle.write(contentsOf: Data([content[2 * blockSize + 7] ^ 0xff]))
+        try? handle.close()
+    }
+
+    let upstream = CountingStream(content: content)
+    let stream = RDMPEGCachingIOStream(stream: upstream, cache: cache, contentKey: "bad")
+    check(stream.open(), "reopen")
+    read(stream, range: 0..<content.count, content: content, label: "corrupted")
+    check(upstream.fetchedBlocks == [2], "fetched blocks \(upstream.fetchedBlocks.sorted()), expected 2")
+    stream.close()
+}
+
+func testEviction() {
+    let directoryURL = makeDirectory()
+    defer { try? FileManager.default.removeItem(at: directoryURL) }
+
+    let firstContent = makeContent(length: 3 * blockSize, seed: 4)
+    let secondContent = makeContent(length: 3 * blockSize, seed: 5)
+    let cache = RDMPEGIOCache(directoryURL: directoryURL, capacity: 4 * UInt64(blockSize))
+
+    let firstStream = RDMPEGCachingIOStream(stream: CountingStream(content: firstContent), cache: cache,
+                                            contentKey: "first")
+    check(firstStream.open(), "open first")
+    read(firstStream, range: 0..<firstContent.count, content: firstContent, label: "first")
+    firstStream.close()
+
+    // Second content doesn't fit next to the first one, which isn't opened, so the first one is evicted
+    let secondStream = RDMPEGCachingIOStream(stream: CountingStream(content: secondContent), cache: cache,
+                                             contentKey: "second")
+    check(secondStream.open(), "open second")
+    read(secondStream, range: 0..<secondContent.count, content: secondContent, label: "second")
+    secondStream.close()
+
+    check(cache.totalSize <= 4 * UInt64(blockSize), "total size \(cache.totalSize) exceeds capacity")
+    check(cache.containsBlock(at: 0, forKey: "first") == false, "least recently used content kept")
+    check(cache.containsBlock(at: 2, forKey: "second"), "recently used content evicted")
+
+    let upstream = CountingStream(content: firstContent)
+    let stream = RDMPEGCachingIOStream(stream: upstream, cache: cache, contentKey: "first")
+    check(stream.open(), "reopen first")
+    read(stream, range: 0..<firstContent.count, content: firstContent, label: "first again")
+    check(upstream.bytesRead == firstContent.count, "evicted content fetched \(upstream.bytesRead) bytes")
+    stream.close()
+}
+
+func crashContent(at keyIndex: Int) -> Data {
+    return makeContent(length: crashContentLength, seed: 100 + UInt32(keyIndex))
+}
+
+// Writer process: rewrites crash keys in turn, reporting every completed key with a marker on stdout
+func runWriter(directoryURL: URL) -> Never {
+    let cache = RDMPEGIOCache(directoryURL: directoryURL, capacity: 64 * UInt64(blockSize))
+    let contents = (0..<crashKeysCount).map { crashContent(at: $0) }
+
+    for round in 0..<10_000 {
+        let keyIndex = round % crashKeysCount
+        let key = "crash-\(keyIndex)"
+
+        cache.removeData(forKey: key)
+
+        let stream = RDMPEGCachingIOStream(stream: CountingStream(content: contents[keyIndex]), cache: cache,
+                                           contentKey: key)
+        _ = stream.open()
+        read(stream, range: 0..<crashContentLength, content: contents[keyIndex], label: key)
+        stream.close()
+
+        FileHandle.standardOutput.write(Data([crashKeyCompletedMarker]))
+    }
+
+    exit(0)
+}
+
+func testKilledWriter() {
+    let directoryURL = makeDirectory()
+    defer { try? FileManager.default.removeItem(at: directoryURL) }
+
+    let outputPipe = Pipe()
+    let writer = Process()
+    writer.executableURL = URL(fileURLWithPath: CommandLine.arguments[0])
+    writer.arguments = [writerArgument, directoryURL.path]
+    writer.standardOutput = outputPipe
+
+    do {
+        try writer.run()
+    }
+    catch {
+        check(false, "unable to run writer: \(error)")
+        return
+    }
+
+    // Writer is killed right after a completed key, while it resets and writes the next one
+    var completedKeysCount = 0
+    while completedKeysCount < crashCompletedKeysCount {
+        let output = outputPipe.fileHandleForReading.availableData
+        guard !output.isEmpty else { break }
+        completedKeysCount += output.filter { $0 == crashKeyCompletedMarker }.count
+    }
+
+    kill(writer.processIdentifier, SIGKILL)
+    writer.waitUntilExit()
+
+    check(completedKeysCount >= crashCompletedKeysCount, "writer exited after \(completedKeysCount) keys")
+    check(writer.terminationReason == .uncaughtSignal, "writer wasn't killed")
+
+    // Torn tail of a journal write, as if the kill landed in the middle of it
+    let journalURL = directoryURL.appendingPathComponent("index.rdjournal")
+    if let handle = try? FileHandle(forWritingTo: journalURL) {
+        _ = try? handle.seekToEnd()
+        try? handle.write(contentsOf: Data([0x00, 0x10, 0x00, 0x00, 0x62, 0x70, 0x6c]))
+        try? handle.close()
+    }
+    else {
+        check(false, "writer left no journal")
+    }
+
+    let cache = RDMPEGIOCache(directoryURL: directoryURL, capacity: 64 * UInt64(blockSize))
+    check(cache.totalSize <= UInt64(crashKeysCount * crashContentLength),
+          "recovered total size \(cache.totalSize) exceeds written content")
+    check(fileSize(at: journalURL) == 0, "journal isn't folded into the index on recovery")
+
+    // Every key reads back intact, only the one being written when killed may be fetched again
+    var recoveredKeysCount = 0
+
+    for keyIndex in 0..<crashKeysCount {
+        let content = crashContent(at: keyIndex)
+        let upstream = CountingStream(content: content)
+        let stream = RDMPEGCachingIOStream(stream: upstream, cache: cache, contentKey: "crash-\(keyIndex)")
+        check(stream.open(), "open crash-\(keyIndex) after recovery")
+        read(stream, range: 0..<content.count, content: content, label: "crash-\(keyIndex) after recovery")
+        stream.close()
+
+        if upstream.bytesRead == 0 {
+            recoveredKeysCount += 1
+        }
+    }
+
+    check(recoveredKeysCount >= crashKeysCount - 1,
+          "\(recoveredKeysCount) of \(crashKeysCount) keys recovered, expected at least \(crashKeysCount - 1)")
+}
+
+if CommandLine.arguments.count == 3, CommandLine.arguments[1] == writerArgument {
+    runWriter(directoryURL: URL(fileURLWithPath: CommandLine.arguments[2]))
+}
+
+testRepeatedReads()
+testSparseRanges()
+testCorruptedBlock()
+testEviction()
+testKilledWriter()
+
+if failuresCount == 0 {
+    print("PASS")
+    exit(0)
+}
+else {
+    print("FAIL: \(failuresCount) checks")
+    exit(1)
+}
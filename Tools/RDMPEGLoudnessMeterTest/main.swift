@@ -0,0 +1,176 @@
+//
+//  main.swift
+//  RDMPEGLoudnessMeterTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Known answers of RDMPEGLoudnessMeter on synthetic signals of EBU Tech 3341: 997 Hz sine at -23 and -33 dBFS
+// reads -23 and -33 LUFS, relative gate ignores quiet parts (cases 3 and 5), a single channel reads 3 dB lower,
+// surround and LFE channels get their BS.1770 weights, and true peak of a 12 kHz sine sampled 45 degrees off
+// its peaks is found between samples (case 15). Samples are fed in chunks which don't align with 100 ms steps.
+
+let samplingRate: Double = 48_000
+let chunkFramesCount = 1_000
+// EBU Tech 3341 tolerance of integrated loudness and true peak
+let loudnessTolerance = 0.1
+let truePeakTolerance = (below: 0.4, above: 0.2)
+var failuresCount = 0
+
+func check(_ condition: Bool, _ message: @autoclosure () -> String) {
+    if !condition {
+        print("FAIL: \(message())")
+        failuresCount += 1
+    }
+}
+
+struct Tone {
+    let level: Double
+    let duration: TimeInterval
+    var frequency: Double = 997
+    var phase: Double = 0
+}
+
+// Interleaved samples, tones follow each other in every active channel, others are silent
+func signal(_ tones: [Tone], channelsCount: Int, activeChannels: Set<Int>, samplingRate: Double) -> [Float] {
+    var samples: [Float] = []
+
+    for tone in tones {
+        let amplitude = pow(10, tone.level / 20)
+        let framesCount = Int((tone.duration * samplingRate).rounded())
+
+        for frame in 0..<framesCount {
+            let time = Double(frame) / samplingRate
+            let value = Float(amplitude * sin(2 * Double.pi * tone.frequency * time + tone.phase))
+
+            for channel in 0..<channelsCount {
+                samples.append(activeChannels.contains(channel) ? value : 0)
+            }
+        }
+    }
+
+    return samples
+}
+
+func measure(_ samples: [Float], meter: RDMPEGLoudnessMeter) -> RDMPEGLoudness {
+    samples.withUnsafeBufferPointer { buffer in
+        var offset = 0
+
+        while offset < buffer.count {
+            let count = min(chunkFramesCount * meter.channelsCount, buffer.count - offset)
+            meter.process(UnsafeBufferPointer(rebasing: buffer[offset..<(offset + count)]))
+            offset += count
+        }
+    }
+
+    return meter.loudness
+}
+
+func checkLoudness(
+    _ name: String,
+    _ tones: [Tone],
+    expected: Double,
+    channelWeights: [Double] = [1, 1],
+    activeChannels: Set<Int> = [0, 1],
+    samplingRate: Double = samplingRate
+) {
+    let meter = RDMPEGLoudnessMeter(samplingRate: samplingRate, channelWeights: channelWeights)
+    let samples = signal(
+        tones,
+        channelsCount: channelWeights.count,
+        activeChannels: activeChannels,
+        samplingRate: samplingRate
+    )
+    let loudness = measure(samples, meter: meter)
+
+    check(abs(loudness.integratedLoudness - expected) <= loudnessTolerance,
+          "\(name): \(loudness.integratedLoudness) LUFS, expected \(expected)")
+
+    print("\(name): \(loudness)")
+}
+
+func testSine() {
+    checkLoudness("3341 case 1", [Tone(level: -23, duration: 20)], expected: -23)
+    checkLoudness("3341 case 2", [Tone(level: -33, duration: 20)], expected: -33)
+    checkLoudness("44.1 kHz", [Tone(level: -23, duration: 20)], expected: -23, samplingRate: 44_100)
+
+    // BS.1770: 0 dBFS sine in a single channel reads -3.01 LKFS
+    checkLoudness("single channel", [Tone(level: -23, duration: 20)], expected: -26.01, activeChannels: [0])
+    checkLoudness("mono", [Tone(level: -23, duration: 20)], expected: -26.01, channelWeights: [1], activeChannels: [0])
+}
+
+func testGating() {
+    checkLoudness(
+        "3341 case 3",
+        [Tone(level: -36, duration: 10), Tone(level: -23, duration: 60), Tone(level: -36, duration: 10)],
+        expected: -23
+    )
+    checkLoudness(
+        "3341 case 5",
+        [Tone(level: -26, duration: 20), Tone(level: -20, duration: 20.1), Tone(level: -26, duration: 20)],
+        expected: -23
+    )
+}
+
+func testChannelWeights() {
+    // 5.1 as FFmpeg orders it: L R C LFE Ls Rs
+    let weights: [Double] = [1, 1, 1, 0, 1.41, 1.41]
+
+    checkLoudness(
+        "5.1 surround channel",
+        [Tone(level: -23, duration: 20)],
+        expected: -26.01 + 10 * log10(1.41),
+        channelWeights: weights,
+        activeChannels: [4]
+    )
+
+    let meter = RDMPEGLoudnessMeter(samplingRate: samplingRate, channelWeights: weights)
+    let lfeSamples = signal(
+        [Tone(level: -23, duration: 20)],
+        channelsCount: weights.count,
+        activeChannels: [3],
+        samplingRate: samplingRate
+    )
+    let loudness = measure(lfeSamples, meter: meter)
+    check(loudness.integratedLoudness == -.infinity, "LFE counted: \(loudness.integratedLoudness) LUFS")
+    check(abs(loudness.truePeak + 23) < 0.1, "LFE true peak \(loudness.truePeak) dBTP")
+}
+
+func testTruePeak() {
+    // Samples of 12 kHz sine 45 degrees off its peaks are 3 dB below them
+    let tone = Tone(level: -6.02, duration: 2, frequency: 12_000, phase: Double.pi / 4)
+    let samples = signal([tone], channelsCount: 2, activeChannels: [0, 1], samplingRate: samplingRate)
+    let samplePeak = 20 * log10(Double(samples.map { abs($0) }.max() ?? 0))
+    let loudness = measure(samples, meter: RDMPEGLoudnessMeter(samplingRate: samplingRate, channelsCount: 2))
+
+    check(abs(samplePeak + 9.03) < 0.05, "sample peak \(samplePeak) dBFS")
+    check(loudness.truePeak >= -6 - truePeakTolerance.below && loudness.truePeak <= -6 + truePeakTolerance.above,
+          "3341 case 15: true peak \(loudness.truePeak) dBTP, sample peak \(samplePeak) dBFS")
+
+    print("3341 case 15: true peak \(String(format: "%.2f", loudness.truePeak)) dBTP")
+}
+
+func testSilence() {
+    let meter = RDMPEGLoudnessMeter(samplingRate: samplingRate, channelsCount: 2)
+    let loudness = measure([Float](repeating: 0, count: Int(samplingRate) * 2 * 2), meter: meter)
+
+    check(loudness.integratedLoudness == -.infinity, "silence \(loudness.integratedLoudness) LUFS")
+    check(loudness.truePeak == -.infinity, "silence \(loudness.truePeak) dBTP")
+}
+
+testSine()
+testGating()
+testChannelWeights()
+testTruePeak()
+testSilence()
+
+if failuresCount == 0 {
+    print("PASS")
+    exit(0)
+}
+else {
+    print("FAIL: \(failuresCount) checks")
+    exit(1)
+}
@@ -0,0 +1,14 @@
+//
+//  Bridging.h
+//  RDMPEGReverseBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include <libavutil/avutil.h>
+#include "RDMPEGBenchmarkBudgets.h"
+#include "RDMPEGBenchmarkMedia.h"
+#include "RDMPEGBenchmarkReport.h"
+
+// Swift doesn't import FFERRTAG based error codes
+static const int RDMPEGAVErrorStreamNotFound = AVERROR_STREAM_NOT_FOUND;
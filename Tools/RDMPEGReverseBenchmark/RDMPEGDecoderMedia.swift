@@ -0,0 +1,104 @@
+//
+//  RDMPEGDecoderMedia.swift
+//  RDMPEGReverseBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Stand-ins for the decoder types RDMPEGReverseDecoder uses, backed by the benchmark's media reader, which runs
+// RDMPEGDecoder's own seeks and conversions from RDMPEGDecodeCore. Converted frames are released right away,
+// frames keep the byte size they would have, so reverse decoder budgets and splits GOPs as in the player.
+// They are public, as the reverse decoder interface refers to them.
+
+@objcMembers
+public class RDMPEGFrame: NSObject {
+    let position: TimeInterval
+    let byteSize: Int
+
+    init(position: TimeInterval, byteSize: Int) {
+        self.position = position
+        self.byteSize = byteSize
+        super.init()
+    }
+}
+
+public class RDMPEGVideoFrame: RDMPEGFrame {
+    var isKeyframe = false
+}
+
+// Used from reverse decoder worker queue only, counters are read once playback is over
+@objcMembers
+public class RDMPEGDecoder: NSObject {
+    private var media: RDMPEGBenchmarkMedia
+    private(set) var isEndReached = false
+    // First error reading or decoding media, 0 when there was none
+    private(set) var status: Int32 = 0
+    // Frames decoded since creation, including ones decoded again
+    private(set) var decodedFramesCount = 0
+    private(set) var keyframePositions = Set<TimeInterval>()
+
+    var duration: TimeInterval {
+        withUnsafePointer(to: media) { rdmpeg_benchmark_media_duration($0) }
+    }
+
+    // Media should be opened with video stream, it's closed along with decoder
+    init(media: RDMPEGBenchmarkMedia) {
+        self.media = media
+        super.init()
+    }
+
+    deinit {
+        rdmpeg_benchmark_media_close(&media)
+    }
+
+    // Media is opened without them
+    func deactivateAudioStream() {
+    }
+
+    func deactivateSubtitleStream() {
+    }
+
+    func moveToKeyframe(before position: TimeInterval) {
+        isEndReached = false
+
+        let seekStatus = rdmpeg_benchmark_media_seek_keyframe(&media, position)
+        if seekStatus < 0 && status == 0 {
+            status = seekStatus
+        }
+    }
+
+    func decodeFrames() -> [RDMPEGFrame]? {
+        guard !isEndReached else {
+            return nil
+        }
+
+        while true {
+            let bytesCopied = media.bytesCopied
+            var position: Double = 0
+            let frameType = rdmpeg_benchmark_media_next_frame(&media, &position)
+
+            if frameType == Int32(RDMPEGBenchmarkFrameTypeVideo.rawValue) {
+                let frame = RDMPEGVideoFrame(position: position, byteSize: Int(media.bytesCopied - bytesCopied))
+                frame.isKeyframe = media.videoFrameKeyframe != 0
+                decodedFramesCount += 1
+
+                if frame.isKeyframe {
+                    keyframePositions.insert(position)
+                }
+
+                return [frame]
+            }
+
+            if frameType < 0 && status == 0 {
+                status = frameType
+            }
+
+            if frameType <= 0 {
+                isEndReached = true
+                return nil
+            }
+        }
+    }
+}
@@ -0,0 +1,299 @@
+//
+//  main.swift
+//  RDMPEGReverseBenchmark
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Plays every file backwards from the end through RDMPEGReverseDecoder and reports reverse fps next to the GOP
+// length of the file and how many times frames were decoded (GOP which doesn't fit the half of the budget is
+// decoded again from its keyframe). Frames handed out out of order or more than once are counted as well,
+// so open GOP leading frames taken for keyframes show up in the report. Report and budgets are the ones of
+// rdmpeg-benchmark, under the "reverse" pass.
+
+struct Options {
+    var byteBudget = 128 * 1024 * 1024
+    var deinterlace = false
+    var outputPath: String?
+    var budgetsPath: String?
+    var verbose = false
+    var paths: [String] = []
+}
+
+// Budgets keep metric names by pointer, as C string literals would be
+func metricName(_ name: StaticString) -> UnsafePointer<CChar> {
+    UnsafeRawPointer(name.utf8Start).assumingMemoryBound(to: CChar.self)
+}
+
+func errorDescription(_ status: Int32) -> String {
+    var buffer = [CChar](repeating: 0, count: 256)
+    av_strerror(status, &buffer, buffer.count)
+    return String(cString: buffer)
+}
+
+func printUsage() {
+    let usage = """
+    Usage: \(CommandLine.arguments[0]) [options] <file or directory>...
+
+    Options:
+      -c, --reverse-budget MB    RDMPEGReverseDecoder byteBudget (default: 128)
+      -d, --deinterlace          deinterlace interlaced video, as RDMPEGDecoder isDeinterlacingEnabled
+      -o, --output FILE          write JSON report to FILE instead of stdout
+      -b, --budgets FILE         check "reverse" pass metrics against budgets in FILE, exit with failure on violation
+      -v, --verbose              keep libav info logging
+
+    """
+    FileHandle.standardError.write(usage.data(using: .utf8)!)
+}
+
+func parseOptions() -> Options? {
+    var options = Options()
+    var arguments = CommandLine.arguments.dropFirst()
+
+    while let argument = arguments.popFirst() {
+        switch argument {
+        case "-c", "--reverse-budget":
+            guard let value = arguments.popFirst().flatMap({ Int($0) }), value > 0 else { return nil }
+            options.byteBudget = value * 1024 * 1024
+        case "-d", "--deinterlace":
+            options.deinterlace = true
+        case "-o", "--output":
+            guard let value = arguments.popFirst() else { return nil }
+            options.outputPath = value
+        case "-b", "--budgets":
+            guard let value = arguments.popFirst() else { return nil }
+            options.budgetsPath = value
+        case "-v", "--verbose":
+            options.verbose = true
+        default:
+            guard !argument.hasPrefix("-") else { return nil }
+            options.paths.append(argument)
+        }
+    }
+
+    return options.paths.isEmpty ? nil : options
+}
+
+// Directory entries are sorted so reports of the same corpus are always in the same order
+func corpusPaths(_ paths: [String]) -> [String] {
+    var corpus: [String] = []
+
+    for path in paths {
+        var isDirectory: ObjCBool = false
+
+        guard FileManager.default.fileExists(atPath: path, isDirectory: &isDirectory) else {
+            FileHandle.standardError.write("\(path): No such file or directory\n".data(using: .utf8)!)
+            continue
+        }
+
+        guard isDirectory.boolValue else {
+            corpus.append(path)
+            continue
+        }
+
+        let names = (try? FileManager.default.contentsOfDirectory(atPath: path)) ?? []
+
+        for name in names.sorted() where !name.hasPrefix(".") {
+            let entryPath = (path as NSString).appendingPathComponent(name)
+
+            if FileManager.default.fileExists(atPath: entryPath, isDirectory: &isDirectory), !isDirectory.boolValue {
+                corpus.append(entryPath)
+            }
+        }
+    }
+
+    return corpus
+}
+
+// Frames handed out per GOP, GOP being frames from a keyframe up to the next one
+func gopLengths(of positions: [TimeInterval], keyframePositions: Set<TimeInterval>) -> [Int] {
+    let keyframes = keyframePositions.sorted()
+    var lengths = [Int](repeating: 0, count: keyframes.count)
+
+    for position in positions {
+        // Last keyframe at or before the position
+        var lowerBound = 0
+        var upperBound = keyframes.count
+
+        while lowerBound < upperBound {
+            let middle = (lowerBound + upperBound) / 2
+
+            if keyframes[middle] <= position {
+                lowerBound = middle + 1
+            }
+            else {
+                upperBound = middle
+            }
+        }
+
+        if lowerBound > 0 {
+            lengths[lowerBound - 1] += 1
+        }
+    }
+
+    return lengths.filter { $0 > 0 }
+}
+
+func runReversePass(
+    path: String,
+    options: Options,
+    json: inout RDMPEGBenchmarkJSON,
+    metrics: inout RDMPEGBenchmarkMetrics
+) -> Int32 {
+    var media = RDMPEGBenchmarkMedia()
+    media.deinterlace = options.deinterlace ? 1 : 0
+
+    let openStatus = rdmpeg_benchmark_media_open(&media, path, RDMPEG_BENCHMARK_MEDIA_VIDEO)
+    if openStatus == RDMPEGAVErrorStreamNotFound {
+        rdmpeg_benchmark_json_string(&json, "skipped", "no video stream")
+        return 0
+    }
+    if openStatus < 0 {
+        rdmpeg_benchmark_json_string(&json, "error", errorDescription(openStatus))
+        return openStatus
+    }
+
+    let decoder = RDMPEGDecoder(media: media)
+    let duration = decoder.duration
+
+    guard duration > 0 else {
+        let status = -ERANGE
+        rdmpeg_benchmark_json_string(&json, "error", errorDescription(status))
+        return status
+    }
+
+    let reverseDecoder = RDMPEGReverseDecoder(decoder: decoder, byteBudget: options.byteBudget)
+    var positions: [TimeInterval] = []
+    var outOfOrderFrames = 0
+
+    let startTime = rdmpeg_benchmark_now()
+    reverseDecoder.move(to: duration)
+
+    while let frame = reverseDecoder.previousFrame() {
+        if let previousPosition = positions.last, frame.position >= previousPosition {
+            outOfOrderFrames += 1
+        }
+
+        positions.append(frame.position)
+    }
+
+    let wallTime = rdmpeg_benchmark_now() - startTime
+
+    // Worker queue is idle once the beginning is reached, counters aren't touched anymore
+    let lengths = gopLengths(of: positions, keyframePositions: decoder.keyframePositions)
+    var gopSamples = RDMPEGBenchmarkSamples()
+    for length in lengths {
+        rdmpeg_benchmark_samples_add(&gopSamples, Double(length))
+    }
+
+    let reverseFPS = wallTime > 0 ? Double(positions.count) / wallTime : 0
+    let decodeRatio = positions.isEmpty ? 0 : Double(decoder.decodedFramesCount) / Double(positions.count)
+    let gopFramesP50 = rdmpeg_benchmark_samples_percentile(&gopSamples, 50)
+    let gopFramesMax = rdmpeg_benchmark_samples_percentile(&gopSamples, 100)
+    rdmpeg_benchmark_samples_free(&gopSamples)
+
+    if decoder.status < 0 {
+        rdmpeg_benchmark_json_string(&json, "error", errorDescription(decoder.status))
+    }
+
+    rdmpeg_benchmark_json_double(&json, "wall_s", wallTime)
+    rdmpeg_benchmark_json_int(&json, "byte_budget", Int64(options.byteBudget))
+    rdmpeg_benchmark_json_int(&json, "gops", Int64(lengths.count))
+    rdmpeg_benchmark_json_double(&json, "gop_frames_p50", gopFramesP50)
+    rdmpeg_benchmark_json_double(&json, "gop_frames_max", gopFramesMax)
+    rdmpeg_benchmark_json_int(&json, "video_frames", Int64(positions.count))
+    rdmpeg_benchmark_json_int(&json, "decoded_frames", Int64(decoder.decodedFramesCount))
+    rdmpeg_benchmark_json_int(&json, "out_of_order_frames", Int64(outOfOrderFrames))
+    rdmpeg_benchmark_json_double(&json, "decode_ratio", decodeRatio)
+    rdmpeg_benchmark_json_double(&json, "reverse_fps", reverseFPS)
+
+    rdmpeg_benchmark_metrics_set(&metrics, metricName("reverse_fps"), reverseFPS)
+    rdmpeg_benchmark_metrics_set(&metrics, metricName("decode_ratio"), decodeRatio)
+    rdmpeg_benchmark_metrics_set(&metrics, metricName("gop_frames_max"), gopFramesMax)
+    rdmpeg_benchmark_metrics_set(&metrics, metricName("out_of_order_frames"), Double(outOfOrderFrames))
+
+    return decoder.status
+}
+
+guard let options = parseOptions() else {
+    printUsage()
+    exit(EXIT_FAILURE)
+}
+
+av_log_set_level(options.verbose ? AV_LOG_INFO : AV_LOG_ERROR)
+
+var budgets = RDMPEGBenchmarkBudgets()
+if let budgetsPath = options.budgetsPath, rdmpeg_benchmark_budgets_load(&budgets, budgetsPath) != 0 {
+    exit(EXIT_FAILURE)
+}
+
+let corpus = corpusPaths(options.paths)
+if corpus.isEmpty {
+    FileHandle.standardError.write("No media files found\n".data(using: .utf8)!)
+    exit(EXIT_FAILURE)
+}
+
+var output: UnsafeMutablePointer<FILE> = stdout
+if let outputPath = options.outputPath {
+    guard let file = fopen(outputPath, "w") else {
+        perror(outputPath)
+        exit(EXIT_FAILURE)
+    }
+
+    output = file
+}
+
+var json = RDMPEGBenchmarkJSON(file: output, depth: 0, needsComma: 0)
+var failures = 0
+var budgetViolations = 0
+var peakRSS = rdmpeg_benchmark_peak_rss()
+
+rdmpeg_benchmark_json_begin_object(&json, nil)
+rdmpeg_benchmark_json_string(&json, "tool", "rdmpeg-reverse-benchmark")
+rdmpeg_benchmark_json_string(&json, "ffmpeg_version", av_version_info())
+rdmpeg_benchmark_json_begin_array(&json, "files")
+
+for (index, path) in corpus.enumerated() {
+    FileHandle.standardError.write("[\(index + 1)/\(corpus.count)] \(path)\n".data(using: .utf8)!)
+
+    rdmpeg_benchmark_json_begin_object(&json, nil)
+    rdmpeg_benchmark_json_string(&json, "path", path)
+    rdmpeg_benchmark_json_begin_object(&json, "passes")
+    rdmpeg_benchmark_json_begin_object(&json, "reverse")
+
+    var metrics = RDMPEGBenchmarkMetrics()
+    let isRSSPerPass = rdmpeg_benchmark_reset_peak_rss() == 0
+
+    if runReversePass(path: path, options: options, json: &json, metrics: &metrics) < 0 {
+        failures += 1
+    }
+
+    let passPeakRSS = rdmpeg_benchmark_peak_rss()
+    peakRSS = max(peakRSS, passPeakRSS)
+    rdmpeg_benchmark_json_int(&json, "peak_rss_bytes", passPeakRSS)
+    rdmpeg_benchmark_json_string(&json, "peak_rss_scope", isRSSPerPass ? "pass" : "process")
+
+    if metrics.count > 0 {
+        budgetViolations += rdmpeg_benchmark_budgets_check(&budgets, path, "reverse", &metrics, &json)
+    }
+
+    rdmpeg_benchmark_json_end_object(&json)
+    rdmpeg_benchmark_json_end_object(&json)
+    rdmpeg_benchmark_json_end_object(&json)
+}
+
+rdmpeg_benchmark_json_end_array(&json)
+rdmpeg_benchmark_json_int(&json, "peak_rss_bytes", peakRSS)
+rdmpeg_benchmark_json_int(&json, "failures", Int64(failures))
+rdmpeg_benchmark_json_int(&json, "budget_violations", Int64(budgetViolations))
+rdmpeg_benchmark_json_end_object(&json)
+
+if output != stdout {
+    fclose(output)
+}
+
+rdmpeg_benchmark_budgets_free(&budgets)
+
+exit(failures > 0 || budgetViolations > 0 ? EXIT_FAILURE : EXIT_SUCCESS)
@@ -0,0 +1,122 @@
+//
+//  RDMPEGDecoderStub.swift
+//  RDMPEGReverseDecoderTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Stand-ins for the decoder types RDMPEGReverseDecoder uses, so it builds with swiftc outside of the framework.
+// They are public, as the reverse decoder interface refers to them.
+// Decoder plays a synthetic video stream: frames of fixed duration with exact timestamps, a keyframe every
+// GOP length frames, one frame per decodeFrames() call in presentation order. GOPs may be open: after moving to
+// a keyframe the leading frames preceding it come out first, decoded without their references.
+
+@objcMembers
+public class RDMPEGFrame: NSObject {
+    let position: TimeInterval
+    let duration: TimeInterval
+    let byteSize: Int
+
+    init(position: TimeInterval, duration: TimeInterval, byteSize: Int) {
+        self.position = position
+        self.duration = duration
+        self.byteSize = byteSize
+        super.init()
+    }
+}
+
+public class RDMPEGVideoFrame: RDMPEGFrame {
+    var isKeyframe = false
+    // Leading frame of open GOP decoded right after moving to its keyframe
+    var isBroken = false
+}
+
+@objcMembers
+public class RDMPEGDecoder: NSObject {
+    let framesCount: Int
+    let gopLength: Int
+    let frameDuration: TimeInterval
+    let frameByteSize: Int
+    let leadingFramesCount: Int
+
+    private let lock = NSLock()
+    private var nextFrameIndex = 0
+    private var brokenFramesEndIndex = 0
+    private var decodedFramesCountValue = 0
+    private var isEndReachedValue = false
+    private(set) var isAudioStreamActive = true
+    private(set) var isSubtitleStreamActive = true
+
+    var isEndReached: Bool {
+        lock.withLock { isEndReachedValue }
+    }
+
+    // Frames decoded since creation, including ones decoded again
+    var decodedFramesCount: Int {
+        lock.withLock { decodedFramesCountValue }
+    }
+
+    var duration: TimeInterval {
+        Double(framesCount) * frameDuration
+    }
+
+    init(framesCount: Int, gopLength: Int, frameDuration: TimeInterval, frameByteSize: Int, leadingFramesCount: Int = 0) {
+        self.framesCount = framesCount
+        self.gopLength = gopLength
+        self.frameDuration = frameDuration
+        self.frameByteSize = frameByteSize
+        self.leadingFramesCount = leadingFramesCount
+        super.init()
+    }
+
+    func position(ofFrameAt index: Int) -> TimeInterval {
+        Double(index) * frameDuration
+    }
+
+    func frameIndex(of frame: RDMPEGFrame) -> Int {
+        Int((frame.position / frameDuration).rounded())
+    }
+
+    func deactivateAudioStream() {
+        isAudioStreamActive = false
+    }
+
+    func deactivateSubtitleStream() {
+        isSubtitleStreamActive = false
+    }
+
+    // Keyframe at or before the position
+    func moveToKeyframe(before position: TimeInterval) {
+        lock.withLock {
+            let frameIndex = min(max(Int((position / frameDuration).rounded(.down)), 0), framesCount - 1)
+            let keyframeIndex = frameIndex / gopLength * gopLength
+            nextFrameIndex = max(keyframeIndex - leadingFramesCount, 0)
+            brokenFramesEndIndex = keyframeIndex
+            isEndReachedValue = false
+        }
+    }
+
+    func decodeFrames() -> [RDMPEGFrame]? {
+        lock.withLock {
+            guard nextFrameIndex < framesCount else {
+                isEndReachedValue = true
+                return nil
+            }
+
+            let frame = RDMPEGVideoFrame(
+                position: position(ofFrameAt: nextFrameIndex),
+                duration: frameDuration,
+                byteSize: frameByteSize
+            )
+            frame.isBroken = nextFrameIndex < brokenFramesEndIndex
+            frame.isKeyframe = nextFrameIndex % gopLength == 0 && !frame.isBroken
+
+            nextFrameIndex += 1
+            decodedFramesCountValue += 1
+
+            return [frame]
+        }
+    }
+}
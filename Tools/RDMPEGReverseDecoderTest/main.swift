@@ -0,0 +1,131 @@
+//
+//  main.swift
+//  RDMPEGReverseDecoderTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Plays a synthetic stream (three GOPs of 12 frames) backwards through RDMPEGReverseDecoder and checks that every
+// frame is handed out exactly once in descending order across GOP boundaries: from the end, from the middle of
+// a GOP, with a budget too small for a whole GOP, which splits it and decodes its head again, and with open GOPs,
+// whose leading frames come out broken before the keyframe and are taken from the preceding GOP instead.
+
+let gopLength = 12
+let gopsCount = 3
+let framesCount = gopLength * gopsCount
+let frameDuration: TimeInterval = 0.04
+let frameByteSize = 100
+var failuresCount = 0
+
+func check(_ condition: Bool, _ message: @autoclosure () -> String) {
+    if !condition {
+        print("FAIL: \(message())")
+        failuresCount += 1
+    }
+}
+
+func makeDecoder(leadingFramesCount: Int = 0) -> RDMPEGDecoder {
+    RDMPEGDecoder(
+        framesCount: framesCount,
+        gopLength: gopLength,
+        frameDuration: frameDuration,
+        frameByteSize: frameByteSize,
+        leadingFramesCount: leadingFramesCount
+    )
+}
+
+// Frame indices handed out until the beginning is reached
+func playBackwards(_ reverseDecoder: RDMPEGReverseDecoder, of decoder: RDMPEGDecoder) -> [Int] {
+    var indices: [Int] = []
+
+    while let frame = reverseDecoder.previousFrame(), indices.count <= framesCount * 2 {
+        let index = decoder.frameIndex(of: frame)
+        check(!frame.isBroken, "broken leading frame \(index) handed out")
+        indices.append(index)
+    }
+
+    return indices
+}
+
+func testFromEnd() {
+    let decoder = makeDecoder()
+    let reverseDecoder = RDMPEGReverseDecoder(decoder: decoder, byteBudget: 1 << 30)
+    check(!decoder.isAudioStreamActive && !decoder.isSubtitleStreamActive, "audio and subtitles kept active")
+
+    reverseDecoder.move(to: decoder.duration)
+    let indices = playBackwards(reverseDecoder, of: decoder)
+
+    check(indices == Array((0..<framesCount).reversed()), "frames from the end \(indices)")
+    check(reverseDecoder.previousFrame() == nil, "frame handed out past the beginning")
+
+    // Whole GOPs fit, every one is decoded once plus the keyframe which ends its segment
+    check(decoder.decodedFramesCount <= framesCount + gopsCount, "\(decoder.decodedFramesCount) frames decoded")
+}
+
+func testFromMiddleOfGOP() {
+    let decoder = makeDecoder()
+    let reverseDecoder = RDMPEGReverseDecoder(decoder: decoder, byteBudget: 1 << 30)
+
+    // Halfway through frame 17, in the second GOP
+    reverseDecoder.move(to: decoder.position(ofFrameAt: 17) + frameDuration / 2)
+    let indices = playBackwards(reverseDecoder, of: decoder)
+
+    check(indices == Array((0...17).reversed()), "frames from the middle of GOP \(indices)")
+
+    // Moving again starts over
+    reverseDecoder.move(to: decoder.position(ofFrameAt: 25))
+    let movedIndices = playBackwards(reverseDecoder, of: decoder)
+    check(movedIndices == Array((0...24).reversed()), "frames after moving again \(movedIndices)")
+}
+
+func testSplitGOP() {
+    let decoder = makeDecoder()
+    // Half of the budget holds 5 frames, less than half of a GOP
+    let reverseDecoder = RDMPEGReverseDecoder(decoder: decoder, byteBudget: frameByteSize * 10)
+
+    reverseDecoder.move(to: decoder.duration)
+    let indices = playBackwards(reverseDecoder, of: decoder)
+
+    check(indices == Array((0..<framesCount).reversed()), "frames of split GOPs \(indices)")
+    check(decoder.decodedFramesCount > framesCount, "split GOP wasn't decoded again from its keyframe")
+
+    print("split GOPs: \(indices.count) frames handed out, \(decoder.decodedFramesCount) decoded")
+}
+
+func testOpenGOP() {
+    let leadingFramesCount = 3
+    let decoder = makeDecoder(leadingFramesCount: leadingFramesCount)
+    let reverseDecoder = RDMPEGReverseDecoder(decoder: decoder, byteBudget: 1 << 30)
+
+    reverseDecoder.move(to: decoder.duration)
+    let indices = playBackwards(reverseDecoder, of: decoder)
+    check(indices == Array((0..<framesCount).reversed()), "frames of open GOPs \(indices)")
+
+    // Leading frames are taken from the segment of the preceding GOP, decoded through to the next keyframe
+    reverseDecoder.move(to: decoder.position(ofFrameAt: gopLength + 1))
+    let movedIndices = playBackwards(reverseDecoder, of: decoder)
+    check(movedIndices == Array((0...gopLength).reversed()), "open GOP frames after moving \(movedIndices)")
+
+    // Split GOP is decoded again from the same keyframe, its leading frames are skipped every time
+    let splitDecoder = makeDecoder(leadingFramesCount: leadingFramesCount)
+    let splitReverseDecoder = RDMPEGReverseDecoder(decoder: splitDecoder, byteBudget: frameByteSize * 10)
+    splitReverseDecoder.move(to: splitDecoder.duration)
+    let splitIndices = playBackwards(splitReverseDecoder, of: splitDecoder)
+    check(splitIndices == Array((0..<framesCount).reversed()), "frames of split open GOPs \(splitIndices)")
+}
+
+testFromEnd()
+testFromMiddleOfGOP()
+testSplitGOP()
+testOpenGOP()
+
+if failuresCount == 0 {
+    print("PASS")
+    exit(0)
+}
+else {
+    print("FAIL: \(failuresCount) checks")
+    exit(1)
+}
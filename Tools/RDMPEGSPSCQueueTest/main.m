@@ -0,0 +1,232 @@
+//
+//  main.m
+//  RDMPEGSPSCQueueTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#import "RDMPEGSPSCQueue.h"
+#import <sched.h>
+#import <stdatomic.h>
+#import <stdio.h>
+
+// Interleaves push, pop and purge on RDMPEGSPSCQueue and checks order, totals, capacity held by purged
+// objects and that purged objects are released and never handed out. The threaded pass runs producer
+// (pushing and purging) against consumer and checks order and that nothing leaks.
+
+static int failuresCount = 0;
+static _Atomic long liveObjectsCount = 0;
+static _Atomic bool producerFinished = false;
+
+static void check(int condition, const char *description) {
+    if (!condition) {
+        printf("FAIL %s\n", description);
+        failuresCount++;
+    }
+}
+
+@interface RDMPEGTestObject : NSObject
+
+@property (nonatomic, readonly) NSUInteger sequence;
+@property (nonatomic, readonly) NSUInteger epoch;
+
+- (instancetype)initWithSequence:(NSUInteger)sequence epoch:(NSUInteger)epoch;
+
+@end
+
+@implementation RDMPEGTestObject
+
+- (instancetype)initWithSequence:(NSUInteger)sequence epoch:(NSUInteger)epoch {
+    self = [super init];
+    if (self) {
+        _sequence = sequence;
+        _epoch = epoch;
+        atomic_fetch_add(&liveObjectsCount, 1);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    atomic_fetch_sub(&liveObjectsCount, 1);
+}
+
+@end
+
+static BOOL push(RDMPEGSPSCQueue<RDMPEGTestObject *> *queue, NSUInteger sequence, NSUInteger epoch) {
+    RDMPEGTestObject *object = [[RDMPEGTestObject alloc] initWithSequence:sequence epoch:epoch];
+    return [queue pushObject:object duration:0.5 byteSize:100];
+}
+
+// Pool keeps live objects count exact, popped object is released before the count is checked
+static NSInteger pop_sequence(RDMPEGSPSCQueue<RDMPEGTestObject *> *queue) {
+    @autoreleasepool {
+        RDMPEGTestObject *object = [queue popObject];
+        return object ? (NSInteger)object.sequence : -1;
+    }
+}
+
+static NSInteger first_sequence(RDMPEGSPSCQueue<RDMPEGTestObject *> *queue) {
+    @autoreleasepool {
+        RDMPEGTestObject *object = queue.firstObject;
+        return object ? (NSInteger)object.sequence : -1;
+    }
+}
+
+static void test_order_and_totals(void) {
+    @autoreleasepool {
+        RDMPEGSPSCQueue<RDMPEGTestObject *> *queue = [[RDMPEGSPSCQueue alloc] initWithCapacity:5];
+        check(queue.capacity == 8, "capacity rounded up to power of two");
+
+        for (NSUInteger sequence = 0; sequence < 3; sequence++) {
+            push(queue, sequence, 0);
+        }
+        check(queue.count == 3 && queue.duration == 1.5 && queue.byteSize == 300, "totals after pushes");
+        check(first_sequence(queue) == 0, "first object");
+        check(pop_sequence(queue) == 0 && pop_sequence(queue) == 1, "pop order");
+        check(queue.count == 1 && queue.duration == 0.5 && queue.byteSize == 100, "totals after pops");
+        check(pop_sequence(queue) == 2 && pop_sequence(queue) == -1, "pop until empty");
+        check(queue.count == 0 && queue.duration == 0.0 && queue.byteSize == 0, "totals of empty queue");
+    }
+    check(atomic_load(&liveObjectsCount) == 0, "objects released after order test");
+}
+
+static void test_purge_interleaving(void) {
+    @autoreleasepool {
+        RDMPEGSPSCQueue<RDMPEGTestObject *> *queue = [[RDMPEGSPSCQueue alloc] initWithCapacity:8];
+
+        push(queue, 0, 0);
+        push(queue, 1, 0);
+        check(pop_sequence(queue) == 0, "pop before purge");
+        [queue purge];
+        check(queue.count == 0 && queue.duration == 0.0 && queue.byteSize == 0, "totals drop at purge");
+        check(atomic_load(&liveObjectsCount) == 1, "purged object is kept until consumer touches queue");
+
+        push(queue, 2, 1);
+        check(queue.count == 1 && queue.byteSize == 100, "totals after push following purge");
+        check(first_sequence(queue) == 2, "first object skips purged one");
+        check(atomic_load(&liveObjectsCount) == 1, "purged object released by consumer");
+
+        // Purge between peek and pop: consumer saw the object, but it must not get it
+        push(queue, 3, 1);
+        check(first_sequence(queue) == 2, "first object before purge");
+        [queue purge];
+        push(queue, 4, 2);
+        check(pop_sequence(queue) == 4, "pop after purge returns only object pushed after it");
+        check(pop_sequence(queue) == -1, "nothing left after purge");
+
+        // Purge of an empty queue and consecutive purges
+        [queue purge];
+        [queue purge];
+        push(queue, 5, 4);
+        [queue purge];
+        check(pop_sequence(queue) == -1 && queue.count == 0, "consecutive purges");
+        push(queue, 6, 5);
+        check(queue.count == 1 && pop_sequence(queue) == 6, "push after consecutive purges");
+        check(queue.count == 0 && queue.duration == 0.0 && queue.byteSize == 0, "totals after purge interleaving");
+    }
+    check(atomic_load(&liveObjectsCount) == 0, "objects released after purge test");
+}
+
+static void test_purged_capacity(void) {
+    @autoreleasepool {
+        RDMPEGSPSCQueue<RDMPEGTestObject *> *queue = [[RDMPEGSPSCQueue alloc] initWithCapacity:4];
+
+        for (NSUInteger sequence = 0; sequence < 4; sequence++) {
+            check(push(queue, sequence, 0), "push up to capacity");
+        }
+        check(push(queue, 4, 0) == NO, "push into full queue fails");
+
+        [queue purge];
+        check(queue.count == 0, "purged queue is empty");
+        check(push(queue, 5, 1) == NO, "purged objects hold capacity until consumer drains them");
+        check(atomic_load(&liveObjectsCount) == 4, "purged objects alive until drained");
+
+        check(pop_sequence(queue) == -1, "pop drains purged objects");
+        check(atomic_load(&liveObjectsCount) == 0, "drained objects released");
+
+        for (NSUInteger sequence = 6; sequence < 10; sequence++) {
+            check(push(queue, sequence, 1), "push up to capacity after drain");
+        }
+        check(queue.count == 4 && pop_sequence(queue) == 6, "queue usable after drain");
+    }
+    check(atomic_load(&liveObjectsCount) == 0, "objects released after capacity test");
+}
+
+static void test_threaded(void) {
+    static const NSUInteger objectsCount = 200000;
+    static const NSUInteger purgeInterval = 997;
+
+    @autoreleasepool {
+        RDMPEGSPSCQueue<RDMPEGTestObject *> *queue = [[RDMPEGSPSCQueue alloc] initWithCapacity:64];
+        __block BOOL orderBroken = NO;
+        __block NSUInteger poppedCount = 0;
+
+        dispatch_group_t group = dispatch_group_create();
+
+        dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+            NSUInteger epoch = 0;
+            for (NSUInteger sequence = 0; sequence < objectsCount; sequence++) {
+                @autoreleasepool {
+                    if (sequence % purgeInterval == 0) {
+                        [queue purge];
+                        epoch++;
+                    }
+
+                    while (push(queue, sequence, epoch) == NO) {
+                        sched_yield();
+                    }
+                }
+            }
+            atomic_store(&producerFinished, true);
+        });
+
+        dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+            NSInteger lastSequence = -1;
+            NSUInteger lastEpoch = 0;
+            while (YES) {
+                @autoreleasepool {
+                    bool finished = atomic_load(&producerFinished);
+                    RDMPEGTestObject *object = [queue popObject];
+                    if (object == nil) {
+                        if (finished) {
+                            break;
+                        }
+                        sched_yield();
+                        continue;
+                    }
+
+                    if ((NSInteger)object.sequence <= lastSequence || object.epoch < lastEpoch) {
+                        orderBroken = YES;
+                    }
+                    lastSequence = (NSInteger)object.sequence;
+                    lastEpoch = object.epoch;
+                    poppedCount++;
+                }
+            }
+        });
+
+        dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+        check(orderBroken == NO, "threaded pop order");
+        check(poppedCount > 0, "threaded pass popped objects");
+        check(queue.count == 0 && queue.byteSize == 0, "threaded totals after drain");
+        printf("threaded: %lu popped, %lu purged\n", (unsigned long)poppedCount,
+               (unsigned long)(objectsCount - poppedCount));
+    }
+    check(atomic_load(&liveObjectsCount) == 0, "objects released after threaded test");
+}
+
+int main(void) {
+    test_order_and_totals();
+    test_purge_interleaving();
+    test_purged_capacity();
+    test_threaded();
+
+    if (failuresCount > 0) {
+        printf("FAIL: %d checks failed\n", failuresCount);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,623 @@
+//
+//  main.c
+//  RDMPEGTranscoderTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+#include "../../RDMPEG/RDMPEGConverter/RDMPEGTranscoder/RDMPEGTranscoder.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+
+// Runs RDMPEGTranscoder jobs against a synthetic clip (MPEG-4 part 2 video and AAC audio, both built into every
+// FFmpeg) and checks the output: stream parameters, frame counts and duration, trimming, stream copy, custom
+// input I/O, progress, cancellation at any moment and failures with their messages.
+
+#define INPUT_WIDTH 320
+#define INPUT_HEIGHT 240
+#define INPUT_FRAME_RATE 25
+#define INPUT_GOP_SIZE 12
+#define INPUT_SAMPLE_RATE 44100
+// Stereo
+#define INPUT_CHANNELS_COUNT 2
+#define INPUT_DURATION 3
+#define INPUT_FRAMES_COUNT (INPUT_FRAME_RATE * INPUT_DURATION)
+#define CANCEL_ITERATIONS_COUNT 20
+
+typedef struct OutputInfo {
+    int streamsCount;
+    enum AVCodecID videoCodec;
+    int width;
+    int height;
+    int64_t videoPacketsCount;
+    double firstVideoTime;
+    enum AVCodecID audioCodec;
+    int sampleRate;
+    int channelsCount;
+    double duration;
+} OutputInfo;
+
+typedef struct ProgressLog {
+    RDMPEGTranscoder *transcoder;
+    int reportsCount;
+    int isMonotonic;
+    RDMPEGTranscoderProgress last;
+    int cancelAfterReportsCount;
+} ProgressLog;
+
+static int failuresCount = 0;
+static char inputPath[512];
+static char directory[256];
+
+static void check(int condition, const char *description) {
+    printf("%s %s\n", condition ? "PASS" : "FAIL", description);
+    if (!condition) {
+        failuresCount++;
+    }
+}
+
+// MARK: - Input
+
+static int encode_and_write(AVFormatContext *formatContext, AVCodecContext *codecContext, AVStream *stream,
+                            AVFrame *frame) {
+    AVPacket *packet = av_packet_alloc();
+    int status = avcodec_send_frame(codecContext, frame);
+
+    while (status >= 0) {
+        status = avcodec_receive_packet(codecContext, packet);
+        if (status == AVERROR(EAGAIN) || status == AVERROR_EOF) {
+            status = 0;
+            break;
+        }
+
+        if (status >= 0) {
+            av_packet_rescale_ts(packet, codecContext->time_base, stream->time_base);
+            packet->stream_index = stream->index;
+            status = av_interleaved_write_frame(formatContext, packet);
+        }
+    }
+
+    av_packet_free(&packet);
+    return status;
+}
+
+static AVCodecContext *open_encoder(AVFormatContext *formatContext, enum AVCodecID codecID, AVStream **stream) {
+    const AVCodec *encoder = avcodec_find_encoder(codecID);
+    AVCodecContext *codecContext = encoder ? avcodec_alloc_context3(encoder) : NULL;
+    if (codecContext == NULL) {
+        return NULL;
+    }
+
+    if (codecID == AV_CODEC_ID_MPEG4) {
+        codecContext->width = INPUT_WIDTH;
+        codecContext->height = INPUT_HEIGHT;
+        codecContext->pix_fmt = AV_PIX_FMT_YUV420P;
+        codecContext->time_base = (AVRational){1, INPUT_FRAME_RATE};
+        codecContext->framerate = (AVRational){INPUT_FRAME_RATE, 1};
+        codecContext->gop_size = INPUT_GOP_SIZE;
+        codecContext->max_b_frames = 2;
+    }
+    else {
+        codecContext->sample_rate = INPUT_SAMPLE_RATE;
+        // Channel masks were replaced by AVChannelLayout in FFmpeg 5.1 and removed in 7.0
+#ifdef AV_CHANNEL_LAYOUT_MASK
+        av_channel_layout_from_mask(&codecContext->ch_layout, AV_CH_LAYOUT_STEREO);
+#else
+        codecContext->channel_layout = AV_CH_LAYOUT_STEREO;
+        codecContext->channels = INPUT_CHANNELS_COUNT;
+#endif
+        codecContext->sample_fmt = encoder->sample_fmts[0];
+        codecContext->time_base = (AVRational){1, INPUT_SAMPLE_RATE};
+    }
+
+    if (formatContext->oformat->flags & AVFMT_GLOBALHEADER) {
+        codecContext->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    *stream = avformat_new_stream(formatContext, NULL);
+
+    if (*stream == NULL ||
+        avcodec_open2(codecContext, encoder, NULL) < 0 ||
+        avcodec_parameters_from_context((*stream)->codecpar, codecContext) < 0) {
+        avcodec_free_context(&codecContext);
+        return NULL;
+    }
+
+    (*stream)->time_base = codecContext->time_base;
+
+    return codecContext;
+}
+
+// Moving gradient and a sine tone, video and audio are interleaved by time
+static int generate_input(const char *path) {
+    AVFormatContext *formatContext = NULL;
+    AVStream *videoStream = NULL;
+    AVStream *audioStream = NULL;
+    AVCodecContext *videoContext = NULL;
+    AVCodecContext *audioContext = NULL;
+    AVFrame *videoFrame = av_frame_alloc();
+    AVFrame *audioFrame = av_frame_alloc();
+    int status = avformat_alloc_output_context2(&formatContext, NULL, NULL, path);
+
+    if (status >= 0) {
+        videoContext = open_encoder(formatContext, AV_CODEC_ID_MPEG4, &videoStream);
+        audioContext = open_encoder(formatContext, AV_CODEC_ID_AAC, &audioStream);
+        status = videoContext && audioContext ? 0 : AVERROR_ENCODER_NOT_FOUND;
+    }
+
+    if (status >= 0) {
+        status = avio_open(&formatContext->pb, path, AVIO_FLAG_WRITE);
+    }
+
+    if (status >= 0) {
+        status = avformat_write_header(formatContext, NULL);
+    }
+
+    if (status >= 0) {
+        videoFrame->format = videoContext->pix_fmt;
+        videoFrame->width = videoContext->width;
+        videoFrame->height = videoContext->height;
+        audioFrame->format = audioContext->sample_fmt;
+#ifdef AV_CHANNEL_LAYOUT_MASK
+        status = av_channel_layout_copy(&audioFrame->ch_layout, &audioContext->ch_layout);
+#else
+        audioFrame->channel_layout = audioContext->channel_layout;
+        audioFrame->channels = audioContext->channels;
+#endif
+        audioFrame->sample_rate = audioContext->sample_rate;
+        audioFrame->nb_samples = audioContext->frame_size;
+
+        if (status < 0 || av_frame_get_buffer(videoFrame, 0) < 0 || av_frame_get_buffer(audioFrame, 0) < 0) {
+            status = AVERROR(ENOMEM);
+        }
+    }
+
+    int64_t frameIndex = 0;
+    int64_t sampleIndex = 0;
+    int64_t samplesCount = (int64_t)INPUT_SAMPLE_RATE * INPUT_DURATION;
+
+    while (status >= 0 && (frameIndex < INPUT_FRAMES_COUNT || sampleIndex < samplesCount)) {
+        int isVideoNext = sampleIndex >= samplesCount ||
+                          (frameIndex < INPUT_FRAMES_COUNT &&
+                           frameIndex * INPUT_SAMPLE_RATE <= sampleIndex * INPUT_FRAME_RATE);
+
+        if (isVideoNext) {
+            status = av_frame_make_writable(videoFrame);
+
+            for (int y = 0; status >= 0 && y < INPUT_HEIGHT; y++) {
+                for (int x = 0; x < INPUT_WIDTH; x++) {
+                    videoFrame->data[0][y * videoFrame->linesize[0] + x] = (uint8_t)(x + y + frameIndex * 3);
+                }
+            }
+
+            for (int y = 0; status >= 0 && y < INPUT_HEIGHT / 2; y++) {
+                int chroma = 128 + (int)(frameIndex % 64);
+                memset(videoFrame->data[1] + y * videoFrame->linesize[1], chroma, INPUT_WIDTH / 2);
+                memset(videoFrame->data[2] + y * videoFrame->linesize[2], 64 + y, INPUT_WIDTH / 2);
+            }
+
+            videoFrame->pts = frameIndex++;
+
+            if (status >= 0) {
+                status = encode_and_write(formatContext, videoContext, videoStream, videoFrame);
+            }
+        }
+        else {
+            status = av_frame_make_writable(audioFrame);
+
+            for (int i = 0; status >= 0 && i < audioFrame->nb_samples; i++) {
+                float sample = 0.25f * (float)sin(2.0 * M_PI * 440.0 * (sampleIndex + i) / INPUT_SAMPLE_RATE);
+
+                for (int channel = 0; channel < INPUT_CHANNELS_COUNT; channel++) {
+                    ((float *)audioFrame->extended_data[channel])[i] = sample;
+                }
+            }
+
+            audioFrame->pts = sampleIndex;
+            sampleIndex += audioFrame->nb_samples;
+
+            if (status >= 0) {
+                status = encode_and_write(formatContext, audioContext, audioStream, audioFrame);
+            }
+        }
+    }
+
+    if (status >= 0) {
+        status = encode_and_write(formatContext, videoContext, videoStream, NULL);
+    }
+
+    if (status >= 0) {
+        status = encode_and_write(formatContext, audioContext, audioStream, NULL);
+    }
+
+    if (status >= 0) {
+        status = av_write_trailer(formatContext);
+    }
+
+    av_frame_free(&videoFrame);
+    av_frame_free(&audioFrame);
+    avcodec_free_context(&videoContext);
+    avcodec_free_context(&audioContext);
+
+    if (formatContext) {
+        avio_closep(&formatContext->pb);
+        avformat_free_context(formatContext);
+    }
+
+    return status;
+}
+
+// MARK: - Output
+
+static int probe_output(const char *path, OutputInfo *info) {
+    AVFormatContext *formatContext = NULL;
+    memset(info, 0, sizeof(OutputInfo));
+
+    int status = avformat_open_input(&formatContext, path, NULL, NULL);
+    if (status < 0) {
+        return status;
+    }
+
+    status = avformat_find_stream_info(formatContext, NULL);
+    if (status < 0) {
+        avformat_close_input(&formatContext);
+        return status;
+    }
+
+    info->streamsCount = (int)formatContext->nb_streams;
+    info->firstVideoTime = NAN;
+    info->duration = formatContext->duration != AV_NOPTS_VALUE ? (double)formatContext->duration / AV_TIME_BASE : 0.0;
+
+    for (unsigned i = 0; i < formatContext->nb_streams; i++) {
+        AVCodecParameters *parameters = formatContext->streams[i]->codecpar;
+
+        if (parameters->codec_type == AVMEDIA_TYPE_VIDEO) {
+            info->videoCodec = parameters->codec_id;
+            info->width = parameters->width;
+            info->height = parameters->height;
+        }
+        else if (parameters->codec_type == AVMEDIA_TYPE_AUDIO) {
+            info->audioCodec = parameters->codec_id;
+            info->sampleRate = parameters->sample_rate;
+#ifdef AV_CHANNEL_LAYOUT_MASK
+            info->channelsCount = parameters->ch_layout.nb_channels;
+#else
+            info->channelsCount = parameters->channels;
+#endif
+        }
+    }
+
+    AVPacket *packet = av_packet_alloc();
+
+    while (av_read_frame(formatContext, packet) >= 0) {
+        AVStream *stream = formatContext->streams[packet->stream_index];
+
+        if (stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            double time = packet->pts * av_q2d(stream->time_base);
+
+            if (isnan(info->firstVideoTime) || time < info->firstVideoTime) {
+                info->firstVideoTime = time;
+            }
+
+            info->videoPacketsCount++;
+        }
+
+        av_packet_unref(packet);
+    }
+
+    av_packet_free(&packet);
+    avformat_close_input(&formatContext);
+
+    return 0;
+}
+
+static void log_progress(const RDMPEGTranscoderProgress *progress, void *context) {
+    ProgressLog *log = context;
+
+    if (log->reportsCount > 0 && (progress->time < log->last.time ||
+                                  progress->videoFramesCount < log->last.videoFramesCount ||
+                                  progress->bytesWritten < log->last.bytesWritten)) {
+        log->isMonotonic = 0;
+    }
+
+    log->last = *progress;
+    log->reportsCount++;
+
+    if (log->cancelAfterReportsCount > 0 && log->reportsCount == log->cancelAfterReportsCount) {
+        rdmpeg_transcoder_cancel(log->transcoder);
+    }
+}
+
+static RDMPEGTranscoderJob make_job(const char *outputName, char *outputPath, size_t outputPathSize) {
+    snprintf(outputPath, outputPathSize, "%s/%s", directory, outputName);
+
+    RDMPEGTranscoderJob job = {
+        .inputPath = inputPath,
+        .outputPath = outputPath,
+        .video = {.mode = RDMPEGTranscoderStreamModeTranscode, .streamIndex = -1},
+        .audio = {.mode = RDMPEGTranscoderStreamModeTranscode, .streamIndex = -1},
+    };
+
+    return job;
+}
+
+static int run_job(const RDMPEGTranscoderJob *job, ProgressLog *log, char *errorMessage, size_t errorMessageSize) {
+    RDMPEGTranscoder *transcoder = rdmpeg_transcoder_create(job);
+
+    memset(log, 0, sizeof(ProgressLog));
+    log->transcoder = transcoder;
+    log->isMonotonic = 1;
+
+    int status = rdmpeg_transcoder_run(transcoder, log_progress, log);
+
+    if (errorMessage) {
+        snprintf(errorMessage, errorMessageSize, "%s", rdmpeg_transcoder_error_message(transcoder));
+    }
+
+    rdmpeg_transcoder_destroy(transcoder);
+
+    return status;
+}
+
+// MARK: - Tests
+
+static void test_transcode(void) {
+    char outputPath[512];
+    RDMPEGTranscoderJob job = make_job("transcode.mp4", outputPath, sizeof(outputPath));
+    job.video.encoderName = "mpeg4";
+    job.video.width = 160;
+    job.video.bitRate = 200000;
+    job.video.encoderOptions = "mpeg_quant=1";
+    job.audio.encoderName = "aac";
+    job.audio.sampleRate = 48000;
+    job.audio.channelsCount = 1;
+
+    ProgressLog log;
+    OutputInfo info;
+    int status = run_job(&job, &log, NULL, 0);
+
+    check(status == 0, "transcode succeeds");
+    check(probe_output(outputPath, &info) == 0, "transcoded output opens");
+
+    printf("     %dx%d, %lld video packets, %d Hz %d channels, %.3f s, %d progress reports, last at %.3f s\n",
+           info.width, info.height, (long long)info.videoPacketsCount, info.sampleRate, info.channelsCount,
+           info.duration, log.reportsCount, log.last.time);
+
+    check(info.streamsCount == 2 && info.videoCodec == AV_CODEC_ID_MPEG4 && info.audioCodec == AV_CODEC_ID_AAC,
+          "output has requested codecs");
+    check(info.width == 160 && info.height == 120, "height follows aspect ratio when only width is set");
+    check(info.sampleRate == 48000 && info.channelsCount == 1, "audio is resampled and downmixed");
+    check(info.videoPacketsCount == INPUT_FRAMES_COUNT, "every video frame is transcoded");
+    check(fabs(info.duration - INPUT_DURATION) < 0.15, "output duration matches input");
+    check(log.reportsCount > 1 && log.isMonotonic, "progress is reported and only grows");
+    check(fabs(log.last.time - INPUT_DURATION) < 0.15 && fabs(log.last.duration - INPUT_DURATION) < 0.15,
+          "final progress reaches the end");
+    check(log.last.videoFramesCount == INPUT_FRAMES_COUNT && log.last.bytesWritten > 0,
+          "final progress counts frames and bytes");
+}
+
+static void test_trim(void) {
+    char outputPath[512];
+    RDMPEGTranscoderJob job = make_job("trim.mkv", outputPath, sizeof(outputPath));
+    job.video.encoderName = "mpeg4";
+    job.audio.mode = RDMPEGTranscoderStreamModeDrop;
+    job.startTime = 1.0;
+    job.duration = 1.0;
+
+    ProgressLog log;
+    OutputInfo info;
+    int status = run_job(&job, &log, NULL, 0);
+
+    check(status == 0 && probe_output(outputPath, &info) == 0, "trimmed transcode succeeds");
+
+    printf("     %lld video packets, first at %.3f s, %.3f s\n",
+           (long long)info.videoPacketsCount, info.firstVideoTime, info.duration);
+
+    check(info.streamsCount == 1, "dropped stream isn't in the output");
+    check(info.videoPacketsCount == INPUT_FRAME_RATE, "frames outside of the window are dropped");
+    check(fabs(info.firstVideoTime) < 0.001, "output starts at zero");
+}
+
+static void test_copy(void) {
+    char outputPath[512];
+    RDMPEGTranscoderJob job = make_job("copy.mkv", outputPath, sizeof(outputPath));
+    job.video.mode = RDMPEGTranscoderStreamModeCopy;
+    job.audio.mode = RDMPEGTranscoderStreamModeCopy;
+
+    ProgressLog log;
+    OutputInfo info;
+    int status = run_job(&job, &log, NULL, 0);
+
+    check(status == 0 && probe_output(outputPath, &info) == 0, "stream copy succeeds");
+    check(info.streamsCount == 2 && info.videoCodec == AV_CODEC_ID_MPEG4 && info.audioCodec == AV_CODEC_ID_AAC,
+          "copied streams keep their codecs");
+    check(info.width == INPUT_WIDTH && info.videoPacketsCount == INPUT_FRAMES_COUNT, "every video packet is copied");
+    check(log.reportsCount > 0 && log.isMonotonic, "copy reports progress");
+}
+
+static int read_file(void *context, uint8_t *buffer, int size) {
+    size_t readCount = fread(buffer, 1, (size_t)size, context);
+    return readCount > 0 ? (int)readCount : AVERROR_EOF;
+}
+
+static int64_t seek_file(void *context, int64_t offset, int whence) {
+    FILE *file = context;
+
+    if (whence == AVSEEK_SIZE) {
+        long position = ftell(file);
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, position, SEEK_SET);
+        return size;
+    }
+
+    return fseek(file, (long)offset, whence & ~AVSEEK_FORCE) == 0 ? ftell(file) : -1;
+}
+
+static void test_custom_io(void) {
+    char outputPath[512];
+    RDMPEGTranscoderJob job = make_job("custom_io.mkv", outputPath, sizeof(outputPath));
+    FILE *file = fopen(inputPath, "rb");
+    job.video.encoderName = "mpeg4";
+    job.audio.mode = RDMPEGTranscoderStreamModeCopy;
+    job.readCallback = read_file;
+    job.seekCallback = seek_file;
+    job.ioContext = file;
+
+    ProgressLog log;
+    OutputInfo info;
+    int status = run_job(&job, &log, NULL, 0);
+    fclose(file);
+
+    check(status == 0 && probe_output(outputPath, &info) == 0, "transcode from custom I/O succeeds");
+    check(info.videoPacketsCount == INPUT_FRAMES_COUNT && info.audioCodec == AV_CODEC_ID_AAC,
+          "custom I/O input is read to the end");
+}
+
+static void test_failures(void) {
+    char outputPath[512];
+    char errorMessage[512];
+    ProgressLog log;
+
+    RDMPEGTranscoderJob job = make_job("failure.mp4", outputPath, sizeof(outputPath));
+    job.video.encoderName = "no-such-encoder";
+    int status = run_job(&job, &log, errorMessage, sizeof(errorMessage));
+    printf("     %s\n", errorMessage);
+    check(status == AVERROR_ENCODER_NOT_FOUND && strstr(errorMessage, "no-such-encoder"),
+          "missing encoder fails with its name");
+
+    job = make_job("failure.mp4", outputPath, sizeof(outputPath));
+    job.video.encoderName = "mpeg4";
+    job.video.encoderOptions = "no_such_option=1";
+    status = run_job(&job, &log, errorMessage, sizeof(errorMessage));
+    printf("     %s\n", errorMessage);
+    check(status == AVERROR_OPTION_NOT_FOUND && strstr(errorMessage, "no_such_option"),
+          "unknown encoder option fails");
+
+    job = make_job("failure.mp4", outputPath, sizeof(outputPath));
+    job.inputPath = "/nonexistent/input.mp4";
+    status = run_job(&job, &log, errorMessage, sizeof(errorMessage));
+    printf("     %s\n", errorMessage);
+    check(status < 0 && status != RDMPEG_TRANSCODER_CANCELLED && errorMessage[0] != '\0',
+          "missing input fails");
+
+    job = make_job("failure.mp4", outputPath, sizeof(outputPath));
+    job.video.streamIndex = 1;
+    status = run_job(&job, &log, errorMessage, sizeof(errorMessage));
+    check(status == AVERROR_STREAM_NOT_FOUND, "explicit stream of wrong type fails");
+}
+
+typedef struct CancelThread {
+    RDMPEGTranscoder *transcoder;
+    useconds_t delay;
+} CancelThread;
+
+static void *cancel_later(void *context) {
+    CancelThread *thread = context;
+    usleep(thread->delay);
+    rdmpeg_transcoder_cancel(thread->transcoder);
+    return NULL;
+}
+
+static void test_cancel(void) {
+    char outputPath[512];
+    RDMPEGTranscoderJob job = make_job("cancel.mp4", outputPath, sizeof(outputPath));
+    job.video.encoderName = "mpeg4";
+    job.audio.encoderName = "aac";
+
+    // From progress callback, i.e. on the muxer thread
+    ProgressLog log;
+    RDMPEGTranscoder *transcoder = rdmpeg_transcoder_create(&job);
+    memset(&log, 0, sizeof(log));
+    log.transcoder = transcoder;
+    log.isMonotonic = 1;
+    log.cancelAfterReportsCount = 2;
+
+    int status = rdmpeg_transcoder_run(transcoder, log_progress, &log);
+    check(status == RDMPEG_TRANSCODER_CANCELLED && log.reportsCount == 2, "cancel from progress stops the job");
+    check(strcmp(rdmpeg_transcoder_error_message(transcoder), "Cancelled") == 0, "cancelled job says so");
+    rdmpeg_transcoder_destroy(transcoder);
+
+    // Before the job runs
+    transcoder = rdmpeg_transcoder_create(&job);
+    rdmpeg_transcoder_cancel(transcoder);
+    check(rdmpeg_transcoder_run(transcoder, NULL, NULL) == RDMPEG_TRANSCODER_CANCELLED, "cancel before run");
+    rdmpeg_transcoder_destroy(transcoder);
+
+    // From another thread at random moments, job must neither hang nor crash nor report something else
+    int cancelledCount = 0;
+    int finishedCount = 0;
+    int unexpectedCount = 0;
+
+    for (int i = 0; i < CANCEL_ITERATIONS_COUNT; i++) {
+        CancelThread thread = {
+            .transcoder = rdmpeg_transcoder_create(&job),
+            .delay = (useconds_t)(i * 5000),
+        };
+
+        pthread_t cancelThread;
+        pthread_create(&cancelThread, NULL, cancel_later, &thread);
+        status = rdmpeg_transcoder_run(thread.transcoder, NULL, NULL);
+        pthread_join(cancelThread, NULL);
+        rdmpeg_transcoder_destroy(thread.transcoder);
+
+        if (status == RDMPEG_TRANSCODER_CANCELLED) {
+            cancelledCount++;
+        }
+        else if (status == 0) {
+            finishedCount++;
+        }
+        else {
+            unexpectedCount++;
+        }
+    }
+
+    printf("     %d cancelled, %d finished before cancel\n", cancelledCount, finishedCount);
+    check(unexpectedCount == 0 && cancelledCount > 0, "cancel from another thread at any moment");
+}
+
+int main(void) {
+    av_log_set_level(AV_LOG_ERROR);
+
+    snprintf(directory, sizeof(directory), "%s", "/tmp/rdmpeg-transcoder-test-XXXXXX");
+    if (mkdtemp(directory) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    snprintf(inputPath, sizeof(inputPath), "%s/input.mp4", directory);
+
+    int status = generate_input(inputPath);
+    if (status < 0) {
+        fprintf(stderr, "Unable to generate %s: %s\n", inputPath, av_err2str(status));
+        return 1;
+    }
+
+    test_transcode();
+    test_trim();
+    test_copy();
+    test_custom_io();
+    test_failures();
+    test_cancel();
+
+    if (failuresCount > 0) {
+        printf("FAIL: %d checks failed, outputs are kept in %s\n", failuresCount, directory);
+        return 1;
+    }
+
+    char command[512];
+    snprintf(command, sizeof(command), "rm -rf '%s'", directory);
+    if (system(command) != 0) {
+        fprintf(stderr, "Unable to remove %s\n", directory);
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,224 @@
+//
+//  main.swift
+//  RDMPEGTrickPlayTest
+//
+//  Copyright © 2026 Readdle. All rights reserved.
+//
+
+import Foundation
+
+// Runs RDMPEGTrickPlay against a synthetic source with a keyframe every second of media and checks the sequence
+// of presented keyframes (order, deadlines, hopping over keyframes passed during a slow decode, stopping at
+// the first keyframe when rewinding) and cancellation: nothing is decoded or presented after cancel, whether it
+// comes during a decode, while a keyframe waits for its deadline or from presentation itself, and decoding
+// queue stays free while a keyframe waits.
+
+let keyframesCount = 20
+let keyframeDuration: TimeInterval = 0.04
+let maximumLateness: TimeInterval = 0.03
+var failuresCount = 0
+
+func check(_ condition: Bool, _ message: @autoclosure () -> String) {
+    if !condition {
+        print("FAIL: \(message())")
+        failuresCount += 1
+    }
+}
+
+func hostTime() -> TimeInterval {
+    RDMPEGCorrectionInfo.hostTime
+}
+
+// Main queue runs trick play scheduler and decoded keyframe handoff
+func runMainLoop(for interval: TimeInterval, until condition: () -> Bool = { false }) {
+    let deadline = hostTime() + interval
+
+    while hostTime() < deadline && !condition() {
+        _ = RunLoop.main.run(mode: .default, before: Date(timeIntervalSinceNow: 0.002))
+    }
+}
+
+final class TestKeyframe: RDMPEGTrickPlayKeyframe {
+    let position: TimeInterval
+    let duration = keyframeDuration
+
+    init(position: TimeInterval) {
+        self.position = position
+    }
+}
+
+// Keyframe at every whole second of media, decoding one takes the decode duration
+final class KeyframeSource {
+    let decodeDuration: TimeInterval
+    private let lock = NSLock()
+    private var decodesCountValue = 0
+
+    var decodesCount: Int {
+        lock.withLock { decodesCountValue }
+    }
+
+    init(decodeDuration: TimeInterval) {
+        self.decodeDuration = decodeDuration
+    }
+
+    func decode(_ targetPosition: TimeInterval, _ forward: Bool) -> TestKeyframe? {
+        lock.withLock { decodesCountValue += 1 }
+        Thread.sleep(forTimeInterval: decodeDuration)
+
+        let index = forward ? Int((targetPosition - 1e-9).rounded(.up)) : Int((targetPosition + 1e-9).rounded(.down))
+        guard index >= 0 && index < keyframesCount else {
+            return nil
+        }
+
+        return TestKeyframe(position: Double(index))
+    }
+}
+
+final class TrickPlayRun {
+    let source: KeyframeSource
+    let decodingQueue = OperationQueue()
+    private(set) var trickPlay: RDMPEGTrickPlay<TestKeyframe>!
+    private(set) var startHostTime: TimeInterval = 0
+    private(set) var presented: [(position: TimeInterval, hostTime: TimeInterval)] = []
+    // Called after a keyframe is recorded, may cancel trick play
+    var presentationHandler: (() -> Void)?
+
+    var presentedPositions: [TimeInterval] {
+        presented.map { $0.position }
+    }
+
+    init(startPosition: TimeInterval, rate: Double, decodeDuration: TimeInterval) {
+        source = KeyframeSource(decodeDuration: decodeDuration)
+        decodingQueue.maxConcurrentOperationCount = 1
+
+        trickPlay = RDMPEGTrickPlay<TestKeyframe>(
+            startPosition: startPosition,
+            rate: rate,
+            decodingQueue: decodingQueue,
+            decodeKeyframe: source.decode,
+            presentKeyframe: { [unowned self] keyframe in
+                self.presented.append((keyframe.position, hostTime()))
+                self.presentationHandler?()
+            }
+        )
+    }
+
+    func start() {
+        startHostTime = hostTime()
+        trickPlay.start()
+    }
+
+    // Lateness of every presented keyframe against the trick play clock
+    func latenesses() -> [TimeInterval] {
+        presented.map { $0.hostTime - (startHostTime + ($0.position - trickPlay.startPosition) / trickPlay.rate) }
+    }
+}
+
+func testSequence() {
+    let run = TrickPlayRun(startPosition: 0, rate: 8, decodeDuration: 0.005)
+    run.start()
+    runMainLoop(for: 3) { run.presented.count >= 9 }
+    run.trickPlay.cancel()
+
+    check(run.presentedPositions == (0...8).map(Double.init), "forward sequence \(run.presentedPositions)")
+
+    for (position, lateness) in zip(run.presentedPositions, run.latenesses()) {
+        check(lateness > -0.002, "keyframe \(position) presented \(-lateness) s early")
+        check(lateness < maximumLateness, "keyframe \(position) presented \(lateness) s late")
+    }
+}
+
+func testHopOver() {
+    // Decoding a keyframe takes longer than the clock needs to reach the next one
+    let run = TrickPlayRun(startPosition: 0, rate: 8, decodeDuration: 0.3)
+    run.start()
+    runMainLoop(for: 1.6)
+    run.trickPlay.cancel()
+
+    let positions = run.presentedPositions
+    check(positions.count >= 3, "only \(positions.count) keyframes presented while decoding slowly")
+    check(zip(positions, positions.dropFirst()).allSatisfy { $1 > $0 }, "sequence not increasing \(positions)")
+    check(zip(positions, positions.dropFirst()).contains { $1 - $0 > 1 }, "no keyframe hopped over \(positions)")
+    check(run.latenesses().allSatisfy { $0 > -0.002 }, "keyframe presented before its time")
+
+    print("slow decoding presented keyframes \(positions.map { Int($0) })")
+}
+
+func testRewindToFirstKeyframe() {
+    let run = TrickPlayRun(startPosition: 3, rate: -8, decodeDuration: 0.005)
+    run.start()
+    runMainLoop(for: 2) { !run.trickPlay.isRunning }
+
+    check(run.presentedPositions == [3, 2, 1, 0], "rewind sequence \(run.presentedPositions)")
+    check(!run.trickPlay.isRunning, "trick play kept running past the first keyframe")
+    check(run.latenesses().allSatisfy { $0 > -0.002 && $0 < maximumLateness }, "rewind missed deadlines")
+}
+
+func testCancelDuringDecode() {
+    let run = TrickPlayRun(startPosition: 0, rate: 8, decodeDuration: 0.2)
+    run.start()
+    runMainLoop(for: 0.05)
+    check(run.source.decodesCount == 1, "first keyframe decode didn't start")
+
+    run.trickPlay.cancel()
+    check(!run.trickPlay.isRunning, "trick play running after cancel")
+
+    runMainLoop(for: 0.4)
+    check(run.presented.isEmpty, "keyframe decoded before cancel was presented")
+    check(run.source.decodesCount == 1, "decoded \(run.source.decodesCount) keyframes despite cancel")
+    check(run.decodingQueue.operationCount == 0, "operations left on decoding queue after cancel")
+}
+
+func testCancelWhileWaiting() {
+    // At 2x the next keyframe is due half a second after the first one
+    let run = TrickPlayRun(startPosition: 0, rate: 2, decodeDuration: 0.005)
+    run.start()
+    runMainLoop(for: 1) { run.presented.count == 1 }
+    runMainLoop(for: 0.1)
+
+    check(run.presentedPositions == [0], "first keyframe \(run.presentedPositions)")
+    check(run.source.decodesCount == 2, "next keyframe not decoded ahead of its deadline")
+    check(run.decodingQueue.operationCount == 0, "decoding queue busy while keyframe waits")
+
+    // Decoding queue serves other work at once, it isn't blocked until the keyframe's deadline
+    let requestTime = hostTime()
+    var startTime: TimeInterval?
+    run.decodingQueue.addOperation { startTime = hostTime() }
+    run.decodingQueue.waitUntilAllOperationsAreFinished()
+    check((startTime ?? .infinity) - requestTime < 0.05, "decoding queue blocked while keyframe waits")
+
+    let cancelTime = hostTime()
+    run.trickPlay.cancel()
+    runMainLoop(for: 0.8)
+
+    check(run.presentedPositions == [0], "keyframe presented after cancel \(run.presentedPositions)")
+    check(run.source.decodesCount == 2, "decoded after cancel")
+    check(hostTime() - cancelTime >= 0.8, "main loop didn't run")
+}
+
+func testCancelFromPresentation() {
+    let run = TrickPlayRun(startPosition: 0, rate: 8, decodeDuration: 0.005)
+    run.presentationHandler = { run.trickPlay.cancel() }
+    run.start()
+    runMainLoop(for: 0.5)
+
+    check(run.presentedPositions == [0], "presented after cancel from presentation \(run.presentedPositions)")
+    check(run.source.decodesCount == 1, "decoded after cancel from presentation")
+    check(!run.trickPlay.isRunning, "trick play running after cancel from presentation")
+}
+
+testSequence()
+testHopOver()
+testRewindToFirstKeyframe()
+testCancelDuringDecode()
+testCancelWhileWaiting()
+testCancelFromPresentation()
+
+if failuresCount == 0 {
+    print("PASS")
+    exit(0)
+}
+else {
+    print("FAIL: \(failuresCount) checks")
+    exit(1)
+}